@@ -21,6 +21,22 @@ taskkill /F /IM test.exe >nul 2>nul
 taskkill /F /IM test_cmd.exe >nul 2>nul
 taskkill /F /IM test_items.exe >nul 2>nul
 taskkill /F /IM test_gen.exe >nul 2>nul
+taskkill /F /IM test_timer.exe >nul 2>nul
+taskkill /F /IM test_craft.exe >nul 2>nul
+taskkill /F /IM test_mbin.exe >nul 2>nul
+taskkill /F /IM test_loader.exe >nul 2>nul
+taskkill /F /IM test_save.exe >nul 2>nul
+taskkill /F /IM test_delta.exe >nul 2>nul
+taskkill /F /IM test_lz.exe >nul 2>nul
+taskkill /F /IM test_fork.exe >nul 2>nul
+taskkill /F /IM test_world.exe >nul 2>nul
+taskkill /F /IM test_rng.exe >nul 2>nul
+taskkill /F /IM test_hash.exe >nul 2>nul
+taskkill /F /IM test_profile.exe >nul 2>nul
+taskkill /F /IM test_platform.exe >nul 2>nul
+taskkill /F /IM test_sched.exe >nul 2>nul
+taskkill /F /IM test_spatial.exe >nul 2>nul
+taskkill /F /IM test_ws.exe >nul 2>nul
 
 REM === Logic Branching ===
 if "%1"=="ui_test" goto DO_UI_TEST
@@ -31,15 +47,17 @@ if "%1"=="web_serve" goto DO_WEB_SERVE
 if "%1"=="test" goto DO_TEST
 if "%1"=="gcc" goto DO_GCC
 if "%1"=="msvc" goto DO_MSVC
+if "%1"=="montecarlo" goto DO_MONTECARLO
 if "%1"=="clean_dlls" goto DO_CLEAN_DLLS
 
 :USAGE
-echo Usage: build.bat [msvc^|gcc^|test^|ui_test^|sprite_font_editor^|mindmarr^|web^|web_serve^|clean_dlls]
+echo Usage: build.bat [msvc^|gcc^|test^|montecarlo^|ui_test^|sprite_font_editor^|mindmarr^|web^|web_serve^|clean_dlls]
 echo.
 echo    msvc                - Build runtime with Visual Studio cl.exe
 echo    gcc                 - Build runtime with GCC/MinGW
 echo    test                - Build and run test harness (GCC)
 echo    test msvc           - Build and run test harness (MSVC)
+echo    montecarlo          - Build batch Monte Carlo runner (GCC)
 echo    ui_test             - Build and run Lua UI Demo (SDL2 + EGL + Lua)
 echo    sprite_font_editor  - Build and run Sprite Font Editor Tool
 echo    mindmarr            - Build and run MindMarr game
@@ -252,21 +270,75 @@ if "%2"=="msvc" (
     cl /std:c11 /W4 /O2 tests\test_cmd.c /Fe:test_cmd.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
     cl /std:c11 /W4 /O2 tests\test_items.c /Fe:test_items.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
     cl /std:c11 /W4 /O2 tests\test_gen.c /Fe:test_gen.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_timer.c /Fe:test_timer.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_craft.c /Fe:test_craft.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_mbin.c /Fe:test_mbin.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_loader.c /Fe:test_loader.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_save.c /Fe:test_save.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_delta.c /Fe:test_delta.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_lz.c /Fe:test_lz.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_fork.c /Fe:test_fork.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_world.c /Fe:test_world.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_rng.c /Fe:test_rng.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_hash.c /Fe:test_hash.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_profile.c /Fe:test_profile.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_platform.c /Fe:test_platform.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_sched.c /Fe:test_sched.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_spatial.c /Fe:test_spatial.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
+    cl /std:c11 /W4 /O2 tests\test_ws.c /Fe:test_ws.exe /Iinclude /Ivendor\ThirdParty\include /I"%MSYS_DIR%\include" /link /LIBPATH:"%MSYS_DIR%\lib" %LUA_LIB%.lib
 ) else (
     gcc -std=c99 -w -O2 tests\test.c -o test.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
     gcc -std=c99 -w -O2 tests\test_cmd.c -o test_cmd.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
     gcc -std=c99 -w -O2 tests\test_items.c -o test_items.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
     gcc -std=c99 -w -O2 tests\test_gen.c -o test_gen.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_timer.c -o test_timer.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_craft.c -o test_craft.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_mbin.c -o test_mbin.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_loader.c -o test_loader.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_save.c -o test_save.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_delta.c -o test_delta.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_lz.c -o test_lz.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_fork.c -o test_fork.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_world.c -o test_world.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_rng.c -o test_rng.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_hash.c -o test_hash.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_profile.c -o test_profile.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_platform.c -o test_platform.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm -lwinmm
+    gcc -std=c99 -w -O2 tests\test_sched.c -o test_sched.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_spatial.c -o test_spatial.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+    gcc -std=c99 -w -O2 tests\test_ws.c -o test_ws.exe -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
 )
 if %ERRORLEVEL% NEQ 0 exit /b 1
 if exist test.exe .\test.exe
 if exist test_cmd.exe .\test_cmd.exe
 if exist test_items.exe .\test_items.exe
 if exist test_gen.exe .\test_gen.exe
+if exist test_timer.exe .\test_timer.exe
+if exist test_craft.exe .\test_craft.exe
+if exist test_mbin.exe .\test_mbin.exe
+if exist test_loader.exe .\test_loader.exe
+if exist test_save.exe .\test_save.exe
+if exist test_delta.exe .\test_delta.exe
+if exist test_lz.exe .\test_lz.exe
+if exist test_fork.exe .\test_fork.exe
+if exist test_world.exe .\test_world.exe
+if exist test_rng.exe .\test_rng.exe
+if exist test_hash.exe .\test_hash.exe
+if exist test_profile.exe .\test_profile.exe
+if exist test_platform.exe .\test_platform.exe
+if exist test_sched.exe .\test_sched.exe
+if exist test_spatial.exe .\test_spatial.exe
+if exist test_ws.exe .\test_ws.exe
 exit /b 0
 
 :DO_GCC
-gcc -std=c99 -w -O2 src\main.c -o %OUT_NAME% -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm
+gcc -std=c99 -w -O2 src\main.c -o %OUT_NAME% -Iinclude -Ivendor\ThirdParty\include -I"%MSYS_DIR%\include" -L"%MSYS_DIR%\lib" -static -l%LUA_LIB% -lm -lwinmm
+goto FINISH
+
+:DO_MONTECARLO
+set "OUT_NAME=marble_montecarlo.exe"
+taskkill /F /IM %OUT_NAME% >nul 2>nul
+gcc -std=c99 -w -O2 src\montecarlo.c -o %OUT_NAME% -Iinclude
 goto FINISH
 
 :DO_MSVC
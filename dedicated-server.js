@@ -1,4 +1,7 @@
 // dedicated-server.js - Server simulates the entire game
+// For the NetWorld protocol (marble_net.h) use the native server instead:
+// src/net_server.c (epoll, binary delta snapshots). This one stays for the
+// JSON space shooter demos (scripts/demos/space_shooter_mult*.lua).
 const WebSocket = require('ws');
 
 const PORT = 8080;
@@ -0,0 +1,84 @@
+/*
+ * marble_atomic.h -- 32-bit Atomics Shim (Phase 0.4)
+ *
+ * PURPOSE:
+ *   The few atomic operations the engine needs across threads: worker
+ *   completion flags (marble_thread.h, marble_save.h autosave) and the
+ *   socket-thread -> tick-thread MPSC ring (marble_net.h).
+ *
+ * BACKENDS:
+ *   C11 <stdatomic.h> when available, else the GCC/Clang __atomic
+ *   builtins (same memory orders; they work under -std=c99), else MSVC
+ *   volatile (/volatile:ms gives acquire/release on plain loads and
+ *   stores) plus Interlocked intrinsics for the read-modify-writes.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_ATOMIC_H
+#define MARBLE_ATOMIC_H
+
+#include <stdint.h>
+
+/* load_acquire / store_release: everything written before the store is
+ *   visible after a load that sees it.
+ * cas: weak compare-and-swap (may fail spuriously; call in a loop). On
+ *   failure *expected receives the current value. acq_rel on success.
+ * fetch_add_relaxed: returns the previous value; no ordering, for
+ *   counters only. */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+typedef _Atomic uint32_t McAtomicU32;
+static uint32_t mc_atomic_load_acquire(McAtomicU32* p) {
+    return atomic_load_explicit(p, memory_order_acquire);
+}
+static uint32_t mc_atomic_load_relaxed(McAtomicU32* p) {
+    return atomic_load_explicit(p, memory_order_relaxed);
+}
+static void mc_atomic_store_release(McAtomicU32* p, uint32_t v) {
+    atomic_store_explicit(p, v, memory_order_release);
+}
+static int mc_atomic_cas(McAtomicU32* p, uint32_t* expected, uint32_t desired) {
+    return atomic_compare_exchange_weak_explicit(p, expected, desired,
+                                                 memory_order_acq_rel, memory_order_acquire);
+}
+static uint32_t mc_atomic_fetch_add_relaxed(McAtomicU32* p, uint32_t v) {
+    return atomic_fetch_add_explicit(p, v, memory_order_relaxed);
+}
+#elif defined(__GNUC__) || defined(__clang__)
+typedef uint32_t McAtomicU32;
+static uint32_t mc_atomic_load_acquire(McAtomicU32* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static uint32_t mc_atomic_load_relaxed(McAtomicU32* p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+static void mc_atomic_store_release(McAtomicU32* p, uint32_t v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+static int mc_atomic_cas(McAtomicU32* p, uint32_t* expected, uint32_t desired) {
+    return __atomic_compare_exchange_n(p, expected, desired, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static uint32_t mc_atomic_fetch_add_relaxed(McAtomicU32* p, uint32_t v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+}
+#elif defined(_MSC_VER)
+#include <intrin.h>
+typedef volatile long McAtomicU32;
+static uint32_t mc_atomic_load_acquire(McAtomicU32* p) { return (uint32_t)*p; }
+static uint32_t mc_atomic_load_relaxed(McAtomicU32* p) { return (uint32_t)*p; }
+static void mc_atomic_store_release(McAtomicU32* p, uint32_t v) { *p = (long)v; }
+static int mc_atomic_cas(McAtomicU32* p, uint32_t* expected, uint32_t desired) {
+    long seen = _InterlockedCompareExchange(p, (long)desired, (long)*expected);
+    if ((uint32_t)seen == *expected) return 1;
+    *expected = (uint32_t)seen;
+    return 0;
+}
+static uint32_t mc_atomic_fetch_add_relaxed(McAtomicU32* p, uint32_t v) {
+    return (uint32_t)_InterlockedExchangeAdd(p, (long)v);
+}
+#else
+#error "marble_atomic.h: no atomics for this compiler"
+#endif
+
+#endif /* MARBLE_ATOMIC_H */
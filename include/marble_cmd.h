@@ -15,7 +15,7 @@
  *   CMD_DAMAGE_LAYER     -- reduce outermost layer integrity (peel on 0)
  *   CMD_MODIFY_STAT      -- add/subtract a stat on an entity
  *   CMD_TRANSFORM_ENTITY -- replace entity's definition (item -> new item)
- *   CMD_MOVE_ENTITY      -- change entity location/container
+ *   CMD_MOVE_ENTITY      -- place entity in the world or inside a container
  *   CMD_REMOVE_ENTITY    -- destroy entity entirely
  *   CMD_PLAY_FEEDBACK    -- emit message (no state change, logged only)
  *
@@ -37,6 +37,8 @@
 
 #include "marble_core.h"
 #include "marble_interact.h"  /* CapabilityDef, conditions, body part checks */
+#include "marble_spatial.h"   /* SpatialGrid, ContainerIndex for moves */
+#include "marble_fork_pool.h" /* copy-on-write pool views (CmdPool)   */
 
 /* =========================================================================
  * SECTION 1: COMMAND TYPES
@@ -104,7 +106,9 @@ typedef struct {
     uint32_t    new_def_id;     /* item definition ID to transform into */
 
     /* CMD_MOVE_ENTITY */
-    uint32_t    destination;    /* destination enum or container entity */
+    uint32_t    destination;    /* MC_MOVE_TO_WORLD or container entity */
+    float       move_x;         /* world position when destination is */
+    float       move_y;         /*   MC_MOVE_TO_WORLD                 */
 
     /* CMD_PLAY_FEEDBACK */
     uint32_t    message_id;     /* index into message table */
@@ -113,6 +117,10 @@ typedef struct {
     uint64_t    tick;
 } Command;
 
+/* CMD_MOVE_ENTITY destination meaning "into the world at (move_x, move_y)".
+ * Any other value is the EntityID of the container to move into. */
+#define MC_MOVE_TO_WORLD UINT32_MAX
+
 /* =========================================================================
  * SECTION 3: COMMAND BUFFER
  *
@@ -130,18 +138,20 @@ typedef struct {
     uint32_t count;
     uint32_t rejected;  /* count of commands that failed validation */
     uint32_t applied;   /* count of commands successfully applied */
+    uint32_t relinked;  /* grid/container index relinks by the last flush */
 } CommandBuffer;
 
 static void mc_cmd_buf_init(CommandBuffer* buf) {
     buf->count    = 0;
     buf->rejected = 0;
     buf->applied  = 0;
+    buf->relinked = 0;
 }
 
 /* Push a command into the buffer. Returns 0 on success, -1 if full. */
 static int mc_cmd_push(CommandBuffer* buf, const Command* cmd) {
     if (buf->count >= MAX_COMMANDS) {
-        printf("  [CMD] WARNING: command buffer full, dropping %s\n",
+        MC_LOG("  [CMD] WARNING: command buffer full, dropping %s\n",
                CMD_TYPE_NAMES[cmd->type]);
         return -1;
     }
@@ -232,6 +242,36 @@ static void mc_emit_remove(
     mc_cmd_push(buf, &cmd);
 }
 
+static void mc_emit_move_to(
+    CommandBuffer* buf, uint64_t tick,
+    EntityID source, EntityID target, float x, float y
+) {
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type          = CMD_MOVE_ENTITY;
+    cmd.source_entity = source;
+    cmd.target_entity = target;
+    cmd.destination   = MC_MOVE_TO_WORLD;
+    cmd.move_x        = x;
+    cmd.move_y        = y;
+    cmd.tick          = tick;
+    mc_cmd_push(buf, &cmd);
+}
+
+static void mc_emit_move_into(
+    CommandBuffer* buf, uint64_t tick,
+    EntityID source, EntityID target, EntityID container
+) {
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type          = CMD_MOVE_ENTITY;
+    cmd.source_entity = source;
+    cmd.target_entity = target;
+    cmd.destination   = container;
+    cmd.tick          = tick;
+    mc_cmd_push(buf, &cmd);
+}
+
 static void mc_emit_feedback(
     CommandBuffer* buf, uint64_t tick,
     EntityID source, uint32_t message_id
@@ -250,26 +290,102 @@ static void mc_emit_feedback(
  *
  * These are the ONLY functions that mutate component pools.
  * They are called ONLY during the flush phase at tick boundary.
+ *
+ * Applicators reach rows through a CmdPool: a live SparseSet, or a
+ * world fork's copy-on-write view of one (marble_fork_pool.h). The live
+ * flush and the fork flush run these same functions; only the CmdPool
+ * they are handed differs. In-place writes on a SparseSet are bracketed
+ * by mc_sparse_set_hash_out()/_in() so the pool's running state hash
+ * stays current (views carry no hash).
  * ========================================================================= */
 
+typedef struct {
+    SparseSet* set;      /* a live pool ...                      */
+    ForkPool*  view;     /* ... or a fork's view of one          */
+    ForkArena* arena;    /* the view's page arena                */
+} CmdPool;               /* all NULL: the pool doesn't exist here */
+
+static CmdPool mc_cmd_pool_set(SparseSet* ss) {
+    CmdPool p;
+    p.set   = ss;
+    p.view  = NULL;
+    p.arena = NULL;
+    return p;
+}
+
+static CmdPool mc_cmd_pool_view(ForkArena* arena, ForkPool* view) {
+    CmdPool p;
+    p.set   = NULL;
+    p.view  = view;
+    p.arena = arena;
+    return p;
+}
+
+static int mc_cmd__pool_present(const CmdPool* p) {
+    return p->set != NULL || p->view != NULL;
+}
+
+static uint32_t mc_cmd__pool_stride(const CmdPool* p) {
+    if (p->set != NULL) return p->set->stride;
+    return (p->view != NULL) ? p->view->stride : 0;
+}
+
+static const void* mc_cmd__get_const(const CmdPool* p, EntityID eid) {
+    if (p->set != NULL) return mc_sparse_set_get_const(p->set, eid);
+    if (p->view != NULL) return mc_fork_pool_get_const(p->arena, p->view, eid);
+    return NULL;
+}
+
+/* Writable row for an in-place write, closed by mc_cmd__write_end().
+ * NULL if absent, or if a view's arena can't take the page copy. */
+static void* mc_cmd__write_begin(CmdPool* p, EntityID eid) {
+    if (p->set != NULL) {
+        void* row = mc_sparse_set_get(p->set, eid);
+        if (row != NULL) mc_sparse_set_hash_out(p->set, eid);
+        return row;
+    }
+    if (p->view != NULL) return mc_fork_pool_get(p->arena, p->view, eid);
+    return NULL;
+}
+
+static void mc_cmd__write_end(CmdPool* p, EntityID eid) {
+    if (p->set != NULL) mc_sparse_set_hash_in(p->set, eid);
+}
+
+static int mc_cmd__add(CmdPool* p, EntityID eid, const void* row) {
+    if (p->set != NULL) return mc_sparse_set_add(p->set, eid, row);
+    if (p->view != NULL) return mc_fork_pool_add(p->arena, p->view, eid, row);
+    return -1;
+}
+
+static int mc_cmd__remove(CmdPool* p, EntityID eid) {
+    if (p->set != NULL) return mc_sparse_set_remove(p->set, eid);
+    if (p->view != NULL) return mc_fork_pool_remove(p->arena, p->view, eid);
+    return -1;
+}
+
 /* Apply layer damage to an entity's LayerStack.
  * Same logic as old apply_effect(DAMAGE_LAYER) but routed through cmd buf. */
 static int mc_apply_damage_layer(
-    const Command* cmd, SparseSet* pool_layers
+    const Command* cmd, CmdPool* pool_layers
 ) {
+    const CLayerStack* peek;
     CLayerStack* stack;
     int32_t d;
 
-    stack = (CLayerStack*)mc_sparse_set_get(pool_layers, cmd->target_entity);
+    /* Checked read-only first: a rejected command writes (and copies) nothing */
+    peek = (const CLayerStack*)mc_cmd__get_const(pool_layers, cmd->target_entity);
+    if (peek == NULL) return -1;
+    if (peek->layer_count == 0) return -1;
+    stack = (CLayerStack*)mc_cmd__write_begin(pool_layers, cmd->target_entity);
     if (stack == NULL) return -1;
-    if (stack->layer_count == 0) return -1;
 
     for (d = 0; d < cmd->damage_amount && stack->layer_count > 0; d++) {
         stack->layers[0].integrity--;
 
         if (stack->layers[0].integrity <= 0) {
             uint32_t i;
-            printf("    >> Layer DESTROYED: %s peeled on eid %u <<\n",
+            MC_LOG("    >> Layer DESTROYED: %s peeled on eid %u <<\n",
                    MATERIAL_NAMES[stack->layers[0].material],
                    cmd->target_entity);
             for (i = 0; i + 1 < stack->layer_count; i++) {
@@ -278,32 +394,33 @@ static int mc_apply_damage_layer(
             stack->layer_count--;
         }
     }
+    mc_cmd__write_end(pool_layers, cmd->target_entity);
     return 0;
 }
 
 /* Apply critical self-damage to a body part entity's LayerStack. */
 static int mc_apply_crit_damage(
-    const Command* cmd, SparseSet* pool_layers
+    const Command* cmd, CmdPool* pool_layers
 ) {
     CLayerStack* stack;
     int32_t d;
 
-    stack = (CLayerStack*)mc_sparse_set_get(pool_layers, cmd->target_entity);
+    stack = (CLayerStack*)mc_cmd__write_begin(pool_layers, cmd->target_entity);
     if (stack == NULL) return -1;
 
-    printf("    >> CRIT FAIL! Entity %u damages own body part (eid %u)! <<\n",
+    MC_LOG("    >> CRIT FAIL! Entity %u damages own body part (eid %u)! <<\n",
            cmd->source_entity, cmd->target_entity);
 
     for (d = 0; d < cmd->damage_amount && stack->layer_count > 0; d++) {
         stack->layers[0].integrity--;
-        printf("    >> %s integrity -> %d/%d <<\n",
+        MC_LOG("    >> %s integrity -> %d/%d <<\n",
                MATERIAL_NAMES[stack->layers[0].material],
                stack->layers[0].integrity,
                stack->layers[0].max_integrity);
 
         if (stack->layers[0].integrity <= 0) {
             uint32_t i;
-            printf("    >> %s layer DESTROYED <<\n",
+            MC_LOG("    >> %s layer DESTROYED <<\n",
                    MATERIAL_NAMES[stack->layers[0].material]);
             for (i = 0; i + 1 < stack->layer_count; i++) {
                 stack->layers[i] = stack->layers[i + 1];
@@ -311,11 +428,12 @@ static int mc_apply_crit_damage(
             stack->layer_count--;
 
             if (stack->layer_count == 0) {
-                printf("    >> Body part eid %u FULLY DESTROYED -- fine motor LOST <<\n",
+                MC_LOG("    >> Body part eid %u FULLY DESTROYED -- fine motor LOST <<\n",
                        cmd->target_entity);
             }
         }
     }
+    mc_cmd__write_end(pool_layers, cmd->target_entity);
     return 0;
 }
 
@@ -327,18 +445,68 @@ typedef struct {
 } CItemDef;
 
 static int mc_apply_transform(
-    const Command* cmd, SparseSet* pool_item_defs
+    const Command* cmd, CmdPool* pool_item_defs
 ) {
     CItemDef* def;
-    def = (CItemDef*)mc_sparse_set_get(pool_item_defs, cmd->target_entity);
+    def = (CItemDef*)mc_cmd__write_begin(pool_item_defs, cmd->target_entity);
     if (def == NULL) {
-        printf("    >> TRANSFORM: eid %u has no CItemDef, cannot transform <<\n",
+        MC_LOG("    >> TRANSFORM: eid %u has no CItemDef, cannot transform <<\n",
                cmd->target_entity);
         return -1;
     }
-    printf("    >> TRANSFORM: eid %u def %u -> %u <<\n",
+    MC_LOG("    >> TRANSFORM: eid %u def %u -> %u <<\n",
            cmd->target_entity, def->def_id, cmd->new_def_id);
     def->def_id = cmd->new_def_id;
+    mc_cmd__write_end(pool_item_defs, cmd->target_entity);
+    return 0;
+}
+
+/* Move an entity into the world or into a container.
+ *
+ * Only the authoritative state is written here, in command order: the
+ * position row (x, y = first two floats, as in every CPosition) and the
+ * container parent. An entity in the world has a position row and no
+ * parent; a contained one has a parent and no position row. The grid and
+ * the container child lists are derived from those and are caught up for
+ * the whole tick at once by mc_cmd__apply_move_batch().
+ *
+ * Container existence isn't checked (no allocator here); cycles are. */
+static int mc_apply_move(
+    const Command* cmd, CmdPool* pool_positions, ContainerIndex* containers
+) {
+    EntityID eid = cmd->target_entity;
+
+    if (cmd->destination == MC_MOVE_TO_WORLD) {
+        float xy[2];
+        uint8_t row[64];
+        uint32_t stride = mc_cmd__pool_stride(pool_positions);
+        if (stride < sizeof(xy) || stride > sizeof(row)) return -1;
+        if (eid >= MC_MAX_ENTITIES) return -1;
+        xy[0] = cmd->move_x;
+        xy[1] = cmd->move_y;
+        if (mc_cmd__get_const(pool_positions, eid) != NULL) {
+            void* pos = mc_cmd__write_begin(pool_positions, eid);
+            if (pos == NULL) return -1;
+            memcpy(pos, xy, sizeof(xy));
+            mc_cmd__write_end(pool_positions, eid);
+        } else {
+            memset(row, 0, sizeof(row));
+            memcpy(row, xy, sizeof(xy));
+            if (mc_cmd__add(pool_positions, eid, row) != 0) return -1;
+        }
+        if (containers != NULL) mc_container_set_parent(containers, eid, MC_CONTAINER_NONE);
+        return 0;
+    }
+
+    if (containers == NULL) return -1;
+    if (eid >= MC_GRID_MAX_ENTITIES || cmd->destination >= MC_GRID_MAX_ENTITIES) return -1;
+    if (mc_container_would_cycle(containers, eid, cmd->destination)) {
+        MC_LOG("    >> MOVE: eid %u into %u would contain itself <<\n",
+               eid, cmd->destination);
+        return -1;
+    }
+    mc_container_set_parent(containers, eid, cmd->destination);
+    mc_cmd__remove(pool_positions, eid);
     return 0;
 }
 
@@ -350,19 +518,101 @@ static int mc_apply_transform(
  * with a log entry.
  *
  * pool_ptrs is a struct of all pool pointers so the flush can route
- * each command type to the right pool.
+ * each command type to the right pool. mc_cmd_flush() wraps them as
+ * CmdPools and runs mc_cmd_flush_pools(), the one dispatch loop; world
+ * forks (marble_fork.h) call it with views instead.
+ *
+ * Moves are validated and applied in order like everything else, but
+ * the spatial grid and container lists are updated once at the end, in
+ * a single pass sorted by destination cell.
  * ========================================================================= */
 
 typedef struct {
-    SparseSet* layers;
-    SparseSet* item_defs;
+    SparseSet*      layers;
+    SparseSet*      item_defs;
+    SparseSet*      positions;    /* CMD_MOVE_ENTITY to the world          */
+    SpatialGrid*    grid;         /* kept in sync with positions; optional */
+    ContainerIndex* containers;   /* CMD_MOVE_ENTITY into containers       */
     /* Add more pool pointers as needed */
 } PoolPtrs;
 
-static void mc_cmd_flush(CommandBuffer* buf, PoolPtrs* pools) {
+typedef struct {
+    CmdPool         layers;
+    CmdPool         item_defs;    /* absent: transforms are logged only */
+    CmdPool         positions;
+    SpatialGrid*    grid;
+    ContainerIndex* containers;
+} CmdPools;
+
+/* LSD radix sort of 64-bit keys, 8 bits per pass. Passes where every key
+ * has the same digit are skipped, so small cell/eid ranges cost 2-3. */
+static void mc_cmd__radix_sort64(uint64_t* keys, uint64_t* tmp, uint32_t n) {
+    uint32_t counts[256];
+    uint32_t shift, i;
+    for (shift = 0; shift < 64; shift += 8) {
+        uint32_t sum = 0;
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < n; i++) counts[(keys[i] >> shift) & 0xFF]++;
+        if (counts[(keys[0] >> shift) & 0xFF] == n) continue;
+        for (i = 0; i < 256; i++) {
+            uint32_t c = counts[i];
+            counts[i] = sum;
+            sum += c;
+        }
+        for (i = 0; i < n; i++) tmp[counts[(keys[i] >> shift) & 0xFF]++] = keys[i];
+        memcpy(keys, tmp, n * sizeof(uint64_t));
+    }
+}
+
+/* Bring the grid and container lists up to date for every entity moved
+ * this flush. Entities are keyed (destination cell, eid) and sorted, so
+ * cell lists are linked in memory order and an entity moved several
+ * times in one tick is relinked once, to where it ended up. Contained
+ * entities sort last under MC_GRID_NONE. */
+static uint32_t mc_cmd__apply_move_batch(CmdPools* pools, const EntityID* moved, uint32_t n) {
+    uint64_t keys[MAX_COMMANDS], tmp[MAX_COMMANDS];
+    uint32_t i, relinked = 0;
+
+    for (i = 0; i < n; i++) {
+        uint32_t cell = MC_GRID_NONE;
+        const float* xy = (const float*)mc_cmd__get_const(&pools->positions, moved[i]);
+        if (pools->grid != NULL && xy != NULL) cell = mc_grid_cell_of_point(pools->grid, xy[0], xy[1]);
+        keys[i] = ((uint64_t)cell << 32) | moved[i];
+    }
+    if (n > 1) mc_cmd__radix_sort64(keys, tmp, n);
+
+    for (i = 0; i < n; i++) {
+        EntityID eid  = (EntityID)(keys[i] & 0xFFFFFFFFu);
+        uint32_t cell = (uint32_t)(keys[i] >> 32);
+        if (i > 0 && keys[i] == keys[i - 1]) continue;
+
+        if (pools->grid != NULL) {
+            SpatialGrid* g = pools->grid;
+            if (cell == MC_GRID_NONE) {
+                if (mc_grid_remove(g, eid) == 0) relinked++;
+            } else {
+                float xy[2];
+                uint32_t was = mc_grid_has(g, eid) ? g->cell_of[eid] : MC_GRID_NONE;
+                memcpy(xy, mc_cmd__get_const(&pools->positions, eid), sizeof(xy));
+                if (was == MC_GRID_NONE) mc_grid_insert(g, eid, xy[0], xy[1]);
+                else                     mc_grid_move(g, eid, xy[0], xy[1]);
+                if (was != cell) relinked++;
+            }
+        }
+        if (pools->containers != NULL && eid < MC_GRID_MAX_ENTITIES) {
+            relinked += (uint32_t)mc_container_sync(pools->containers, eid);
+        }
+    }
+    return relinked;
+}
+
+static void mc_cmd_flush_pools(CommandBuffer* buf, CmdPools* pools) {
+    EntityID moved[MAX_COMMANDS];
+    uint32_t moved_count = 0;
     uint32_t i;
     buf->applied  = 0;
     buf->rejected = 0;
+    buf->relinked = 0;
 
     for (i = 0; i < buf->count; i++) {
         Command* cmd = &buf->commands[i];
@@ -370,17 +620,17 @@ static void mc_cmd_flush(CommandBuffer* buf, PoolPtrs* pools) {
 
         switch (cmd->type) {
             case CMD_DAMAGE_LAYER:
-                result = mc_apply_damage_layer(cmd, pools->layers);
+                result = mc_apply_damage_layer(cmd, &pools->layers);
                 break;
 
             case CMD_CRIT_DAMAGE:
-                result = mc_apply_crit_damage(cmd, pools->layers);
+                result = mc_apply_crit_damage(cmd, &pools->layers);
                 break;
 
             case CMD_MODIFY_STAT:
                 /* Phase 0.3: stat modification via generic path.
                  * For now, log only. Full stat system in Phase 0.4. */
-                printf("    >> MODIFY_STAT: eid %u stat %u %s %d <<\n",
+                MC_LOG("    >> MODIFY_STAT: eid %u stat %u %s %d <<\n",
                        cmd->target_entity, cmd->stat_id,
                        cmd->stat_op == OP_ADD ? "+=" :
                        cmd->stat_op == OP_SUBTRACT ? "-=" : "=",
@@ -389,30 +639,36 @@ static void mc_cmd_flush(CommandBuffer* buf, PoolPtrs* pools) {
                 break;
 
             case CMD_TRANSFORM_ENTITY:
-                if (pools->item_defs) {
-                    result = mc_apply_transform(cmd, pools->item_defs);
+                if (mc_cmd__pool_present(&pools->item_defs)) {
+                    result = mc_apply_transform(cmd, &pools->item_defs);
                 } else {
-                    printf("    >> TRANSFORM: eid %u -> def %u (no pool, logged only) <<\n",
+                    MC_LOG("    >> TRANSFORM: eid %u -> def %u (no pool, logged only) <<\n",
                            cmd->target_entity, cmd->new_def_id);
                     result = 0;
                 }
                 break;
 
+            case CMD_MOVE_ENTITY:
+                /* High volume: no per-move log line. Indexes catch up below. */
+                result = mc_apply_move(cmd, &pools->positions, pools->containers);
+                if (result == 0) moved[moved_count++] = cmd->target_entity;
+                break;
+
             case CMD_REMOVE_ENTITY:
-                printf("    >> REMOVE: eid %u <<\n", cmd->target_entity);
+                MC_LOG("    >> REMOVE: eid %u <<\n", cmd->target_entity);
                 /* Phase 0.3: remove from all pools would go here.
                  * For now, log only. */
                 result = 0;
                 break;
 
             case CMD_PLAY_FEEDBACK:
-                printf("    >> FEEDBACK: msg_id %u from eid %u <<\n",
+                MC_LOG("    >> FEEDBACK: msg_id %u from eid %u <<\n",
                        cmd->message_id, cmd->source_entity);
                 result = 0;
                 break;
 
             default:
-                printf("    >> UNKNOWN CMD TYPE %d <<\n", cmd->type);
+                MC_LOG("    >> UNKNOWN CMD TYPE %d <<\n", cmd->type);
                 break;
         }
 
@@ -420,13 +676,18 @@ static void mc_cmd_flush(CommandBuffer* buf, PoolPtrs* pools) {
             buf->applied++;
         } else {
             buf->rejected++;
-            printf("    >> CMD REJECTED: %s on eid %u <<\n",
+            MC_LOG("    >> CMD REJECTED: %s on eid %u <<\n",
                    CMD_TYPE_NAMES[cmd->type], cmd->target_entity);
         }
     }
 
+    if (moved_count > 0) {
+        buf->relinked = mc_cmd__apply_move_batch(pools, moved, moved_count);
+        MC_LOG("  [CMD] Moves: %u applied, %u index relinks\n", moved_count, buf->relinked);
+    }
+
     if (buf->count > 0) {
-        printf("  [CMD] Flush: %u applied, %u rejected (of %u total)\n",
+        MC_LOG("  [CMD] Flush: %u applied, %u rejected (of %u total)\n",
                buf->applied, buf->rejected, buf->count);
     }
 
@@ -434,6 +695,16 @@ static void mc_cmd_flush(CommandBuffer* buf, PoolPtrs* pools) {
     buf->count = 0;
 }
 
+static void mc_cmd_flush(CommandBuffer* buf, PoolPtrs* pools) {
+    CmdPools cp;
+    cp.layers     = mc_cmd_pool_set(pools->layers);
+    cp.item_defs  = mc_cmd_pool_set(pools->item_defs);
+    cp.positions  = mc_cmd_pool_set(pools->positions);
+    cp.grid       = pools->grid;
+    cp.containers = pools->containers;
+    mc_cmd_flush_pools(buf, &cp);
+}
+
 /* =========================================================================
  * SECTION 7: RULE SYSTEM
  *
@@ -29,6 +29,8 @@
 #include <string.h>  /* memcpy, memset */
 #include <stdio.h>   /* printf for tick log — replace with ring buffer later */
 
+#include "marble_hash.h"
+
 /* =========================================================================
  * SECTION 1: CONFIGURATION
  * ========================================================================= */
@@ -40,6 +42,15 @@
 /* Tick rate: 600ms per tick. Stored as microseconds for integer math. */
 #define MC_TICK_INTERVAL_US 600000
 
+/* Simulation log lines (interaction and command results). Define MC_QUIET
+ * before including any engine header to compile them out, e.g. for batch
+ * runs that step thousands of worlds. */
+#ifdef MC_QUIET
+#define MC_LOG(...) ((void)0)
+#else
+#define MC_LOG(...) printf(__VA_ARGS__)
+#endif
+
 /* =========================================================================
  * SECTION 2: ENTITY ID
  * ========================================================================= */
@@ -108,10 +119,16 @@ static uint32_t mc_rng_next(McRng* rng) {
     return z;
 }
 
+/* Map a uniform 32-bit value onto [0, n) by multiply-shift: the high
+ * word of x * n. No division, and the bias is spread evenly across the
+ * range instead of piling onto the low values as x % n does. */
+static uint32_t mc_rng_reduce(uint32_t x, uint32_t n) {
+    return (uint32_t)(((uint64_t)x * (uint64_t)n) >> 32);
+}
+
 /* Returns a value in [0, max_exclusive). */
 static uint32_t mc_rng_range(McRng* rng, uint32_t max_exclusive) {
-    if (max_exclusive == 0) return 0;
-    return mc_rng_next(rng) % max_exclusive;
+    return mc_rng_reduce(mc_rng_next(rng), max_exclusive);
 }
 
 /* Convenience: d100 roll returning 0-99. */
@@ -154,8 +171,43 @@ typedef struct {
 
     /* Count of live entries in dense/data */
     uint32_t count;
+
+    /* Change tracking (consumed by delta saves, marble_delta.h).
+     * dirty: one bit per EntityID whose component was added, removed or
+     *        fetched for writing since the last checkpoint.
+     * structural: nonzero if dense[] order changed (add/remove). */
+    uint32_t dirty[MC_MAX_ENTITIES / 32];
+    uint32_t structural;
+
+    /* State hash: XOR over live rows of mc_sparse_set_row_hash(). Kept
+     * current by add/remove; in-place writes through mc_sparse_set_get()
+     * must be bracketed with mc_sparse_set_hash_out()/_in(). Independent
+     * of dense[] order. */
+    uint64_t hash;
 } SparseSet;
 
+static void mc_sparse_set__touch(SparseSet* ss, EntityID eid) {
+    ss->dirty[eid >> 5] |= 1u << (eid & 31);
+}
+
+/* Forget all tracked changes (called when a checkpoint is written). */
+static void mc_sparse_set_clear_dirty(SparseSet* ss) {
+    memset(ss->dirty, 0, sizeof(ss->dirty));
+    ss->structural = 0;
+}
+
+/* Mark every slot changed -- for bulk loads that bypass add/remove. */
+static void mc_sparse_set_mark_all_dirty(SparseSet* ss) {
+    memset(ss->dirty, 0xFF, sizeof(ss->dirty));
+    ss->structural = 1;
+}
+
+/* Hash of one row: XXH64 of the component bytes, seeded by the EntityID
+ * so equal components on different entities don't cancel out. */
+static uint64_t mc_sparse_set__hash_at(const SparseSet* ss, uint32_t idx) {
+    return mc_hash64(&ss->data[idx * ss->stride], ss->stride, (uint64_t)ss->dense[idx]);
+}
+
 /* Initialize a sparse set for a component type of `stride` bytes.
  * MUST be called before any other operation.
  * stride must be <= 64 (the per-entity data budget in this phase). */
@@ -166,6 +218,8 @@ static void mc_sparse_set_init(SparseSet* ss, uint32_t stride) {
     for (i = 0; i < MC_MAX_ENTITIES; i++) {
         ss->sparse[i] = MC_INVALID_INDEX;
     }
+    mc_sparse_set_clear_dirty(ss);
+    ss->hash = 0;
     /* Dense and data are implicitly valid up to ss->count — no need to zero. */
 }
 
@@ -190,7 +244,10 @@ static int mc_sparse_set_add(SparseSet* ss, EntityID eid, const void* component_
     ss->dense[idx] = eid;
     ss->sparse[eid] = idx;
     memcpy(&ss->data[idx * ss->stride], component_data, ss->stride);
+    ss->hash ^= mc_sparse_set__hash_at(ss, idx);
     ss->count++;
+    mc_sparse_set__touch(ss, eid);
+    ss->structural = 1;
     return 0;
 }
 
@@ -205,6 +262,7 @@ static int mc_sparse_set_remove(SparseSet* ss, EntityID eid) {
     idx_removed = ss->sparse[eid];
     idx_last    = ss->count - 1;
     eid_last    = ss->dense[idx_last];
+    ss->hash ^= mc_sparse_set__hash_at(ss, idx_removed);
 
     /* Move last element into the removed slot */
     ss->dense[idx_removed] = eid_last;
@@ -218,14 +276,19 @@ static int mc_sparse_set_remove(SparseSet* ss, EntityID eid) {
     /* Invalidate removed entity */
     ss->sparse[eid] = MC_INVALID_INDEX;
     ss->count--;
+    mc_sparse_set__touch(ss, eid);
+    ss->structural = 1;
     return 0;
 }
 
 /* Get pointer to component data for entity. Returns NULL if not present.
- * Caller casts to their concrete struct type immediately. */
+ * Caller casts to their concrete struct type immediately.
+ * A mutable fetch marks the entity dirty; read-only code should use
+ * mc_sparse_set_get_const() so it doesn't inflate delta saves. */
 static void* mc_sparse_set_get(SparseSet* ss, EntityID eid) {
     uint32_t idx;
     if (!mc_sparse_set_has(ss, eid)) return NULL;
+    mc_sparse_set__touch(ss, eid);
     idx = ss->sparse[eid];
     return &ss->data[idx * ss->stride];
 }
@@ -238,6 +301,38 @@ static const void* mc_sparse_set_get_const(const SparseSet* ss, EntityID eid) {
     return &ss->data[idx * ss->stride];
 }
 
+/* Row hash for an entity, 0 if absent. */
+static uint64_t mc_sparse_set_row_hash(const SparseSet* ss, EntityID eid) {
+    if (!mc_sparse_set_has(ss, eid)) return 0;
+    return mc_sparse_set__hash_at(ss, ss->sparse[eid]);
+}
+
+/* Bracket an in-place write: hash_out before touching the row, hash_in
+ * after. Both are the same XOR; the names say which side of the write
+ * the call is on. No-ops for absent entities. */
+static void mc_sparse_set_hash_out(SparseSet* ss, EntityID eid) {
+    ss->hash ^= mc_sparse_set_row_hash(ss, eid);
+}
+
+static void mc_sparse_set_hash_in(SparseSet* ss, EntityID eid) {
+    ss->hash ^= mc_sparse_set_row_hash(ss, eid);
+}
+
+/* Recompute from scratch -- for bulk loads that bypass add/remove, and
+ * for debug checks of the incremental value. */
+static uint64_t mc_sparse_set_compute_hash(const SparseSet* ss) {
+    uint64_t h = 0;
+    uint32_t i;
+    for (i = 0; i < ss->count; i++) {
+        h ^= mc_sparse_set__hash_at(ss, i);
+    }
+    return h;
+}
+
+static void mc_sparse_set_rehash(SparseSet* ss) {
+    ss->hash = mc_sparse_set_compute_hash(ss);
+}
+
 /* =========================================================================
  * SECTION 4: TICK LOOP
  *
@@ -249,8 +344,12 @@ static const void* mc_sparse_set_get_const(const SparseSet* ss, EntityID eid) {
  *   2. Run all systems via static dispatch switch (Phase 0: placeholder)
  *   3. Advance tick counter
  *
- * The loop does NOT free-spin. It yields to the OS between ticks.
- * On Windows: Sleep(). On other platforms: nanosleep().
+ * The loop does NOT free-spin. It sleeps to an absolute deadline
+ * (mc_platform_sleep_until_us) and spins only the last stretch.
+ *
+ * TickJitter records how late each tick started against its ideal
+ * start, in 1 us buckets, so p99 lateness is exact to the microsecond
+ * up to MC_JITTER_BUCKETS - 1 us.
  * ========================================================================= */
 
 typedef struct {
@@ -265,6 +364,48 @@ static void mc_tick_state_init(TickState* ts, uint64_t now_us) {
     ts->last_time_us   = now_us;
 }
 
+#define MC_JITTER_BUCKETS 1024   /* 1 us each; the last one is ">= 1023 us" */
+
+typedef struct {
+    uint32_t hist[MC_JITTER_BUCKETS];
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t catchup_ticks;   /* ticks run back-to-back to catch up */
+} TickJitter;
+
+static void mc_tick_jitter_init(TickJitter* j) {
+    memset(j, 0, sizeof(TickJitter));
+}
+
+/* late_us: how long after its ideal start the tick actually started */
+static void mc_tick_jitter_record(TickJitter* j, uint64_t late_us) {
+    uint64_t b = (late_us < MC_JITTER_BUCKETS - 1) ? late_us : MC_JITTER_BUCKETS - 1;
+    j->hist[b]++;
+    j->count++;
+    j->sum_us += late_us;
+    if (late_us > j->max_us) j->max_us = late_us;
+}
+
+/* Lateness at quantile q (0..1) in us; max_us if it falls in the
+ * overflow bucket. */
+static uint64_t mc_tick_jitter_quantile(const TickJitter* j, double q) {
+    uint64_t rank, seen = 0;
+    uint32_t b;
+    if (j->count == 0) return 0;
+    rank = (uint64_t)(q * (double)j->count);
+    if (rank >= j->count) rank = j->count - 1;
+    for (b = 0; b < MC_JITTER_BUCKETS - 1; b++) {
+        seen += j->hist[b];
+        if (seen > rank) return b;
+    }
+    return j->max_us;
+}
+
+static uint64_t mc_tick_jitter_mean(const TickJitter* j) {
+    return (j->count > 0) ? j->sum_us / j->count : 0;
+}
+
 /* =========================================================================
  * SECTION 5: SYSTEM OP CODES (static dispatch)
  *
@@ -0,0 +1,469 @@
+/*
+ * marble_craft.h -- Crafting Recipe Table + Indexed Matcher (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Answer "what can this player craft right now?" without scanning
+ *   every recipe against every inventory item.
+ *
+ * ARCHITECTURE:
+ *   1. RECIPE TABLE -- static, immutable. Compiled from .marble `recipe`
+ *      blocks by marble_compile.lua (GEN_RECIPES[]) or built in code.
+ *      Each ingredient is either a specific item def or an ItemTag:
+ *        recipe IronSword {
+ *            output 1                -- Rusty Sword def
+ *            yield  1
+ *            item   951 count 2      -- two Iron Bars
+ *            tag    Leather count 1  -- any leather item
+ *        }
+ *
+ *   2. RECIPE INDEX -- built once after the table is loaded. Every recipe
+ *      is filed under exactly ONE key: its rarest ingredient. A specific
+ *      def is always rarer than a tag; between tags, the tag carried by
+ *      the fewest item defs wins. Posting lists are stored CSR-style
+ *      (offsets + packed recipe indices), no pointers.
+ *
+ *   3. COUNT VECTOR -- built once per query from the inventory:
+ *      per-def counts (open-addressed hash) + per-tag counts (32 bins).
+ *
+ *   4. MATCH -- walk only the posting lists of keys the inventory
+ *      actually holds. A recipe whose rarest ingredient is absent is
+ *      never touched. Each candidate is verified against the count
+ *      vector in O(ingredients).
+ *
+ *   Cost: O(distinct defs + candidates * ingredients), independent of
+ *   the total number of recipes.
+ *
+ * OVERLAP RULE:
+ *   Counts are checked, not allocated, but one item never fills two
+ *   ingredient slots of the same recipe. Def ingredients claim their
+ *   items first; what is left is the supply for the tag ingredients.
+ *   With one tag ingredient that is a subtraction. With several, an
+ *   item may carry more than one of the wanted tags, so every subset
+ *   of tag ingredients is checked against the items that could fill
+ *   it (Hall's condition: at most 2^6 - 1 subsets).
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_CRAFT_H
+#define MARBLE_CRAFT_H
+
+#include "marble_core.h"
+#include "marble_cmd.h"
+#include "marble_items.h"
+#include "marble_recipe.h"
+
+/* =========================================================================
+ * SECTION 1: CONFIGURATION
+ * ========================================================================= */
+
+#define MAX_RECIPES               256
+#define MC_CRAFT_TAG_BITS         32
+
+/* Inventory count vector: distinct defs per query, hash must be a
+ * power of two and at least 2x MC_CRAFT_MAX_INV_DEFS. */
+#define MC_CRAFT_MAX_INV_DEFS     256
+#define MC_CRAFT_INV_HASH         512
+
+/* =========================================================================
+ * SECTION 2: RECIPE TABLE
+ *
+ * RecipeDef lives in marble_recipe.h, which the GEN_RECIPES[] table
+ * emitted by marble_compile.lua includes too.
+ * ========================================================================= */
+
+typedef struct {
+    RecipeDef recipes[MAX_RECIPES];
+    uint32_t  count;
+} RecipeTable;
+
+static void mc_recipe_table_init(RecipeTable* table) {
+    table->count = 0;
+}
+
+/* Add a recipe. Returns 0 on success, -1 if the table is full or the
+ * recipe is malformed (no ingredients, zero count, multi-bit tag). */
+static int mc_recipe_table_add(RecipeTable* table, const RecipeDef* def) {
+    uint32_t i;
+    if (table->count >= MAX_RECIPES) return -1;
+    if (def->ingredient_count == 0 || def->ingredient_count > MAX_RECIPE_INGREDIENTS) return -1;
+    for (i = 0; i < def->ingredient_count; i++) {
+        const RecipeIngredient* ing = &def->ingredients[i];
+        if (ing->count == 0) return -1;
+        if (ing->kind == RECIPE_ING_TAG) {
+            if (ing->key == 0 || (ing->key & (ing->key - 1)) != 0) return -1;
+        }
+    }
+    table->recipes[table->count] = *def;
+    table->count++;
+    return 0;
+}
+
+/* Bulk-load a compiled table (e.g. GEN_RECIPES). Returns recipes loaded. */
+static uint32_t mc_recipe_table_load(RecipeTable* table, const RecipeDef* defs, uint32_t n) {
+    uint32_t i, loaded = 0;
+    for (i = 0; i < n; i++) {
+        if (mc_recipe_table_add(table, &defs[i]) == 0) loaded++;
+    }
+    return loaded;
+}
+
+/* Index of the lowest set bit. `bit` must be non-zero. */
+static uint32_t mc_craft_tag_index(uint32_t bit) {
+    uint32_t idx = 0;
+    while ((bit & 1u) == 0 && idx < MC_CRAFT_TAG_BITS) {
+        bit >>= 1;
+        idx++;
+    }
+    return idx;
+}
+
+/* =========================================================================
+ * SECTION 3: RECIPE INDEX
+ *
+ * Posting list for def key k:  entries[def_offsets[k] .. def_offsets[k+1])
+ * Posting list for tag bit b:  entries[tag_offsets[b] .. tag_offsets[b+1])
+ * def_keys[] is sorted so a lookup is a binary search.
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t def_keys[MAX_RECIPES];
+    uint32_t def_offsets[MAX_RECIPES + 1];
+    uint32_t def_key_count;
+
+    uint32_t tag_offsets[MC_CRAFT_TAG_BITS + 1];
+
+    uint16_t def_entries[MAX_RECIPES];
+    uint16_t tag_entries[MAX_RECIPES];
+} RecipeIndex;
+
+/* Choose the ingredient a recipe is filed under. `tag_freq` is the number
+ * of item defs carrying each tag (all-equal if no item table is known). */
+static uint32_t mc_craft__rarest(const RecipeDef* r, const uint32_t* tag_freq) {
+    uint32_t i, best = 0;
+    uint32_t best_cost = UINT32_MAX;
+    for (i = 0; i < r->ingredient_count; i++) {
+        const RecipeIngredient* ing = &r->ingredients[i];
+        uint32_t cost;
+        if (ing->kind == RECIPE_ING_ITEM) {
+            cost = 0;  /* a specific def beats any tag */
+        } else {
+            cost = 1 + tag_freq[mc_craft_tag_index(ing->key)];
+        }
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/* Build the index. `items` may be NULL; it is only used to rank tags by
+ * how many item defs carry them. */
+static void mc_craft_index_build(
+    RecipeIndex* idx, const RecipeTable* table, const ItemDefTable* items
+) {
+    uint32_t tag_freq[MC_CRAFT_TAG_BITS];
+    uint32_t key_of[MAX_RECIPES];     /* def_id or tag index per recipe */
+    uint8_t  is_tag[MAX_RECIPES];
+    uint32_t tag_fill[MC_CRAFT_TAG_BITS];
+    uint32_t i, b;
+
+    memset(tag_freq, 0, sizeof(tag_freq));
+    if (items != NULL) {
+        for (i = 0; i < items->count; i++) {
+            for (b = 0; b < MC_CRAFT_TAG_BITS; b++) {
+                if (items->defs[i].tags & (1u << b)) tag_freq[b]++;
+            }
+        }
+    }
+
+    /* 1. Pick each recipe's key */
+    for (i = 0; i < table->count; i++) {
+        const RecipeIngredient* ing =
+            &table->recipes[i].ingredients[mc_craft__rarest(&table->recipes[i], tag_freq)];
+        is_tag[i] = (ing->kind == RECIPE_ING_TAG) ? 1 : 0;
+        key_of[i] = is_tag[i] ? mc_craft_tag_index(ing->key) : ing->key;
+    }
+
+    /* 2. Distinct def keys, sorted (insertion sort: bounded by MAX_RECIPES) */
+    idx->def_key_count = 0;
+    for (i = 0; i < table->count; i++) {
+        uint32_t k, pos;
+        int dup = 0;
+        if (is_tag[i]) continue;
+        for (k = 0; k < idx->def_key_count; k++) {
+            if (idx->def_keys[k] == key_of[i]) { dup = 1; break; }
+        }
+        if (dup) continue;
+        pos = idx->def_key_count;
+        while (pos > 0 && idx->def_keys[pos - 1] > key_of[i]) {
+            idx->def_keys[pos] = idx->def_keys[pos - 1];
+            pos--;
+        }
+        idx->def_keys[pos] = key_of[i];
+        idx->def_key_count++;
+    }
+
+    /* 3. Counting sort into CSR posting lists. Recipes keep table order
+     *    within a list, so match output order is deterministic. */
+    memset(idx->def_offsets, 0, sizeof(idx->def_offsets));
+    memset(idx->tag_offsets, 0, sizeof(idx->tag_offsets));
+    for (i = 0; i < table->count; i++) {
+        if (is_tag[i]) {
+            idx->tag_offsets[key_of[i] + 1]++;
+        } else {
+            uint32_t lo = 0, hi = idx->def_key_count;
+            while (lo < hi) {
+                uint32_t mid = (lo + hi) / 2;
+                if (idx->def_keys[mid] < key_of[i]) lo = mid + 1; else hi = mid;
+            }
+            key_of[i] = lo;  /* now the slot in def_keys[] */
+            idx->def_offsets[lo + 1]++;
+        }
+    }
+    for (i = 0; i < idx->def_key_count; i++) {
+        idx->def_offsets[i + 1] += idx->def_offsets[i];
+    }
+    for (b = 0; b < MC_CRAFT_TAG_BITS; b++) {
+        idx->tag_offsets[b + 1] += idx->tag_offsets[b];
+        tag_fill[b] = idx->tag_offsets[b];
+    }
+    {
+        uint32_t def_fill[MAX_RECIPES];
+        for (i = 0; i < idx->def_key_count; i++) def_fill[i] = idx->def_offsets[i];
+        for (i = 0; i < table->count; i++) {
+            if (is_tag[i]) idx->tag_entries[tag_fill[key_of[i]]++] = (uint16_t)i;
+            else           idx->def_entries[def_fill[key_of[i]]++] = (uint16_t)i;
+        }
+    }
+}
+
+/* =========================================================================
+ * SECTION 4: INVENTORY COUNT VECTOR
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t hash_keys[MC_CRAFT_INV_HASH];   /* def_id, or MC_INVALID_INDEX */
+    uint32_t hash_counts[MC_CRAFT_INV_HASH];
+    uint32_t hash_tags[MC_CRAFT_INV_HASH];
+
+    uint32_t defs[MC_CRAFT_MAX_INV_DEFS];    /* distinct def_ids, insertion order */
+    uint32_t def_count;
+
+    uint32_t tag_counts[MC_CRAFT_TAG_BITS];
+    uint32_t tag_present;                    /* bit b set if tag_counts[b] > 0 */
+} CraftCounts;
+
+static void mc_craft_counts_init(CraftCounts* c) {
+    memset(c->hash_keys, 0xFF, sizeof(c->hash_keys));
+    memset(c->tag_counts, 0, sizeof(c->tag_counts));
+    c->def_count   = 0;
+    c->tag_present = 0;
+}
+
+static uint32_t mc_craft__slot(const CraftCounts* c, uint32_t def_id) {
+    uint32_t h = (def_id * 2654435761u) & (MC_CRAFT_INV_HASH - 1);
+    uint32_t probes = 0;
+    while (c->hash_keys[h] != MC_INVALID_INDEX && c->hash_keys[h] != def_id
+           && probes < MC_CRAFT_INV_HASH) {
+        h = (h + 1) & (MC_CRAFT_INV_HASH - 1);
+        probes++;
+    }
+    return h;
+}
+
+/* Count of `def_id` held. */
+static uint32_t mc_craft_counts_get(const CraftCounts* c, uint32_t def_id) {
+    uint32_t h = mc_craft__slot(c, def_id);
+    return (c->hash_keys[h] == def_id) ? c->hash_counts[h] : 0;
+}
+
+/* Add `n` items of `def_id` carrying `tags`.
+ * Returns 0 on success, -1 if the distinct-def budget is exhausted. */
+static int mc_craft_counts_add(CraftCounts* c, uint32_t def_id, uint32_t tags, uint32_t n) {
+    uint32_t h = mc_craft__slot(c, def_id);
+    uint32_t b;
+
+    if (c->hash_keys[h] != def_id) {
+        if (c->def_count >= MC_CRAFT_MAX_INV_DEFS) return -1;
+        c->hash_keys[h]   = def_id;
+        c->hash_counts[h] = 0;
+        c->hash_tags[h]   = tags;
+        c->defs[c->def_count++] = def_id;
+    }
+    c->hash_counts[h] += n;
+
+    for (b = 0; tags != 0 && b < MC_CRAFT_TAG_BITS; b++) {
+        if (tags & (1u << b)) {
+            c->tag_counts[b] += n;
+            tags &= ~(1u << b);
+        }
+    }
+    c->tag_present |= c->hash_tags[h];
+    return 0;
+}
+
+/* Build from an inventory of (def_id, stack count) pairs, resolving tags
+ * through the item table once per distinct def. Returns 0, or -1 if the
+ * inventory holds more than MC_CRAFT_MAX_INV_DEFS distinct defs; the
+ * excess defs are left out, so the caller should not trust the matches. */
+static int mc_craft_counts_from_inventory(
+    CraftCounts* c, const ItemDefTable* items,
+    const uint32_t* def_ids, const uint32_t* stack_counts, uint32_t n
+) {
+    uint32_t i;
+    int rc = 0;
+    mc_craft_counts_init(c);
+    for (i = 0; i < n; i++) {
+        uint32_t h = mc_craft__slot(c, def_ids[i]);
+        uint32_t tags;
+        if (c->hash_keys[h] == def_ids[i]) {
+            tags = c->hash_tags[h];
+        } else {
+            const ItemDef* def = mc_item_table_get(items, def_ids[i]);
+            tags = (def != NULL) ? def->tags : 0;
+        }
+        if (mc_craft_counts_add(c, def_ids[i], tags,
+                                stack_counts != NULL ? stack_counts[i] : 1) != 0) rc = -1;
+    }
+    return rc;
+}
+
+/* =========================================================================
+ * SECTION 5: MATCHING
+ * ========================================================================= */
+
+/* Items of `def_id` claimed by the def ingredients of `r` */
+static uint32_t mc_craft__claimed(const RecipeDef* r, uint32_t def_id) {
+    uint32_t i, n = 0;
+    for (i = 0; i < r->ingredient_count; i++) {
+        if (r->ingredients[i].kind == RECIPE_ING_ITEM && r->ingredients[i].key == def_id) {
+            n += r->ingredients[i].count;
+        }
+    }
+    return n;
+}
+
+/* Two or more tag ingredients: can they be filled from distinct items?
+ * supply[m] is the number of unclaimed items whose tags hit exactly the
+ * set m of tag ingredients; subset S is fillable only if the items
+ * hitting any ingredient in S cover the total count S needs. */
+static int mc_craft__tags_fit(const RecipeDef* r, const CraftCounts* c) {
+    uint64_t supply[1u << MAX_RECIPE_INGREDIENTS];
+    uint32_t bits[MAX_RECIPE_INGREDIENTS], need[MAX_RECIPE_INGREDIENTS];
+    uint32_t i, k, nt = 0, set, m;
+
+    for (i = 0; i < r->ingredient_count; i++) {
+        if (r->ingredients[i].kind != RECIPE_ING_TAG) continue;
+        bits[nt] = r->ingredients[i].key;
+        need[nt] = r->ingredients[i].count;
+        nt++;
+    }
+    memset(supply, 0, sizeof(uint64_t) << nt);
+    for (i = 0; i < c->def_count; i++) {
+        uint32_t h = mc_craft__slot(c, c->defs[i]);
+        uint32_t claimed = mc_craft__claimed(r, c->defs[i]);
+        if (c->hash_counts[h] <= claimed) continue;
+        for (k = 0, m = 0; k < nt; k++) {
+            if (c->hash_tags[h] & bits[k]) m |= 1u << k;
+        }
+        if (m != 0) supply[m] += c->hash_counts[h] - claimed;
+    }
+    for (set = 1; set < (1u << nt); set++) {
+        uint64_t want = 0, have = 0;
+        for (k = 0; k < nt; k++) {
+            if (set & (1u << k)) want += need[k];
+        }
+        for (m = 1; m < (1u << nt); m++) {
+            if (m & set) have += supply[m];
+        }
+        if (have < want) return 0;
+    }
+    return 1;
+}
+
+/* Returns 1 if the count vector satisfies every ingredient of `r`. */
+static int mc_craft_can_craft(const RecipeDef* r, const CraftCounts* c) {
+    uint32_t i, j, tag_ings = 0;
+    for (i = 0; i < r->ingredient_count; i++) {
+        const RecipeIngredient* ing = &r->ingredients[i];
+        if (ing->kind == RECIPE_ING_TAG) {
+            tag_ings++;
+        } else if (mc_craft_counts_get(c, ing->key) < mc_craft__claimed(r, ing->key)) {
+            return 0;
+        }
+    }
+    if (tag_ings > 1) return mc_craft__tags_fit(r, c);
+    for (i = 0; i < r->ingredient_count; i++) {
+        const RecipeIngredient* ing = &r->ingredients[i];
+        uint32_t have, reserved = 0;
+        if (ing->kind != RECIPE_ING_TAG) continue;
+        have = c->tag_counts[mc_craft_tag_index(ing->key)];
+        /* Items already claimed by a def ingredient don't count twice */
+        for (j = 0; j < r->ingredient_count; j++) {
+            const RecipeIngredient* other = &r->ingredients[j];
+            if (other->kind != RECIPE_ING_ITEM) continue;
+            {
+                uint32_t h = mc_craft__slot(c, other->key);
+                if (c->hash_keys[h] == other->key && (c->hash_tags[h] & ing->key)) {
+                    reserved += other->count;
+                }
+            }
+        }
+        if (have < reserved || have - reserved < ing->count) return 0;
+    }
+    return 1;
+}
+
+/* List every craftable recipe. Writes recipe TABLE INDICES (ascending)
+ * into `out`, up to `cap`. Returns the number of craftable recipes
+ * (which may exceed `cap`; only the first `cap` are written). */
+static uint32_t mc_craft_find_craftable(
+    const RecipeIndex* idx, const RecipeTable* table,
+    const CraftCounts* c, uint32_t* out, uint32_t cap
+) {
+    uint32_t hits[(MAX_RECIPES + 31) / 32];
+    uint32_t i, e, b, found = 0;
+
+    memset(hits, 0, sizeof(hits));
+
+    /* Candidates keyed by a def the inventory holds */
+    for (i = 0; i < c->def_count; i++) {
+        uint32_t lo = 0, hi = idx->def_key_count;
+        uint32_t def_id = c->defs[i];
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (idx->def_keys[mid] < def_id) lo = mid + 1; else hi = mid;
+        }
+        if (lo >= idx->def_key_count || idx->def_keys[lo] != def_id) continue;
+        for (e = idx->def_offsets[lo]; e < idx->def_offsets[lo + 1]; e++) {
+            uint32_t r = idx->def_entries[e];
+            if (mc_craft_can_craft(&table->recipes[r], c)) hits[r >> 5] |= 1u << (r & 31);
+        }
+    }
+
+    /* Candidates keyed by a tag the inventory holds */
+    for (b = 0; b < MC_CRAFT_TAG_BITS; b++) {
+        if (!(c->tag_present & (1u << b))) continue;
+        for (e = idx->tag_offsets[b]; e < idx->tag_offsets[b + 1]; e++) {
+            uint32_t r = idx->tag_entries[e];
+            if (mc_craft_can_craft(&table->recipes[r], c)) hits[r >> 5] |= 1u << (r & 31);
+        }
+    }
+
+    /* Emit in table order */
+    for (i = 0; i < (MAX_RECIPES + 31) / 32; i++) {
+        uint32_t word = hits[i];
+        for (b = 0; word != 0 && b < 32; b++) {
+            if (word & (1u << b)) {
+                if (found < cap) out[found] = i * 32 + b;
+                found++;
+                word &= ~(1u << b);
+            }
+        }
+    }
+    return found;
+}
+
+#endif /* MARBLE_CRAFT_H */
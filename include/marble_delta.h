@@ -0,0 +1,666 @@
+/*
+ * marble_delta.h -- Incremental Delta Saves (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Checkpoint a world at a cost proportional to what changed, not to
+ *   how big the world is. A chain is one full base save (marble_save.h)
+ *   followed by deltas, each holding only what changed since the
+ *   previous checkpoint:
+ *
+ *     base.msav  ->  d1.mdlt  ->  d2.mdlt  ->  ...  ->  dN.mdlt
+ *
+ *   Loading composes them in order. A new base is written periodically
+ *   to bound chain length (and load time).
+ *
+ * CHANGE TRACKING:
+ *   Nothing is diffed. SparseSet keeps a dirty bit per EntityID, set by
+ *   mc_sparse_set_add / _remove / mutable _get -- and the command flush
+ *   applicators only mutate through those, so every gameplay write is
+ *   seen. TimerWheel keeps a dirty bit per node, set by its list ops.
+ *   Writing a checkpoint clears the bits.
+ *
+ * WHAT A DELTA HOLDS:
+ *   - ALOC / TICK / RNG       always (a few bytes)
+ *   - PDLT per changed pool   upserts (eid + data), removals (eid) and,
+ *                             only if adds/removes happened, the new
+ *                             dense[] order -- so iteration order after
+ *                             loading matches the live world exactly
+ *   - TDLT if timers exist    wheel scalars, slot heads/tails, and the
+ *                             nodes touched since the last checkpoint
+ *
+ * FILES:
+ *   mc_world_save_delta_file() optionally writes the delta as an LZ frame
+ *   (marble_lz.h); a chain of small deltas compresses well because the
+ *   upsert rows of one pool sit next to each other.
+ *
+ * CHAIN SAFETY:
+ *   Every delta carries the base's checksum and its sequence number. A
+ *   delta applied to the wrong base or out of order is rejected before
+ *   the world is touched.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_DELTA_H
+#define MARBLE_DELTA_H
+
+#include "marble_save.h"
+
+/* =========================================================================
+ * SECTION 1: FORMAT
+ * ========================================================================= */
+
+#define MC_DELTA_MAGIC      0x544C444Du   /* "MDLT" */
+#define MC_DELTA_VERSION    1
+
+#define MC_DELTA_TAG_POOL   0x544C4450u   /* "PDLT" */
+#define MC_DELTA_TAG_TIMERS 0x544C4454u   /* "TDLT" */
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t base_id;       /* checksum of the base save this chain starts from */
+    uint32_t seq;           /* 1 for the first delta after the base */
+    uint32_t chunk_count;
+    uint32_t total_size;
+} DeltaHeader;
+
+typedef struct {
+    uint32_t stride;
+    uint32_t count;         /* live entries after applying */
+    uint32_t upsert_count;  /* eid[] then data[] */
+    uint32_t remove_count;  /* eid[] */
+    uint32_t has_order;     /* 1: dense[count] follows */
+    uint32_t reserved;
+} DeltaPoolHeader;
+
+typedef struct {
+    uint64_t current_tick;
+    uint32_t free_head;
+    uint32_t count;
+    uint32_t dropped;
+    uint32_t fired;
+    uint32_t node_count;
+    uint32_t reserved;
+} DeltaTimerHeader;
+
+typedef struct {
+    uint32_t  index;
+    uint32_t  reserved;
+    TimerNode node;
+} DeltaTimerNode;
+
+#define MC_DELTA_TIMER_SLOTS (MC_TIMER_WHEEL_LEVELS * MC_TIMER_WHEEL_SLOTS)
+
+/* Where a chain stands: which base, and how many deltas applied/written */
+typedef struct {
+    uint32_t base_id;
+    uint32_t seq;
+} DeltaChain;
+
+static uint32_t mc_delta__fnv1a(const uint8_t* bytes, uint32_t len) {
+    uint32_t h = 2166136261u;
+    uint32_t i;
+    for (i = 0; i < len; i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t mc_delta__popcount(const uint32_t* bits, uint32_t words) {
+    uint32_t i, n = 0;
+    for (i = 0; i < words; i++) {
+        uint32_t v = bits[i];
+        while (v != 0) {
+            v &= v - 1;
+            n++;
+        }
+    }
+    return n;
+}
+
+static void mc_delta__clear_tracking(WorldRefs* w) {
+    uint32_t p;
+    for (p = 0; p < w->pool_count; p++) {
+        mc_sparse_set_clear_dirty(w->pools[p]);
+    }
+    if (w->timers != NULL) mc_timer_wheel_clear_dirty(w->timers);
+}
+
+/* =========================================================================
+ * SECTION 2: BASE CHECKPOINTS
+ * ========================================================================= */
+
+/* Full save that starts a new chain. Returns bytes written, 0 if `cap`
+ * is too small. */
+static uint32_t mc_world_save_base(WorldRefs* w, DeltaChain* chain, uint8_t* out, uint32_t cap) {
+    uint32_t len = mc_world_save(w, out, cap);
+    if (len == 0) return 0;
+    chain->base_id = mc_delta__fnv1a(out, len);
+    chain->seq     = 0;
+    mc_delta__clear_tracking(w);
+    return len;
+}
+
+/* Load a base save and start composing its chain. */
+static int mc_world_load_base(WorldRefs* w, DeltaChain* chain, const uint8_t* in, uint32_t len) {
+    if (mc_world_load(w, in, len) != 0) return -1;
+    chain->base_id = mc_delta__fnv1a(in, len);
+    chain->seq     = 0;
+    mc_delta__clear_tracking(w);
+    return 0;
+}
+
+/* =========================================================================
+ * SECTION 3: DELTA SAVE
+ * ========================================================================= */
+
+static uint32_t mc_delta__pool_payload(const SparseSet* ss) {
+    uint32_t dirty = mc_delta__popcount(ss->dirty, MC_MAX_ENTITIES / 32);
+    uint32_t upserts = 0, e;
+    for (e = 0; e < MC_MAX_ENTITIES; e++) {
+        if ((ss->dirty[e >> 5] & (1u << (e & 31))) && mc_sparse_set_has(ss, e)) upserts++;
+    }
+    return (uint32_t)sizeof(DeltaPoolHeader)
+         + upserts * ((uint32_t)sizeof(EntityID) + ss->stride)
+         + (dirty - upserts) * (uint32_t)sizeof(EntityID)
+         + (ss->structural ? ss->count * (uint32_t)sizeof(EntityID) : 0);
+}
+
+static uint32_t mc_delta__timer_payload(const TimerWheel* tw) {
+    return (uint32_t)sizeof(DeltaTimerHeader)
+         + 2u * MC_DELTA_TIMER_SLOTS * (uint32_t)sizeof(uint32_t)
+         + mc_delta__popcount(tw->dirty, MC_MAX_TIMERS / 32) * (uint32_t)sizeof(DeltaTimerNode);
+}
+
+static int mc_delta__pool_changed(const SparseSet* ss) {
+    uint32_t i;
+    if (ss->structural) return 1;
+    for (i = 0; i < MC_MAX_ENTITIES / 32; i++) {
+        if (ss->dirty[i] != 0) return 1;
+    }
+    return 0;
+}
+
+/* Exact size mc_world_save_delta() will produce right now. */
+static uint32_t mc_world_save_delta_size(const WorldRefs* w) {
+    uint32_t size = (uint32_t)sizeof(DeltaHeader);
+    uint32_t p;
+    size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8((uint32_t)sizeof(EntityID));
+    size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8((uint32_t)sizeof(SaveTickPayload));
+    size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8((uint32_t)sizeof(McRng));
+    for (p = 0; p < w->pool_count; p++) {
+        if (!mc_delta__pool_changed(w->pools[p])) continue;
+        size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8(mc_delta__pool_payload(w->pools[p]));
+    }
+    if (w->timers != NULL) {
+        size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8(mc_delta__timer_payload(w->timers));
+    }
+    return size;
+}
+
+/* Serialize the next delta without committing it (chain and tracking
+ * untouched). */
+static uint32_t mc_delta__write(const WorldRefs* w, const DeltaChain* chain, uint8_t* out, uint32_t cap) {
+    DeltaHeader hdr;
+    SaveTickPayload tp;
+    uint32_t size = mc_world_save_delta_size(w);
+    uint32_t off = (uint32_t)sizeof(DeltaHeader);
+    uint32_t chunks = 0;
+    uint32_t p, e;
+
+    if (size > cap) return 0;
+    memset(out, 0, size);
+
+    off = mc_save__chunk(out, off, MC_SAVE_TAG_ALLOC, 0, (uint32_t)sizeof(EntityID));
+    memcpy(out + off, &w->alloc->next_id, sizeof(EntityID));
+    off += mc_save__pad8((uint32_t)sizeof(EntityID));
+    chunks++;
+
+    tp.tick_number    = w->tick->tick_number;
+    tp.accumulated_us = w->tick->accumulated_us;
+    off = mc_save__chunk(out, off, MC_SAVE_TAG_TICK, 0, (uint32_t)sizeof(tp));
+    memcpy(out + off, &tp, sizeof(tp));
+    off += mc_save__pad8((uint32_t)sizeof(tp));
+    chunks++;
+
+    off = mc_save__chunk(out, off, MC_SAVE_TAG_RNG, 0, (uint32_t)sizeof(McRng));
+    memcpy(out + off, w->rng, sizeof(McRng));
+    off += mc_save__pad8((uint32_t)sizeof(McRng));
+    chunks++;
+
+    for (p = 0; p < w->pool_count; p++) {
+        const SparseSet* ss = w->pools[p];
+        uint32_t payload, end, eid_off, data_off, rem_off;
+        DeltaPoolHeader ph;
+        if (!mc_delta__pool_changed(ss)) continue;
+
+        payload = mc_delta__pool_payload(ss);
+        off = mc_save__chunk(out, off, MC_DELTA_TAG_POOL, p, payload);
+        end = off + mc_save__pad8(payload);
+
+        memset(&ph, 0, sizeof(ph));
+        ph.stride    = ss->stride;
+        ph.count     = ss->count;
+        ph.has_order = ss->structural ? 1u : 0u;
+        for (e = 0; e < MC_MAX_ENTITIES; e++) {
+            if (!(ss->dirty[e >> 5] & (1u << (e & 31)))) continue;
+            if (mc_sparse_set_has(ss, e)) ph.upsert_count++;
+            else                          ph.remove_count++;
+        }
+        memcpy(out + off, &ph, sizeof(ph));
+
+        eid_off  = off + (uint32_t)sizeof(ph);
+        data_off = eid_off + ph.upsert_count * (uint32_t)sizeof(EntityID);
+        rem_off  = data_off + ph.upsert_count * ss->stride;
+        for (e = 0; e < MC_MAX_ENTITIES; e++) {
+            if (!(ss->dirty[e >> 5] & (1u << (e & 31)))) continue;
+            if (mc_sparse_set_has(ss, e)) {
+                memcpy(out + eid_off, &e, sizeof(EntityID));
+                memcpy(out + data_off, mc_sparse_set_get_const(ss, e), ss->stride);
+                eid_off  += (uint32_t)sizeof(EntityID);
+                data_off += ss->stride;
+            } else {
+                memcpy(out + rem_off, &e, sizeof(EntityID));
+                rem_off += (uint32_t)sizeof(EntityID);
+            }
+        }
+        if (ph.has_order) {
+            memcpy(out + rem_off, ss->dense, ss->count * sizeof(EntityID));
+        }
+        off = end;
+        chunks++;
+    }
+
+    if (w->timers != NULL) {
+        const TimerWheel* tw = w->timers;
+        uint32_t payload = mc_delta__timer_payload(tw);
+        DeltaTimerHeader th;
+        uint32_t n;
+        off = mc_save__chunk(out, off, MC_DELTA_TAG_TIMERS, 0, payload);
+
+        memset(&th, 0, sizeof(th));
+        th.current_tick = tw->current_tick;
+        th.free_head    = tw->free_head;
+        th.count        = tw->count;
+        th.dropped      = tw->dropped;
+        th.fired        = tw->fired;
+        th.node_count   = mc_delta__popcount(tw->dirty, MC_MAX_TIMERS / 32);
+        memcpy(out + off, &th, sizeof(th));
+        off += (uint32_t)sizeof(th);
+        memcpy(out + off, tw->heads, sizeof(tw->heads));
+        off += (uint32_t)sizeof(tw->heads);
+        memcpy(out + off, tw->tails, sizeof(tw->tails));
+        off += (uint32_t)sizeof(tw->tails);
+        for (n = 0; n < MC_MAX_TIMERS; n++) {
+            DeltaTimerNode rec;
+            if (!(tw->dirty[n >> 5] & (1u << (n & 31)))) continue;
+            memset(&rec, 0, sizeof(rec));
+            rec.index = n;
+            rec.node  = tw->nodes[n];
+            memcpy(out + off, &rec, sizeof(rec));
+            off += (uint32_t)sizeof(rec);
+        }
+        off = mc_save__pad8(off);
+        chunks++;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic       = MC_DELTA_MAGIC;
+    hdr.version     = MC_DELTA_VERSION;
+    hdr.header_size = (uint16_t)sizeof(DeltaHeader);
+    hdr.base_id     = chain->base_id;
+    hdr.seq         = chain->seq + 1;
+    hdr.chunk_count = chunks;
+    hdr.total_size  = off;
+    memcpy(out, &hdr, sizeof(hdr));
+    return off;
+}
+
+/* Write everything changed since the last checkpoint and advance the
+ * chain. Returns bytes written, 0 if `cap` is too small (tracking is
+ * left intact so the next attempt still sees every change). */
+static uint32_t mc_world_save_delta(WorldRefs* w, DeltaChain* chain, uint8_t* out, uint32_t cap) {
+    uint32_t len = mc_delta__write(w, chain, out, cap);
+    if (len == 0) return 0;
+    chain->seq++;
+    mc_delta__clear_tracking(w);
+    return len;
+}
+
+/* =========================================================================
+ * SECTION 4: DELTA LOAD
+ * ========================================================================= */
+
+/* Would applying this pool chunk leave `ss` holding exactly the
+ * writer's members (and, with has_order, in a permutation of them)?
+ * Simulated on a membership bitmap; `ss` is not touched. */
+static int mc_delta__pool_fits(const SparseSet* ss, const DeltaPoolHeader* ph,
+                               const uint8_t* eids, const uint8_t* rems) {
+    uint32_t member[MC_MAX_ENTITIES / 32];
+    uint32_t seen[MC_MAX_ENTITIES / 32];
+    uint32_t i, count = ss->count;
+
+    memset(member, 0, sizeof(member));
+    for (i = 0; i < ss->count; i++) member[ss->dense[i] >> 5] |= 1u << (ss->dense[i] & 31);
+
+    for (i = 0; i < ph->remove_count; i++) {
+        EntityID eid;
+        memcpy(&eid, rems + i * sizeof(EntityID), sizeof(eid));
+        if (eid >= MC_MAX_ENTITIES) return -1;
+        if (member[eid >> 5] & (1u << (eid & 31))) {
+            member[eid >> 5] &= ~(1u << (eid & 31));
+            count--;
+        }
+    }
+    for (i = 0; i < ph->upsert_count; i++) {
+        EntityID eid;
+        memcpy(&eid, eids + i * sizeof(EntityID), sizeof(eid));
+        if (!(member[eid >> 5] & (1u << (eid & 31)))) {
+            member[eid >> 5] |= 1u << (eid & 31);
+            count++;
+        }
+    }
+    if (count != ph->count) return -1;
+
+    if (ph->has_order) {
+        const uint8_t* order = rems + ph->remove_count * sizeof(EntityID);
+        memset(seen, 0, sizeof(seen));
+        for (i = 0; i < ph->count; i++) {
+            EntityID eid;
+            memcpy(&eid, order + i * sizeof(EntityID), sizeof(eid));
+            if (eid >= MC_MAX_ENTITIES) return -1;
+            if (!(member[eid >> 5] & (1u << (eid & 31)))) return -1;
+            if (seen[eid >> 5] & (1u << (eid & 31))) return -1;   /* duplicate */
+            seen[eid >> 5] |= 1u << (eid & 31);
+        }
+    }
+    return 0;
+}
+
+/* Check a delta against the chain and the registered world layout
+ * without modifying anything. Returns 0 if it can be applied: every
+ * pool chunk is simulated against the live pool, so a delta from a
+ * different history is refused here rather than half-applied. */
+static int mc_world_delta_validate(
+    const WorldRefs* w, const DeltaChain* chain, const uint8_t* in, uint32_t len
+) {
+    DeltaHeader hdr;
+    uint32_t off, c;
+    uint32_t next_id = 0;
+    uint32_t pool_seen = 0;
+    int have_alloc = 0;
+
+    if (len < sizeof(DeltaHeader)) return -1;
+    memcpy(&hdr, in, sizeof(hdr));
+    if (hdr.magic != MC_DELTA_MAGIC || hdr.version != MC_DELTA_VERSION) return -1;
+    if (hdr.header_size != sizeof(DeltaHeader) || hdr.total_size != len) return -1;
+    if (hdr.base_id != chain->base_id || hdr.seq != chain->seq + 1) return -1;
+
+    off = hdr.header_size;
+    for (c = 0; c < hdr.chunk_count; c++) {
+        SaveChunkHeader ch;
+        const uint8_t* payload;
+        if ((uint64_t)off + sizeof(ch) > len) return -1;
+        memcpy(&ch, in + off, sizeof(ch));
+        off += (uint32_t)sizeof(ch);
+        if ((uint64_t)off + mc_save__pad8(ch.size) > len) return -1;
+        payload = in + off;
+
+        switch (ch.tag) {
+        case MC_SAVE_TAG_ALLOC:
+            if (ch.version != 1 || ch.size != sizeof(EntityID)) return -1;
+            memcpy(&next_id, payload, sizeof(EntityID));
+            if (next_id > MC_MAX_ENTITIES) return -1;
+            have_alloc = 1;
+            break;
+        case MC_SAVE_TAG_TICK:
+            if (ch.version != 1 || ch.size != sizeof(SaveTickPayload)) return -1;
+            break;
+        case MC_SAVE_TAG_RNG:
+            if (ch.version != 1 || ch.size != sizeof(McRng)) return -1;
+            break;
+        case MC_DELTA_TAG_POOL: {
+            DeltaPoolHeader ph;
+            uint32_t i, n;
+            if (ch.version != 1 || !have_alloc || ch.id >= w->pool_count || ch.size < sizeof(ph)) return -1;
+            memcpy(&ph, payload, sizeof(ph));
+            if (ph.stride != w->pools[ch.id]->stride) return -1;
+            if (ph.count > MC_MAX_ENTITIES || ph.upsert_count > MC_MAX_ENTITIES
+                || ph.remove_count > MC_MAX_ENTITIES) return -1;
+            if (ch.size != sizeof(ph)
+                + (uint64_t)ph.upsert_count * (sizeof(EntityID) + ph.stride)
+                + (uint64_t)ph.remove_count * sizeof(EntityID)
+                + (ph.has_order ? (uint64_t)ph.count * sizeof(EntityID) : 0)) return -1;
+            n = ph.upsert_count;
+            for (i = 0; i < n; i++) {
+                EntityID eid;
+                memcpy(&eid, payload + sizeof(ph) + i * sizeof(EntityID), sizeof(eid));
+                if (eid >= next_id) return -1;
+            }
+            /* One chunk per pool: the simulation starts from the live pool */
+            if (pool_seen & (1u << ch.id)) return -1;
+            pool_seen |= 1u << ch.id;
+            if (mc_delta__pool_fits(w->pools[ch.id], &ph, payload + sizeof(ph),
+                                    payload + sizeof(ph) + (size_t)n * (sizeof(EntityID) + ph.stride)) != 0) {
+                return -1;
+            }
+            break;
+        }
+        case MC_DELTA_TAG_TIMERS: {
+            DeltaTimerHeader th;
+            uint32_t i;
+            const uint8_t* recs;
+            if (w->timers == NULL || ch.version != 1 || ch.size < sizeof(th)) return -1;
+            memcpy(&th, payload, sizeof(th));
+            if (th.node_count > MC_MAX_TIMERS || th.count > MC_MAX_TIMERS) return -1;
+            if (ch.size != sizeof(th) + 2u * MC_DELTA_TIMER_SLOTS * sizeof(uint32_t)
+                           + th.node_count * sizeof(DeltaTimerNode)) return -1;
+            /* Every link the wheel will follow, same rules as a full snapshot */
+            if (!mc_timer__link_ok(th.free_head, MC_MAX_TIMERS)) return -1;
+            for (i = 0; i < 2u * MC_DELTA_TIMER_SLOTS; i++) {
+                uint32_t v;
+                memcpy(&v, payload + sizeof(th) + i * sizeof(uint32_t), sizeof(v));
+                if (!mc_timer__link_ok(v, MC_MAX_TIMERS)) return -1;
+            }
+            recs = payload + sizeof(th) + 2u * MC_DELTA_TIMER_SLOTS * sizeof(uint32_t);
+            for (i = 0; i < th.node_count; i++) {
+                DeltaTimerNode rec;
+                memcpy(&rec, recs + i * sizeof(rec), sizeof(rec));
+                if (rec.index >= MC_MAX_TIMERS) return -1;
+                if (!mc_timer__node_links_ok(&rec.node)) return -1;
+            }
+            break;
+        }
+        default:
+            break;  /* unknown chunk: skip */
+        }
+        off += mc_save__pad8(ch.size);
+    }
+    return have_alloc ? 0 : -1;
+}
+
+/* Reorder a pool in place so dense[] matches `order` (count entries).
+ * `order` must be a permutation of the pool's members, which
+ * mc_delta__pool_fits() has checked. */
+static void mc_delta__reorder(SparseSet* ss, const uint8_t* order, uint32_t count) {
+    uint8_t tmp[64];
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        EntityID want;
+        uint32_t j;
+        memcpy(&want, order + i * sizeof(EntityID), sizeof(want));
+        j = ss->sparse[want];
+        if (j != i) {
+            EntityID other = ss->dense[i];
+            memcpy(tmp, &ss->data[i * ss->stride], ss->stride);
+            memcpy(&ss->data[i * ss->stride], &ss->data[j * ss->stride], ss->stride);
+            memcpy(&ss->data[j * ss->stride], tmp, ss->stride);
+            ss->dense[i] = want;
+            ss->dense[j] = other;
+            ss->sparse[want]  = i;
+            ss->sparse[other] = j;
+        }
+    }
+}
+
+/* Apply the next delta in the chain. Returns 0 on success, -1 if it
+ * doesn't belong to this chain/position, is malformed, or was written
+ * from a different history than the loaded world (world untouched:
+ * everything is checked by mc_world_delta_validate() first). Tracking
+ * is cleared afterwards, so the world can keep extending the same
+ * chain with mc_world_save_delta(). */
+static int mc_world_load_delta(WorldRefs* w, DeltaChain* chain, const uint8_t* in, uint32_t len) {
+    DeltaHeader hdr;
+    uint32_t off, c;
+
+    if (mc_world_delta_validate(w, chain, in, len) != 0) return -1;
+    memcpy(&hdr, in, sizeof(hdr));
+
+    off = hdr.header_size;
+    for (c = 0; c < hdr.chunk_count; c++) {
+        SaveChunkHeader ch;
+        const uint8_t* payload;
+        memcpy(&ch, in + off, sizeof(ch));
+        off += (uint32_t)sizeof(ch);
+        payload = in + off;
+
+        switch (ch.tag) {
+        case MC_SAVE_TAG_ALLOC:
+            memcpy(&w->alloc->next_id, payload, sizeof(EntityID));
+            break;
+        case MC_SAVE_TAG_TICK: {
+            SaveTickPayload tp;
+            memcpy(&tp, payload, sizeof(tp));
+            w->tick->tick_number    = tp.tick_number;
+            w->tick->accumulated_us = tp.accumulated_us;
+            break;
+        }
+        case MC_SAVE_TAG_RNG:
+            memcpy(w->rng, payload, sizeof(McRng));
+            break;
+        case MC_DELTA_TAG_POOL: {
+            SparseSet* ss = w->pools[ch.id];
+            DeltaPoolHeader ph;
+            const uint8_t* eids;
+            const uint8_t* data;
+            const uint8_t* rems;
+            uint32_t i;
+            memcpy(&ph, payload, sizeof(ph));
+            eids = payload + sizeof(ph);
+            data = eids + ph.upsert_count * sizeof(EntityID);
+            rems = data + (size_t)ph.upsert_count * ph.stride;
+
+            for (i = 0; i < ph.remove_count; i++) {
+                EntityID eid;
+                memcpy(&eid, rems + i * sizeof(EntityID), sizeof(eid));
+                mc_sparse_set_remove(ss, eid);
+            }
+            for (i = 0; i < ph.upsert_count; i++) {
+                EntityID eid;
+                void* dst;
+                memcpy(&eid, eids + i * sizeof(EntityID), sizeof(eid));
+                dst = mc_sparse_set_get(ss, eid);
+                if (dst != NULL) {
+                    mc_sparse_set_hash_out(ss, eid);
+                    memcpy(dst, data + (size_t)i * ph.stride, ph.stride);
+                    mc_sparse_set_hash_in(ss, eid);
+                } else {
+                    /* Can't fail: validation bounded the pool to ph.count */
+                    (void)mc_sparse_set_add(ss, eid, data + (size_t)i * ph.stride);
+                }
+            }
+            if (ph.has_order) mc_delta__reorder(ss, rems + ph.remove_count * sizeof(EntityID), ph.count);
+            break;
+        }
+        case MC_DELTA_TAG_TIMERS: {
+            TimerWheel* tw = w->timers;
+            DeltaTimerHeader th;
+            const uint8_t* cur = payload;
+            uint32_t i;
+            memcpy(&th, cur, sizeof(th));
+            cur += sizeof(th);
+            tw->current_tick = th.current_tick;
+            tw->free_head    = th.free_head;
+            tw->count        = th.count;
+            tw->dropped      = th.dropped;
+            tw->fired        = th.fired;
+            memcpy(tw->heads, cur, sizeof(tw->heads));
+            cur += sizeof(tw->heads);
+            memcpy(tw->tails, cur, sizeof(tw->tails));
+            cur += sizeof(tw->tails);
+            for (i = 0; i < th.node_count; i++) {
+                DeltaTimerNode rec;
+                memcpy(&rec, cur + i * sizeof(rec), sizeof(rec));
+                tw->nodes[rec.index] = rec.node;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        off += mc_save__pad8(ch.size);
+    }
+
+    chain->seq = hdr.seq;
+    mc_delta__clear_tracking(w);
+    return 0;
+}
+
+/* =========================================================================
+ * SECTION 5: FILE I/O
+ *
+ * Scratch sizing and atomic-write behavior follow mc_world_save_file()
+ * (marble_save.h). With `lz` set the file is an LZ frame; loading
+ * accepts either form.
+ * ========================================================================= */
+
+/* Start a new chain with a full save at `path`. The chain id is taken
+ * from the raw save bytes, so it is the same compressed or not. */
+static int mc_world_save_base_file(
+    WorldRefs* w, DeltaChain* chain, const char* path,
+    McLzWriter* lz, uint8_t* scratch, uint32_t cap
+) {
+    uint32_t len = mc_world_save(w, scratch, cap);
+    if (len == 0) return -1;
+    if (mc_save__write_bytes(path, lz, scratch, len, cap) != 0) return -1;
+    chain->base_id = mc_delta__fnv1a(scratch, len);
+    chain->seq     = 0;
+    mc_delta__clear_tracking(w);
+    return 0;
+}
+
+static int mc_world_load_base_file(
+    WorldRefs* w, DeltaChain* chain, const char* path, uint8_t* scratch, uint32_t cap
+) {
+    uint32_t len;
+    if (mc_save__read_bytes(path, scratch, cap, &len) != 0) return -1;
+    return mc_world_load_base(w, chain, scratch, len);
+}
+
+/* Write the next delta to `path`. The chain only advances (and tracking
+ * is only cleared) once the file is safely on disk, so a failed write
+ * can simply be retried. */
+static int mc_world_save_delta_file(
+    WorldRefs* w, DeltaChain* chain, const char* path,
+    McLzWriter* lz, uint8_t* scratch, uint32_t cap
+) {
+    uint32_t len = mc_delta__write(w, chain, scratch, cap);
+    if (len == 0) return -1;
+    if (mc_save__write_bytes(path, lz, scratch, len, cap) != 0) return -1;
+    chain->seq++;
+    mc_delta__clear_tracking(w);
+    return 0;
+}
+
+static int mc_world_load_delta_file(
+    WorldRefs* w, DeltaChain* chain, const char* path, uint8_t* scratch, uint32_t cap
+) {
+    uint32_t len;
+    if (mc_save__read_bytes(path, scratch, cap, &len) != 0) return -1;
+    return mc_world_load_delta(w, chain, scratch, len);
+}
+
+#endif /* MARBLE_DELTA_H */
@@ -0,0 +1,218 @@
+/*
+ * marble_fork.h -- Copy-on-Write World Forks (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Let AI planners and what-if tools run a few ticks of command flushes
+ *   ahead of the live world and throw the result away. A fork starts out
+ *   sharing every byte of the parent's pools; the first write to a page
+ *   copies just that page into the fork's own arena. A lookahead that touches a
+ *   handful of entities copies a handful of pages instead of ~72 KB per
+ *   pool, and discarding a fork is resetting a counter.
+ *
+ * ARCHITECTURE:
+ *   Every parent pool gets a ForkPool view (marble_fork_pool.h: paged,
+ *   copy-on-write) and all views share the fork's ForkArena. Scalars
+ *   (allocator, tick, RNG) are copied at fork time -- they're a few bytes.
+ *
+ *   Systems reach fork state through the mc_fork_* accessors, which
+ *   mirror the SparseSet API. mc_fork_step() flushes a CommandBuffer into
+ *   the fork with mc_cmd_flush_pools() -- the same dispatch and
+ *   applicators mc_cmd_flush() runs, handed views instead of SparseSets --
+ *   so a lookahead that emits commands and steps N times ends in the
+ *   same pool state as flushing those commands into a full copy N times.
+ *
+ * THREADING:
+ *   The parent is only ever read. Any number of forks of the same world
+ *   can run concurrently on worker threads (marble_thread.h), one fork
+ *   per thread, as long as the parent isn't ticked until they finish.
+ *
+ * NOT FORKED:
+ *   - The TimerWheel. mc_fork_step() refuses to run a tick on which a
+ *     parent timer is due, so a lookahead stops at the next timer
+ *     instead of silently skipping it.
+ *   - The interaction processor. process_interaction() writes effects
+ *     straight into a SparseSet, so mc_world_step()'s request phase
+ *     can't run on a fork; lookahead systems emit commands instead.
+ *   - The spatial grid and container index (see SECTION 4).
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_FORK_H
+#define MARBLE_FORK_H
+
+#include "marble_save.h"
+
+/* =========================================================================
+ * SECTION 1: LAYOUT
+ * ========================================================================= */
+
+typedef struct {
+    const WorldRefs* parent;
+    EntityAllocator  alloc;
+    TickState        tick;
+    McRng            rng;
+    ForkPool         pools[MC_SAVE_MAX_POOLS];
+    uint32_t         pool_count;
+    ForkArena        arena;         /* private pages, shared by all pools */
+} WorldFork;
+
+/* =========================================================================
+ * SECTION 2: FORK / DISCARD
+ * ========================================================================= */
+
+/* Fork `parent`. O(pools): only page tables and scalars are touched. */
+static void mc_fork_init(WorldFork* f, const WorldRefs* parent) {
+    uint32_t p;
+    f->parent     = parent;
+    f->alloc      = *parent->alloc;
+    f->tick       = *parent->tick;
+    f->rng        = *parent->rng;
+    f->pool_count = parent->pool_count;
+    mc_fork_arena_init(&f->arena);
+    for (p = 0; p < parent->pool_count; p++) {
+        mc_fork_pool_init(&f->pools[p], parent->pools[p]);
+    }
+}
+
+/* Throw away everything the fork did and start again from the parent's
+ * current state. Same cost as mc_fork_init(). */
+static void mc_fork_reset(WorldFork* f) {
+    mc_fork_init(f, f->parent);
+}
+
+static uint32_t mc_fork_pages_used(const WorldFork* f) {
+    return f->arena.page_count;
+}
+
+/* Writes refused because the arena was full. A lookahead with
+ * overflows != 0 has diverged from what the full world would do. */
+static uint32_t mc_fork_overflows(const WorldFork* f) {
+    return f->arena.overflows;
+}
+
+/* =========================================================================
+ * SECTION 3: POOL API (mirrors SparseSet)
+ *
+ * `pool` is the index the pool was registered under in WorldRefs.
+ * ========================================================================= */
+
+static uint32_t mc_fork_count(const WorldFork* f, uint32_t pool) {
+    return f->pools[pool].count;
+}
+
+static int mc_fork_has(const WorldFork* f, uint32_t pool, EntityID eid) {
+    return mc_fork_pool_has(&f->arena, &f->pools[pool], eid);
+}
+
+/* Read-only component; never copies. NULL if absent. */
+static const void* mc_fork_get_const(const WorldFork* f, uint32_t pool, EntityID eid) {
+    return mc_fork_pool_get_const(&f->arena, &f->pools[pool], eid);
+}
+
+/* Writable component; copies its page on first write. NULL if absent or
+ * the fork's page arena is full. */
+static void* mc_fork_get(WorldFork* f, uint32_t pool, EntityID eid) {
+    return mc_fork_pool_get(&f->arena, &f->pools[pool], eid);
+}
+
+/* Iteration in dense order: entity / component at index i < count */
+static EntityID mc_fork_entity_at(const WorldFork* f, uint32_t pool, uint32_t i) {
+    return mc_fork__dense(&f->arena, &f->pools[pool], i);
+}
+
+static const void* mc_fork_data_at(const WorldFork* f, uint32_t pool, uint32_t i) {
+    return mc_fork__row_const(&f->arena, &f->pools[pool], i);
+}
+
+/* Returns 0 on success, -1 if present, out of range or out of pages. */
+static int mc_fork_add(WorldFork* f, uint32_t pool, EntityID eid, const void* component) {
+    return mc_fork_pool_add(&f->arena, &f->pools[pool], eid, component);
+}
+
+/* Swap-remove, same order semantics as mc_sparse_set_remove(). */
+static int mc_fork_remove(WorldFork* f, uint32_t pool, EntityID eid) {
+    return mc_fork_pool_remove(&f->arena, &f->pools[pool], eid);
+}
+
+static EntityID mc_fork_entity_create(WorldFork* f) {
+    return mc_entity_create(&f->alloc);
+}
+
+/* Build a full private SparseSet from the fork's view of `pool`, for
+ * systems that only speak SparseSet. Dense order is preserved. This is a
+ * whole-pool copy -- it gives up copy-on-write for that pool, so the
+ * tick path below never uses it. */
+static void mc_fork_materialize_pool(const WorldFork* f, uint32_t pool, SparseSet* out) {
+    const ForkPool* fp = &f->pools[pool];
+    uint32_t i;
+    mc_sparse_set_init(out, fp->stride);
+    for (i = 0; i < fp->count; i++) {
+        mc_sparse_set_add(out, mc_fork__dense(&f->arena, fp, i), mc_fork__row_const(&f->arena, fp, i));
+    }
+}
+
+/* =========================================================================
+ * SECTION 4: COMMAND FLUSH / STEP
+ *
+ * mc_fork_cmd_flush() is mc_cmd_flush() on the fork: it hands the fork's
+ * views to mc_cmd_flush_pools(), so commands are dispatched, validated
+ * and applied by the same code, in the same order. A command whose row
+ * can't be copied because the arena is full is rejected and counted in
+ * mc_fork_overflows().
+ *
+ * There is no spatial grid or ContainerIndex on a fork, so the flush
+ * runs without them -- as mc_world_step() does without a ContainerIndex:
+ * moves to the world write the position row (the grid is derived from
+ * it) and moves into a container are rejected.
+ * ========================================================================= */
+
+#define MC_FORK_NO_POOL UINT32_MAX
+
+/* Fork-side PoolPtrs: pool indices as registered in the parent WorldRefs,
+ * or MC_FORK_NO_POOL where mc_cmd_flush() would be handed NULL. */
+typedef struct {
+    uint32_t layers;
+    uint32_t item_defs;
+    uint32_t positions;
+} ForkPoolPtrs;
+
+static CmdPool mc_fork__cmd_pool(WorldFork* f, uint32_t pool) {
+    if (pool == MC_FORK_NO_POOL) return mc_cmd_pool_set(NULL);
+    return mc_cmd_pool_view(&f->arena, &f->pools[pool]);
+}
+
+static void mc_fork_cmd_flush(WorldFork* f, CommandBuffer* buf, const ForkPoolPtrs* pools) {
+    CmdPools cp;
+    cp.layers     = mc_fork__cmd_pool(f, pools->layers);
+    cp.item_defs  = mc_fork__cmd_pool(f, pools->item_defs);
+    cp.positions  = mc_fork__cmd_pool(f, pools->positions);
+    cp.grid       = NULL;
+    cp.containers = NULL;
+    mc_cmd_flush_pools(buf, &cp);
+}
+
+/* Nonzero if the parent has a timer that fires on or before `tick`.
+ * Timers are not forked (see the header), so a fork can't step past one. */
+static int mc_fork__timer_due(const WorldFork* f, uint64_t tick) {
+    const TimerWheel* w = f->parent->timers;
+    uint32_t n;
+    if (w == NULL || w->count == 0) return 0;
+    for (n = 0; n < MC_MAX_TIMERS; n++) {
+        if (w->nodes[n].active && w->nodes[n].due_tick <= tick) return 1;
+    }
+    return 0;
+}
+
+/* Advance the fork one tick: flush `buf` (the commands the caller's
+ * systems emitted against fork state this tick) and bump the tick.
+ * Returns 0, or -1 with nothing applied if a parent timer is due this
+ * tick -- the lookahead horizon ends there. */
+static int mc_fork_step(WorldFork* f, CommandBuffer* buf, const ForkPoolPtrs* pools) {
+    if (mc_fork__timer_due(f, f->tick.tick_number)) return -1;
+    mc_fork_cmd_flush(f, buf, pools);
+    f->tick.tick_number++;
+    return 0;
+}
+
+#endif /* MARBLE_FORK_H */
@@ -0,0 +1,278 @@
+/*
+ * marble_fork_pool.h -- Copy-on-Write Pool Views (Phase 0.4)
+ *
+ * PURPOSE:
+ *   The page layer under world forks (marble_fork.h): a read-mostly view
+ *   of one SparseSet that shares the parent's bytes until the first
+ *   write to a page, which copies just that page into a ForkArena.
+ *   It sits below marble_cmd.h so the command applicators can write
+ *   through a view exactly as they write a SparseSet (CmdPool).
+ *
+ * ARCHITECTURE:
+ *   Each pool is viewed as three paged regions of the parent SparseSet:
+ *
+ *     sparse[]  MC_FORK_PAGE_SIZE / 4 EntityIDs per page
+ *     dense[]   MC_FORK_PAGE_SIZE / 4 indices per page
+ *     data[]    floor(MC_FORK_PAGE_SIZE / stride) rows per page
+ *               (rows never straddle a page, so every component the
+ *               view hands out is contiguous)
+ *
+ *   A page table entry is either MC_FORK_SHARED (read the parent) or an
+ *   index into ForkArena.pages[]. All views of one fork share an arena.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_FORK_POOL_H
+#define MARBLE_FORK_POOL_H
+
+#include "marble_core.h"
+
+/* =========================================================================
+ * SECTION 1: LAYOUT
+ * ========================================================================= */
+
+#ifndef MC_FORK_PAGE_SIZE
+#define MC_FORK_PAGE_SIZE   4096
+#endif
+
+#ifndef MC_FORK_MAX_PAGES
+#define MC_FORK_MAX_PAGES   64      /* private pages per fork (256 KB) */
+#endif
+
+#define MC_FORK_SHARED      0xFFFFu
+#define MC_FORK_IDX_PER_PAGE (MC_FORK_PAGE_SIZE / 4)
+#define MC_FORK_INDEX_PAGES  ((MC_MAX_ENTITIES + MC_FORK_IDX_PER_PAGE - 1) / MC_FORK_IDX_PER_PAGE)
+/* Worst case is the widest row: MC_MAX_ENTITIES * 64 bytes of data */
+#define MC_FORK_DATA_PAGES   ((MC_MAX_ENTITIES * 64 + MC_FORK_PAGE_SIZE - 1) / MC_FORK_PAGE_SIZE + 1)
+
+typedef struct {
+    const SparseSet* parent;
+    uint32_t count;
+    uint32_t stride;
+    uint32_t rows_per_page;
+    uint16_t sparse_page[MC_FORK_INDEX_PAGES];
+    uint16_t dense_page[MC_FORK_INDEX_PAGES];
+    uint16_t data_page[MC_FORK_DATA_PAGES];
+} ForkPool;
+
+typedef struct {
+    uint32_t page_count;    /* private pages in use */
+    uint32_t overflows;     /* writes refused: arena full */
+    uint8_t  pages[MC_FORK_MAX_PAGES][MC_FORK_PAGE_SIZE];
+} ForkArena;
+
+static void mc_fork_arena_init(ForkArena* a) {
+    a->page_count = 0;
+    a->overflows  = 0;
+}
+
+/* View `parent` with every page shared. O(page table). */
+static void mc_fork_pool_init(ForkPool* fp, const SparseSet* parent) {
+    fp->parent = parent;
+    fp->count  = parent->count;
+    fp->stride = parent->stride;
+    fp->rows_per_page = (fp->stride > 0) ? MC_FORK_PAGE_SIZE / fp->stride : MC_FORK_PAGE_SIZE;
+    memset(fp->sparse_page, 0xFF, sizeof(fp->sparse_page));
+    memset(fp->dense_page, 0xFF, sizeof(fp->dense_page));
+    memset(fp->data_page, 0xFF, sizeof(fp->data_page));
+}
+
+/* =========================================================================
+ * SECTION 2: PAGE ACCESS
+ * ========================================================================= */
+
+static const uint8_t* mc_fork__sparse_read(const ForkArena* a, const ForkPool* fp, uint32_t page) {
+    uint16_t s = fp->sparse_page[page];
+    if (s == MC_FORK_SHARED) return (const uint8_t*)&fp->parent->sparse[page * MC_FORK_IDX_PER_PAGE];
+    return a->pages[s];
+}
+
+static const uint8_t* mc_fork__dense_read(const ForkArena* a, const ForkPool* fp, uint32_t page) {
+    uint16_t s = fp->dense_page[page];
+    if (s == MC_FORK_SHARED) return (const uint8_t*)&fp->parent->dense[page * MC_FORK_IDX_PER_PAGE];
+    return a->pages[s];
+}
+
+static const uint8_t* mc_fork__data_read(const ForkArena* a, const ForkPool* fp, uint32_t page) {
+    uint16_t s = fp->data_page[page];
+    if (s == MC_FORK_SHARED) return &fp->parent->data[page * fp->rows_per_page * fp->stride];
+    return a->pages[s];
+}
+
+/* Bytes of the parent region a page covers (the last page may be short) */
+static uint32_t mc_fork__index_page_bytes(uint32_t page) {
+    uint32_t first = page * MC_FORK_IDX_PER_PAGE;
+    uint32_t n = MC_MAX_ENTITIES - first;
+    if (n > MC_FORK_IDX_PER_PAGE) n = MC_FORK_IDX_PER_PAGE;
+    return n * 4u;
+}
+
+static uint32_t mc_fork__data_page_bytes(const ForkPool* fp, uint32_t page) {
+    uint32_t first = page * fp->rows_per_page;
+    uint32_t n = MC_MAX_ENTITIES - first;
+    if (n > fp->rows_per_page) n = fp->rows_per_page;
+    return n * fp->stride;
+}
+
+/* Copy-on-write: make `*slot` private, copying `bytes` from `src` the
+ * first time. Returns the private page, NULL if the arena is full. */
+static uint8_t* mc_fork__own(ForkArena* a, uint16_t* slot, const uint8_t* src, uint32_t bytes) {
+    if (*slot == MC_FORK_SHARED) {
+        if (a->page_count >= MC_FORK_MAX_PAGES) {
+            a->overflows++;
+            return NULL;
+        }
+        *slot = (uint16_t)a->page_count++;
+        memcpy(a->pages[*slot], src, bytes);
+    }
+    return a->pages[*slot];
+}
+
+static uint32_t mc_fork__get_u32(const uint8_t* page, uint32_t i) {
+    uint32_t v;
+    memcpy(&v, page + i * 4u, 4);
+    return v;
+}
+
+static uint32_t mc_fork__sparse(const ForkArena* a, const ForkPool* fp, EntityID eid) {
+    return mc_fork__get_u32(mc_fork__sparse_read(a, fp, eid / MC_FORK_IDX_PER_PAGE),
+                            eid % MC_FORK_IDX_PER_PAGE);
+}
+
+static EntityID mc_fork__dense(const ForkArena* a, const ForkPool* fp, uint32_t idx) {
+    return mc_fork__get_u32(mc_fork__dense_read(a, fp, idx / MC_FORK_IDX_PER_PAGE),
+                            idx % MC_FORK_IDX_PER_PAGE);
+}
+
+static const uint8_t* mc_fork__row_const(const ForkArena* a, const ForkPool* fp, uint32_t idx) {
+    return mc_fork__data_read(a, fp, idx / fp->rows_per_page) + (idx % fp->rows_per_page) * fp->stride;
+}
+
+static uint8_t* mc_fork__sparse_own(ForkArena* a, ForkPool* fp, EntityID eid) {
+    uint32_t page = eid / MC_FORK_IDX_PER_PAGE;
+    uint8_t* p = mc_fork__own(a, &fp->sparse_page[page], mc_fork__sparse_read(a, fp, page),
+                              mc_fork__index_page_bytes(page));
+    return (p != NULL) ? p + (eid % MC_FORK_IDX_PER_PAGE) * 4u : NULL;
+}
+
+static uint8_t* mc_fork__dense_own(ForkArena* a, ForkPool* fp, uint32_t idx) {
+    uint32_t page = idx / MC_FORK_IDX_PER_PAGE;
+    uint8_t* p = mc_fork__own(a, &fp->dense_page[page], mc_fork__dense_read(a, fp, page),
+                              mc_fork__index_page_bytes(page));
+    return (p != NULL) ? p + (idx % MC_FORK_IDX_PER_PAGE) * 4u : NULL;
+}
+
+static uint8_t* mc_fork__row_own(ForkArena* a, ForkPool* fp, uint32_t idx) {
+    uint32_t page = idx / fp->rows_per_page;
+    uint8_t* p = mc_fork__own(a, &fp->data_page[page], mc_fork__data_read(a, fp, page),
+                              mc_fork__data_page_bytes(fp, page));
+    return (p != NULL) ? p + (idx % fp->rows_per_page) * fp->stride : NULL;
+}
+
+/* Number of distinct still-shared slots among `slots` -- the pages a
+ * mutation would copy. Checked up front so a mutation either fully
+ * applies or doesn't start. */
+static uint32_t mc_fork__pages_needed(uint16_t* const* slots, uint32_t n) {
+    uint32_t i, j, need = 0;
+    for (i = 0; i < n; i++) {
+        int dup = 0;
+        if (*slots[i] != MC_FORK_SHARED) continue;
+        for (j = 0; j < i; j++) {
+            if (slots[j] == slots[i]) dup = 1;
+        }
+        if (!dup) need++;
+    }
+    return need;
+}
+
+/* =========================================================================
+ * SECTION 3: POOL VIEW API (mirrors SparseSet)
+ * ========================================================================= */
+
+static int mc_fork_pool_has(const ForkArena* a, const ForkPool* fp, EntityID eid) {
+    uint32_t idx;
+    if (eid >= MC_MAX_ENTITIES) return 0;
+    idx = mc_fork__sparse(a, fp, eid);
+    if (idx >= fp->count) return 0;
+    return (mc_fork__dense(a, fp, idx) == eid) ? 1 : 0;
+}
+
+/* Read-only component; never copies. NULL if absent. */
+static const void* mc_fork_pool_get_const(const ForkArena* a, const ForkPool* fp, EntityID eid) {
+    if (!mc_fork_pool_has(a, fp, eid)) return NULL;
+    return mc_fork__row_const(a, fp, mc_fork__sparse(a, fp, eid));
+}
+
+/* Writable component; copies its page on first write. NULL if absent or
+ * the arena is full. */
+static void* mc_fork_pool_get(ForkArena* a, ForkPool* fp, EntityID eid) {
+    if (!mc_fork_pool_has(a, fp, eid)) return NULL;
+    return mc_fork__row_own(a, fp, mc_fork__sparse(a, fp, eid));
+}
+
+/* Returns 0 on success, -1 if present, out of range or out of pages. */
+static int mc_fork_pool_add(ForkArena* a, ForkPool* fp, EntityID eid, const void* component) {
+    uint32_t idx = fp->count;
+    uint16_t* slots[3];
+    uint8_t* s;
+    uint8_t* d;
+    uint8_t* row;
+
+    if (eid >= MC_MAX_ENTITIES || idx >= MC_MAX_ENTITIES) return -1;
+    if (mc_fork_pool_has(a, fp, eid)) return -1;
+
+    slots[0] = &fp->sparse_page[eid / MC_FORK_IDX_PER_PAGE];
+    slots[1] = &fp->dense_page[idx / MC_FORK_IDX_PER_PAGE];
+    slots[2] = &fp->data_page[idx / fp->rows_per_page];
+    if (a->page_count + mc_fork__pages_needed(slots, 3) > MC_FORK_MAX_PAGES) {
+        a->overflows++;
+        return -1;
+    }
+
+    s   = mc_fork__sparse_own(a, fp, eid);
+    d   = mc_fork__dense_own(a, fp, idx);
+    row = mc_fork__row_own(a, fp, idx);
+    memcpy(s, &idx, 4);
+    memcpy(d, &eid, 4);
+    memcpy(row, component, fp->stride);
+    fp->count++;
+    return 0;
+}
+
+/* Swap-remove, same order semantics as mc_sparse_set_remove(). */
+static int mc_fork_pool_remove(ForkArena* a, ForkPool* fp, EntityID eid) {
+    uint32_t idx, last;
+    EntityID last_eid;
+    uint16_t* slots[3];
+
+    if (!mc_fork_pool_has(a, fp, eid)) return -1;
+    idx      = mc_fork__sparse(a, fp, eid);
+    last     = fp->count - 1;
+    last_eid = mc_fork__dense(a, fp, last);
+
+    if (idx != last) {
+        uint8_t* s;
+        uint8_t* d;
+        uint8_t* row;
+        slots[0] = &fp->sparse_page[last_eid / MC_FORK_IDX_PER_PAGE];
+        slots[1] = &fp->dense_page[idx / MC_FORK_IDX_PER_PAGE];
+        slots[2] = &fp->data_page[idx / fp->rows_per_page];
+        if (a->page_count + mc_fork__pages_needed(slots, 3) > MC_FORK_MAX_PAGES) {
+            a->overflows++;
+            return -1;
+        }
+        row = mc_fork__row_own(a, fp, idx);
+        memcpy(row, mc_fork__row_const(a, fp, last), fp->stride);
+        d = mc_fork__dense_own(a, fp, idx);
+        memcpy(d, &last_eid, 4);
+        s = mc_fork__sparse_own(a, fp, last_eid);
+        memcpy(s, &idx, 4);
+    }
+    /* sparse[eid] may keep its stale value: has() rejects it because
+     * the index is now >= count or points at another entity. */
+    fp->count--;
+    return 0;
+}
+
+#endif /* MARBLE_FORK_POOL_H */
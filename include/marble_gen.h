@@ -213,6 +213,39 @@ static const RuleDef GEN_RULES[1] = {
     },
 };
 
+/* ---- Crafting Recipes ---- */
+#ifndef MARBLE_GEN_RECIPES_H
+#define MARBLE_GEN_RECIPES_H
+
+#include "marble_recipe.h"
+
+#define GEN_RECIPE_COUNT 3
+
+static const RecipeDef GEN_RECIPES[3] = {
+    /* Planks */ {
+        1, 911, 4,
+        {
+            { RECIPE_ING_ITEM, 910, 1 },
+        }, 1
+    },
+    /* Torch */ {
+        2, 972, 1,
+        {
+            { RECIPE_ING_ITEM, 970, 1 },
+            { RECIPE_ING_TAG, (1u << 16) /*TAG_FIRE*/, 1 },
+        }, 2
+    },
+    /* TrailRation */ {
+        3, 982, 1,
+        {
+            { RECIPE_ING_TAG, (1u << 5) /*TAG_FOOD*/, 2 },
+            { RECIPE_ING_TAG, (1u << 19) /*TAG_LEATHER*/, 1 },
+        }, 2
+    },
+};
+
+#endif /* MARBLE_GEN_RECIPES_H */
+
 /* ---- Condition Evaluator (generated) ---- */
 static int gen_evaluate_condition(ConditionID cond, EntityID actor, EntityID target, const SparseSet* pool_tool, const SparseSet* pool_layers) {
     switch (cond) {
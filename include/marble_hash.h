@@ -0,0 +1,115 @@
+/*
+ * marble_hash.h -- 64-bit State Hash (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Fast, seedable 64-bit hash for small fixed-size rows (component
+ *   structs, network entities). Used to keep running world-state hashes
+ *   that clients and servers compare once per tick to detect desyncs.
+ *
+ * ALGORITHM:
+ *   XXH64 (Yann Collet), bit-exact with the reference implementation, so
+ *   hashes can be checked against any other xxHash port. Input words are
+ *   assembled little-endian byte by byte: no alignment requirements, and
+ *   the same bytes hash the same on every target.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_HASH_H
+#define MARBLE_HASH_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define MC_XXH64_P1 0x9E3779B185EBCA87ull
+#define MC_XXH64_P2 0xC2B2AE3D27D4EB4Full
+#define MC_XXH64_P3 0x165667B19E3779F9ull
+#define MC_XXH64_P4 0x85EBCA77C2B2AE63ull
+#define MC_XXH64_P5 0x27D4EB2F165667C5ull
+
+static uint64_t mc_hash__rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t mc_hash__read64(const uint8_t* p) {
+    return  (uint64_t)p[0]        | ((uint64_t)p[1] << 8)
+         | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24)
+         | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40)
+         | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static uint32_t mc_hash__read32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t mc_hash__round(uint64_t acc, uint64_t in) {
+    acc += in * MC_XXH64_P2;
+    acc  = mc_hash__rotl64(acc, 31);
+    return acc * MC_XXH64_P1;
+}
+
+static uint64_t mc_hash__merge(uint64_t acc, uint64_t v) {
+    acc ^= mc_hash__round(0, v);
+    return acc * MC_XXH64_P1 + MC_XXH64_P4;
+}
+
+/* Final mix: every input bit affects every output bit */
+static uint64_t mc_hash64_avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= MC_XXH64_P2;
+    h ^= h >> 29;
+    h *= MC_XXH64_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+static uint64_t mc_hash64(const void* data, uint32_t len, uint64_t seed) {
+    const uint8_t* p   = (const uint8_t*)data;
+    const uint8_t* end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        const uint8_t* limit = end - 32;
+        uint64_t v1 = seed + MC_XXH64_P1 + MC_XXH64_P2;
+        uint64_t v2 = seed + MC_XXH64_P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - MC_XXH64_P1;
+        do {
+            v1 = mc_hash__round(v1, mc_hash__read64(p));      p += 8;
+            v2 = mc_hash__round(v2, mc_hash__read64(p));      p += 8;
+            v3 = mc_hash__round(v3, mc_hash__read64(p));      p += 8;
+            v4 = mc_hash__round(v4, mc_hash__read64(p));      p += 8;
+        } while (p <= limit);
+        h = mc_hash__rotl64(v1, 1) + mc_hash__rotl64(v2, 7)
+          + mc_hash__rotl64(v3, 12) + mc_hash__rotl64(v4, 18);
+        h = mc_hash__merge(h, v1);
+        h = mc_hash__merge(h, v2);
+        h = mc_hash__merge(h, v3);
+        h = mc_hash__merge(h, v4);
+    } else {
+        h = seed + MC_XXH64_P5;
+    }
+
+    h += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        h ^= mc_hash__round(0, mc_hash__read64(p));
+        h  = mc_hash__rotl64(h, 27) * MC_XXH64_P1 + MC_XXH64_P4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)mc_hash__read32(p) * MC_XXH64_P1;
+        h  = mc_hash__rotl64(h, 23) * MC_XXH64_P2 + MC_XXH64_P3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (uint64_t)(*p) * MC_XXH64_P5;
+        h  = mc_hash__rotl64(h, 11) * MC_XXH64_P1;
+        p++;
+    }
+
+    return mc_hash64_avalanche(h);
+}
+
+#endif /* MARBLE_HASH_H */
@@ -401,17 +401,19 @@ static void apply_effect(
             if (stack == NULL) break;
             if (stack->layer_count == 0) break;
 
+            mc_sparse_set_hash_out(pool_layers, target);
             stack->layers[0].integrity--;
 
             if (stack->layers[0].integrity <= 0) {
                 uint32_t i;
-                printf("    >> Layer DESTROYED: %s peeled <<\n",
+                MC_LOG("    >> Layer DESTROYED: %s peeled <<\n",
                        MATERIAL_NAMES[stack->layers[0].material]);
                 for (i = 0; i + 1 < stack->layer_count; i++) {
                     stack->layers[i] = stack->layers[i + 1];
                 }
                 stack->layer_count--;
             }
+            mc_sparse_set_hash_in(pool_layers, target);
             break;
         }
 
@@ -446,19 +448,20 @@ static void apply_crit_fail_damage(
     stack = (CLayerStack*)mc_sparse_set_get(pool_layers, part_eid);
     if (stack == NULL) return;
 
-    printf("    >> CRIT FAIL! Entity %u damages own %s! <<\n",
+    MC_LOG("    >> CRIT FAIL! Entity %u damages own %s! <<\n",
            actor, BODYPART_NAMES[part]);
 
+    mc_sparse_set_hash_out(pool_layers, part_eid);
     for (d = 0; d < damage && stack->layer_count > 0; d++) {
         stack->layers[0].integrity--;
-        printf("    >> %s integrity -> %d/%d <<\n",
+        MC_LOG("    >> %s integrity -> %d/%d <<\n",
                MATERIAL_NAMES[stack->layers[0].material],
                stack->layers[0].integrity,
                stack->layers[0].max_integrity);
 
         if (stack->layers[0].integrity <= 0) {
             uint32_t i;
-            printf("    >> %s layer on %s DESTROYED <<\n",
+            MC_LOG("    >> %s layer on %s DESTROYED <<\n",
                    MATERIAL_NAMES[stack->layers[0].material],
                    BODYPART_NAMES[part]);
             for (i = 0; i + 1 < stack->layer_count; i++) {
@@ -467,11 +470,12 @@ static void apply_crit_fail_damage(
             stack->layer_count--;
 
             if (stack->layer_count == 0) {
-                printf("    >> %s FULLY DESTROYED -- fine motor LOST <<\n",
+                MC_LOG("    >> %s FULLY DESTROYED -- fine motor LOST <<\n",
                        BODYPART_NAMES[part]);
             }
         }
     }
+    mc_sparse_set_hash_in(pool_layers, part_eid);
 }
 
 /* --- The Generic Processor --- */
@@ -10,6 +10,14 @@
  *   This is analogous to a compiled .data section in an executable.
  *   The loader iterates this array and performs type-safe copying
  *   into the appropriate SparseSets.
+ *
+ *   Loader_LoadWorldBinary() is the fast path: the compiler writes a
+ *   .mbin whose pools are already packed (marble_mbin.h), and each pool
+ *   is loaded with a single block copy instead of per-entry adds.
+ *
+ *   Loader_LoadWorldGrouped() loads the same ManifestEntry array as
+ *   Loader_LoadWorld(), but buckets it by component type first and
+ *   fills each pool on its own worker thread.
  */
 
 #ifndef MARBLE_LOADER_H
@@ -17,7 +25,8 @@
 
 #include "marble_core.h"
 #include "marble_interact.h"
-#include "marble_behavior.h"
+#include "marble_mbin.h"
+#include "marble_thread.h"
 
 /* =========================================================================
  * MANIFEST SCHEMA
@@ -152,4 +161,242 @@ static void Loader_LoadWorld(
     printf("[Loader] Population complete.\n");
 }
 
+/* =========================================================================
+ * BINARY LOADER
+ *
+ * Loads a compiled .mbin image (see marble_mbin.h). Each pool is one
+ * memcpy for dense + one for data; no per-entry dispatch. The image
+ * may be a file mapping (mc_mbin_map) or any in-memory buffer.
+ *
+ * Returns 0 on success, -1 if the image is malformed or a pool's stride
+ * doesn't match the runtime component size (stale .mbin). The payload
+ * checksum is not checked here; callers loading untrusted files run
+ * mc_mbin_verify_checksum() first.
+ * ========================================================================= */
+
+static SparseSet *Loader_PoolForType(WorldContext *ctx, uint32_t type)
+{
+    switch (type)
+    {
+    case COMP_TYPE_HEALTH:       return ctx->pool_health;
+    case COMP_TYPE_POSITION:     return ctx->pool_position;
+    case COMP_TYPE_LAYERS:       return ctx->pool_layers;
+    case COMP_TYPE_SKILLS:       return ctx->pool_skills;
+    case COMP_TYPE_ANATOMY:      return ctx->pool_anatomy;
+    case COMP_TYPE_CAPABILITIES: return ctx->pool_capabilities;
+    case COMP_TYPE_AFFORDANCES:  return ctx->pool_affordances;
+    case COMP_TYPE_TOOL:         return ctx->pool_tool;
+    case COMP_TYPE_BODY_PARTS:   return ctx->pool_body_parts;
+    case COMP_TYPE_BEHAVIOR:     return ctx->pool_behavior;
+    default:                     return NULL;
+    }
+}
+
+static int Loader_LoadWorldBinary(
+    WorldContext *ctx,
+    const uint8_t *image,
+    uint64_t image_size)
+{
+    const MbinHeader *hdr;
+    uint32_t p;
+
+    if (mc_mbin_validate(image, image_size) != 0)
+    {
+        printf("[Loader] Rejected binary manifest (bad header or bounds).\n");
+        return -1;
+    }
+    hdr = mc_mbin_header(image);
+
+    /* Strides are checked for every pool before anything is copied,
+       so a stale image never leaves the world half-loaded. */
+    for (p = 0; p < hdr->pool_count; p++)
+    {
+        const MbinPoolDesc *pd = mc_mbin_pool_desc(image, p);
+        SparseSet *ss = Loader_PoolForType(ctx, pd->comp_type);
+        if (ss == NULL || ss->stride != pd->stride)
+        {
+            printf("[Loader] Pool %u (type %u) does not match runtime layout.\n",
+                   p, pd->comp_type);
+            return -1;
+        }
+    }
+
+    if (ctx->alloc->next_id < hdr->entity_count)
+    {
+        ctx->alloc->next_id = hdr->entity_count;
+    }
+    for (p = 0; p < hdr->pool_count; p++)
+    {
+        const MbinPoolDesc *pd = mc_mbin_pool_desc(image, p);
+        mc_mbin_load_pool(Loader_PoolForType(ctx, pd->comp_type), image, pd);
+    }
+
+    printf("[Loader] Loaded %u entities, %u pools from binary manifest.\n",
+           hdr->entity_count, hdr->pool_count);
+    return 0;
+}
+
+/* =========================================================================
+ * GROUPED / PARALLEL LOADER
+ *
+ * Same input and result as Loader_LoadWorld(), different access pattern:
+ *   1. One pass: histogram by ComponentType + highest entity index.
+ *   2. Stable counting sort of the entries into per-type buckets.
+ *   3. Each pool is filled from its own contiguous bucket. Pools share
+ *      nothing, so large buckets are filled on worker threads; small
+ *      ones stay on the calling thread (thread start costs more than
+ *      a few hundred adds).
+ *
+ * The sort is stable, so every pool's dense[] order is identical to
+ * the sequential loader's -- the world hash doesn't depend on the path.
+ *
+ * Scratch space is owned by the caller (no hidden statics), which keeps
+ * concurrent loads of separate worlds safe.
+ * ========================================================================= */
+
+#define LOADER_POOL_COUNT            10
+#define LOADER_MAX_ENTRIES           (MC_MAX_ENTITIES * LOADER_POOL_COUNT)
+#define LOADER_PARALLEL_MIN_ENTRIES  256
+
+typedef struct
+{
+    SparseSet *pool;
+    const ManifestEntry *bucket;
+    uint32_t count;
+    uint32_t failed;   /* adds rejected by the pool (duplicate / out of range) */
+} LoaderPoolJob;
+
+typedef struct
+{
+    ManifestEntry sorted[LOADER_MAX_ENTRIES];
+    LoaderPoolJob jobs[LOADER_POOL_COUNT];
+    uint32_t max_workers;   /* threads incl. the caller; 0 = one per core */
+    uint32_t workers_used;  /* out: pools filled on worker threads */
+} LoaderScratch;
+
+static void Loader__FillPool(LoaderPoolJob *job)
+{
+    uint32_t i;
+    for (i = 0; i < job->count; i++)
+    {
+        if (mc_sparse_set_add(job->pool, (EntityID)job->bucket[i].entity_idx,
+                              job->bucket[i].data_ptr) != 0)
+        {
+            job->failed++;
+        }
+    }
+}
+
+static MC_THREAD_PROC(Loader__PoolWorker)
+{
+    Loader__FillPool((LoaderPoolJob *)mc_thread_arg);
+    MC_THREAD_RETURN;
+}
+
+/* Returns 0 if every entry was placed, -1 if the manifest is too large
+ * or any entry was rejected (unknown type, bad index, duplicate). */
+static int Loader_LoadWorldGrouped(
+    WorldContext *ctx,
+    const ManifestEntry *entries,
+    uint32_t entry_count,
+    LoaderScratch *scratch)
+{
+    uint32_t counts[LOADER_POOL_COUNT];
+    uint32_t offsets[LOADER_POOL_COUNT];
+    McThread threads[LOADER_POOL_COUNT];
+    uint32_t threaded[LOADER_POOL_COUNT];
+    uint32_t thread_count = 0;
+    uint32_t max_workers;
+    uint32_t rejected = 0;
+    uint32_t max_idx = 0;
+    uint32_t i, t;
+
+    if (entry_count > LOADER_MAX_ENTRIES)
+    {
+        printf("[Loader] Manifest too large (%u entries, max %u).\n",
+               entry_count, (uint32_t)LOADER_MAX_ENTRIES);
+        return -1;
+    }
+    printf("[Loader] Loading %u manifest entries (grouped)...\n", entry_count);
+
+    /* Phase 1: histogram + entity high-water mark */
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < entry_count; i++)
+    {
+        uint32_t type = (uint32_t)entries[i].type;
+        if (type >= LOADER_POOL_COUNT || entries[i].entity_idx >= MC_MAX_ENTITIES)
+        {
+            rejected++;
+            continue;
+        }
+        counts[type]++;
+        if (entries[i].entity_idx + 1 > max_idx) max_idx = entries[i].entity_idx + 1;
+    }
+    while (ctx->alloc->next_id < max_idx)
+    {
+        mc_entity_create(ctx->alloc);
+    }
+    printf("[Loader] Allocated %u entities.\n", ctx->alloc->next_id);
+
+    /* Phase 2: stable counting sort into buckets */
+    offsets[0] = 0;
+    for (t = 1; t < LOADER_POOL_COUNT; t++)
+    {
+        offsets[t] = offsets[t - 1] + counts[t - 1];
+    }
+    for (t = 0; t < LOADER_POOL_COUNT; t++)
+    {
+        LoaderPoolJob *job = &scratch->jobs[t];
+        job->pool = Loader_PoolForType(ctx, t);
+        job->bucket = &scratch->sorted[offsets[t]];
+        job->count = counts[t];
+        job->failed = 0;
+        if (job->pool == NULL) rejected += counts[t];
+    }
+    for (i = 0; i < entry_count; i++)
+    {
+        uint32_t type = (uint32_t)entries[i].type;
+        if (type >= LOADER_POOL_COUNT || entries[i].entity_idx >= MC_MAX_ENTITIES) continue;
+        scratch->sorted[offsets[type]++] = entries[i];
+    }
+
+    /* Phase 3: fill pools -- big buckets on workers, the rest inline */
+    max_workers = scratch->max_workers ? scratch->max_workers : mc_thread_cpu_count();
+    if (max_workers > MC_THREAD_MAX_WORKERS) max_workers = MC_THREAD_MAX_WORKERS;
+    for (t = 0; t < LOADER_POOL_COUNT; t++)
+    {
+        LoaderPoolJob *job = &scratch->jobs[t];
+        if (job->pool == NULL || job->count < LOADER_PARALLEL_MIN_ENTRIES) continue;
+        if (thread_count + 1 >= max_workers) continue;  /* keep one core for inline work */
+        if (mc_thread_start(&threads[thread_count], Loader__PoolWorker, job) == 0)
+        {
+            threaded[thread_count++] = t;
+        }
+    }
+    for (t = 0; t < LOADER_POOL_COUNT; t++)
+    {
+        LoaderPoolJob *job = &scratch->jobs[t];
+        uint32_t w, on_worker = 0;
+        if (job->pool == NULL) continue;
+        for (w = 0; w < thread_count; w++)
+        {
+            if (threaded[w] == t) on_worker = 1;
+        }
+        if (!on_worker) Loader__FillPool(job);
+    }
+    for (t = 0; t < thread_count; t++)
+    {
+        mc_thread_join(&threads[t]);
+    }
+
+    for (t = 0; t < LOADER_POOL_COUNT; t++)
+    {
+        rejected += scratch->jobs[t].failed;
+    }
+    scratch->workers_used = thread_count;
+    printf("[Loader] Population complete (%u pools on workers, %u rejected).\n",
+           thread_count, rejected);
+    return (rejected == 0) ? 0 : -1;
+}
+
 #endif /* MARBLE_LOADER_H */
\ No newline at end of file
@@ -0,0 +1,518 @@
+/*
+ * marble_lz.h -- Block Compression (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Shrink saves, delta files and network snapshots. World state is
+ *   very redundant (CLayerStack arrays stamped from the same template,
+ *   zeroed skill tables, runs of identical component rows), so a plain
+ *   LZ77 byte coder gets most of the win. Decoding is a tight
+ *   copy loop that should never be the slow part of a load.
+ *
+ * FORMAT:
+ *   Blocks use the LZ4 block encoding (token nibbles, 255-run length
+ *   extensions, 2-byte little-endian offsets, 4-byte minimum match, last
+ *   5 bytes always literal), so any LZ4 block tool can inspect them.
+ *   Blocks are wrapped in a small frame:
+ *
+ *     LzFrameHeader                      magic "MLZF", totals
+ *     { LzBlockHeader, payload } * N     each block <= MC_LZ_BLOCK_SIZE raw
+ *
+ *   Every block carries an XXH32 checksum of its raw bytes. A block that
+ *   doesn't shrink is stored as-is (bit 31 of stored_size), so a frame
+ *   is never much bigger than its input (mc_lz_frame_bound()).
+ *
+ * STREAMING:
+ *   McLzWriter is the fixed work buffer: the match table plus one staging
+ *   block. Append any number of byte ranges; a full block is compressed
+ *   as soon as it fills. McLzReader walks a frame one block at a time,
+ *   so a consumer can decode into a buffer as small as one block.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_LZ_H
+#define MARBLE_LZ_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* =========================================================================
+ * SECTION 1: CONSTANTS / FORMAT
+ * ========================================================================= */
+
+#define MC_LZ_BLOCK_SIZE     (64u * 1024u)  /* max raw bytes per block */
+#define MC_LZ_HASH_LOG       12
+#define MC_LZ_HASH_SIZE      (1u << MC_LZ_HASH_LOG)
+#define MC_LZ_MIN_MATCH      4
+#define MC_LZ_LAST_LITERALS  5              /* block always ends in literals */
+#define MC_LZ_MFLIMIT        12             /* no match may start this close to the end */
+#define MC_LZ_MAX_OFFSET     65535u
+
+#define MC_LZ_FRAME_MAGIC    0x465A4C4Du    /* "MLZF" */
+#define MC_LZ_FRAME_VERSION  1
+#define MC_LZ_STORED_FLAG    0x80000000u    /* block payload is raw bytes */
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t block_size;    /* MC_LZ_BLOCK_SIZE at write time */
+    uint32_t block_count;
+    uint32_t raw_size;      /* sum of raw block sizes */
+    uint32_t reserved;
+} LzFrameHeader;
+
+typedef struct {
+    uint32_t stored_size;   /* payload bytes (| MC_LZ_STORED_FLAG if raw) */
+    uint32_t raw_size;      /* bytes after decoding */
+    uint32_t checksum;      /* XXH32 (seed 0) of the raw bytes */
+} LzBlockHeader;
+
+/* Worst-case compressed size of one block of `n` bytes */
+static uint32_t mc_lz_compress_bound(uint32_t n) {
+    return n + n / 255u + 16u;
+}
+
+/* Worst-case frame size for `n` input bytes (stored blocks never grow) */
+static uint32_t mc_lz_frame_bound(uint32_t n) {
+    uint32_t blocks = (n + MC_LZ_BLOCK_SIZE - 1) / MC_LZ_BLOCK_SIZE;
+    return (uint32_t)sizeof(LzFrameHeader) + blocks * (uint32_t)sizeof(LzBlockHeader) + n;
+}
+
+static uint32_t mc_lz__read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint64_t mc_lz__read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+/* =========================================================================
+ * SECTION 2: CHECKSUM (XXH32)
+ * ========================================================================= */
+
+#define MC_LZ__P1 2654435761u
+#define MC_LZ__P2 2246822519u
+#define MC_LZ__P3 3266489917u
+#define MC_LZ__P4 668265263u
+#define MC_LZ__P5 374761393u
+
+static uint32_t mc_lz__rotl(uint32_t x, uint32_t r) {
+    return (x << r) | (x >> (32u - r));
+}
+
+static uint32_t mc_lz_checksum(const uint8_t* p, uint32_t len) {
+    uint32_t i = 0, h;
+    if (len >= 16) {
+        uint32_t v1 = MC_LZ__P1 + MC_LZ__P2;
+        uint32_t v2 = MC_LZ__P2;
+        uint32_t v3 = 0;
+        uint32_t v4 = 0u - MC_LZ__P1;
+        for (; i + 16 <= len; i += 16) {
+            v1 = mc_lz__rotl(v1 + mc_lz__read32(p + i)      * MC_LZ__P2, 13) * MC_LZ__P1;
+            v2 = mc_lz__rotl(v2 + mc_lz__read32(p + i + 4)  * MC_LZ__P2, 13) * MC_LZ__P1;
+            v3 = mc_lz__rotl(v3 + mc_lz__read32(p + i + 8)  * MC_LZ__P2, 13) * MC_LZ__P1;
+            v4 = mc_lz__rotl(v4 + mc_lz__read32(p + i + 12) * MC_LZ__P2, 13) * MC_LZ__P1;
+        }
+        h = mc_lz__rotl(v1, 1) + mc_lz__rotl(v2, 7) + mc_lz__rotl(v3, 12) + mc_lz__rotl(v4, 18);
+    } else {
+        h = MC_LZ__P5;
+    }
+    h += len;
+    for (; i + 4 <= len; i += 4) {
+        h += mc_lz__read32(p + i) * MC_LZ__P3;
+        h = mc_lz__rotl(h, 17) * MC_LZ__P4;
+    }
+    for (; i < len; i++) {
+        h += p[i] * MC_LZ__P5;
+        h = mc_lz__rotl(h, 11) * MC_LZ__P1;
+    }
+    h ^= h >> 15;
+    h *= MC_LZ__P2;
+    h ^= h >> 13;
+    h *= MC_LZ__P3;
+    h ^= h >> 16;
+    return h;
+}
+
+/* =========================================================================
+ * SECTION 3: BLOCK CODEC
+ * ========================================================================= */
+
+/* Match finder state. 16 KB; reset per block. */
+typedef struct {
+    uint32_t table[MC_LZ_HASH_SIZE];
+} McLzState;
+
+static uint32_t mc_lz__hash(uint32_t seq) {
+    return (seq * MC_LZ__P1) >> (32 - MC_LZ_HASH_LOG);
+}
+
+/* Write a length continuation (the part beyond the 15 in the token) */
+static uint32_t mc_lz__put_len(uint8_t* dst, uint32_t op, uint32_t len) {
+    while (len >= 255) {
+        dst[op++] = 255;
+        len -= 255;
+    }
+    dst[op++] = (uint8_t)len;
+    return op;
+}
+
+/* Emit one sequence. Returns new output offset, 0 if it doesn't fit. */
+static uint32_t mc_lz__emit(
+    uint8_t* dst, uint32_t op, uint32_t cap,
+    const uint8_t* lit, uint32_t lit_len, uint32_t offset, uint32_t match_len
+) {
+    uint32_t need = 1 + lit_len + lit_len / 255 + 1 + (match_len ? 2 + match_len / 255 + 1 : 0);
+    uint8_t* token;
+    if (need > cap - op) return 0;
+
+    token = &dst[op++];
+    *token = (uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15) op = mc_lz__put_len(dst, op, lit_len - 15);
+    memcpy(dst + op, lit, lit_len);
+    op += lit_len;
+
+    if (match_len != 0) {
+        uint32_t ml = match_len - MC_LZ_MIN_MATCH;
+        dst[op++] = (uint8_t)(offset & 0xFF);
+        dst[op++] = (uint8_t)(offset >> 8);
+        *token |= (uint8_t)(ml >= 15 ? 15 : ml);
+        if (ml >= 15) op = mc_lz__put_len(dst, op, ml - 15);
+    }
+    return op;
+}
+
+/* Compress `n` bytes (n <= MC_LZ_BLOCK_SIZE) into `dst`. Returns the
+ * compressed size, or 0 if it didn't fit in `cap`. Greedy single-probe
+ * matching; the scan step grows through incompressible stretches so
+ * random data costs little. */
+static uint32_t mc_lz_compress_block(
+    McLzState* st, const uint8_t* src, uint32_t n, uint8_t* dst, uint32_t cap
+) {
+    uint32_t ip = 0, anchor = 0, op = 0;
+
+    if (n > MC_LZ_BLOCK_SIZE) return 0;
+    memset(st->table, 0, sizeof(st->table));
+
+    if (n > MC_LZ_MFLIMIT) {
+        uint32_t limit       = n - MC_LZ_MFLIMIT;
+        uint32_t match_limit = n - MC_LZ_LAST_LITERALS;
+        uint32_t misses      = 0;
+        ip = 1;
+        while (ip < limit) {
+            uint32_t seq = mc_lz__read32(src + ip);
+            uint32_t h   = mc_lz__hash(seq);
+            uint32_t ref = st->table[h];
+            uint32_t len;
+            st->table[h] = ip;
+
+            if (ref >= ip || ip - ref > MC_LZ_MAX_OFFSET || mc_lz__read32(src + ref) != seq) {
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            /* Extend backwards into pending literals */
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            /* Extend forwards, 8 bytes at a time */
+            len = MC_LZ_MIN_MATCH;
+            while (ip + len + 8 <= match_limit
+                   && mc_lz__read64(src + ip + len) == mc_lz__read64(src + ref + len)) {
+                len += 8;
+            }
+            while (ip + len < match_limit && src[ip + len] == src[ref + len]) len++;
+
+            op = mc_lz__emit(dst, op, cap, src + anchor, ip - anchor, ip - ref, len);
+            if (op == 0) return 0;
+            ip += len;
+            anchor = ip;
+            if (ip >= 2 && ip < limit) {
+                st->table[mc_lz__hash(mc_lz__read32(src + ip - 2))] = ip - 2;
+            }
+        }
+    }
+
+    op = mc_lz__emit(dst, op, cap, src + anchor, n - anchor, 0, 0);
+    return op;
+}
+
+/* Decode one block. Returns 0 and sets *out_len, or -1 if the block is
+ * malformed or would overflow `cap`. Every read and write is bounds
+ * checked; short copies go 8 bytes at a time when there is room. */
+static int mc_lz_decompress_block(
+    const uint8_t* src, uint32_t n, uint8_t* dst, uint32_t cap, uint32_t* out_len
+) {
+    uint32_t ip = 0, op = 0;
+
+    for (;;) {
+        uint32_t token, lit, off, ml;
+        if (ip >= n) return -1;
+        token = src[ip++];
+
+        lit = token >> 4;
+        if (lit == 15) {
+            uint32_t b;
+            do {
+                if (ip >= n) return -1;
+                b = src[ip++];
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > n - ip || lit > cap - op) return -1;
+        if (lit <= 16 && ip + 16 <= n && op + 16 <= cap) {
+            memcpy(dst + op, src + ip, 8);
+            memcpy(dst + op + 8, src + ip + 8, 8);
+        } else {
+            memcpy(dst + op, src + ip, lit);
+        }
+        ip += lit;
+        op += lit;
+
+        if (ip == n) break;  /* last sequence has no match */
+
+        if (n - ip < 2) return -1;
+        off = (uint32_t)src[ip] | ((uint32_t)src[ip + 1] << 8);
+        ip += 2;
+        if (off == 0 || off > op) return -1;
+
+        ml = token & 15;
+        if (ml == 15) {
+            uint32_t b;
+            do {
+                if (ip >= n) return -1;
+                b = src[ip++];
+                ml += b;
+            } while (b == 255);
+        }
+        ml += MC_LZ_MIN_MATCH;
+        if (ml > cap - op) return -1;
+
+        if (off >= 8 && ml + 8 <= cap - op) {
+            /* Non-overlapping 8-byte steps; may write up to 7 bytes past
+             * the match, which the next sequence overwrites. */
+            uint32_t i;
+            for (i = 0; i < ml; i += 8) {
+                memcpy(dst + op + i, dst + op + i - off, 8);
+            }
+        } else {
+            uint32_t i;
+            for (i = 0; i < ml; i++) dst[op + i] = dst[op + i - off];
+        }
+        op += ml;
+    }
+
+    *out_len = op;
+    return 0;
+}
+
+/* =========================================================================
+ * SECTION 4: STREAMING FRAME WRITER
+ * ========================================================================= */
+
+typedef struct {
+    McLzState state;
+    uint8_t   stage[MC_LZ_BLOCK_SIZE];
+    uint32_t  fill;          /* bytes waiting in stage[] */
+    uint8_t*  out;
+    uint32_t  cap;
+    uint32_t  off;
+    uint32_t  block_count;
+    uint32_t  raw_size;
+    int       failed;        /* output overflowed; frame is unusable */
+} McLzWriter;
+
+static void mc_lz_writer_begin(McLzWriter* w, uint8_t* out, uint32_t cap) {
+    w->fill        = 0;
+    w->out         = out;
+    w->cap         = cap;
+    w->off         = (uint32_t)sizeof(LzFrameHeader);
+    w->block_count = 0;
+    w->raw_size    = 0;
+    w->failed      = (cap < sizeof(LzFrameHeader)) ? 1 : 0;
+}
+
+static void mc_lz__write_block(McLzWriter* w, const uint8_t* raw, uint32_t n) {
+    LzBlockHeader bh;
+    uint32_t hdr_at = w->off;
+    uint32_t body_at = hdr_at + (uint32_t)sizeof(LzBlockHeader);
+    uint32_t room, packed;
+
+    if (w->failed) return;
+    if (body_at > w->cap) {
+        w->failed = 1;
+        return;
+    }
+    room = w->cap - body_at;
+
+    /* Compress only into space that beats storing raw */
+    packed = mc_lz_compress_block(&w->state, raw, n, w->out + body_at, (room < n) ? room : n - 1);
+    if (packed != 0 && packed < n) {
+        bh.stored_size = packed;
+    } else {
+        if (n > room) {
+            w->failed = 1;
+            return;
+        }
+        memcpy(w->out + body_at, raw, n);
+        bh.stored_size = n | MC_LZ_STORED_FLAG;
+        packed = n;
+    }
+    bh.raw_size = n;
+    bh.checksum = mc_lz_checksum(raw, n);
+    memcpy(w->out + hdr_at, &bh, sizeof(bh));
+    w->off = body_at + packed;
+    w->block_count++;
+    w->raw_size += n;
+}
+
+/* Append bytes. Full blocks taken straight from `data` skip the stage. */
+static void mc_lz_writer_write(McLzWriter* w, const void* data, uint32_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0 && !w->failed) {
+        uint32_t take;
+        if (w->fill == 0 && len >= MC_LZ_BLOCK_SIZE) {
+            mc_lz__write_block(w, p, MC_LZ_BLOCK_SIZE);
+            p   += MC_LZ_BLOCK_SIZE;
+            len -= MC_LZ_BLOCK_SIZE;
+            continue;
+        }
+        take = MC_LZ_BLOCK_SIZE - w->fill;
+        if (take > len) take = len;
+        memcpy(w->stage + w->fill, p, take);
+        w->fill += take;
+        p       += take;
+        len     -= take;
+        if (w->fill == MC_LZ_BLOCK_SIZE) {
+            mc_lz__write_block(w, w->stage, w->fill);
+            w->fill = 0;
+        }
+    }
+}
+
+/* Flush the partial block and finish the header. Returns the frame size,
+ * or 0 if the output buffer was too small at any point. */
+static uint32_t mc_lz_writer_end(McLzWriter* w) {
+    LzFrameHeader hdr;
+    if (w->fill > 0) {
+        mc_lz__write_block(w, w->stage, w->fill);
+        w->fill = 0;
+    }
+    if (w->failed) return 0;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic       = MC_LZ_FRAME_MAGIC;
+    hdr.version     = MC_LZ_FRAME_VERSION;
+    hdr.header_size = (uint16_t)sizeof(LzFrameHeader);
+    hdr.block_size  = MC_LZ_BLOCK_SIZE;
+    hdr.block_count = w->block_count;
+    hdr.raw_size    = w->raw_size;
+    memcpy(w->out, &hdr, sizeof(hdr));
+    return w->off;
+}
+
+/* One-shot: compress `len` bytes into a frame. Returns frame size or 0. */
+static uint32_t mc_lz_frame_compress(
+    McLzWriter* w, const void* in, uint32_t len, uint8_t* out, uint32_t cap
+) {
+    mc_lz_writer_begin(w, out, cap);
+    mc_lz_writer_write(w, in, len);
+    return mc_lz_writer_end(w);
+}
+
+/* =========================================================================
+ * SECTION 5: STREAMING FRAME READER
+ * ========================================================================= */
+
+typedef struct {
+    const uint8_t* in;
+    uint32_t       len;
+    uint32_t       off;
+    uint32_t       block_index;
+    LzFrameHeader  header;
+} McLzReader;
+
+/* True if `in` starts with a frame header (cheap format sniffing) */
+static int mc_lz_is_frame(const uint8_t* in, uint32_t len) {
+    return len >= sizeof(LzFrameHeader) && mc_lz__read32(in) == MC_LZ_FRAME_MAGIC;
+}
+
+/* Raw size recorded in the frame header, 0 if `in` isn't a frame */
+static uint32_t mc_lz_frame_raw_size(const uint8_t* in, uint32_t len) {
+    LzFrameHeader hdr;
+    if (!mc_lz_is_frame(in, len)) return 0;
+    memcpy(&hdr, in, sizeof(hdr));
+    return hdr.raw_size;
+}
+
+static int mc_lz_reader_begin(McLzReader* r, const uint8_t* in, uint32_t len) {
+    if (!mc_lz_is_frame(in, len)) return -1;
+    memcpy(&r->header, in, sizeof(r->header));
+    if (r->header.version != MC_LZ_FRAME_VERSION
+        || r->header.header_size != sizeof(LzFrameHeader)
+        || r->header.block_size == 0 || r->header.block_size > MC_LZ_BLOCK_SIZE) return -1;
+    r->in          = in;
+    r->len         = len;
+    r->off         = r->header.header_size;
+    r->block_index = 0;
+    return 0;
+}
+
+/* Decode the next block into `dst`. Returns 1 with *out_len set, 0 at
+ * the end of the frame, -1 on truncation, corruption or checksum
+ * mismatch (or if `cap` is smaller than the block). */
+static int mc_lz_reader_next(McLzReader* r, uint8_t* dst, uint32_t cap, uint32_t* out_len) {
+    LzBlockHeader bh;
+    uint32_t stored, got = 0;
+
+    if (r->block_index == r->header.block_count) {
+        return (r->off == r->len) ? 0 : -1;
+    }
+    if (r->len - r->off < sizeof(bh)) return -1;
+    memcpy(&bh, r->in + r->off, sizeof(bh));
+    r->off += (uint32_t)sizeof(bh);
+
+    stored = bh.stored_size & ~MC_LZ_STORED_FLAG;
+    if (stored > r->len - r->off) return -1;
+    if (bh.raw_size > r->header.block_size || bh.raw_size > cap) return -1;
+
+    if (bh.stored_size & MC_LZ_STORED_FLAG) {
+        if (stored != bh.raw_size) return -1;
+        memcpy(dst, r->in + r->off, stored);
+        got = stored;
+    } else if (mc_lz_decompress_block(r->in + r->off, stored, dst, bh.raw_size, &got) != 0) {
+        return -1;
+    }
+    if (got != bh.raw_size || mc_lz_checksum(dst, got) != bh.checksum) return -1;
+
+    r->off += stored;
+    r->block_index++;
+    *out_len = got;
+    return 1;
+}
+
+/* One-shot: decode a whole frame into `out`. Returns 0 and sets
+ * *out_len, or -1 on any error. */
+static int mc_lz_frame_decompress(
+    const uint8_t* in, uint32_t len, uint8_t* out, uint32_t cap, uint32_t* out_len
+) {
+    McLzReader r;
+    uint32_t total = 0, got;
+    int rc;
+    if (mc_lz_reader_begin(&r, in, len) != 0) return -1;
+    if (r.header.raw_size > cap) return -1;
+    while ((rc = mc_lz_reader_next(&r, out + total, cap - total, &got)) == 1) {
+        total += got;
+    }
+    if (rc != 0 || total != r.header.raw_size) return -1;
+    *out_len = total;
+    return 0;
+}
+
+#endif /* MARBLE_LZ_H */
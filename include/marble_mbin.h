@@ -0,0 +1,365 @@
+/*
+ * marble_mbin.h -- Binary World Manifest (.mbin) (Phase 0.4)
+ *
+ * PURPOSE:
+ *   "Binary Caching: compiled world states for instant load times."
+ *   A .mbin file is a world whose component pools are already packed
+ *   exactly the way SparseSet stores them. Loading is one memcpy for
+ *   the dense IDs and one memcpy for the data block per pool, followed
+ *   by an O(count) rebuild of sparse[]. No per-entity parsing, no
+ *   per-entity mc_sparse_set_add.
+ *
+ * FILE LAYOUT (little-endian, all offsets from file start):
+ *
+ *   +--------------------+  0
+ *   | MbinHeader         |  32 bytes
+ *   +--------------------+
+ *   | MbinPoolDesc[n]    |  32 bytes each
+ *   +--------------------+  (64-byte aligned)
+ *   | pool 0 dense[]     |  count * 4 bytes
+ *   +--------------------+  (64-byte aligned)
+ *   | pool 0 data[]      |  count * stride bytes
+ *   +--------------------+
+ *   | ... pool 1..n-1    |
+ *   +--------------------+  file_size
+ *
+ *   Blocks are 64-byte aligned so a mapping can be used in place:
+ *   mc_mbin_pool_data() hands back a pointer straight into the file
+ *   for read-only definition pools that never need a private copy.
+ *
+ * PRODUCERS:
+ *   - scripts/core/marble_compile.lua <world.marble> --mbin <out.mbin>
+ *   - mc_mbin_write() -- bakes live pools (tools, tests, snapshots)
+ *
+ * CONSUMER:
+ *   - Loader_LoadWorldBinary() in marble_loader.h
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_MBIN_H
+#define MARBLE_MBIN_H
+
+#include "marble_core.h"
+
+/* =========================================================================
+ * SECTION 1: FORMAT
+ * ========================================================================= */
+
+#define MC_MBIN_MAGIC       0x4E49424Du   /* "MBIN" */
+#define MC_MBIN_VERSION     1
+#define MC_MBIN_ALIGN       64
+#define MC_MBIN_MAX_POOLS   32
+
+typedef struct {
+    uint32_t magic;         /* MC_MBIN_MAGIC */
+    uint16_t version;       /* MC_MBIN_VERSION */
+    uint16_t header_size;   /* sizeof(MbinHeader) */
+    uint32_t entity_count;  /* allocator high-water mark */
+    uint32_t pool_count;    /* number of MbinPoolDesc records */
+    uint32_t file_size;     /* total bytes, header included */
+    uint32_t checksum;      /* FNV-1a over bytes [header_size, file_size),
+                               checked by mc_mbin_verify_checksum() only */
+    uint32_t reserved[2];
+} MbinHeader;
+
+typedef struct {
+    uint32_t comp_type;     /* ComponentType (marble_loader.h) */
+    uint32_t stride;        /* sizeof(component) -- must match the pool */
+    uint32_t count;         /* live entries */
+    uint32_t dense_offset;  /* EntityID[count] */
+    uint32_t data_offset;   /* uint8_t[count * stride] */
+    uint32_t reserved[3];
+} MbinPoolDesc;
+
+static uint32_t mc_mbin__align(uint32_t off) {
+    return (off + (MC_MBIN_ALIGN - 1)) & ~(uint32_t)(MC_MBIN_ALIGN - 1);
+}
+
+static uint32_t mc_mbin_checksum(const uint8_t* bytes, uint32_t len) {
+    uint32_t h = 2166136261u;
+    uint32_t i;
+    for (i = 0; i < len; i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static const MbinHeader* mc_mbin_header(const uint8_t* image) {
+    return (const MbinHeader*)image;
+}
+
+static const MbinPoolDesc* mc_mbin_pool_desc(const uint8_t* image, uint32_t pool) {
+    return (const MbinPoolDesc*)(image + sizeof(MbinHeader)) + pool;
+}
+
+/* =========================================================================
+ * SECTION 2: VALIDATION
+ *
+ * Everything the loader trusts is checked here once: magic, version,
+ * sizes, every block in bounds, one pool per comp_type, every EntityID
+ * below entity_count and unique within its pool. After this passes the
+ * loader does no checks. Only the header, the descriptors and the
+ * dense[] blocks are read; data blocks are left to the pool copy.
+ *
+ * The checksum is a byte-at-a-time pass over the whole file, so it is
+ * opt-in: call mc_mbin_verify_checksum() for images that may be damaged
+ * or tampered with (downloads, mods). The structural checks alone keep a
+ * bad image from corrupting memory; the checksum catches bad payloads.
+ * ========================================================================= */
+
+/* Returns 0 if `image` is a well-formed manifest, -1 otherwise. */
+static int mc_mbin_validate(const uint8_t* image, uint64_t len) {
+    const MbinHeader* hdr;
+    uint32_t seen[MC_MAX_ENTITIES / 32];
+    uint32_t p, i;
+
+    if (image == NULL || len < sizeof(MbinHeader)) return -1;
+    if (((uintptr_t)image & 3u) != 0) return -1;
+    hdr = mc_mbin_header(image);
+    if (hdr->magic != MC_MBIN_MAGIC) return -1;
+    if (hdr->version != MC_MBIN_VERSION) return -1;
+    if (hdr->header_size != sizeof(MbinHeader)) return -1;
+    if (hdr->file_size != len) return -1;
+    if (hdr->entity_count > MC_MAX_ENTITIES) return -1;
+    if (hdr->pool_count > MC_MBIN_MAX_POOLS) return -1;
+    if (sizeof(MbinHeader) + (uint64_t)hdr->pool_count * sizeof(MbinPoolDesc) > len) return -1;
+
+    for (p = 0; p < hdr->pool_count; p++) {
+        const MbinPoolDesc* pd = mc_mbin_pool_desc(image, p);
+        const EntityID* dense;
+        uint32_t q;
+        for (q = 0; q < p; q++) {
+            /* Two pools of one type would load over each other */
+            if (mc_mbin_pool_desc(image, q)->comp_type == pd->comp_type) return -1;
+        }
+        if (pd->stride == 0 || pd->stride > 64) return -1;
+        if (pd->count > MC_MAX_ENTITIES) return -1;
+        if ((pd->dense_offset & (MC_MBIN_ALIGN - 1)) != 0) return -1;
+        if ((pd->data_offset & (MC_MBIN_ALIGN - 1)) != 0) return -1;
+        if ((uint64_t)pd->dense_offset + (uint64_t)pd->count * sizeof(EntityID) > len) return -1;
+        if ((uint64_t)pd->data_offset + (uint64_t)pd->count * pd->stride > len) return -1;
+
+        dense = (const EntityID*)(image + pd->dense_offset);
+        memset(seen, 0, sizeof(seen));
+        for (i = 0; i < pd->count; i++) {
+            EntityID eid = dense[i];
+            if (eid >= hdr->entity_count) return -1;
+            if (seen[eid >> 5] & (1u << (eid & 31))) return -1;  /* duplicate */
+            seen[eid >> 5] |= 1u << (eid & 31);
+        }
+    }
+    return 0;
+}
+
+/* Returns 0 if the payload matches the header checksum, -1 otherwise.
+ * Reads every byte of the file; call after mc_mbin_validate(). */
+static int mc_mbin_verify_checksum(const uint8_t* image) {
+    const MbinHeader* hdr = mc_mbin_header(image);
+    return (mc_mbin_checksum(image + sizeof(MbinHeader),
+                             hdr->file_size - (uint32_t)sizeof(MbinHeader)) == hdr->checksum) ? 0 : -1;
+}
+
+/* =========================================================================
+ * SECTION 3: POOL ACCESS
+ *
+ * All functions below assume mc_mbin_validate() succeeded.
+ * ========================================================================= */
+
+/* Find the descriptor for a component type. Returns NULL if absent. */
+static const MbinPoolDesc* mc_mbin_find_pool(const uint8_t* image, uint32_t comp_type) {
+    uint32_t p;
+    for (p = 0; p < mc_mbin_header(image)->pool_count; p++) {
+        const MbinPoolDesc* pd = mc_mbin_pool_desc(image, p);
+        if (pd->comp_type == comp_type) return pd;
+    }
+    return NULL;
+}
+
+/* Zero-copy views into the image. Valid as long as the image is. */
+static const EntityID* mc_mbin_pool_dense(const uint8_t* image, const MbinPoolDesc* pd) {
+    return (const EntityID*)(image + pd->dense_offset);
+}
+
+static const void* mc_mbin_pool_data(const uint8_t* image, const MbinPoolDesc* pd) {
+    return image + pd->data_offset;
+}
+
+/* Replace the contents of `ss` with the pool described by `pd`.
+ * Returns 0 on success, -1 if the pool's stride doesn't match. */
+static int mc_mbin_load_pool(SparseSet* ss, const uint8_t* image, const MbinPoolDesc* pd) {
+    uint32_t i;
+    if (pd->stride != ss->stride) return -1;
+
+    /* Drop whatever was there (only the slots actually in use) */
+    for (i = 0; i < ss->count; i++) {
+        ss->sparse[ss->dense[i]] = MC_INVALID_INDEX;
+    }
+
+    memcpy(ss->dense, image + pd->dense_offset, (size_t)pd->count * sizeof(EntityID));
+    memcpy(ss->data,  image + pd->data_offset,  (size_t)pd->count * pd->stride);
+    ss->count = pd->count;
+
+    for (i = 0; i < ss->count; i++) {
+        ss->sparse[ss->dense[i]] = i;
+    }
+    mc_sparse_set_mark_all_dirty(ss);
+    mc_sparse_set_rehash(ss);
+    return 0;
+}
+
+/* =========================================================================
+ * SECTION 4: WRITER
+ *
+ * Bakes live pools into a manifest image. `comp_types[i]` tags `pools[i]`.
+ * Returns bytes written, or 0 if `cap` is too small.
+ * mc_mbin_write_size() gives the exact size needed.
+ * ========================================================================= */
+
+static uint32_t mc_mbin_write_size(const SparseSet* const* pools, uint32_t pool_count) {
+    uint32_t off = mc_mbin__align((uint32_t)(sizeof(MbinHeader) + pool_count * sizeof(MbinPoolDesc)));
+    uint32_t p;
+    for (p = 0; p < pool_count; p++) {
+        off = mc_mbin__align(off + pools[p]->count * (uint32_t)sizeof(EntityID));
+        off = mc_mbin__align(off + pools[p]->count * pools[p]->stride);
+    }
+    return off;
+}
+
+static uint32_t mc_mbin_write(
+    uint8_t* out, uint32_t cap,
+    const EntityAllocator* alloc,
+    const SparseSet* const* pools, const uint32_t* comp_types, uint32_t pool_count
+) {
+    MbinHeader hdr;
+    uint32_t size = mc_mbin_write_size(pools, pool_count);
+    uint32_t off, p;
+
+    if (pool_count > MC_MBIN_MAX_POOLS || size > cap) return 0;
+    memset(out, 0, size);
+
+    off = mc_mbin__align((uint32_t)(sizeof(MbinHeader) + pool_count * sizeof(MbinPoolDesc)));
+    for (p = 0; p < pool_count; p++) {
+        MbinPoolDesc pd;
+        const SparseSet* ss = pools[p];
+        memset(&pd, 0, sizeof(pd));
+        pd.comp_type    = comp_types[p];
+        pd.stride       = ss->stride;
+        pd.count        = ss->count;
+        pd.dense_offset = off;
+        memcpy(out + off, ss->dense, ss->count * sizeof(EntityID));
+        off = mc_mbin__align(off + ss->count * (uint32_t)sizeof(EntityID));
+        pd.data_offset  = off;
+        memcpy(out + off, ss->data, (size_t)ss->count * ss->stride);
+        off = mc_mbin__align(off + ss->count * ss->stride);
+        memcpy(out + sizeof(MbinHeader) + p * sizeof(MbinPoolDesc), &pd, sizeof(pd));
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic        = MC_MBIN_MAGIC;
+    hdr.version      = MC_MBIN_VERSION;
+    hdr.header_size  = (uint16_t)sizeof(MbinHeader);
+    hdr.entity_count = alloc->next_id;
+    hdr.pool_count   = pool_count;
+    hdr.file_size    = size;
+    hdr.checksum     = mc_mbin_checksum(out + sizeof(MbinHeader), size - (uint32_t)sizeof(MbinHeader));
+    memcpy(out, &hdr, sizeof(hdr));
+    return size;
+}
+
+/* =========================================================================
+ * SECTION 5: FILE MAPPING
+ *
+ * Maps a .mbin read-only. mc_mbin_validate() faults in the descriptor
+ * and dense[] pages; data pages are faulted in by the pool memcpy, so
+ * data that isn't loaded is never read from disk -- unless the caller
+ * opts in to mc_mbin_verify_checksum(), which reads the whole file.
+ * ========================================================================= */
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    const uint8_t* base;
+    uint64_t       size;
+#ifdef _WIN32
+    HANDLE         file;
+    HANDLE         mapping;
+#else
+    int            fd;
+#endif
+} MbinMapping;
+
+/* Returns 0 on success, -1 if the file can't be opened or mapped. */
+static int mc_mbin_map(MbinMapping* m, const char* path) {
+    memset(m, 0, sizeof(*m));
+#ifdef _WIN32
+    {
+        LARGE_INTEGER sz;
+        m->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m->file == INVALID_HANDLE_VALUE) return -1;
+        if (!GetFileSizeEx(m->file, &sz) || sz.QuadPart == 0) {
+            CloseHandle(m->file);
+            return -1;
+        }
+        m->mapping = CreateFileMappingA(m->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m->mapping == NULL) {
+            CloseHandle(m->file);
+            return -1;
+        }
+        m->base = (const uint8_t*)MapViewOfFile(m->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m->base == NULL) {
+            CloseHandle(m->mapping);
+            CloseHandle(m->file);
+            return -1;
+        }
+        m->size = (uint64_t)sz.QuadPart;
+    }
+#else
+    {
+        struct stat st;
+        void* p;
+        m->fd = open(path, O_RDONLY);
+        if (m->fd < 0) return -1;
+        if (fstat(m->fd, &st) != 0 || st.st_size <= 0) {
+            close(m->fd);
+            return -1;
+        }
+        p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, m->fd, 0);
+        if (p == MAP_FAILED) {
+            close(m->fd);
+            return -1;
+        }
+        m->base = (const uint8_t*)p;
+        m->size = (uint64_t)st.st_size;
+    }
+#endif
+    return 0;
+}
+
+static void mc_mbin_unmap(MbinMapping* m) {
+    if (m->base == NULL) return;
+#ifdef _WIN32
+    UnmapViewOfFile((LPCVOID)m->base);
+    CloseHandle(m->mapping);
+    CloseHandle(m->file);
+#else
+    munmap((void*)m->base, (size_t)m->size);
+    close(m->fd);
+#endif
+    m->base = NULL;
+    m->size = 0;
+}
+
+#endif /* MARBLE_MBIN_H */
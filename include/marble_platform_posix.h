@@ -0,0 +1,97 @@
+/*
+ * marble_platform_posix.h — Linux/macOS platform shim (Phase 0.4)
+ *
+ * Provides the same API as marble_platform_win32.h:
+ *   mc_platform_init()           — calibrate the wakeup spin margin
+ *   mc_platform_time_us()        — microsecond time via CLOCK_MONOTONIC
+ *   mc_platform_sleep_us()       — relative sleep via nanosleep()
+ *   mc_platform_sleep_until_us() — absolute-deadline clock_nanosleep()
+ *                                  followed by a short spin
+ *
+ * The tick loop waits on deadlines, not durations: sleeping until an
+ * absolute time can't accumulate drift from the work done between
+ * sleeps, and the final spin removes the kernel's wakeup latency
+ * (typically 50-100 us of timer slack) from tick-start jitter.
+ *
+ * BUILD:
+ *   Under -std=c99 the including .c file must define
+ *   _POSIX_C_SOURCE >= 200112L before its first #include.
+ */
+
+#ifndef MARBLE_PLATFORM_POSIX_H
+#define MARBLE_PLATFORM_POSIX_H
+
+#ifndef _WIN32
+
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+
+#if !defined(CLOCK_MONOTONIC) || !defined(TIMER_ABSTIME)
+#error "marble_platform_posix.h needs clock_nanosleep(): define _POSIX_C_SOURCE 200112L before the first #include"
+#endif
+
+/* Bounds on the calibrated spin margin */
+#define MC_PLATFORM_SPIN_MIN_US   20
+#define MC_PLATFORM_SPIN_MAX_US 2000
+#define MC_PLATFORM_CALIBRATION_SLEEPS 16
+
+/* How far ahead of a deadline clock_nanosleep() hands over to the spin.
+ * Set by mc_platform_init() from measured wakeup latency. */
+static uint64_t g_spin_us = 200;
+
+static uint64_t mc_platform_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/* Sleep for approximately `us` microseconds. */
+static void mc_platform_sleep_us(uint64_t us) {
+    struct timespec req;
+    req.tv_sec  = (time_t)(us / 1000000ULL);
+    req.tv_nsec = (long)((us % 1000000ULL) * 1000ULL);
+    while (nanosleep(&req, &req) != 0 && errno == EINTR) { }
+}
+
+/* Kernel sleep until CLOCK_MONOTONIC reaches `deadline_us`. Absolute,
+ * so an EINTR retry waits for the same moment rather than restarting. */
+static void mc_platform__nanosleep_until(uint64_t deadline_us) {
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(deadline_us / 1000000ULL);
+    ts.tv_nsec = (long)((deadline_us % 1000000ULL) * 1000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) { }
+}
+
+/* Return no earlier than `deadline_us` and as soon after it as the
+ * scheduler allows: kernel sleep to deadline - spin margin, then spin. */
+static void mc_platform_sleep_until_us(uint64_t deadline_us) {
+    uint64_t now = mc_platform_time_us();
+    if (deadline_us > now + g_spin_us) {
+        mc_platform__nanosleep_until(deadline_us - g_spin_us);
+    }
+    while (mc_platform_time_us() < deadline_us) { }
+}
+
+/* Measure how late clock_nanosleep() wakes on this machine and set the
+ * spin margin to the worst lateness seen plus 50%. Takes ~10 ms. */
+static void mc_platform_init(void) {
+    uint64_t worst = 0;
+    uint32_t i;
+    for (i = 0; i < MC_PLATFORM_CALIBRATION_SLEEPS; i++) {
+        uint64_t deadline = mc_platform_time_us() + 500;
+        uint64_t late;
+        mc_platform__nanosleep_until(deadline);
+        late = mc_platform_time_us() - deadline;
+        if (late > worst) worst = late;
+    }
+    g_spin_us = worst + worst / 2;
+    if (g_spin_us < MC_PLATFORM_SPIN_MIN_US) g_spin_us = MC_PLATFORM_SPIN_MIN_US;
+    if (g_spin_us > MC_PLATFORM_SPIN_MAX_US) g_spin_us = MC_PLATFORM_SPIN_MAX_US;
+}
+
+#else
+#error "This header is POSIX-only. Use marble_platform_win32.h on Windows."
+#endif /* _WIN32 */
+
+#endif /* MARBLE_PLATFORM_POSIX_H */
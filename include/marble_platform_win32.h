@@ -2,11 +2,16 @@
  * marble_platform_win32.h — Windows 10 platform shim (Phase 0)
  *
  * Provides:
- *   mc_platform_time_us()  — microsecond wall-clock via QueryPerformanceCounter
- *   mc_platform_sleep_us() — OS yield via Sleep()
+ *   mc_platform_time_us()        — microsecond wall-clock via QueryPerformanceCounter
+ *   mc_platform_sleep_us()       — OS yield via Sleep()
+ *   mc_platform_sleep_until_us() — Sleep() to near a deadline, then spin
  *
  * This is the ONLY file that includes <windows.h>.
- * In Phase 1+, Linux/macOS shims go in separate headers with the same API.
+ * Linux/macOS: marble_platform_posix.h, same API.
+ *
+ * BUILD:
+ *   Needs winmm (timeBeginPeriod): -lwinmm with MinGW; MSVC links it
+ *   through the #pragma below.
  */
 
 #ifndef MARBLE_PLATFORM_WIN32_H
@@ -16,16 +21,28 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <mmsystem.h>   /* timeBeginPeriod */
 #include <stdint.h>
 
+#ifdef _MSC_VER
+#pragma comment(lib, "winmm.lib")
+#endif
+
+/* Bounds on the calibrated spin margin. With the 1 ms timer period
+ * Sleep(1) wakes within ~1-2 ms, so the cap matches the POSIX path;
+ * if the period can't be raised, Sleep() rounds up to the ~15.6 ms
+ * default quantum and the fallback cap covers that instead. */
+#define MC_PLATFORM_SPIN_MIN_US           1000
+#define MC_PLATFORM_SPIN_MAX_US           2000
+#define MC_PLATFORM_SPIN_MAX_COARSE_US   20000
+#define MC_PLATFORM_CALIBRATION_SLEEPS 8
+
 /* Cache the QPC frequency at init. Call once before any time queries. */
 static LARGE_INTEGER g_qpc_freq;
 static int g_qpc_initialized = 0;
 
-static void mc_platform_init(void) {
-    QueryPerformanceFrequency(&g_qpc_freq);
-    g_qpc_initialized = 1;
-}
+/* How far ahead of a deadline Sleep() hands over to the spin */
+static uint64_t g_spin_us = 2000;
 
 /* Returns current wall-clock time in microseconds. */
 static uint64_t mc_platform_time_us(void) {
@@ -45,6 +62,39 @@ static void mc_platform_sleep_us(uint64_t us) {
     Sleep(ms);
 }
 
+/* Return no earlier than `deadline_us`: Sleep() while the deadline is
+ * more than the spin margin away, then spin on QPC. */
+static void mc_platform_sleep_until_us(uint64_t deadline_us) {
+    uint64_t now = mc_platform_time_us();
+    if (deadline_us > now + g_spin_us) {
+        mc_platform_sleep_us(deadline_us - now - g_spin_us);
+    }
+    while (mc_platform_time_us() < deadline_us) { }
+}
+
+/* Raise the system timer resolution to 1 ms for the life of the
+ * process (Windows drops it at exit), then measure how far Sleep(1)
+ * still overshoots and set the spin margin to the worst overshoot
+ * plus 50%. */
+static void mc_platform_init(void) {
+    uint64_t worst = 0, cap = MC_PLATFORM_SPIN_MAX_US;
+    int i;
+    QueryPerformanceFrequency(&g_qpc_freq);
+    g_qpc_initialized = 1;
+    if (timeBeginPeriod(1) != TIMERR_NOERROR) cap = MC_PLATFORM_SPIN_MAX_COARSE_US;
+    for (i = 0; i < MC_PLATFORM_CALIBRATION_SLEEPS; i++) {
+        uint64_t t0 = mc_platform_time_us();
+        uint64_t late;
+        Sleep(1);
+        late = mc_platform_time_us() - t0;
+        late = (late > 1000) ? late - 1000 : 0;
+        if (late > worst) worst = late;
+    }
+    g_spin_us = worst + worst / 2;
+    if (g_spin_us < MC_PLATFORM_SPIN_MIN_US) g_spin_us = MC_PLATFORM_SPIN_MIN_US;
+    if (g_spin_us > cap) g_spin_us = cap;
+}
+
 #else
 #error "This header is Windows-only. Use marble_platform_posix.h for Linux/macOS."
 #endif /* _WIN32 */
@@ -0,0 +1,430 @@
+/*
+ * marble_profile.h -- Tick Profiler (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Show which system blew the tick budget, not just that the tick
+ *   overran. Hosts wrap each system, the command flush and snapshot
+ *   building in a zone. The profiler keeps per-zone duration histograms
+ *   (p50/p99/max) and a ring of recent zone events per thread. The ring
+ *   can be dumped as a Chrome trace (chrome://tracing, Perfetto) on
+ *   demand or automatically when a tick runs over budget.
+ *
+ * ARCHITECTURE:
+ *   McProfiler holds MC_PROF_MAX_THREADS slots. Each recording thread
+ *   owns one slot by index (main loop = 0, runtime worker N = N) and is
+ *   its only writer, so recording takes no locks. A zone costs two clock
+ *   reads, one ring write and one histogram increment.
+ *
+ *   Histograms are log-linear: four buckets per power of two of
+ *   nanoseconds, under 20% relative error. Percentiles come from a fixed
+ *   bucket array per zone; samples are never stored.
+ *
+ *   Reports and trace dumps read every slot. Call them while the
+ *   recording threads are idle (between ticks, after a runtime join).
+ *
+ * CLOCK:
+ *   Win32: QueryPerformanceCounter. POSIX: clock_gettime(CLOCK_MONOTONIC)
+ *   (a vDSO call, ~20 ns). Under -std=c99 the including .c file must
+ *   define _POSIX_C_SOURCE >= 199309L before its first #include.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_PROFILE_H
+#define MARBLE_PROFILE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#ifndef CLOCK_MONOTONIC
+#error "marble_profile.h needs clock_gettime(): define _POSIX_C_SOURCE 199309L before the first #include"
+#endif
+#endif
+
+/* =========================================================================
+ * SECTION 1: CONFIGURATION
+ * ========================================================================= */
+
+#define MC_PROF_MAX_THREADS   16     /* matches MC_THREAD_MAX_WORKERS */
+#define MC_PROF_MAX_ZONES     32
+#define MC_PROF_MAX_DEPTH      8     /* deeper zones are counted, not timed */
+#define MC_PROF_RING_EVENTS 2048     /* per thread, power of two */
+#define MC_PROF_HIST_BUCKETS 160     /* 4 per octave up to 2^41 ns (~36 min) */
+
+/* Built-in zones. Host systems use MC_PROF_ZONE_FIRST_SYSTEM + SystemID. */
+typedef enum {
+    MC_PROF_ZONE_TICK = 0,       /* whole tick: mc_prof_tick_begin/_end */
+    MC_PROF_ZONE_CMD_FLUSH,      /* timers + command buffer flush */
+    MC_PROF_ZONE_SNAPSHOT,       /* snapshot build + serialize */
+    MC_PROF_ZONE_FIRST_SYSTEM
+} McProfZone;
+
+#ifndef MC_NO_PROFILE
+#define MC_PROF_BEGIN(p, slot, zone) mc_prof_begin((p), (slot), (zone))
+#define MC_PROF_END(p, slot)         mc_prof_end((p), (slot))
+#else
+#define MC_PROF_BEGIN(p, slot, zone) ((void)0)
+#define MC_PROF_END(p, slot)         ((void)0)
+#endif
+
+/* =========================================================================
+ * SECTION 2: DATA
+ * ========================================================================= */
+
+/* One completed zone. 24 bytes. */
+typedef struct {
+    uint64_t start_ns;    /* relative to McProfiler.epoch_ns */
+    uint32_t dur_ns;      /* saturates at ~4.29 s */
+    uint32_t tick;        /* low 32 bits of the tick it ran in */
+    uint16_t zone;
+    uint16_t depth;
+} McProfEvent;
+
+typedef struct {
+    uint32_t bucket[MC_PROF_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} McProfHist;
+
+typedef struct {
+    McProfEvent ring[MC_PROF_RING_EVENTS];
+    uint64_t    written;                         /* events ever recorded */
+    uint64_t    open_start[MC_PROF_MAX_DEPTH];
+    uint16_t    open_zone[MC_PROF_MAX_DEPTH];
+    uint32_t    depth;                           /* may exceed MAX_DEPTH */
+    uint32_t    too_deep;                        /* zones not timed */
+    uint64_t    tick;
+    uint64_t    tick_zone_ns[MC_PROF_MAX_ZONES]; /* inclusive time this tick */
+    McProfHist  hist[MC_PROF_MAX_ZONES];
+    const char* name;
+} McProfThread;
+
+/* The most recent over-budget tick and where its time went */
+typedef struct {
+    uint64_t tick;
+    uint64_t dur_ns;
+    uint32_t worst_zone;   /* zone (not the tick itself) with the most time */
+    uint64_t worst_ns;
+    uint32_t slot;
+} McProfSlowTick;
+
+typedef struct {
+    McProfThread   threads[MC_PROF_MAX_THREADS];
+    const char*    zone_names[MC_PROF_MAX_ZONES];
+    uint64_t       epoch_ns;
+
+    uint64_t       slow_tick_ns;      /* budget; 0 = trigger off */
+    char           trace_path[256];   /* dump here on a slow tick; "" = don't */
+    uint32_t       dumps_left;
+    uint32_t       slow_ticks;
+    McProfSlowTick last_slow;
+} McProfiler;
+
+/* Per-zone summary across all slots */
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+} McProfStats;
+
+/* =========================================================================
+ * SECTION 3: CLOCK
+ * ========================================================================= */
+
+#ifdef _WIN32
+static uint64_t mc_prof_now_ns(void) {
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    /* Split to keep now * 1e9 from overflowing */
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000ull
+         + (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000ull / (uint64_t)freq.QuadPart;
+}
+#else
+static uint64_t mc_prof_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+/* =========================================================================
+ * SECTION 4: HISTOGRAM
+ *
+ * Values 0..3 get their own bucket. Above that, bucket = 4 * (octave - 1)
+ * + the two bits after the leading one.
+ * ========================================================================= */
+
+static uint32_t mc_prof__bucket(uint64_t ns) {
+    uint32_t e = 0;
+    uint64_t v = ns;
+    uint32_t b;
+    if (ns < 4) return (uint32_t)ns;
+    while (v > 1) { v >>= 1; e++; }              /* e = floor(log2 ns) >= 2 */
+    b = (e - 1) * 4 + (uint32_t)((ns >> (e - 2)) & 3u);
+    return (b < MC_PROF_HIST_BUCKETS) ? b : MC_PROF_HIST_BUCKETS - 1;
+}
+
+/* Smallest value that lands in bucket b */
+static uint64_t mc_prof__bucket_low(uint32_t b) {
+    if (b < 4) return b;
+    return (uint64_t)(4 + (b & 3u)) << (b / 4 - 1);
+}
+
+static void mc_prof__hist_add(McProfHist* h, uint64_t ns) {
+    h->bucket[mc_prof__bucket(ns)]++;
+    h->count++;
+    h->total_ns += ns;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+/* Value at quantile q (0..1): upper edge of the bucket holding it,
+ * clamped to the exact max. */
+static uint64_t mc_prof__hist_quantile(const McProfHist* h, double q) {
+    uint64_t rank, seen = 0;
+    uint32_t b;
+    if (h->count == 0) return 0;
+    rank = (uint64_t)(q * (double)h->count);
+    if (rank >= h->count) rank = h->count - 1;
+    for (b = 0; b < MC_PROF_HIST_BUCKETS; b++) {
+        seen += h->bucket[b];
+        if (seen > rank) {
+            uint64_t hi = (b + 1 < MC_PROF_HIST_BUCKETS) ? mc_prof__bucket_low(b + 1) - 1 : h->max_ns;
+            return (hi < h->max_ns) ? hi : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+/* =========================================================================
+ * SECTION 5: RECORDING
+ * ========================================================================= */
+
+static void mc_prof_init(McProfiler* p) {
+    memset(p, 0, sizeof(McProfiler));
+    p->zone_names[MC_PROF_ZONE_TICK]      = "tick";
+    p->zone_names[MC_PROF_ZONE_CMD_FLUSH] = "cmd_flush";
+    p->zone_names[MC_PROF_ZONE_SNAPSHOT]  = "snapshot";
+    p->epoch_ns = mc_prof_now_ns();
+}
+
+/* `name` must outlive the profiler (a string literal or static table) */
+static void mc_prof_zone_name(McProfiler* p, uint32_t zone, const char* name) {
+    if (zone < MC_PROF_MAX_ZONES) p->zone_names[zone] = name;
+}
+
+static void mc_prof_thread_name(McProfiler* p, uint32_t slot, const char* name) {
+    if (slot < MC_PROF_MAX_THREADS) p->threads[slot].name = name;
+}
+
+/* Dump a trace to `path` on each of the next `max_dumps` ticks that take
+ * longer than `budget_us`. path may be NULL to only count and record
+ * them in last_slow. budget_us = 0 turns the trigger off. */
+static void mc_prof_set_slow_trigger(McProfiler* p, uint64_t budget_us,
+                                     const char* path, uint32_t max_dumps) {
+    p->slow_tick_ns = budget_us * 1000u;
+    p->trace_path[0] = '\0';
+    if (path != NULL) {
+        strncpy(p->trace_path, path, sizeof(p->trace_path) - 1);
+        p->trace_path[sizeof(p->trace_path) - 1] = '\0';
+    }
+    p->dumps_left = max_dumps;
+}
+
+/* Record a finished zone. mc_prof_end() calls this; tests and hosts
+ * with their own clock may call it directly. */
+static void mc_prof_record(McProfiler* p, uint32_t slot, uint32_t zone,
+                           uint64_t start_ns, uint64_t dur_ns) {
+    McProfThread* t;
+    McProfEvent* e;
+    if (slot >= MC_PROF_MAX_THREADS || zone >= MC_PROF_MAX_ZONES) return;
+    t = &p->threads[slot];
+
+    e = &t->ring[t->written & (MC_PROF_RING_EVENTS - 1)];
+    e->start_ns = start_ns - p->epoch_ns;
+    e->dur_ns   = (dur_ns > 0xFFFFFFFFull) ? 0xFFFFFFFFu : (uint32_t)dur_ns;
+    e->tick     = (uint32_t)t->tick;
+    e->zone     = (uint16_t)zone;
+    e->depth    = (uint16_t)t->depth;
+    t->written++;
+
+    t->tick_zone_ns[zone] += dur_ns;
+    mc_prof__hist_add(&t->hist[zone], dur_ns);
+}
+
+static void mc_prof_begin(McProfiler* p, uint32_t slot, uint32_t zone) {
+    McProfThread* t;
+    if (slot >= MC_PROF_MAX_THREADS) return;
+    t = &p->threads[slot];
+    if (t->depth < MC_PROF_MAX_DEPTH) {
+        t->open_zone[t->depth]  = (uint16_t)zone;
+        t->open_start[t->depth] = mc_prof_now_ns();
+    } else {
+        t->too_deep++;
+    }
+    t->depth++;
+}
+
+/* Closes the innermost open zone. Returns its duration in ns. */
+static uint64_t mc_prof_end(McProfiler* p, uint32_t slot) {
+    McProfThread* t;
+    uint64_t now, dur;
+    if (slot >= MC_PROF_MAX_THREADS) return 0;
+    t = &p->threads[slot];
+    if (t->depth == 0) return 0;
+    t->depth--;
+    if (t->depth >= MC_PROF_MAX_DEPTH) return 0;
+    now = mc_prof_now_ns();
+    dur = now - t->open_start[t->depth];
+    mc_prof_record(p, slot, t->open_zone[t->depth], t->open_start[t->depth], dur);
+    return dur;
+}
+
+static int mc_prof_write_trace_file(const McProfiler* p, const char* path);
+
+static void mc_prof_tick_begin(McProfiler* p, uint32_t slot, uint64_t tick) {
+    McProfThread* t;
+    if (slot >= MC_PROF_MAX_THREADS) return;
+    t = &p->threads[slot];
+    t->tick = tick;
+    memset(t->tick_zone_ns, 0, sizeof(t->tick_zone_ns));
+    mc_prof_begin(p, slot, MC_PROF_ZONE_TICK);
+}
+
+/* Closes the tick zone. Returns 1 if the tick went over the slow-tick
+ * budget (last_slow then names the zone that took longest, and a trace
+ * is dumped if one is armed), else 0. */
+static int mc_prof_tick_end(McProfiler* p, uint32_t slot) {
+    McProfThread* t;
+    uint64_t dur;
+    uint32_t z;
+    if (slot >= MC_PROF_MAX_THREADS) return 0;
+    t = &p->threads[slot];
+    dur = mc_prof_end(p, slot);
+    if (p->slow_tick_ns == 0 || dur <= p->slow_tick_ns) return 0;
+
+    p->slow_ticks++;
+    p->last_slow.tick       = t->tick;
+    p->last_slow.dur_ns     = dur;
+    p->last_slow.slot       = slot;
+    p->last_slow.worst_zone = MC_PROF_ZONE_TICK;
+    p->last_slow.worst_ns   = 0;
+    for (z = 0; z < MC_PROF_MAX_ZONES; z++) {
+        if (z == MC_PROF_ZONE_TICK) continue;
+        if (t->tick_zone_ns[z] > p->last_slow.worst_ns) {
+            p->last_slow.worst_zone = z;
+            p->last_slow.worst_ns   = t->tick_zone_ns[z];
+        }
+    }
+    if (p->trace_path[0] != '\0' && p->dumps_left > 0) {
+        p->dumps_left--;
+        mc_prof_write_trace_file(p, p->trace_path);
+    }
+    return 1;
+}
+
+/* =========================================================================
+ * SECTION 6: REPORTING
+ * ========================================================================= */
+
+static const char* mc_prof__zone_label(const McProfiler* p, uint32_t zone) {
+    return (p->zone_names[zone] != NULL) ? p->zone_names[zone] : "zone";
+}
+
+/* Merge one zone's histograms across slots */
+static void mc_prof_zone_stats(const McProfiler* p, uint32_t zone, McProfStats* out) {
+    static McProfHist merged;   /* 680 bytes; keep it off the stack */
+    uint32_t s, b;
+    memset(out, 0, sizeof(*out));
+    if (zone >= MC_PROF_MAX_ZONES) return;
+    memset(&merged, 0, sizeof(merged));
+    for (s = 0; s < MC_PROF_MAX_THREADS; s++) {
+        const McProfHist* h = &p->threads[s].hist[zone];
+        if (h->count == 0) continue;
+        for (b = 0; b < MC_PROF_HIST_BUCKETS; b++) merged.bucket[b] += h->bucket[b];
+        merged.count    += h->count;
+        merged.total_ns += h->total_ns;
+        if (h->max_ns > merged.max_ns) merged.max_ns = h->max_ns;
+    }
+    out->count    = merged.count;
+    out->total_ns = merged.total_ns;
+    out->max_ns   = merged.max_ns;
+    out->p50_ns   = mc_prof__hist_quantile(&merged, 0.50);
+    out->p99_ns   = mc_prof__hist_quantile(&merged, 0.99);
+}
+
+/* One line per zone that ran, times in microseconds */
+static void mc_prof_report(const McProfiler* p, FILE* f) {
+    uint32_t z;
+    fprintf(f, "  %-18s %8s %10s %10s %10s %10s\n",
+            "zone", "count", "mean_us", "p50_us", "p99_us", "max_us");
+    for (z = 0; z < MC_PROF_MAX_ZONES; z++) {
+        McProfStats st;
+        mc_prof_zone_stats(p, z, &st);
+        if (st.count == 0) continue;
+        fprintf(f, "  %-18s %8llu %10.1f %10.1f %10.1f %10.1f\n",
+                mc_prof__zone_label(p, z), (unsigned long long)st.count,
+                (double)st.total_ns / (double)st.count / 1000.0,
+                (double)st.p50_ns / 1000.0, (double)st.p99_ns / 1000.0,
+                (double)st.max_ns / 1000.0);
+    }
+    if (p->slow_ticks > 0) {
+        fprintf(f, "  slow ticks: %u (last: tick %llu, %.1f us, worst zone %s %.1f us)\n",
+                p->slow_ticks, (unsigned long long)p->last_slow.tick,
+                (double)p->last_slow.dur_ns / 1000.0,
+                mc_prof__zone_label(p, p->last_slow.worst_zone),
+                (double)p->last_slow.worst_ns / 1000.0);
+    }
+}
+
+/* Chrome trace-event JSON: one "X" (complete) event per ring entry,
+ * oldest first per thread, plus thread_name metadata. Timestamps are
+ * microseconds since mc_prof_init(). Returns events written. */
+static uint32_t mc_prof_write_trace(const McProfiler* p, FILE* f) {
+    uint32_t s, written = 0;
+    int first = 1;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (s = 0; s < MC_PROF_MAX_THREADS; s++) {
+        const McProfThread* t = &p->threads[s];
+        uint64_t i, begin;
+        if (t->written == 0) continue;
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                   "\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", s, (t->name != NULL) ? t->name : "worker");
+        first = 0;
+        begin = (t->written > MC_PROF_RING_EVENTS) ? t->written - MC_PROF_RING_EVENTS : 0;
+        for (i = begin; i < t->written; i++) {
+            const McProfEvent* e = &t->ring[i & (MC_PROF_RING_EVENTS - 1)];
+            fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"marble\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                       "\"ts\":%llu.%03u,\"dur\":%u.%03u,\"args\":{\"tick\":%u}}",
+                    mc_prof__zone_label(p, e->zone), s,
+                    (unsigned long long)(e->start_ns / 1000u), (unsigned)(e->start_ns % 1000u),
+                    e->dur_ns / 1000u, e->dur_ns % 1000u, e->tick);
+            written++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return written;
+}
+
+/* Returns 0 on success, -1 if the file can't be written. */
+static int mc_prof_write_trace_file(const McProfiler* p, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) return -1;
+    mc_prof_write_trace(p, f);
+    return (fclose(f) == 0) ? 0 : -1;
+}
+
+#endif /* MARBLE_PROFILE_H */
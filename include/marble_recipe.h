@@ -0,0 +1,39 @@
+/*
+ * marble_recipe.h -- Crafting Recipe Definition (Phase 0.4)
+ *
+ * PURPOSE:
+ *   The RecipeDef layout on its own, shared by marble_craft.h (which
+ *   matches recipes) and the GEN_RECIPES[] table marble_compile.lua
+ *   emits. Both include this header, so a compiled table can be passed
+ *   straight to mc_recipe_table_load().
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_RECIPE_H
+#define MARBLE_RECIPE_H
+
+#include <stdint.h>
+
+#define MAX_RECIPE_INGREDIENTS    6
+
+typedef enum {
+    RECIPE_ING_ITEM = 0,   /* key = def_id */
+    RECIPE_ING_TAG  = 1    /* key = single ItemTag bit */
+} RecipeIngredientKind;
+
+typedef struct {
+    RecipeIngredientKind kind;
+    uint32_t             key;
+    uint32_t             count;
+} RecipeIngredient;
+
+typedef struct {
+    uint32_t         recipe_id;
+    uint32_t         output_def_id;
+    uint32_t         output_count;
+    RecipeIngredient ingredients[MAX_RECIPE_INGREDIENTS];
+    uint32_t         ingredient_count;
+} RecipeDef;
+
+#endif /* MARBLE_RECIPE_H */
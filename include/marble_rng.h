@@ -0,0 +1,329 @@
+/*
+ * marble_rng.h -- Counter-Based RNG Streams (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Random numbers that depend only on WHAT is being rolled, never on
+ *   the order rolls happen in. McRng (marble_core.h) is a sequential
+ *   state: two systems sharing one stream, or one system split across
+ *   threads, see different numbers depending on who draws first. Here a
+ *   roll is a pure function of
+ *
+ *       (world_seed, stream, tick, entity, draw)
+ *
+ *   so any thread count, batch size or processing order gives the same
+ *   rolls, and a batch of rolls vectorizes.
+ *
+ * GENERATOR:
+ *   Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as
+ *   1, 2, 3", SC'11). Key = (world_seed, stream). Counter =
+ *   (draw / 4, entity, tick_lo, tick_hi). One block yields four 32-bit
+ *   outputs; draw d uses word d % 4 of block d / 4, so draws 0..3 of an
+ *   entity at a tick cost one block.
+ *
+ * BATCH API:
+ *   mc_crng_u32_batch() / mc_crng_d100_batch() fill N results for N
+ *   (entity, draw) lanes at one tick. The lane loop is vectorized with
+ *   AVX2 (8 lanes), SSE2 (4 lanes) or NEON (4 lanes), chosen at compile
+ *   time; the tail and other targets use the scalar path. Every path
+ *   produces bit-identical results. Define MC_RNG_NO_SIMD to force the
+ *   scalar path.
+ *
+ * RANGE REDUCTION:
+ *   Multiply-shift (mc_rng_reduce in marble_core.h): the high word of
+ *   x * n. No division, and vectorizes with the same 32x32->64 multiply
+ *   the generator already uses.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_RNG_H
+#define MARBLE_RNG_H
+
+#include "marble_core.h"
+
+#ifndef MC_RNG_NO_SIMD
+#if defined(__AVX2__)
+#define MC_RNG_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_RNG_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MC_RNG_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+/* =========================================================================
+ * SECTION 1: PHILOX4x32-10
+ * ========================================================================= */
+
+#define MC_PHILOX_M0     0xD2511F53u
+#define MC_PHILOX_M1     0xCD9E8D57u
+#define MC_PHILOX_W0     0x9E3779B9u   /* golden ratio */
+#define MC_PHILOX_W1     0xBB67AE85u   /* sqrt(3) - 1 */
+#define MC_PHILOX_ROUNDS 10
+
+/* One Philox4x32 block: out = Philox(ctr, key). ctr and out may alias. */
+static void mc_philox4x32(const uint32_t ctr[4], uint32_t k0, uint32_t k1, uint32_t out[4]) {
+    uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+    uint32_t r;
+
+    for (r = 0; r < MC_PHILOX_ROUNDS; r++) {
+        uint64_t p0 = (uint64_t)MC_PHILOX_M0 * x0;
+        uint64_t p1 = (uint64_t)MC_PHILOX_M1 * x2;
+        uint32_t y0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+        uint32_t y2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+        x1 = (uint32_t)p1;
+        x3 = (uint32_t)p0;
+        x0 = y0;
+        x2 = y2;
+        k0 += MC_PHILOX_W0;
+        k1 += MC_PHILOX_W1;
+    }
+
+    out[0] = x0; out[1] = x1; out[2] = x2; out[3] = x3;
+}
+
+/* =========================================================================
+ * SECTION 2: SCALAR API
+ * ========================================================================= */
+
+/* Stream ids: one per consumer, so two systems rolling for the same
+ * entity on the same tick never share numbers. */
+#define MC_CRNG_STREAM_INTERACT  1u
+#define MC_CRNG_STREAM_USER      256u   /* first id free for game code */
+
+typedef struct {
+    uint32_t k0;   /* world seed */
+    uint32_t k1;   /* stream */
+} McCrng;
+
+static void mc_crng_init(McCrng* g, uint32_t world_seed, uint32_t stream) {
+    g->k0 = world_seed;
+    g->k1 = stream;
+}
+
+/* Draws 4*block .. 4*block+3 for (tick, entity) */
+static void mc_crng_block(const McCrng* g, uint64_t tick, uint32_t entity,
+                          uint32_t block, uint32_t out[4]) {
+    uint32_t ctr[4];
+    ctr[0] = block;
+    ctr[1] = entity;
+    ctr[2] = (uint32_t)tick;
+    ctr[3] = (uint32_t)(tick >> 32);
+    mc_philox4x32(ctr, g->k0, g->k1, out);
+}
+
+static uint32_t mc_crng_u32(const McCrng* g, uint64_t tick, uint32_t entity, uint32_t draw) {
+    uint32_t out[4];
+    mc_crng_block(g, tick, entity, draw >> 2, out);
+    return out[draw & 3u];
+}
+
+/* Returns a value in [0, max_exclusive). */
+static uint32_t mc_crng_range(const McCrng* g, uint64_t tick, uint32_t entity,
+                              uint32_t draw, uint32_t max_exclusive) {
+    return mc_rng_reduce(mc_crng_u32(g, tick, entity, draw), max_exclusive);
+}
+
+/* d100 roll returning 0-99 */
+static int32_t mc_crng_d100(const McCrng* g, uint64_t tick, uint32_t entity, uint32_t draw) {
+    return (int32_t)mc_crng_range(g, tick, entity, draw, 100);
+}
+
+/* =========================================================================
+ * SECTION 3: BATCH API
+ *
+ * Lanes are independent: lane i is exactly mc_crng_u32(g, tick,
+ * entity[i], draw[i]), reduced to [0, range) when range != 0. The SIMD
+ * kernels keep the four counter words in four registers (one lane per
+ * entity), run all ten rounds, then pick word (draw & 3) per lane with
+ * compare masks.
+ * ========================================================================= */
+
+#if MC_RNG_AVX2
+
+#define MC_CRNG_LANES 8
+
+static __m256i mc_crng__mul_lo(__m256i a, __m256i m) {
+    return _mm256_mullo_epi32(a, m);
+}
+
+static __m256i mc_crng__mul_hi(__m256i a, __m256i m) {
+    __m256i even = _mm256_mul_epu32(a, m);
+    __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+static void mc_crng__lanes(const McCrng* g, uint64_t tick, const uint32_t* entity,
+                           const uint32_t* draw, uint32_t range, uint32_t* out) {
+    const __m256i m0 = _mm256_set1_epi32((int)MC_PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi32((int)MC_PHILOX_M1);
+    const __m256i three = _mm256_set1_epi32(3);
+    __m256i d  = _mm256_loadu_si256((const __m256i*)draw);
+    __m256i x0 = _mm256_srli_epi32(d, 2);
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)entity);
+    __m256i x2 = _mm256_set1_epi32((int)(uint32_t)tick);
+    __m256i x3 = _mm256_set1_epi32((int)(uint32_t)(tick >> 32));
+    __m256i w, sel;
+    uint32_t k0 = g->k0, k1 = g->k1;
+    uint32_t r;
+
+    for (r = 0; r < MC_PHILOX_ROUNDS; r++) {
+        __m256i hi0 = mc_crng__mul_hi(x0, m0);
+        __m256i lo0 = mc_crng__mul_lo(x0, m0);
+        __m256i hi1 = mc_crng__mul_hi(x2, m1);
+        __m256i lo1 = mc_crng__mul_lo(x2, m1);
+        __m256i y0  = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), _mm256_set1_epi32((int)k0));
+        __m256i y2  = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), _mm256_set1_epi32((int)k1));
+        x1 = lo1;
+        x3 = lo0;
+        x0 = y0;
+        x2 = y2;
+        k0 += MC_PHILOX_W0;
+        k1 += MC_PHILOX_W1;
+    }
+
+    sel = _mm256_and_si256(d, three);
+    w = _mm256_and_si256(x0, _mm256_cmpeq_epi32(sel, _mm256_setzero_si256()));
+    w = _mm256_or_si256(w, _mm256_and_si256(x1, _mm256_cmpeq_epi32(sel, _mm256_set1_epi32(1))));
+    w = _mm256_or_si256(w, _mm256_and_si256(x2, _mm256_cmpeq_epi32(sel, _mm256_set1_epi32(2))));
+    w = _mm256_or_si256(w, _mm256_and_si256(x3, _mm256_cmpeq_epi32(sel, three)));
+    if (range) w = mc_crng__mul_hi(w, _mm256_set1_epi32((int)range));
+    _mm256_storeu_si256((__m256i*)out, w);
+}
+
+#elif MC_RNG_SSE2
+
+#define MC_CRNG_LANES 4
+
+/* SSE2 has no 32-bit mullo; both halves come from two 32x32->64 muls */
+static void mc_crng__mul(__m128i a, __m128i m, __m128i* lo, __m128i* hi) {
+    const __m128i lo_mask = _mm_set_epi32(0, -1, 0, -1);
+    __m128i even = _mm_mul_epu32(a, m);
+    __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+    *lo = _mm_or_si128(_mm_and_si128(even, lo_mask), _mm_slli_epi64(odd, 32));
+    *hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lo_mask, odd));
+}
+
+static void mc_crng__lanes(const McCrng* g, uint64_t tick, const uint32_t* entity,
+                           const uint32_t* draw, uint32_t range, uint32_t* out) {
+    const __m128i m0 = _mm_set1_epi32((int)MC_PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int)MC_PHILOX_M1);
+    const __m128i three = _mm_set1_epi32(3);
+    __m128i d  = _mm_loadu_si128((const __m128i*)draw);
+    __m128i x0 = _mm_srli_epi32(d, 2);
+    __m128i x1 = _mm_loadu_si128((const __m128i*)entity);
+    __m128i x2 = _mm_set1_epi32((int)(uint32_t)tick);
+    __m128i x3 = _mm_set1_epi32((int)(uint32_t)(tick >> 32));
+    __m128i w, sel, unused;
+    uint32_t k0 = g->k0, k1 = g->k1;
+    uint32_t r;
+
+    for (r = 0; r < MC_PHILOX_ROUNDS; r++) {
+        __m128i lo0, hi0, lo1, hi1, y0, y2;
+        mc_crng__mul(x0, m0, &lo0, &hi0);
+        mc_crng__mul(x2, m1, &lo1, &hi1);
+        y0 = _mm_xor_si128(_mm_xor_si128(hi1, x1), _mm_set1_epi32((int)k0));
+        y2 = _mm_xor_si128(_mm_xor_si128(hi0, x3), _mm_set1_epi32((int)k1));
+        x1 = lo1;
+        x3 = lo0;
+        x0 = y0;
+        x2 = y2;
+        k0 += MC_PHILOX_W0;
+        k1 += MC_PHILOX_W1;
+    }
+
+    sel = _mm_and_si128(d, three);
+    w = _mm_and_si128(x0, _mm_cmpeq_epi32(sel, _mm_setzero_si128()));
+    w = _mm_or_si128(w, _mm_and_si128(x1, _mm_cmpeq_epi32(sel, _mm_set1_epi32(1))));
+    w = _mm_or_si128(w, _mm_and_si128(x2, _mm_cmpeq_epi32(sel, _mm_set1_epi32(2))));
+    w = _mm_or_si128(w, _mm_and_si128(x3, _mm_cmpeq_epi32(sel, three)));
+    if (range) mc_crng__mul(w, _mm_set1_epi32((int)range), &unused, &w);
+    _mm_storeu_si128((__m128i*)out, w);
+}
+
+#elif MC_RNG_NEON
+
+#define MC_CRNG_LANES 4
+
+static uint32x4_t mc_crng__mul_hi(uint32x4_t a, uint32_t m) {
+    uint64x2_t p0 = vmull_n_u32(vget_low_u32(a), m);
+    uint64x2_t p1 = vmull_n_u32(vget_high_u32(a), m);
+    return vcombine_u32(vshrn_n_u64(p0, 32), vshrn_n_u64(p1, 32));
+}
+
+static void mc_crng__lanes(const McCrng* g, uint64_t tick, const uint32_t* entity,
+                           const uint32_t* draw, uint32_t range, uint32_t* out) {
+    uint32x4_t d  = vld1q_u32(draw);
+    uint32x4_t x0 = vshrq_n_u32(d, 2);
+    uint32x4_t x1 = vld1q_u32(entity);
+    uint32x4_t x2 = vdupq_n_u32((uint32_t)tick);
+    uint32x4_t x3 = vdupq_n_u32((uint32_t)(tick >> 32));
+    uint32x4_t w, sel;
+    uint32_t k0 = g->k0, k1 = g->k1;
+    uint32_t r;
+
+    for (r = 0; r < MC_PHILOX_ROUNDS; r++) {
+        uint32x4_t hi0 = mc_crng__mul_hi(x0, MC_PHILOX_M0);
+        uint32x4_t lo0 = vmulq_n_u32(x0, MC_PHILOX_M0);
+        uint32x4_t hi1 = mc_crng__mul_hi(x2, MC_PHILOX_M1);
+        uint32x4_t lo1 = vmulq_n_u32(x2, MC_PHILOX_M1);
+        uint32x4_t y0  = veorq_u32(veorq_u32(hi1, x1), vdupq_n_u32(k0));
+        uint32x4_t y2  = veorq_u32(veorq_u32(hi0, x3), vdupq_n_u32(k1));
+        x1 = lo1;
+        x3 = lo0;
+        x0 = y0;
+        x2 = y2;
+        k0 += MC_PHILOX_W0;
+        k1 += MC_PHILOX_W1;
+    }
+
+    sel = vandq_u32(d, vdupq_n_u32(3));
+    w = vandq_u32(x0, vceqq_u32(sel, vdupq_n_u32(0)));
+    w = vorrq_u32(w, vandq_u32(x1, vceqq_u32(sel, vdupq_n_u32(1))));
+    w = vorrq_u32(w, vandq_u32(x2, vceqq_u32(sel, vdupq_n_u32(2))));
+    w = vorrq_u32(w, vandq_u32(x3, vceqq_u32(sel, vdupq_n_u32(3))));
+    if (range) w = mc_crng__mul_hi(w, range);
+    vst1q_u32(out, w);
+}
+
+#else
+
+#define MC_CRNG_LANES 1
+
+#endif
+
+/* draw == NULL means draw 0 for every lane */
+static void mc_crng__batch(const McCrng* g, uint64_t tick, const uint32_t* entity,
+                           const uint32_t* draw, uint32_t range, uint32_t* out, uint32_t n) {
+    uint32_t i = 0;
+
+#if MC_CRNG_LANES > 1
+    uint32_t zeros[MC_CRNG_LANES];
+    memset(zeros, 0, sizeof(zeros));
+    for (; i + MC_CRNG_LANES <= n; i += MC_CRNG_LANES) {
+        mc_crng__lanes(g, tick, entity + i, draw ? draw + i : zeros, range, out + i);
+    }
+#endif
+
+    for (; i < n; i++) {
+        uint32_t x = mc_crng_u32(g, tick, entity[i], draw ? draw[i] : 0);
+        out[i] = range ? mc_rng_reduce(x, range) : x;
+    }
+}
+
+/* out[i] = mc_crng_u32(g, tick, entity[i], draw ? draw[i] : 0) */
+static void mc_crng_u32_batch(const McCrng* g, uint64_t tick, const uint32_t* entity,
+                              const uint32_t* draw, uint32_t* out, uint32_t n) {
+    mc_crng__batch(g, tick, entity, draw, 0, out, n);
+}
+
+/* out[i] = mc_crng_d100(g, tick, entity[i], draw ? draw[i] : 0) */
+static void mc_crng_d100_batch(const McCrng* g, uint64_t tick, const uint32_t* entity,
+                               const uint32_t* draw, int32_t* out, uint32_t n) {
+    mc_crng__batch(g, tick, entity, draw, 100, (uint32_t*)out, n);
+}
+
+#endif /* MARBLE_RNG_H */
@@ -0,0 +1,579 @@
+/*
+ * marble_save.h -- Versioned World Save / Load (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Persist the complete simulation state and restore it bit-exactly,
+ *   so a loaded world continues exactly as the saved one would have.
+ *
+ * WHAT IS SAVED:
+ *   - EntityAllocator         (next_id)
+ *   - every SparseSet         (stride, count, dense[0..count), data[0..count))
+ *                             sparse[] is NEVER written -- it is rebuilt
+ *                             in one pass over dense[] at load time
+ *   - TickState               (tick_number, accumulated_us; the wall-clock
+ *                             anchor last_time_us belongs to the host and
+ *                             is left untouched on load)
+ *   - McRng                   (world RNG state)
+ *   - TimerWheel              (pending scheduled commands, optional)
+ *
+ * FILE LAYOUT (little-endian):
+ *
+ *   SaveHeader   { magic "MSAV", version, header_size, chunk_count, total_size }
+ *   Chunk*       { SaveChunkHeader { tag, version, id, size } + payload,
+ *                  payload padded to 8 bytes }
+ *
+ *   Chunks are self-describing. Unknown tags are skipped on load, so
+ *   newer files with extra chunks still load in older builds as long as
+ *   the chunks they do understand are unchanged. A chunk whose own
+ *   version is unknown rejects the whole file.
+ *
+ * PERFORMANCE:
+ *   Saving is a handful of large memcpys into a caller buffer (no
+ *   per-entity work); the buffer then goes to disk in one fwrite.
+ *   Loading validates every chunk first, then applies -- a bad file
+ *   never leaves the world half-loaded.
+ *
+ *   For autosaves, McAutosave serializes on the calling thread (the
+ *   only part that must see a consistent world, ~memcpy speed) and
+ *   hands compression, the disk write and the atomic rename to a
+ *   worker thread.
+ *
+ * COMPRESSION:
+ *   Files may be written as an LZ frame (marble_lz.h) around the save
+ *   bytes. Loading sniffs the frame magic, so compressed and plain
+ *   files load through the same call.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_SAVE_H
+#define MARBLE_SAVE_H
+
+#include "marble_core.h"
+#include "marble_cmd.h"
+#include "marble_timer.h"
+#include "marble_thread.h"
+#include "marble_lz.h"
+
+/* =========================================================================
+ * SECTION 1: WORLD VIEW
+ *
+ * Non-owning view of everything that makes up one world's state. The
+ * position of a pool in pools[] is its identity in the file, so the
+ * caller must register pools in the same order when saving and loading.
+ * ========================================================================= */
+
+#define MC_SAVE_MAX_POOLS 32
+
+typedef struct {
+    EntityAllocator* alloc;
+    TickState*       tick;
+    McRng*           rng;
+    TimerWheel*      timers;                   /* NULL = no timers chunk */
+    SparseSet*       pools[MC_SAVE_MAX_POOLS];
+    uint32_t         pool_count;
+} WorldRefs;
+
+static void mc_world_refs_init(
+    WorldRefs* w, EntityAllocator* alloc, TickState* tick, McRng* rng, TimerWheel* timers
+) {
+    memset(w, 0, sizeof(*w));
+    w->alloc  = alloc;
+    w->tick   = tick;
+    w->rng    = rng;
+    w->timers = timers;
+}
+
+/* Register the next pool. Returns its index, or -1 if full. */
+static int mc_world_refs_add_pool(WorldRefs* w, SparseSet* pool) {
+    if (w->pool_count >= MC_SAVE_MAX_POOLS) return -1;
+    w->pools[w->pool_count] = pool;
+    return (int)w->pool_count++;
+}
+
+/* =========================================================================
+ * SECTION 2: FORMAT
+ * ========================================================================= */
+
+#define MC_SAVE_MAGIC      0x5641534Du   /* "MSAV" */
+#define MC_SAVE_VERSION    1
+
+#define MC_SAVE_TAG_ALLOC  0x434F4C41u   /* "ALOC" */
+#define MC_SAVE_TAG_TICK   0x4B434954u   /* "TICK" */
+#define MC_SAVE_TAG_RNG    0x20474E52u   /* "RNG " */
+#define MC_SAVE_TAG_POOL   0x4C4F4F50u   /* "POOL" */
+#define MC_SAVE_TAG_TIMERS 0x52454D54u   /* "TMER" */
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t chunk_count;
+    uint32_t total_size;
+} SaveHeader;
+
+typedef struct {
+    uint32_t tag;
+    uint16_t version;     /* per-chunk payload version */
+    uint16_t reserved;
+    uint32_t id;          /* pool index for POOL, 0 otherwise */
+    uint32_t size;        /* payload bytes, excluding padding */
+} SaveChunkHeader;
+
+typedef struct {
+    uint32_t stride;
+    uint32_t count;
+} SavePoolHeader;
+
+typedef struct {
+    uint64_t tick_number;
+    uint64_t accumulated_us;
+} SaveTickPayload;
+
+static uint32_t mc_save__pad8(uint32_t n) {
+    return (n + 7u) & ~7u;
+}
+
+static uint32_t mc_save__pool_payload(const SparseSet* ss) {
+    return (uint32_t)sizeof(SavePoolHeader)
+         + ss->count * (uint32_t)sizeof(EntityID)
+         + ss->count * ss->stride;
+}
+
+/* =========================================================================
+ * SECTION 3: SAVE
+ * ========================================================================= */
+
+/* Exact size mc_world_save() will produce for the world as it is now. */
+static uint32_t mc_world_save_size(const WorldRefs* w) {
+    uint32_t size = (uint32_t)sizeof(SaveHeader);
+    uint32_t p;
+    size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8((uint32_t)sizeof(EntityID));
+    size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8((uint32_t)sizeof(SaveTickPayload));
+    size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8((uint32_t)sizeof(McRng));
+    for (p = 0; p < w->pool_count; p++) {
+        size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8(mc_save__pool_payload(w->pools[p]));
+    }
+    if (w->timers != NULL) {
+        size += (uint32_t)sizeof(SaveChunkHeader) + mc_save__pad8(mc_timer_wheel_snapshot_size());
+    }
+    return size;
+}
+
+/* Append a chunk header at `off`; returns the payload offset. */
+static uint32_t mc_save__chunk(uint8_t* out, uint32_t off, uint32_t tag, uint32_t id, uint32_t size) {
+    SaveChunkHeader ch;
+    ch.tag      = tag;
+    ch.version  = 1;
+    ch.reserved = 0;
+    ch.id       = id;
+    ch.size     = size;
+    memcpy(out + off, &ch, sizeof(ch));
+    return off + (uint32_t)sizeof(ch);
+}
+
+/* Serialize the world into `out`. Returns bytes written, 0 if `cap` is
+ * too small (query mc_world_save_size() first). */
+static uint32_t mc_world_save(const WorldRefs* w, uint8_t* out, uint32_t cap) {
+    SaveHeader hdr;
+    SaveTickPayload tp;
+    uint32_t size = mc_world_save_size(w);
+    uint32_t off = (uint32_t)sizeof(SaveHeader);
+    uint32_t chunks = 0;
+    uint32_t p;
+
+    if (size > cap) return 0;
+
+    off = mc_save__chunk(out, off, MC_SAVE_TAG_ALLOC, 0, (uint32_t)sizeof(EntityID));
+    memset(out + off, 0, 8);
+    memcpy(out + off, &w->alloc->next_id, sizeof(EntityID));
+    off += mc_save__pad8((uint32_t)sizeof(EntityID));
+    chunks++;
+
+    tp.tick_number    = w->tick->tick_number;
+    tp.accumulated_us = w->tick->accumulated_us;
+    off = mc_save__chunk(out, off, MC_SAVE_TAG_TICK, 0, (uint32_t)sizeof(tp));
+    memcpy(out + off, &tp, sizeof(tp));
+    off += mc_save__pad8((uint32_t)sizeof(tp));
+    chunks++;
+
+    off = mc_save__chunk(out, off, MC_SAVE_TAG_RNG, 0, (uint32_t)sizeof(McRng));
+    memset(out + off, 0, mc_save__pad8((uint32_t)sizeof(McRng)));
+    memcpy(out + off, w->rng, sizeof(McRng));
+    off += mc_save__pad8((uint32_t)sizeof(McRng));
+    chunks++;
+
+    for (p = 0; p < w->pool_count; p++) {
+        const SparseSet* ss = w->pools[p];
+        uint32_t payload = mc_save__pool_payload(ss);
+        SavePoolHeader ph;
+        uint32_t end;
+        ph.stride = ss->stride;
+        ph.count  = ss->count;
+        off = mc_save__chunk(out, off, MC_SAVE_TAG_POOL, p, payload);
+        end = off + mc_save__pad8(payload);
+        memcpy(out + off, &ph, sizeof(ph));
+        off += (uint32_t)sizeof(ph);
+        memcpy(out + off, ss->dense, ss->count * sizeof(EntityID));
+        off += ss->count * (uint32_t)sizeof(EntityID);
+        memcpy(out + off, ss->data, (size_t)ss->count * ss->stride);
+        off += ss->count * ss->stride;
+        memset(out + off, 0, end - off);
+        off = end;
+        chunks++;
+    }
+
+    if (w->timers != NULL) {
+        uint32_t payload = mc_timer_wheel_snapshot_size();
+        off = mc_save__chunk(out, off, MC_SAVE_TAG_TIMERS, 0, payload);
+        mc_timer_wheel_snapshot(w->timers, out + off, payload);
+        memset(out + off + payload, 0, mc_save__pad8(payload) - payload);
+        off += mc_save__pad8(payload);
+        chunks++;
+    }
+
+    hdr.magic       = MC_SAVE_MAGIC;
+    hdr.version     = MC_SAVE_VERSION;
+    hdr.header_size = (uint16_t)sizeof(SaveHeader);
+    hdr.chunk_count = chunks;
+    hdr.total_size  = off;
+    memcpy(out, &hdr, sizeof(hdr));
+    return off;
+}
+
+/* =========================================================================
+ * SECTION 4: LOAD
+ * ========================================================================= */
+
+/* Walk and check every chunk without touching the world.
+ * Returns 0 if the file can be applied to `w` in full. */
+static int mc_world_save_validate(const WorldRefs* w, const uint8_t* in, uint32_t len) {
+    SaveHeader hdr;
+    uint32_t off, c;
+    uint32_t seen_pools = 0;
+    uint32_t next_id = MC_MAX_ENTITIES;
+    uint32_t seen[MC_MAX_ENTITIES / 32];
+    int have_alloc = 0, have_tick = 0, have_rng = 0, have_timers = 0;
+
+    if (len < sizeof(SaveHeader)) return -1;
+    memcpy(&hdr, in, sizeof(hdr));
+    if (hdr.magic != MC_SAVE_MAGIC) return -1;
+    if (hdr.version != MC_SAVE_VERSION) return -1;
+    if (hdr.header_size != sizeof(SaveHeader)) return -1;
+    if (hdr.total_size != len) return -1;
+
+    off = hdr.header_size;
+    for (c = 0; c < hdr.chunk_count; c++) {
+        SaveChunkHeader ch;
+        const uint8_t* payload;
+        if ((uint64_t)off + sizeof(ch) > len) return -1;
+        memcpy(&ch, in + off, sizeof(ch));
+        off += (uint32_t)sizeof(ch);
+        if ((uint64_t)off + mc_save__pad8(ch.size) > len) return -1;
+        payload = in + off;
+
+        switch (ch.tag) {
+        case MC_SAVE_TAG_ALLOC:
+            if (ch.version != 1 || ch.size != sizeof(EntityID)) return -1;
+            memcpy(&next_id, payload, sizeof(EntityID));
+            if (next_id > MC_MAX_ENTITIES) return -1;
+            have_alloc = 1;
+            break;
+        case MC_SAVE_TAG_TICK:
+            if (ch.version != 1 || ch.size != sizeof(SaveTickPayload)) return -1;
+            have_tick = 1;
+            break;
+        case MC_SAVE_TAG_RNG:
+            if (ch.version != 1 || ch.size != sizeof(McRng)) return -1;
+            have_rng = 1;
+            break;
+        case MC_SAVE_TAG_POOL: {
+            SavePoolHeader ph;
+            uint32_t i;
+            if (ch.version != 1 || ch.size < sizeof(ph)) return -1;
+            if (!have_alloc) return -1;     /* entity range needed to check IDs */
+            if (ch.id >= w->pool_count || (seen_pools & (1u << ch.id))) return -1;
+            memcpy(&ph, payload, sizeof(ph));
+            if (ph.stride != w->pools[ch.id]->stride) return -1;
+            if (ph.count > MC_MAX_ENTITIES) return -1;
+            if (ch.size != sizeof(ph) + ph.count * (sizeof(EntityID) + ph.stride)) return -1;
+            memset(seen, 0, sizeof(seen));
+            for (i = 0; i < ph.count; i++) {
+                EntityID eid;
+                memcpy(&eid, payload + sizeof(ph) + i * sizeof(EntityID), sizeof(eid));
+                if (eid >= next_id) return -1;
+                if (seen[eid >> 5] & (1u << (eid & 31))) return -1;
+                seen[eid >> 5] |= 1u << (eid & 31);
+            }
+            seen_pools |= 1u << ch.id;
+            break;
+        }
+        case MC_SAVE_TAG_TIMERS:
+            if (ch.version != 1 || ch.size != mc_timer_wheel_snapshot_size()) return -1;
+            if (mc_timer_wheel_snapshot_check(payload, ch.size) != 0) return -1;
+            have_timers = 1;
+            break;
+        default:
+            break;  /* unknown chunk from a newer build: skip */
+        }
+        off += mc_save__pad8(ch.size);
+    }
+
+    if (!have_alloc || !have_tick || !have_rng) return -1;
+    if (w->pool_count > 0 && seen_pools != (uint32_t)((1ull << w->pool_count) - 1)) return -1;
+    if (w->timers != NULL && !have_timers) return -1;
+    return 0;
+}
+
+/* Replace the world's state with the saved one.
+ * Returns 0 on success, -1 (world untouched) if the file is malformed
+ * or doesn't match the registered pools. */
+static int mc_world_load(WorldRefs* w, const uint8_t* in, uint32_t len) {
+    SaveHeader hdr;
+    uint32_t off, c;
+
+    if (mc_world_save_validate(w, in, len) != 0) return -1;
+    memcpy(&hdr, in, sizeof(hdr));
+
+    off = hdr.header_size;
+    for (c = 0; c < hdr.chunk_count; c++) {
+        SaveChunkHeader ch;
+        const uint8_t* payload;
+        memcpy(&ch, in + off, sizeof(ch));
+        off += (uint32_t)sizeof(ch);
+        payload = in + off;
+
+        switch (ch.tag) {
+        case MC_SAVE_TAG_ALLOC:
+            memcpy(&w->alloc->next_id, payload, sizeof(EntityID));
+            break;
+        case MC_SAVE_TAG_TICK: {
+            SaveTickPayload tp;
+            memcpy(&tp, payload, sizeof(tp));
+            w->tick->tick_number    = tp.tick_number;
+            w->tick->accumulated_us = tp.accumulated_us;
+            break;
+        }
+        case MC_SAVE_TAG_RNG:
+            memcpy(w->rng, payload, sizeof(McRng));
+            break;
+        case MC_SAVE_TAG_POOL: {
+            SparseSet* ss = w->pools[ch.id];
+            SavePoolHeader ph;
+            uint32_t i;
+            memcpy(&ph, payload, sizeof(ph));
+            for (i = 0; i < ss->count; i++) {
+                ss->sparse[ss->dense[i]] = MC_INVALID_INDEX;
+            }
+            memcpy(ss->dense, payload + sizeof(ph), ph.count * sizeof(EntityID));
+            memcpy(ss->data, payload + sizeof(ph) + ph.count * sizeof(EntityID),
+                   (size_t)ph.count * ph.stride);
+            ss->count = ph.count;
+            for (i = 0; i < ss->count; i++) {
+                ss->sparse[ss->dense[i]] = i;
+            }
+            mc_sparse_set_mark_all_dirty(ss);
+            mc_sparse_set_rehash(ss);
+            break;
+        }
+        case MC_SAVE_TAG_TIMERS:
+            /* Checked by validation; a failure here means the file changed */
+            if (w->timers != NULL && mc_timer_wheel_restore(w->timers, payload, ch.size) != 0) {
+                return -1;
+            }
+            break;
+        default:
+            break;
+        }
+        off += mc_save__pad8(ch.size);
+    }
+    return 0;
+}
+
+/* =========================================================================
+ * SECTION 5: FILE I/O
+ *
+ * `scratch` is a caller-owned buffer. Saving needs mc_world_save_size()
+ * bytes, plus mc_lz_frame_bound() of that when compressing (the frame is
+ * built right after the raw bytes). Loading needs the file size, plus
+ * the raw size for compressed files. Saving writes to "<path>.tmp" and
+ * renames over <path>, so a crash mid-write never destroys the previous
+ * save.
+ * ========================================================================= */
+
+static int mc_save__write_atomic(const char* path, const uint8_t* data, uint32_t len) {
+    char tmp[512];
+    FILE* f;
+    size_t n = strlen(path);
+    if (n + 5 > sizeof(tmp)) return -1;
+    memcpy(tmp, path, n);
+    memcpy(tmp + n, ".tmp", 5);
+
+    f = fopen(tmp, "wb");
+    if (f == NULL) return -1;
+    if (fwrite(data, 1, len, f) != len) {
+        fclose(f);
+        remove(tmp);
+        return -1;
+    }
+    if (fclose(f) != 0) {
+        remove(tmp);
+        return -1;
+    }
+#ifdef _WIN32
+    remove(path);  /* rename() does not replace on Windows */
+#endif
+    return (rename(tmp, path) == 0) ? 0 : -1;
+}
+
+/* Write scratch[0..len) to `path`, as an LZ frame if `lz` is given.
+ * The frame goes into scratch[len..cap). */
+static int mc_save__write_bytes(
+    const char* path, McLzWriter* lz, uint8_t* scratch, uint32_t len, uint32_t cap
+) {
+    uint32_t packed;
+    if (lz == NULL) return mc_save__write_atomic(path, scratch, len);
+    packed = mc_lz_frame_compress(lz, scratch, len, scratch + len, cap - len);
+    if (packed == 0) return -1;
+    return mc_save__write_atomic(path, scratch + len, packed);
+}
+
+/* Read `path` into scratch, decompressing if it is an LZ frame. The
+ * frame is moved to the end of scratch and decoded into the front, so
+ * the two never overlap. */
+static int mc_save__read_bytes(const char* path, uint8_t* scratch, uint32_t cap, uint32_t* out_len) {
+    FILE* f = fopen(path, "rb");
+    size_t len;
+    uint32_t raw;
+    if (f == NULL) return -1;
+    len = fread(scratch, 1, cap, f);
+    if (len == cap && fgetc(f) != EOF) {   /* file larger than scratch */
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    if (!mc_lz_is_frame(scratch, (uint32_t)len)) {
+        *out_len = (uint32_t)len;
+        return 0;
+    }
+    raw = mc_lz_frame_raw_size(scratch, (uint32_t)len);
+    if (raw > cap - (uint32_t)len) return -1;
+    memmove(scratch + cap - len, scratch, len);
+    return mc_lz_frame_decompress(scratch + cap - len, (uint32_t)len, scratch, raw, out_len);
+}
+
+static int mc_world_save_file(const WorldRefs* w, const char* path, uint8_t* scratch, uint32_t cap) {
+    uint32_t len = mc_world_save(w, scratch, cap);
+    if (len == 0) return -1;
+    return mc_save__write_atomic(path, scratch, len);
+}
+
+/* Same as mc_world_save_file(), written as an LZ frame. */
+static int mc_world_save_file_lz(
+    const WorldRefs* w, const char* path, McLzWriter* lz, uint8_t* scratch, uint32_t cap
+) {
+    uint32_t len = mc_world_save(w, scratch, cap);
+    if (len == 0) return -1;
+    return mc_save__write_bytes(path, lz, scratch, len, cap);
+}
+
+/* Loads plain and compressed saves alike. */
+static int mc_world_load_file(WorldRefs* w, const char* path, uint8_t* scratch, uint32_t cap) {
+    uint32_t len;
+    if (mc_save__read_bytes(path, scratch, cap, &len) != 0) return -1;
+    return mc_world_load(w, scratch, len);
+}
+
+/* =========================================================================
+ * SECTION 6: BACKGROUND AUTOSAVE
+ *
+ * mc_autosave_begin() serializes on the calling thread (between ticks,
+ * while the world is consistent) and starts a worker that writes the
+ * buffer to disk (compressing first if mc_autosave_set_compression()
+ * was called). The buffer belongs to the worker until it is joined; a
+ * new autosave while one is still in flight is refused rather than
+ * blocking the tick.
+ *
+ * The worker raises `done` when the file is written. A game loop calls
+ * mc_autosave_poll() once per tick: it joins only after `done` is set,
+ * so it never waits on the disk. mc_autosave_finish() blocks, for
+ * shutdown and tests.
+ * ========================================================================= */
+
+#define MC_AUTOSAVE_PATH_MAX 512
+
+typedef struct {
+    uint8_t* buffer;          /* caller-owned, >= mc_world_save_size()
+                                 (+ mc_lz_frame_bound() of it if compressed) */
+    uint32_t capacity;
+    McLzWriter* lz;           /* NULL: write plain saves */
+    uint32_t length;
+    char     path[MC_AUTOSAVE_PATH_MAX];
+    McThread thread;
+    McAtomicU32 done;         /* set by the worker when the write is over */
+    int      in_flight;
+    int      threaded;        /* 0 if the worker failed to start (wrote inline) */
+    int      result;          /* 0 ok, -1 write failed */
+    uint32_t completed;       /* autosaves finished */
+} McAutosave;
+
+static void mc_autosave_init(McAutosave* as, uint8_t* buffer, uint32_t capacity) {
+    memset(as, 0, sizeof(*as));
+    as->buffer   = buffer;
+    as->capacity = capacity;
+}
+
+/* Compress autosaves with `lz` (owned by the autosave while in flight),
+ * or NULL to go back to plain files. */
+static void mc_autosave_set_compression(McAutosave* as, McLzWriter* lz) {
+    as->lz = lz;
+}
+
+static MC_THREAD_PROC(mc_autosave__worker) {
+    McAutosave* as = (McAutosave*)mc_thread_arg;
+    as->result = mc_save__write_bytes(as->path, as->lz, as->buffer, as->length, as->capacity);
+    mc_atomic_store_release(&as->done, 1);
+    MC_THREAD_RETURN;
+}
+
+/* Join the in-flight write (if any). Returns its result. */
+static int mc_autosave_finish(McAutosave* as) {
+    if (!as->in_flight) return as->result;
+    if (as->threaded) mc_thread_join(&as->thread);
+    as->in_flight = 0;
+    as->completed++;
+    return as->result;
+}
+
+/* Non-blocking: reap the in-flight write if the worker has finished.
+ * Returns 1 if no autosave is in flight (any result is in as->result),
+ * 0 if the worker is still writing. */
+static int mc_autosave_poll(McAutosave* as) {
+    if (!as->in_flight) return 1;
+    if (!mc_atomic_load_acquire(&as->done)) return 0;
+    mc_autosave_finish(as);
+    return 1;
+}
+
+/* Returns 0 if the autosave was started, -1 if one is still in flight,
+ * the buffer is too small, or the path is too long. */
+static int mc_autosave_begin(McAutosave* as, const WorldRefs* w, const char* path) {
+    size_t n = strlen(path);
+    if (as->in_flight) return -1;
+    if (n + 1 > sizeof(as->path)) return -1;
+    as->length = mc_world_save(w, as->buffer, as->capacity);
+    if (as->length == 0) return -1;
+    memcpy(as->path, path, n + 1);
+
+    as->in_flight = 1;
+    mc_atomic_store_release(&as->done, 0);
+    as->threaded  = (mc_thread_start(&as->thread, mc_autosave__worker, as) == 0);
+    if (!as->threaded) {
+        as->result = mc_save__write_bytes(as->path, as->lz, as->buffer, as->length, as->capacity);
+        mc_atomic_store_release(&as->done, 1);
+    }
+    return 0;
+}
+
+#endif /* MARBLE_SAVE_H */
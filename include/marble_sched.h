@@ -0,0 +1,180 @@
+/*
+ * marble_sched.h -- System Phase Scheduler (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Keep tick cost flat. Gating every periodic system on tick % freq == 0
+ *   lines them all up on tick 0, and again on every common multiple
+ *   (freq 2 and 4 systems all fire on ticks 0, 4, 8, ...). This module
+ *   gives each system a phase offset so it runs on tick % freq == phase,
+ *   with the phases chosen to spread estimated cost evenly.
+ *
+ *   For large per-entity systems it also splits the dense array into
+ *   `freq` slices so the system runs every tick on 1/freq of its
+ *   entities. Each entity is still visited once every freq ticks, with
+ *   no spike.
+ *
+ * ALGORITHM:
+ *   Greedy list scheduling over the hyperperiod (lcm of all freqs, capped
+ *   at MC_SCHED_MAX_PERIOD ticks). Systems are placed in order of
+ *   decreasing load (cost / freq). Each takes the phase that minimizes
+ *   the resulting peak tick load, with ties broken by the sum of squared
+ *   loads and then by the lowest phase. Deterministic for a given table.
+ *
+ *   Coprime frequencies must coincide somewhere (freq 2 and 3 share one
+ *   tick in every 6), so the goal is the lowest peak, not zero overlap.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_SCHED_H
+#define MARBLE_SCHED_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define MC_SCHED_MAX_SYSTEMS  32
+#define MC_SCHED_MAX_PERIOD 1024   /* ticks of load tracked */
+
+typedef struct {
+    uint32_t count;
+    uint32_t period;                        /* min(lcm(freq), MAX_PERIOD) */
+    uint32_t freq[MC_SCHED_MAX_SYSTEMS];
+    uint32_t phase[MC_SCHED_MAX_SYSTEMS];
+    uint32_t cost[MC_SCHED_MAX_SYSTEMS];
+    uint32_t sliced[MC_SCHED_MAX_SYSTEMS];  /* nonzero: runs every tick on 1/freq */
+    uint32_t load[MC_SCHED_MAX_PERIOD];     /* estimated cost per tick of the period */
+} McSchedule;
+
+static uint32_t mc_sched__gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Cost one system adds to a tick it runs on. A sliced system runs every
+ * tick at 1/freq of its full cost (rounded up so it is never free). */
+static uint32_t mc_sched__tick_cost(const McSchedule* s, uint32_t sys) {
+    if (s->sliced[sys]) return (s->cost[sys] + s->freq[sys] - 1) / s->freq[sys];
+    return s->cost[sys];
+}
+
+static int mc_sched__runs(const McSchedule* s, uint32_t sys, uint32_t phase, uint32_t tick) {
+    return s->sliced[sys] || (tick % s->freq[sys]) == phase;
+}
+
+/* Build a schedule for `n` systems.
+ *   freq[i]   -- run every freq[i] ticks (0 is treated as 1)
+ *   cost[i]   -- relative cost estimate; NULL means all equal
+ *   sliced[i] -- nonzero to split the system across ticks; NULL = none
+ * Returns 0, or -1 if n exceeds MC_SCHED_MAX_SYSTEMS. */
+static int mc_sched_init(McSchedule* s, const uint32_t* freq, const uint32_t* cost,
+                         const uint32_t* sliced, uint32_t n) {
+    uint32_t order[MC_SCHED_MAX_SYSTEMS];
+    uint32_t i, j, k;
+
+    if (n > MC_SCHED_MAX_SYSTEMS) return -1;
+    memset(s, 0, sizeof(McSchedule));
+    s->count  = n;
+    s->period = 1;
+    for (i = 0; i < n; i++) {
+        s->freq[i]   = (freq[i] > 0) ? freq[i] : 1;
+        s->cost[i]   = (cost != NULL) ? cost[i] : 1;
+        s->sliced[i] = (sliced != NULL) ? sliced[i] : 0;
+        if (s->period < MC_SCHED_MAX_PERIOD) {
+            uint64_t l = (uint64_t)s->period / mc_sched__gcd(s->period, s->freq[i]) * s->freq[i];
+            s->period = (l < MC_SCHED_MAX_PERIOD) ? (uint32_t)l : MC_SCHED_MAX_PERIOD;
+        }
+        order[i] = i;
+    }
+
+    /* Heaviest per-tick load first (insertion sort; n is small). Compare
+     * cost_a / freq_a > cost_b / freq_b without dividing. */
+    for (i = 1; i < n; i++) {
+        uint32_t x = order[i];
+        j = i;
+        while (j > 0) {
+            uint32_t y = order[j - 1];
+            if ((uint64_t)s->cost[x] * s->freq[y] <= (uint64_t)s->cost[y] * s->freq[x]) break;
+            order[j] = y;
+            j--;
+        }
+        order[j] = x;
+    }
+
+    for (i = 0; i < n; i++) {
+        uint32_t sys   = order[i];
+        uint32_t add   = mc_sched__tick_cost(s, sys);
+        uint32_t best  = 0;
+        uint32_t tries = s->sliced[sys] ? 1 : s->freq[sys];
+        uint64_t best_peak = UINT64_MAX, best_sq = UINT64_MAX;
+        uint32_t p;
+
+        for (p = 0; p < tries; p++) {
+            uint64_t peak = 0, sq = 0;
+            for (k = 0; k < s->period; k++) {
+                uint64_t l = s->load[k];
+                if (mc_sched__runs(s, sys, p, k)) l += add;
+                if (l > peak) peak = l;
+                sq += l * l;
+            }
+            if (peak < best_peak || (peak == best_peak && sq < best_sq)) {
+                best = p;
+                best_peak = peak;
+                best_sq = sq;
+            }
+        }
+
+        s->phase[sys] = best;
+        for (k = 0; k < s->period; k++) {
+            if (mc_sched__runs(s, sys, best, k)) s->load[k] += add;
+        }
+    }
+    return 0;
+}
+
+/* Does system `sys` run on `tick`? Sliced systems run every tick. */
+static int mc_sched_due(const McSchedule* s, uint32_t sys, uint64_t tick) {
+    if (sys >= s->count) return 0;
+    if (s->sliced[sys]) return 1;
+    return (tick % s->freq[sys]) == s->phase[sys];
+}
+
+/* The part of a `count`-element dense array a sliced system processes on
+ * `tick`: [*begin, *end). Over any freq consecutive ticks the slices
+ * cover 0..count-1 exactly once. Entities swap-removed mid-cycle may
+ * move into a slice already visited this cycle and wait one more cycle.
+ * A system that isn't sliced gets the whole array. */
+static void mc_sched_slice(const McSchedule* s, uint32_t sys, uint64_t tick,
+                           uint32_t count, uint32_t* begin, uint32_t* end) {
+    uint32_t f, k;
+    if (sys >= s->count || !s->sliced[sys] || s->freq[sys] <= 1) {
+        *begin = 0;
+        *end   = count;
+        return;
+    }
+    f = s->freq[sys];
+    k = (uint32_t)(tick % f);
+    *begin = (uint32_t)((uint64_t)count * k / f);
+    *end   = (uint32_t)((uint64_t)count * (k + 1) / f);
+}
+
+/* Estimated peak and mean tick cost over the period, for logs/tests */
+static uint32_t mc_sched_peak_load(const McSchedule* s) {
+    uint32_t k, peak = 0;
+    for (k = 0; k < s->period; k++) {
+        if (s->load[k] > peak) peak = s->load[k];
+    }
+    return peak;
+}
+
+static uint32_t mc_sched_mean_load(const McSchedule* s) {
+    uint64_t sum = 0;
+    uint32_t k;
+    for (k = 0; k < s->period; k++) sum += s->load[k];
+    return (uint32_t)((sum + s->period / 2) / s->period);
+}
+
+#endif /* MARBLE_SCHED_H */
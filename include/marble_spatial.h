@@ -0,0 +1,400 @@
+/*
+ * marble_spatial.h -- Uniform Grid Spatial Index (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Proximity queries (radius, rectangle, k nearest) at a cost that
+ *   scales with local density instead of total entity count. Replaces
+ *   "scan every entity" loops for collision, aggro and targeting.
+ *
+ * ARCHITECTURE:
+ *   The world rectangle [origin, origin + cols * cell) x [...] is cut
+ *   into square cells. Each cell heads an intrusive doubly linked list
+ *   of the entities inside it, stored as index arrays keyed by EntityID:
+ *   insert, remove and move are O(1) and nothing is allocated after init.
+ *   Positions outside the rectangle clamp into the edge cells, so every
+ *   entity is always findable. Queries test true positions, never cells.
+ *
+ *   The index is keyed off the position component: mc_grid_build()
+ *   reads x and y as the first two floats of each row, the layout every
+ *   CPosition in the tree uses. Hosts keep it current by calling
+ *   mc_grid_move() wherever positions change.
+ *
+ * QUERIES:
+ *   All queries write into caller buffers and return the number of
+ *   matches, which may exceed `cap`; only the first `cap` are written.
+ *   Results are in cell order, not sorted, except for k-nearest.
+ *
+ * CONTAINMENT:
+ *   An entity held by another (an item in a bag, a bag in a cart) is not
+ *   in the world and not on the grid. ContainerIndex records the holder
+ *   of each entity plus per-holder child lists. Writes to `parent` can be
+ *   deferred and the lists caught up later with mc_container_sync(),
+ *   which is how command flush batches a tick's moves.
+ *
+ * CAPACITY:
+ *   MC_GRID_MAX_ENTITIES (default MC_MAX_ENTITIES) and MC_GRID_MAX_CELLS
+ *   can be raised by defining them before the include, e.g. for a
+ *   server process indexing 100k entities.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_SPATIAL_H
+#define MARBLE_SPATIAL_H
+
+#include "marble_core.h"
+
+#ifndef MC_GRID_MAX_ENTITIES
+#define MC_GRID_MAX_ENTITIES MC_MAX_ENTITIES
+#endif
+
+#ifndef MC_GRID_MAX_CELLS
+#define MC_GRID_MAX_CELLS 4096
+#endif
+
+#define MC_GRID_NONE UINT32_MAX
+
+/* =========================================================================
+ * SECTION 1: GRID
+ * ========================================================================= */
+
+typedef struct {
+    float    origin_x, origin_y;
+    float    cell_size;
+    float    inv_cell;
+    uint32_t cols, rows;
+    uint32_t count;
+
+    uint32_t cell_head[MC_GRID_MAX_CELLS];      /* first eid in cell, or NONE */
+    uint32_t next[MC_GRID_MAX_ENTITIES];        /* per eid: next in cell      */
+    uint32_t prev[MC_GRID_MAX_ENTITIES];        /* per eid: prev in cell      */
+    uint32_t cell_of[MC_GRID_MAX_ENTITIES];     /* per eid: cell, or NONE     */
+    float    x[MC_GRID_MAX_ENTITIES];
+    float    y[MC_GRID_MAX_ENTITIES];
+} SpatialGrid;
+
+/* Returns 0, or -1 if cols * rows exceeds MC_GRID_MAX_CELLS or the cell
+ * size isn't positive. */
+static int mc_grid_init(SpatialGrid* g, float origin_x, float origin_y,
+                        float cell_size, uint32_t cols, uint32_t rows) {
+    uint32_t i;
+    if (!(cell_size > 0.0f) || cols == 0 || rows == 0) return -1;
+    if ((uint64_t)cols * rows > MC_GRID_MAX_CELLS) return -1;
+    g->origin_x  = origin_x;
+    g->origin_y  = origin_y;
+    g->cell_size = cell_size;
+    g->inv_cell  = 1.0f / cell_size;
+    g->cols      = cols;
+    g->rows      = rows;
+    g->count     = 0;
+    for (i = 0; i < MC_GRID_MAX_CELLS; i++) g->cell_head[i] = MC_GRID_NONE;
+    for (i = 0; i < MC_GRID_MAX_ENTITIES; i++) g->cell_of[i] = MC_GRID_NONE;
+    return 0;
+}
+
+/* Column (or row) of a coordinate, clamped to [0, n-1]. NaN -> 0. */
+static uint32_t mc_grid__axis(float v, float origin, float inv_cell, uint32_t n) {
+    float f = (v - origin) * inv_cell;
+    if (!(f >= 0.0f)) return 0;
+    if (f >= (float)n) return n - 1;
+    return (uint32_t)f;
+}
+
+static uint32_t mc_grid_cell_of_point(const SpatialGrid* g, float x, float y) {
+    return mc_grid__axis(y, g->origin_y, g->inv_cell, g->rows) * g->cols
+         + mc_grid__axis(x, g->origin_x, g->inv_cell, g->cols);
+}
+
+static int mc_grid_has(const SpatialGrid* g, EntityID eid) {
+    return eid < MC_GRID_MAX_ENTITIES && g->cell_of[eid] != MC_GRID_NONE;
+}
+
+static void mc_grid__link(SpatialGrid* g, EntityID eid, uint32_t cell) {
+    uint32_t head = g->cell_head[cell];
+    g->prev[eid] = MC_GRID_NONE;
+    g->next[eid] = head;
+    if (head != MC_GRID_NONE) g->prev[head] = eid;
+    g->cell_head[cell] = eid;
+    g->cell_of[eid] = cell;
+}
+
+static void mc_grid__unlink(SpatialGrid* g, EntityID eid) {
+    uint32_t p = g->prev[eid], n = g->next[eid];
+    if (p != MC_GRID_NONE) g->next[p] = n;
+    else                   g->cell_head[g->cell_of[eid]] = n;
+    if (n != MC_GRID_NONE) g->prev[n] = p;
+    g->cell_of[eid] = MC_GRID_NONE;
+}
+
+/* Returns 0, or -1 if eid is out of range or already indexed. */
+static int mc_grid_insert(SpatialGrid* g, EntityID eid, float x, float y) {
+    if (eid >= MC_GRID_MAX_ENTITIES || g->cell_of[eid] != MC_GRID_NONE) return -1;
+    g->x[eid] = x;
+    g->y[eid] = y;
+    mc_grid__link(g, eid, mc_grid_cell_of_point(g, x, y));
+    g->count++;
+    return 0;
+}
+
+/* Returns 0, or -1 if eid isn't indexed. */
+static int mc_grid_remove(SpatialGrid* g, EntityID eid) {
+    if (!mc_grid_has(g, eid)) return -1;
+    mc_grid__unlink(g, eid);
+    g->count--;
+    return 0;
+}
+
+/* Update a position. Relinks only if the cell changed. Returns 0, or -1
+ * if eid isn't indexed. */
+static int mc_grid_move(SpatialGrid* g, EntityID eid, float x, float y) {
+    uint32_t cell;
+    if (!mc_grid_has(g, eid)) return -1;
+    g->x[eid] = x;
+    g->y[eid] = y;
+    cell = mc_grid_cell_of_point(g, x, y);
+    if (cell != g->cell_of[eid]) {
+        mc_grid__unlink(g, eid);
+        mc_grid__link(g, eid, cell);
+    }
+    return 0;
+}
+
+/* Index every row of a position pool (x, y = the first two floats).
+ * Clears the grid first. Returns the number indexed. */
+static uint32_t mc_grid_build(SpatialGrid* g, const SparseSet* positions) {
+    uint32_t i, n = 0;
+    mc_grid_init(g, g->origin_x, g->origin_y, g->cell_size, g->cols, g->rows);
+    if (positions->stride < 2 * sizeof(float)) return 0;
+    for (i = 0; i < positions->count; i++) {
+        float xy[2];
+        memcpy(xy, &positions->data[i * positions->stride], sizeof(xy));
+        if (mc_grid_insert(g, positions->dense[i], xy[0], xy[1]) == 0) n++;
+    }
+    return n;
+}
+
+/* =========================================================================
+ * SECTION 2: RANGE QUERIES
+ * ========================================================================= */
+
+/* Entities in the closed rectangle [min_x, max_x] x [min_y, max_y] */
+static uint32_t mc_grid_query_rect(const SpatialGrid* g, float min_x, float min_y,
+                                   float max_x, float max_y,
+                                   EntityID* out, uint32_t cap) {
+    uint32_t c0 = mc_grid__axis(min_x, g->origin_x, g->inv_cell, g->cols);
+    uint32_t c1 = mc_grid__axis(max_x, g->origin_x, g->inv_cell, g->cols);
+    uint32_t r0 = mc_grid__axis(min_y, g->origin_y, g->inv_cell, g->rows);
+    uint32_t r1 = mc_grid__axis(max_y, g->origin_y, g->inv_cell, g->rows);
+    uint32_t r, c, found = 0;
+    if (!(min_x <= max_x) || !(min_y <= max_y)) return 0;
+    for (r = r0; r <= r1; r++) {
+        for (c = c0; c <= c1; c++) {
+            uint32_t e = g->cell_head[r * g->cols + c];
+            while (e != MC_GRID_NONE) {
+                if (g->x[e] >= min_x && g->x[e] <= max_x
+                    && g->y[e] >= min_y && g->y[e] <= max_y) {
+                    if (found < cap) out[found] = e;
+                    found++;
+                }
+                e = g->next[e];
+            }
+        }
+    }
+    return found;
+}
+
+/* Entities within `radius` of (x, y), boundary included */
+static uint32_t mc_grid_query_radius(const SpatialGrid* g, float x, float y, float radius,
+                                     EntityID* out, uint32_t cap) {
+    uint32_t c0, c1, r0, r1, r, c, found = 0;
+    float r2 = radius * radius;
+    if (!(radius >= 0.0f)) return 0;
+    c0 = mc_grid__axis(x - radius, g->origin_x, g->inv_cell, g->cols);
+    c1 = mc_grid__axis(x + radius, g->origin_x, g->inv_cell, g->cols);
+    r0 = mc_grid__axis(y - radius, g->origin_y, g->inv_cell, g->rows);
+    r1 = mc_grid__axis(y + radius, g->origin_y, g->inv_cell, g->rows);
+    for (r = r0; r <= r1; r++) {
+        for (c = c0; c <= c1; c++) {
+            uint32_t e = g->cell_head[r * g->cols + c];
+            while (e != MC_GRID_NONE) {
+                float dx = g->x[e] - x, dy = g->y[e] - y;
+                if (dx * dx + dy * dy <= r2) {
+                    if (found < cap) out[found] = e;
+                    found++;
+                }
+                e = g->next[e];
+            }
+        }
+    }
+    return found;
+}
+
+/* =========================================================================
+ * SECTION 3: K NEAREST
+ *
+ * Ring search outward from the query's cell. After each ring, any entity
+ * not yet seen lies outside the searched block of cells, so once the
+ * k-th best distance is within the block's margin the answer is final.
+ * Block sides on the grid edge have nothing beyond them (positions clamp
+ * inward), so they don't limit the margin.
+ * ========================================================================= */
+
+/* Insert into the sorted k-best arrays if closer than the current worst */
+static void mc_grid__knn_offer(EntityID e, float d2, EntityID* out, float* dist2,
+                               uint32_t* n, uint32_t k) {
+    uint32_t i;
+    if (*n == k && d2 >= dist2[k - 1]) return;
+    i = (*n < k) ? (*n)++ : k - 1;
+    while (i > 0 && dist2[i - 1] > d2) {
+        out[i]   = out[i - 1];
+        dist2[i] = dist2[i - 1];
+        i--;
+    }
+    out[i]   = e;
+    dist2[i] = d2;
+}
+
+static void mc_grid__knn_cell(const SpatialGrid* g, uint32_t cell, float x, float y,
+                              EntityID* out, float* dist2, uint32_t* n, uint32_t k) {
+    uint32_t e = g->cell_head[cell];
+    while (e != MC_GRID_NONE) {
+        float dx = g->x[e] - x, dy = g->y[e] - y;
+        mc_grid__knn_offer(e, dx * dx + dy * dy, out, dist2, n, k);
+        e = g->next[e];
+    }
+}
+
+/* The k entities nearest (x, y), closest first, with their squared
+ * distances in dist2. Both buffers hold k entries. Returns how many were
+ * found: min(k, g->count). */
+static uint32_t mc_grid_query_knn(const SpatialGrid* g, float x, float y, uint32_t k,
+                                  EntityID* out, float* dist2) {
+    uint32_t cx = mc_grid__axis(x, g->origin_x, g->inv_cell, g->cols);
+    uint32_t cy = mc_grid__axis(y, g->origin_y, g->inv_cell, g->rows);
+    uint32_t max_ring = (g->cols > g->rows) ? g->cols : g->rows;
+    uint32_t n = 0, d;
+
+    if (k == 0) return 0;
+    for (d = 0; d <= max_ring; d++) {
+        int32_t c0 = (int32_t)cx - (int32_t)d, c1 = (int32_t)cx + (int32_t)d;
+        int32_t r0 = (int32_t)cy - (int32_t)d, r1 = (int32_t)cy + (int32_t)d;
+        int32_t r, c;
+        float margin = 3.4e38f;
+
+        /* Cells whose Chebyshev distance from (cx, cy) is exactly d */
+        for (r = r0; r <= r1; r++) {
+            int32_t step;
+            if (r < 0 || r >= (int32_t)g->rows) continue;
+            step = (r == r0 || r == r1) ? 1 : (c1 - c0);
+            for (c = c0; c <= c1; c += (step > 0) ? step : 1) {
+                if (c < 0 || c >= (int32_t)g->cols) continue;
+                mc_grid__knn_cell(g, (uint32_t)r * g->cols + (uint32_t)c, x, y, out, dist2, &n, k);
+            }
+        }
+
+        /* Everything outside the block is at least `margin` away */
+        if (c0 > 0)                   { float m = x - (g->origin_x + (float)c0 * g->cell_size);       if (m < margin) margin = m; }
+        if (c1 < (int32_t)g->cols - 1) { float m = (g->origin_x + (float)(c1 + 1) * g->cell_size) - x; if (m < margin) margin = m; }
+        if (r0 > 0)                   { float m = y - (g->origin_y + (float)r0 * g->cell_size);       if (m < margin) margin = m; }
+        if (r1 < (int32_t)g->rows - 1) { float m = (g->origin_y + (float)(r1 + 1) * g->cell_size) - y; if (m < margin) margin = m; }
+
+        if (margin == 3.4e38f) break;                      /* block covers the grid */
+        if (n == k && margin > 0.0f && dist2[k - 1] <= margin * margin) break;
+    }
+    return n;
+}
+
+/* =========================================================================
+ * SECTION 4: CONTAINMENT
+ *
+ * `parent` is the source of truth. `linked` records which holder's child
+ * list an entity is currently on; the two differ only between a deferred
+ * mc_container_set_parent() and the mc_container_sync() that follows.
+ * Sized by MC_GRID_MAX_ENTITIES like the grid.
+ * ========================================================================= */
+
+#define MC_CONTAINER_NONE UINT32_MAX
+
+typedef struct {
+    uint32_t parent[MC_GRID_MAX_ENTITIES];        /* holder, or NONE        */
+    uint32_t linked[MC_GRID_MAX_ENTITIES];        /* list currently on      */
+    uint32_t first_child[MC_GRID_MAX_ENTITIES];
+    uint32_t next_sibling[MC_GRID_MAX_ENTITIES];
+    uint32_t prev_sibling[MC_GRID_MAX_ENTITIES];
+} ContainerIndex;
+
+static void mc_container_init(ContainerIndex* ci) {
+    uint32_t i;
+    for (i = 0; i < MC_GRID_MAX_ENTITIES; i++) {
+        ci->parent[i]      = MC_CONTAINER_NONE;
+        ci->linked[i]      = MC_CONTAINER_NONE;
+        ci->first_child[i] = MC_CONTAINER_NONE;
+    }
+}
+
+static uint32_t mc_container_parent(const ContainerIndex* ci, EntityID eid) {
+    return (eid < MC_GRID_MAX_ENTITIES) ? ci->parent[eid] : MC_CONTAINER_NONE;
+}
+
+/* 1 if putting `item` into `holder` would make an entity hold itself:
+ * holder == item, or item already (transitively) holds holder. */
+static int mc_container_would_cycle(const ContainerIndex* ci, EntityID item, EntityID holder) {
+    uint32_t e = holder, steps = 0;
+    while (e != MC_CONTAINER_NONE && steps++ < MC_GRID_MAX_ENTITIES) {
+        if (e == item) return 1;
+        e = ci->parent[e];
+    }
+    return 0;
+}
+
+/* Record a new holder (NONE = not contained) without touching the child
+ * lists. Returns 0, or -1 if either id is out of range. */
+static int mc_container_set_parent(ContainerIndex* ci, EntityID eid, uint32_t holder) {
+    if (eid >= MC_GRID_MAX_ENTITIES) return -1;
+    if (holder != MC_CONTAINER_NONE && holder >= MC_GRID_MAX_ENTITIES) return -1;
+    ci->parent[eid] = holder;
+    return 0;
+}
+
+/* Move eid onto the child list of its current parent, if it isn't there.
+ * Returns 1 if it relinked, 0 if the lists were already current. */
+static int mc_container_sync(ContainerIndex* ci, EntityID eid) {
+    uint32_t to = ci->parent[eid], from = ci->linked[eid];
+    if (to == from) return 0;
+    if (from != MC_CONTAINER_NONE) {
+        uint32_t p = ci->prev_sibling[eid], n = ci->next_sibling[eid];
+        if (p != MC_CONTAINER_NONE) ci->next_sibling[p] = n;
+        else                        ci->first_child[from] = n;
+        if (n != MC_CONTAINER_NONE) ci->prev_sibling[n] = p;
+    }
+    if (to != MC_CONTAINER_NONE) {
+        uint32_t head = ci->first_child[to];
+        ci->prev_sibling[eid] = MC_CONTAINER_NONE;
+        ci->next_sibling[eid] = head;
+        if (head != MC_CONTAINER_NONE) ci->prev_sibling[head] = eid;
+        ci->first_child[to] = eid;
+    }
+    ci->linked[eid] = to;
+    return 1;
+}
+
+/* Immediate set + sync, for setup code outside the command flush */
+static int mc_container_place(ContainerIndex* ci, EntityID eid, uint32_t holder) {
+    if (mc_container_set_parent(ci, eid, holder) != 0) return -1;
+    mc_container_sync(ci, eid);
+    return 0;
+}
+
+/* Direct children of `holder`. Same count/cap contract as the queries. */
+static uint32_t mc_container_children(const ContainerIndex* ci, EntityID holder,
+                                      EntityID* out, uint32_t cap) {
+    uint32_t e, found = 0;
+    if (holder >= MC_GRID_MAX_ENTITIES) return 0;
+    for (e = ci->first_child[holder]; e != MC_CONTAINER_NONE; e = ci->next_sibling[e]) {
+        if (found < cap) out[found] = e;
+        found++;
+    }
+    return found;
+}
+
+#endif /* MARBLE_SPATIAL_H */
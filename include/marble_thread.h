@@ -0,0 +1,106 @@
+/*
+ * marble_thread.h -- Minimal Worker Thread Layer (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Start and join OS threads for embarrassingly parallel batch work
+ *   (pool fills at load time, offline batch runs, stepping independent
+ *   worlds in marble_world.h). A single world's tick never spans threads
+ *   -- each simulation stays single-threaded and deterministic.
+ *
+ * USAGE:
+ *   static MC_THREAD_PROC(my_worker) {
+ *       MyJob* job = (MyJob*)mc_thread_arg;
+ *       ...
+ *       MC_THREAD_RETURN;
+ *   }
+ *
+ *   McThread t;
+ *   if (mc_thread_start(&t, my_worker, &job) != 0) { run inline instead }
+ *   mc_thread_join(&t);
+ *
+ *   A worker that finishes on its own publishes that through an
+ *   McAtomicU32 (mc_atomic_store_release); the owner checks it with
+ *   mc_atomic_load_acquire and joins only once it is set.
+ *
+ * NOTE:
+ *   The OS entry point is the one place a function pointer crosses an
+ *   API boundary. Engine code never stores or dispatches through it.
+ *
+ * BUILD:
+ *   POSIX needs -lpthread. Win32 needs nothing extra.
+ */
+
+#ifndef MARBLE_THREAD_H
+#define MARBLE_THREAD_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include <stdint.h>
+#include "marble_atomic.h"   /* McAtomicU32 completion flags */
+
+/* Upper bound on workers any caller should spawn at once */
+#define MC_THREAD_MAX_WORKERS 16
+
+#ifdef _WIN32
+
+typedef struct {
+    HANDLE handle;
+} McThread;
+
+#define MC_THREAD_PROC(name) DWORD WINAPI name(LPVOID mc_thread_arg)
+#define MC_THREAD_RETURN     return 0
+typedef DWORD (WINAPI *McThreadEntry)(LPVOID);
+
+/* Returns 0 on success, -1 if the thread could not be created. */
+static int mc_thread_start(McThread* t, McThreadEntry entry, void* arg) {
+    t->handle = CreateThread(NULL, 0, entry, arg, 0, NULL);
+    return (t->handle != NULL) ? 0 : -1;
+}
+
+static void mc_thread_join(McThread* t) {
+    WaitForSingleObject(t->handle, INFINITE);
+    CloseHandle(t->handle);
+    t->handle = NULL;
+}
+
+static unsigned mc_thread_cpu_count(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (si.dwNumberOfProcessors > 0) ? (unsigned)si.dwNumberOfProcessors : 1u;
+}
+
+#else /* POSIX */
+
+typedef struct {
+    pthread_t handle;
+} McThread;
+
+#define MC_THREAD_PROC(name) void* name(void* mc_thread_arg)
+#define MC_THREAD_RETURN     return NULL
+typedef void* (*McThreadEntry)(void*);
+
+/* Returns 0 on success, -1 if the thread could not be created. */
+static int mc_thread_start(McThread* t, McThreadEntry entry, void* arg) {
+    return (pthread_create(&t->handle, NULL, entry, arg) == 0) ? 0 : -1;
+}
+
+static void mc_thread_join(McThread* t) {
+    pthread_join(t->handle, NULL);
+}
+
+static unsigned mc_thread_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (unsigned)n : 1u;
+}
+
+#endif
+
+#endif /* MARBLE_THREAD_H */
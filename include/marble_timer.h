@@ -0,0 +1,419 @@
+/*
+ * marble_timer.h -- Hierarchical Timing Wheel for Scheduled Commands (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Rules can only emit commands for the current tick. The timing wheel
+ *   lets a system say "apply this CMD_MODIFY_STAT in 30 ticks" or
+ *   "re-enable this capability after a cooldown" without polling.
+ *
+ * ARCHITECTURE:
+ *   Four levels of 64 slots each (6 bits per level), classic hashed
+ *   hierarchical wheel:
+ *
+ *     level 0: ticks [now, now + 64)          one slot per tick
+ *     level 1: ticks [now + 64, now + 4096)   one slot per 64 ticks
+ *     level 2: ticks ... + 262144             one slot per 4096 ticks
+ *     level 3: ticks ... + 16777216           one slot per 262144 ticks
+ *
+ *   When level 0 wraps, the matching level-1 slot is cascaded down, and
+ *   so on up the hierarchy. Timers further out than the top level are
+ *   parked in the farthest slot and re-placed each time they cascade.
+ *
+ *   Every timer is a node in a static pool. Slots are intrusive doubly
+ *   linked lists of node indices (no pointers), so:
+ *     - insert is O(1)  (append to a slot tail)
+ *     - cancel is O(1)  (unlink by index, validated by generation)
+ *     - drain  is O(expired) per tick, plus amortized cascades
+ *
+ * INTEGRATION:
+ *   Due commands are pushed into the CommandBuffer at the START of the
+ *   flush (mc_cmd_flush_timed), so they are validated and applied by the
+ *   exact same applicators as commands emitted this tick.
+ *
+ * DETERMINISM:
+ *   The wheel holds no pointers and no wall-clock state. Two wheels fed
+ *   the same schedule/cancel sequence drain identical command streams in
+ *   identical order. mc_timer_wheel_snapshot()/restore() copy the whole
+ *   wheel so it round-trips with the world snapshot for replay.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_TIMER_H
+#define MARBLE_TIMER_H
+
+#include "marble_core.h"
+#include "marble_cmd.h"
+#include <stddef.h>   /* offsetof (snapshot checks) */
+
+/* =========================================================================
+ * SECTION 1: CONFIGURATION
+ * ========================================================================= */
+
+#define MC_TIMER_WHEEL_BITS    6
+#define MC_TIMER_WHEEL_SLOTS   (1u << MC_TIMER_WHEEL_BITS)   /* 64 */
+#define MC_TIMER_WHEEL_MASK    (MC_TIMER_WHEEL_SLOTS - 1u)
+#define MC_TIMER_WHEEL_LEVELS  4
+#define MC_TIMER_WHEEL_SPAN    (1ull << (MC_TIMER_WHEEL_BITS * MC_TIMER_WHEEL_LEVELS))
+
+#define MC_MAX_TIMERS          1024
+
+/* Bump when the TimerWheel layout changes (snapshot compatibility). */
+#define MC_TIMER_SNAPSHOT_VERSION 1u
+#define MC_TIMER_SNAPSHOT_MAGIC   0x524D4954u  /* "TIMR" */
+
+/* =========================================================================
+ * SECTION 2: TIMER HANDLE
+ *
+ * Low 16 bits: node index. High 16 bits: node generation.
+ * The generation is bumped every time a node is released, so a stale
+ * handle (timer already fired or cancelled) can never cancel the node's
+ * next occupant.
+ * ========================================================================= */
+
+typedef uint32_t TimerHandle;
+
+#define MC_TIMER_INVALID UINT32_MAX
+
+/* =========================================================================
+ * SECTION 3: TIMER WHEEL
+ * ========================================================================= */
+
+typedef struct {
+    Command  cmd;         /* command pushed into the buffer when due */
+    uint64_t due_tick;    /* absolute tick the command fires on */
+    uint32_t next;        /* next node in slot list (or free list) */
+    uint32_t prev;        /* previous node in slot list */
+    uint32_t slot;        /* flat slot index (level * 64 + idx), or INVALID */
+    uint16_t generation;  /* bumped on release; validates handles */
+    uint16_t active;      /* 1 while scheduled */
+} TimerNode;
+
+typedef struct {
+    TimerNode nodes[MC_MAX_TIMERS];
+
+    /* Slot lists, flattened: [level * MC_TIMER_WHEEL_SLOTS + idx] */
+    uint32_t  heads[MC_TIMER_WHEEL_LEVELS * MC_TIMER_WHEEL_SLOTS];
+    uint32_t  tails[MC_TIMER_WHEEL_LEVELS * MC_TIMER_WHEEL_SLOTS];
+
+    uint32_t  free_head;     /* singly linked through nodes[].next */
+    uint32_t  count;         /* live (scheduled) timers */
+    uint32_t  dropped;       /* schedule attempts rejected (pool full) */
+    uint32_t  fired;         /* lifetime timers drained into a buffer */
+    uint64_t  current_tick;  /* next tick to be drained */
+
+    /* Nodes touched since the last checkpoint (delta saves) */
+    uint32_t  dirty[MC_MAX_TIMERS / 32];
+} TimerWheel;
+
+static void mc_timer__touch(TimerWheel* w, uint32_t n) {
+    w->dirty[n >> 5] |= 1u << (n & 31);
+}
+
+static void mc_timer_wheel_clear_dirty(TimerWheel* w) {
+    memset(w->dirty, 0, sizeof(w->dirty));
+}
+
+static void mc_timer_wheel_init(TimerWheel* w, uint64_t start_tick) {
+    uint32_t i;
+    for (i = 0; i < MC_TIMER_WHEEL_LEVELS * MC_TIMER_WHEEL_SLOTS; i++) {
+        w->heads[i] = MC_INVALID_INDEX;
+        w->tails[i] = MC_INVALID_INDEX;
+    }
+    for (i = 0; i < MC_MAX_TIMERS; i++) {
+        w->nodes[i].next       = (i + 1 < MC_MAX_TIMERS) ? i + 1 : MC_INVALID_INDEX;
+        w->nodes[i].prev       = MC_INVALID_INDEX;
+        w->nodes[i].slot       = MC_INVALID_INDEX;
+        w->nodes[i].generation = 0;
+        w->nodes[i].active     = 0;
+        w->nodes[i].due_tick   = 0;
+        memset(&w->nodes[i].cmd, 0, sizeof(Command));
+    }
+    w->free_head    = 0;
+    w->count        = 0;
+    w->dropped      = 0;
+    w->fired        = 0;
+    w->current_tick = start_tick;
+    memset(w->dirty, 0xFF, sizeof(w->dirty));  /* every node reset */
+}
+
+/* =========================================================================
+ * SECTION 4: SLOT LIST PRIMITIVES (internal)
+ * ========================================================================= */
+
+static void mc_timer__link_tail(TimerWheel* w, uint32_t slot, uint32_t n) {
+    TimerNode* node = &w->nodes[n];
+    mc_timer__touch(w, n);
+    node->slot = slot;
+    node->next = MC_INVALID_INDEX;
+    node->prev = w->tails[slot];
+    if (w->tails[slot] != MC_INVALID_INDEX) {
+        mc_timer__touch(w, w->tails[slot]);
+        w->nodes[w->tails[slot]].next = n;
+    } else {
+        w->heads[slot] = n;
+    }
+    w->tails[slot] = n;
+}
+
+static void mc_timer__unlink(TimerWheel* w, uint32_t n) {
+    TimerNode* node = &w->nodes[n];
+    uint32_t slot = node->slot;
+    mc_timer__touch(w, n);
+    if (node->prev != MC_INVALID_INDEX) mc_timer__touch(w, node->prev);
+    if (node->next != MC_INVALID_INDEX) mc_timer__touch(w, node->next);
+    if (node->prev != MC_INVALID_INDEX) w->nodes[node->prev].next = node->next;
+    else                                w->heads[slot] = node->next;
+    if (node->next != MC_INVALID_INDEX) w->nodes[node->next].prev = node->prev;
+    else                                w->tails[slot] = node->prev;
+    node->next = MC_INVALID_INDEX;
+    node->prev = MC_INVALID_INDEX;
+    node->slot = MC_INVALID_INDEX;
+}
+
+static void mc_timer__release(TimerWheel* w, uint32_t n) {
+    TimerNode* node = &w->nodes[n];
+    mc_timer__touch(w, n);
+    node->active = 0;
+    node->generation++;
+    node->next = w->free_head;
+    w->free_head = n;
+    w->count--;
+}
+
+/* Place a node into the correct level/slot relative to current_tick. */
+static void mc_timer__place(TimerWheel* w, uint32_t n) {
+    uint64_t due = w->nodes[n].due_tick;
+    uint64_t delta;
+    uint32_t level, idx;
+
+    if (due < w->current_tick) due = w->current_tick;  /* overdue: fire next drain */
+    delta = due - w->current_tick;
+    if (delta >= MC_TIMER_WHEEL_SPAN) {
+        /* Beyond the horizon: park in the farthest slot, re-placed on cascade */
+        due   = w->current_tick + MC_TIMER_WHEEL_SPAN - 1;
+        delta = MC_TIMER_WHEEL_SPAN - 1;
+    }
+
+    level = 0;
+    while (level + 1 < MC_TIMER_WHEEL_LEVELS
+           && delta >= (1ull << (MC_TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    idx = (uint32_t)(due >> (MC_TIMER_WHEEL_BITS * level)) & MC_TIMER_WHEEL_MASK;
+    mc_timer__link_tail(w, level * MC_TIMER_WHEEL_SLOTS + idx, n);
+}
+
+/* Move every node in a higher-level slot down to its new level.
+ * Returns the slot index that was cascaded (0 means the next level
+ * up must cascade too). */
+static uint32_t mc_timer__cascade(TimerWheel* w, uint32_t level) {
+    uint32_t idx  = (uint32_t)(w->current_tick >> (MC_TIMER_WHEEL_BITS * level))
+                    & MC_TIMER_WHEEL_MASK;
+    uint32_t slot = level * MC_TIMER_WHEEL_SLOTS + idx;
+    uint32_t n    = w->heads[slot];
+
+    w->heads[slot] = MC_INVALID_INDEX;
+    w->tails[slot] = MC_INVALID_INDEX;
+
+    while (n != MC_INVALID_INDEX) {
+        uint32_t next = w->nodes[n].next;
+        mc_timer__place(w, n);
+        n = next;
+    }
+    return idx;
+}
+
+/* =========================================================================
+ * SECTION 5: PUBLIC API
+ * ========================================================================= */
+
+/* Schedule `cmd` to be pushed into the command buffer on `due_tick`.
+ * A due_tick in the past fires on the next drain.
+ * Returns a handle for cancellation, or MC_TIMER_INVALID if the pool
+ * is exhausted (the attempt is counted in w->dropped). */
+static TimerHandle mc_timer_schedule(TimerWheel* w, const Command* cmd, uint64_t due_tick) {
+    uint32_t n;
+    TimerNode* node;
+
+    if (w->free_head == MC_INVALID_INDEX) {
+        w->dropped++;
+        return MC_TIMER_INVALID;
+    }
+    n = w->free_head;
+    node = &w->nodes[n];
+    w->free_head = node->next;
+    mc_timer__touch(w, n);
+
+    node->cmd      = *cmd;
+    node->due_tick = due_tick;
+    node->active   = 1;
+    w->count++;
+    mc_timer__place(w, n);
+
+    return ((uint32_t)node->generation << 16) | n;
+}
+
+/* Convenience: schedule relative to the wheel's current tick. */
+static TimerHandle mc_timer_schedule_in(TimerWheel* w, const Command* cmd, uint32_t delay_ticks) {
+    return mc_timer_schedule(w, cmd, w->current_tick + delay_ticks);
+}
+
+/* Returns 1 if the handle refers to a timer that is still pending. */
+static int mc_timer_pending(const TimerWheel* w, TimerHandle h) {
+    uint32_t n;
+    if (h == MC_TIMER_INVALID) return 0;
+    n = h & 0xFFFFu;
+    if (n >= MC_MAX_TIMERS) return 0;
+    if (!w->nodes[n].active) return 0;
+    return (w->nodes[n].generation == (uint16_t)(h >> 16)) ? 1 : 0;
+}
+
+/* Cancel a pending timer. Returns 0 on success, -1 if the handle is
+ * stale (already fired, already cancelled, or never valid). */
+static int mc_timer_cancel(TimerWheel* w, TimerHandle h) {
+    uint32_t n;
+    if (!mc_timer_pending(w, h)) return -1;
+    n = h & 0xFFFFu;
+    mc_timer__unlink(w, n);
+    mc_timer__release(w, n);
+    return 0;
+}
+
+/* Drain every timer due on or before `tick` into `buf`, advancing the
+ * wheel so current_tick == tick + 1 afterwards. Commands are pushed in
+ * due-tick order; within a tick, in slot order. The command's `tick`
+ * field is rewritten to the tick it actually fires on.
+ * Returns the number of commands pushed. */
+static uint32_t mc_timer_wheel_advance(TimerWheel* w, uint64_t tick, CommandBuffer* buf) {
+    uint32_t pushed = 0;
+
+    while (w->current_tick <= tick) {
+        uint32_t idx = (uint32_t)w->current_tick & MC_TIMER_WHEEL_MASK;
+        uint32_t n;
+
+        /* Level 0 wrapped: pull the next band down from the levels above */
+        if (idx == 0) {
+            uint32_t level;
+            for (level = 1; level < MC_TIMER_WHEEL_LEVELS; level++) {
+                if (mc_timer__cascade(w, level) != 0) break;
+            }
+        }
+
+        n = w->heads[idx];
+        w->heads[idx] = MC_INVALID_INDEX;
+        w->tails[idx] = MC_INVALID_INDEX;
+
+        while (n != MC_INVALID_INDEX) {
+            uint32_t next = w->nodes[n].next;
+            Command cmd = w->nodes[n].cmd;
+            cmd.tick = w->current_tick;
+
+            w->nodes[n].next = MC_INVALID_INDEX;
+            w->nodes[n].prev = MC_INVALID_INDEX;
+            w->nodes[n].slot = MC_INVALID_INDEX;
+            mc_timer__release(w, n);
+
+            mc_cmd_push(buf, &cmd);
+            w->fired++;
+            pushed++;
+            n = next;
+        }
+
+        w->current_tick++;
+        if (w->count == 0 && w->current_tick <= tick) {
+            /* Nothing pending: jump straight to the target tick */
+            w->current_tick = tick + 1;
+        }
+    }
+    return pushed;
+}
+
+/* Flush with scheduled commands: drain timers due this tick into the
+ * buffer FIRST, then validate + apply everything in one pass. */
+static void mc_cmd_flush_timed(
+    CommandBuffer* buf, PoolPtrs* pools, TimerWheel* w, uint64_t tick
+) {
+    mc_timer_wheel_advance(w, tick, buf);
+    mc_cmd_flush(buf, pools);
+}
+
+/* =========================================================================
+ * SECTION 6: SNAPSHOT
+ *
+ * The wheel is pointer-free, so a snapshot is a header plus a raw copy.
+ * Layout: [magic u32][version u32][size u32][TimerWheel bytes]
+ * ========================================================================= */
+
+#define MC_TIMER_SNAPSHOT_HEADER 12u
+
+static uint32_t mc_timer_wheel_snapshot_size(void) {
+    return MC_TIMER_SNAPSHOT_HEADER + (uint32_t)sizeof(TimerWheel);
+}
+
+/* Returns bytes written, or 0 if `cap` is too small. */
+static uint32_t mc_timer_wheel_snapshot(const TimerWheel* w, uint8_t* out, uint32_t cap) {
+    uint32_t header[3];
+    if (cap < mc_timer_wheel_snapshot_size()) return 0;
+    header[0] = MC_TIMER_SNAPSHOT_MAGIC;
+    header[1] = MC_TIMER_SNAPSHOT_VERSION;
+    header[2] = (uint32_t)sizeof(TimerWheel);
+    memcpy(out, header, MC_TIMER_SNAPSHOT_HEADER);
+    memcpy(out + MC_TIMER_SNAPSHOT_HEADER, w, sizeof(TimerWheel));
+    return mc_timer_wheel_snapshot_size();
+}
+
+/* A stored link is a node (or slot) index below `limit`, or INVALID. */
+static int mc_timer__link_ok(uint32_t v, uint32_t limit) {
+    return v < limit || v == MC_INVALID_INDEX;
+}
+
+/* A node's links as stored on disk: next/prev index nodes, slot indexes
+ * the flattened slot lists. */
+static int mc_timer__node_links_ok(const TimerNode* node) {
+    return mc_timer__link_ok(node->next, MC_MAX_TIMERS)
+        && mc_timer__link_ok(node->prev, MC_MAX_TIMERS)
+        && mc_timer__link_ok(node->slot, MC_TIMER_WHEEL_LEVELS * MC_TIMER_WHEEL_SLOTS);
+}
+
+/* Check a snapshot without touching any wheel: header, then every link
+ * the wheel follows (free_head, slot heads/tails, node next/prev/slot),
+ * so a corrupt file can't index outside nodes[]/heads[].
+ * Returns 0 if it is safe to restore, -1 otherwise. */
+static int mc_timer_wheel_snapshot_check(const uint8_t* in, uint32_t len) {
+    const uint8_t* body = in + MC_TIMER_SNAPSHOT_HEADER;
+    uint32_t header[3];
+    uint32_t v, i;
+    if (len < mc_timer_wheel_snapshot_size()) return -1;
+    memcpy(header, in, MC_TIMER_SNAPSHOT_HEADER);
+    if (header[0] != MC_TIMER_SNAPSHOT_MAGIC)   return -1;
+    if (header[1] != MC_TIMER_SNAPSHOT_VERSION) return -1;
+    if (header[2] != (uint32_t)sizeof(TimerWheel)) return -1;
+
+    memcpy(&v, body + offsetof(TimerWheel, free_head), sizeof(v));
+    if (!mc_timer__link_ok(v, MC_MAX_TIMERS)) return -1;
+    memcpy(&v, body + offsetof(TimerWheel, count), sizeof(v));
+    if (v > MC_MAX_TIMERS) return -1;
+    for (i = 0; i < MC_TIMER_WHEEL_LEVELS * MC_TIMER_WHEEL_SLOTS; i++) {
+        memcpy(&v, body + offsetof(TimerWheel, heads) + i * sizeof(uint32_t), sizeof(v));
+        if (!mc_timer__link_ok(v, MC_MAX_TIMERS)) return -1;
+        memcpy(&v, body + offsetof(TimerWheel, tails) + i * sizeof(uint32_t), sizeof(v));
+        if (!mc_timer__link_ok(v, MC_MAX_TIMERS)) return -1;
+    }
+    for (i = 0; i < MC_MAX_TIMERS; i++) {
+        TimerNode node;
+        memcpy(&node, body + offsetof(TimerWheel, nodes) + i * sizeof(TimerNode), sizeof(node));
+        if (!mc_timer__node_links_ok(&node)) return -1;
+    }
+    return 0;
+}
+
+/* Returns 0 on success, -1 on a bad/mismatched snapshot (w untouched). */
+static int mc_timer_wheel_restore(TimerWheel* w, const uint8_t* in, uint32_t len) {
+    if (mc_timer_wheel_snapshot_check(in, len) != 0) return -1;
+    memcpy(w, in + MC_TIMER_SNAPSHOT_HEADER, sizeof(TimerWheel));
+    memset(w->dirty, 0xFF, sizeof(w->dirty));
+    return 0;
+}
+
+#endif /* MARBLE_TIMER_H */
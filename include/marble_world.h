@@ -0,0 +1,405 @@
+/*
+ * marble_world.h -- Self-Contained Worlds and Multi-World Runtime (Phase 0.4)
+ *
+ * PURPOSE:
+ *   Own every piece of per-world runtime state in one object, so a single
+ *   process can host many independent worlds (arenas, instances) instead
+ *   of exactly one world spread across file-level statics.
+ *
+ * ARCHITECTURE:
+ *   World         -- allocator, tick state, RNG, all component pools,
+ *                    interaction queue, command buffer, timer wheel
+ *                    and a spatial grid over the position pool.
+ *                    Embeds a WorldContext (marble_loader.h) that points
+ *                    at its own pools, so the loaders populate it as-is.
+ *   WorldRuntime  -- steps an array of worlds on up to
+ *                    MC_THREAD_MAX_WORKERS workers. World i is always
+ *                    owned by worker (i % worker_count), so a world's
+ *                    memory is only ever touched by one worker and there
+ *                    is nothing to lock.
+ *
+ *   A world itself is still single-threaded and deterministic: stepping
+ *   the same worlds sequentially or on the runtime gives identical state.
+ *
+ * STATE HASH:
+ *   Every pool keeps a running XOR-of-row-hashes (marble_core.h), updated
+ *   by add/remove and by the applicators around in-place writes. The
+ *   world hash folds the pool hashes and the allocator into one 64-bit
+ *   word in O(pools), and mc_world_step() records it for every tick, so
+ *   peers compare one word per tick and the first mismatching tick is
+ *   known the moment its hash arrives.
+ *
+ * SPATIAL GRID:
+ *   Derived state: CMD_MOVE_ENTITY keeps it current during flushes, but
+ *   rows written straight into the position pool (loaders, save loads)
+ *   aren't seen until mc_world_reindex(). Container moves are rejected
+ *   in a World for now, since containment isn't part of saves or the
+ *   state hash yet.
+ *
+ * MEMORY:
+ *   sizeof(World) is ~1 MB (ten 1024-entity pools plus the timer wheel).
+ *   Hosts keep worlds in a static array; hundreds of worlds is hundreds
+ *   of MB, all reserved up front.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_WORLD_H
+#define MARBLE_WORLD_H
+
+#include "marble_core.h"
+#include "marble_interact.h"
+#include "marble_loader.h"
+#include "marble_save.h"
+#include "marble_thread.h"
+#include "marble_rng.h"
+
+/* =========================================================================
+ * SECTION 1: WORLD
+ * ========================================================================= */
+
+#define MC_WORLD_HASH_HISTORY 256           /* ticks of state hashes kept */
+#define MC_WORLD_NO_DESYNC    UINT64_MAX
+
+/* Default grid: 64 x 64 cells of 8 units from the origin */
+#define MC_WORLD_GRID_CELL_SIZE 8.0f
+#define MC_WORLD_GRID_DIM       64
+
+/* One processed interaction, kept until the next processing pass */
+typedef struct {
+    InteractionRequest request;
+    InteractResult     result;
+    uint32_t           rng_state;   /* final RNG state, for debug/replay */
+} WorldInteraction;
+
+typedef struct {
+    uint32_t           id;
+    uint32_t           seed;
+
+    EntityAllocator    alloc;
+    TickState          tick;
+    McRng              rng;
+
+    SparseSet          pools[LOADER_POOL_COUNT];   /* indexed by ComponentType */
+    WorldContext       ctx;                        /* loader view of pools[] */
+
+    InteractionRequest requests[MAX_INTERACTION_REQUESTS];
+    uint32_t           request_count;
+    uint32_t           requests_dropped;
+
+    WorldInteraction   interactions[MAX_INTERACTION_REQUESTS];
+    uint32_t           interaction_count;
+
+    CommandBuffer      commands;
+    TimerWheel         timers;
+    SpatialGrid        grid;
+
+    uint64_t           hash_history[MC_WORLD_HASH_HISTORY];  /* end-of-tick t at t % N */
+    uint64_t           desync_tick;   /* first tick a peer disagreed on, or MC_WORLD_NO_DESYNC */
+} World;
+
+/* strides[] holds the component size for each ComponentType. Health and
+ * position are app-defined, so the host supplies the table; 0 leaves a
+ * pool the app does not use empty. */
+static void mc_world_init(World* w, uint32_t id, uint32_t seed,
+                          const uint32_t strides[LOADER_POOL_COUNT]) {
+    uint32_t t;
+
+    w->id   = id;
+    w->seed = seed;
+
+    mc_entity_alloc_init(&w->alloc);
+    mc_tick_state_init(&w->tick, 0);
+    mc_rng_seed(&w->rng, seed);
+
+    for (t = 0; t < LOADER_POOL_COUNT; t++) {
+        mc_sparse_set_init(&w->pools[t], strides[t]);
+    }
+
+    w->ctx.alloc             = &w->alloc;
+    w->ctx.pool_health       = &w->pools[COMP_TYPE_HEALTH];
+    w->ctx.pool_position     = &w->pools[COMP_TYPE_POSITION];
+    w->ctx.pool_layers       = &w->pools[COMP_TYPE_LAYERS];
+    w->ctx.pool_skills       = &w->pools[COMP_TYPE_SKILLS];
+    w->ctx.pool_anatomy      = &w->pools[COMP_TYPE_ANATOMY];
+    w->ctx.pool_capabilities = &w->pools[COMP_TYPE_CAPABILITIES];
+    w->ctx.pool_affordances  = &w->pools[COMP_TYPE_AFFORDANCES];
+    w->ctx.pool_tool         = &w->pools[COMP_TYPE_TOOL];
+    w->ctx.pool_body_parts   = &w->pools[COMP_TYPE_BODY_PARTS];
+    w->ctx.pool_behavior     = &w->pools[COMP_TYPE_BEHAVIOR];
+
+    w->request_count     = 0;
+    w->requests_dropped  = 0;
+    w->interaction_count = 0;
+
+    mc_cmd_buf_init(&w->commands);
+    mc_timer_wheel_init(&w->timers, 0);
+    mc_grid_init(&w->grid, 0.0f, 0.0f, MC_WORLD_GRID_CELL_SIZE,
+                 MC_WORLD_GRID_DIM, MC_WORLD_GRID_DIM);
+
+    memset(w->hash_history, 0, sizeof(w->hash_history));
+    w->desync_tick = MC_WORLD_NO_DESYNC;
+}
+
+static SparseSet* mc_world_pool(World* w, ComponentType type) {
+    return &w->pools[type];
+}
+
+/* Rebuild the spatial grid from the position pool. Call after loading a
+ * save or filling positions outside the command buffer. */
+static uint32_t mc_world_reindex(World* w) {
+    return mc_grid_build(&w->grid, &w->pools[COMP_TYPE_POSITION]);
+}
+
+/* Queue an interaction for the next processing pass.
+ * Returns 0, or -1 if the queue is full (the request is counted and dropped). */
+static int mc_world_push_request(World* w, EntityID actor, EntityID target, VerbID verb) {
+    InteractionRequest* req;
+    if (w->request_count >= MAX_INTERACTION_REQUESTS) {
+        w->requests_dropped++;
+        return -1;
+    }
+    req = &w->requests[w->request_count++];
+    req->actor  = actor;
+    req->target = target;
+    req->verb   = verb;
+    return 0;
+}
+
+/* Per-interaction seed: same world + tick + entities = same roll. This is
+ * what makes replay and network sync possible. Drawn from the counter
+ * RNG (marble_rng.h) with entity = actor and draw = target, so the seed
+ * does not depend on queue order. */
+static uint32_t mc_world_interaction_seed(const World* w, uint64_t tick,
+                                          const InteractionRequest* req) {
+    McCrng g;
+    mc_crng_init(&g, w->seed, MC_CRNG_STREAM_INTERACT);
+    return mc_crng_u32(&g, tick, req->actor, req->target);
+}
+
+/* Run every queued request against this world's pools, record the
+ * outcomes in interactions[] and empty the queue. Returns the count.
+ * All seeds for the pass are generated in one batch up front. */
+static uint32_t mc_world_process_requests(World* w, uint64_t tick) {
+    uint32_t actors[MAX_INTERACTION_REQUESTS];
+    uint32_t targets[MAX_INTERACTION_REQUESTS];
+    uint32_t seeds[MAX_INTERACTION_REQUESTS];
+    McCrng g;
+    uint32_t i;
+
+    for (i = 0; i < w->request_count; i++) {
+        actors[i]  = w->requests[i].actor;
+        targets[i] = w->requests[i].target;
+    }
+    mc_crng_init(&g, w->seed, MC_CRNG_STREAM_INTERACT);
+    mc_crng_u32_batch(&g, tick, actors, targets, seeds, w->request_count);
+
+    for (i = 0; i < w->request_count; i++) {
+        WorldInteraction* out = &w->interactions[i];
+        McRng rng;
+
+        mc_rng_seed(&rng, seeds[i]);
+
+        out->request = w->requests[i];
+        out->result  = process_interaction(
+            &w->requests[i],
+            &w->pools[COMP_TYPE_CAPABILITIES],
+            &w->pools[COMP_TYPE_AFFORDANCES],
+            &w->pools[COMP_TYPE_ANATOMY],
+            &w->pools[COMP_TYPE_SKILLS],
+            &w->pools[COMP_TYPE_TOOL],
+            &w->pools[COMP_TYPE_BODY_PARTS],
+            &w->pools[COMP_TYPE_LAYERS],
+            &rng
+        );
+        out->rng_state = rng.state;
+    }
+
+    w->interaction_count = w->request_count;
+    w->request_count = 0;
+    return w->interaction_count;
+}
+
+/* Current state hash: pool hashes (in ComponentType order) plus the
+ * allocator, folded with XXH64. O(pools), no row is touched. */
+static uint64_t mc_world_state_hash(const World* w) {
+    uint64_t words[LOADER_POOL_COUNT + 1];
+    uint32_t t;
+    for (t = 0; t < LOADER_POOL_COUNT; t++) {
+        words[t] = w->pools[t].hash;
+    }
+    words[LOADER_POOL_COUNT] = w->alloc.next_id;
+    return mc_hash64(words, (uint32_t)sizeof(words), 0);
+}
+
+/* Debug check: 1 if every incremental pool hash matches a full rehash.
+ * A 0 means some code wrote through mc_sparse_set_get() without
+ * bracketing the write with mc_sparse_set_hash_out()/_in(). */
+static int mc_world_hash_verify(const World* w) {
+    uint32_t t;
+    for (t = 0; t < LOADER_POOL_COUNT; t++) {
+        if (w->pools[t].hash != mc_sparse_set_compute_hash(&w->pools[t])) return 0;
+    }
+    return 1;
+}
+
+/* Hash recorded at the end of `tick`. Returns 0, or -1 if the tick
+ * hasn't run yet or has fallen out of the history window. */
+static int mc_world_tick_hash(const World* w, uint64_t tick, uint64_t* out) {
+    if (tick >= w->tick.tick_number) return -1;
+    if (w->tick.tick_number - tick > MC_WORLD_HASH_HISTORY) return -1;
+    *out = w->hash_history[tick % MC_WORLD_HASH_HISTORY];
+    return 0;
+}
+
+/* Compare a peer's hash for `tick` with ours. Returns 0 on match, 1 on
+ * mismatch (desync_tick keeps the earliest mismatching tick), -1 if the
+ * tick is outside the history window. */
+static int mc_world_hash_check(World* w, uint64_t tick, uint64_t peer_hash) {
+    uint64_t ours;
+    if (mc_world_tick_hash(w, tick, &ours) != 0) return -1;
+    if (ours == peer_hash) return 0;
+    if (tick < w->desync_tick) w->desync_tick = tick;
+    return 1;
+}
+
+/* One simulation tick: interactions, then due timers + queued commands,
+ * then record the state hash and advance the tick counter. */
+static void mc_world_step(World* w) {
+    uint64_t tick = w->tick.tick_number;
+    PoolPtrs pp;
+
+    mc_world_process_requests(w, tick);
+
+    pp.layers     = &w->pools[COMP_TYPE_LAYERS];
+    pp.item_defs  = NULL;
+    pp.positions  = &w->pools[COMP_TYPE_POSITION];
+    pp.grid       = &w->grid;
+    pp.containers = NULL;
+    mc_cmd_flush_timed(&w->commands, &pp, &w->timers, tick);
+
+    w->hash_history[tick % MC_WORLD_HASH_HISTORY] = mc_world_state_hash(w);
+    w->tick.tick_number++;
+}
+
+/* Fill a save view of this world. Pools are registered in ComponentType
+ * order, so any two Worlds agree on pool identity in the file. */
+static void mc_world_refs(World* w, WorldRefs* refs) {
+    uint32_t t;
+    mc_world_refs_init(refs, &w->alloc, &w->tick, &w->rng, &w->timers);
+    for (t = 0; t < LOADER_POOL_COUNT; t++) {
+        mc_world_refs_add_pool(refs, &w->pools[t]);
+    }
+}
+
+/* =========================================================================
+ * SECTION 2: RUNTIME
+ *
+ * Worker k owns worlds k, k + W, k + 2W, ... for the life of the
+ * runtime. A run of N ticks starts one thread per worker, each thread
+ * steps its worlds N times (tick-major: all its worlds reach tick t
+ * before any reaches t + 1), then all threads are joined. Worlds never
+ * read each other, so workers share nothing.
+ *
+ * Hosts that pace ticks against wall-clock time call mc_runtime_run()
+ * with ticks = 1 once per tick interval; offline batches pass a large
+ * count and pay the thread start cost once.
+ *
+ * "Pinned" here is a stable world-to-worker assignment, not OS CPU
+ * affinity; the scheduler still places the worker threads.
+ * ========================================================================= */
+
+typedef struct {
+    World*   worlds;
+    uint32_t world_count;
+    uint32_t first;        /* this worker's first world */
+    uint32_t stride;       /* = worker_count */
+    uint32_t ticks;        /* ticks to run this pass */
+    uint64_t steps;        /* world-steps executed, lifetime */
+} RuntimeWorker;
+
+typedef struct {
+    World*        worlds;
+    uint32_t      world_count;
+    uint32_t      worker_count;
+    RuntimeWorker workers[MC_THREAD_MAX_WORKERS];
+    McThread      threads[MC_THREAD_MAX_WORKERS];
+    uint32_t      inline_passes;   /* worker passes that ran on the caller */
+} WorldRuntime;
+
+/* worker_count 0 = one per CPU. Clamped to [1, MC_THREAD_MAX_WORKERS]
+ * and never more than world_count. */
+static void mc_runtime_init(WorldRuntime* rt, World* worlds, uint32_t world_count,
+                            uint32_t worker_count) {
+    uint32_t k;
+
+    if (worker_count == 0) worker_count = mc_thread_cpu_count();
+    if (worker_count > MC_THREAD_MAX_WORKERS) worker_count = MC_THREAD_MAX_WORKERS;
+    if (worker_count > world_count) worker_count = world_count;
+    if (worker_count == 0) worker_count = 1;
+
+    memset(rt, 0, sizeof(*rt));
+    rt->worlds       = worlds;
+    rt->world_count  = world_count;
+    rt->worker_count = worker_count;
+
+    for (k = 0; k < worker_count; k++) {
+        rt->workers[k].worlds      = worlds;
+        rt->workers[k].world_count = world_count;
+        rt->workers[k].first       = k;
+        rt->workers[k].stride      = worker_count;
+    }
+}
+
+/* Worker index that owns world world_idx */
+static uint32_t mc_runtime_worker_of(const WorldRuntime* rt, uint32_t world_idx) {
+    return world_idx % rt->worker_count;
+}
+
+static void mc_runtime__run_worker(RuntimeWorker* wk) {
+    uint32_t t, i;
+    for (t = 0; t < wk->ticks; t++) {
+        for (i = wk->first; i < wk->world_count; i += wk->stride) {
+            mc_world_step(&wk->worlds[i]);
+            wk->steps++;
+        }
+    }
+}
+
+static MC_THREAD_PROC(mc_runtime__worker) {
+    mc_runtime__run_worker((RuntimeWorker*)mc_thread_arg);
+    MC_THREAD_RETURN;
+}
+
+/* Advance every world by ticks. Worker 0 runs on the calling thread; a
+ * worker whose thread fails to start also runs inline, after the others
+ * have been launched, so the result is the same either way. */
+static void mc_runtime_run(WorldRuntime* rt, uint32_t ticks) {
+    int started[MC_THREAD_MAX_WORKERS];
+    uint32_t k;
+
+    if (ticks == 0 || rt->world_count == 0) return;
+
+    for (k = 0; k < rt->worker_count; k++) {
+        rt->workers[k].ticks = ticks;
+    }
+
+    started[0] = 0;
+    for (k = 1; k < rt->worker_count; k++) {
+        started[k] = (mc_thread_start(&rt->threads[k], mc_runtime__worker,
+                                      &rt->workers[k]) == 0);
+    }
+
+    for (k = 0; k < rt->worker_count; k++) {
+        if (!started[k]) {
+            mc_runtime__run_worker(&rt->workers[k]);
+            if (k != 0) rt->inline_passes++;
+        }
+    }
+
+    for (k = 1; k < rt->worker_count; k++) {
+        if (started[k]) mc_thread_join(&rt->threads[k]);
+    }
+}
+
+#endif /* MARBLE_WORLD_H */
@@ -0,0 +1,344 @@
+/*
+ * marble_ws.h -- Minimal RFC 6455 WebSocket Layer
+ *
+ * PURPOSE:
+ *   Just enough WebSocket to carry marble_net.h packets to browsers and
+ *   native clients: the HTTP upgrade handshake (both sides) and single-
+ *   frame messages. Socket I/O stays with the caller; everything here
+ *   works on byte buffers.
+ *
+ * SCOPE:
+ *   - Handshake: parse a client's GET upgrade, write the 101 reply
+ *     (SHA-1 + base64 of the key, RFC 6455 section 4.2.2); the client
+ *     side writes the request and checks the reply.
+ *   - Frames: text, binary, close, ping, pong. Client frames must be
+ *     masked and server frames must not be (section 5.1).
+ *   - Fragmented messages (FIN = 0, continuation frames) and extensions
+ *     (RSV bits) are refused as protocol errors; no peer here sends them.
+ *
+ * CONSTRAINTS: Same as marble_core.h (no malloc, no fn ptrs, no recursion)
+ */
+
+#ifndef MARBLE_WS_H
+#define MARBLE_WS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define MC_WS_OP_CONT   0x0
+#define MC_WS_OP_TEXT   0x1
+#define MC_WS_OP_BINARY 0x2
+#define MC_WS_OP_CLOSE  0x8
+#define MC_WS_OP_PING   0x9
+#define MC_WS_OP_PONG   0xA
+
+#define MC_WS_KEY_LEN        24   /* base64 of 16 random bytes */
+#define MC_WS_ACCEPT_LEN     28   /* base64 of a SHA-1 digest  */
+#define MC_WS_MAX_HEADER     14   /* 2 + 8 length + 4 mask     */
+#define MC_WS_MAX_HANDSHAKE 2048  /* larger requests are refused */
+
+#define MC_WS_CLOSE_NORMAL    1000
+#define MC_WS_CLOSE_PROTOCOL  1002
+#define MC_WS_CLOSE_TOO_BIG   1009
+
+static const char MC_WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+/* =========================================================================
+ * SECTION 1: SHA-1 AND BASE64 (handshake only)
+ * ========================================================================= */
+
+static uint32_t mc_ws__rol(uint32_t v, uint32_t n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+static void mc_ws__sha1_block(uint32_t h[5], const uint8_t* p) {
+    uint32_t w[80], a, b, c, d, e, i;
+    for (i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)p[i * 4] << 24) | ((uint32_t)p[i * 4 + 1] << 16) |
+               ((uint32_t)p[i * 4 + 2] << 8) | (uint32_t)p[i * 4 + 3];
+    }
+    for (i = 16; i < 80; i++) w[i] = mc_ws__rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
+    for (i = 0; i < 80; i++) {
+        uint32_t f, k, t;
+        if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999u; }
+        else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1u; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDCu; }
+        else             { f = b ^ c ^ d;                   k = 0xCA62C1D6u; }
+        t = mc_ws__rol(a, 5) + f + e + k + w[i];
+        e = d; d = c; c = mc_ws__rol(b, 30); b = a; a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+static void mc_ws_sha1(const uint8_t* data, uint32_t len, uint8_t out[20]) {
+    uint32_t h[5] = { 0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u };
+    uint8_t tail[128];
+    uint64_t bits = (uint64_t)len * 8;
+    uint32_t i, rest, tail_len;
+
+    for (i = 0; i + 64 <= len; i += 64) mc_ws__sha1_block(h, data + i);
+    rest = len - i;
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, data + i, rest);
+    tail[rest] = 0x80;
+    tail_len = (rest < 56) ? 64 : 128;
+    for (i = 0; i < 8; i++) tail[tail_len - 1 - i] = (uint8_t)(bits >> (i * 8));
+    mc_ws__sha1_block(h, tail);
+    if (tail_len == 128) mc_ws__sha1_block(h, tail + 64);
+    for (i = 0; i < 20; i++) out[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+}
+
+/* Standard base64 with padding. out needs 4 * ceil(len / 3) + 1 bytes. */
+static uint32_t mc_ws_base64(const uint8_t* in, uint32_t len, char* out) {
+    static const char tbl[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint32_t i, n = 0;
+    for (i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        out[n++] = tbl[(v >> 18) & 63];
+        out[n++] = tbl[(v >> 12) & 63];
+        out[n++] = (i + 1 < len) ? tbl[(v >> 6) & 63] : '=';
+        out[n++] = (i + 2 < len) ? tbl[v & 63] : '=';
+    }
+    out[n] = '\0';
+    return n;
+}
+
+/* Sec-WebSocket-Accept for a client key: base64(SHA-1(key + GUID)) */
+static void mc_ws_accept_key(const char* key, char out[MC_WS_ACCEPT_LEN + 1]) {
+    uint8_t buf[128], digest[20];
+    uint32_t klen = (uint32_t)strlen(key), glen = (uint32_t)sizeof(MC_WS_GUID) - 1;
+    if (klen > sizeof(buf) - glen) klen = (uint32_t)sizeof(buf) - glen;
+    memcpy(buf, key, klen);
+    memcpy(buf + klen, MC_WS_GUID, glen);
+    mc_ws_sha1(buf, klen + glen, digest);
+    mc_ws_base64(digest, 20, out);
+}
+
+/* =========================================================================
+ * SECTION 2: HANDSHAKE
+ * ========================================================================= */
+
+static int mc_ws__lower(int c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/* Length of the HTTP head including the blank line, or 0 if it hasn't
+ * all arrived yet. */
+static uint32_t mc_ws__head_len(const uint8_t* buf, uint32_t len) {
+    uint32_t i;
+    for (i = 3; i < len; i++) {
+        if (buf[i - 3] == '\r' && buf[i - 2] == '\n' && buf[i - 1] == '\r' && buf[i] == '\n') return i + 1;
+    }
+    return 0;
+}
+
+/* Copy header `name` (lowercase, no colon) into out, trimmed. Returns
+ * 0, or -1 if absent or longer than cap - 1. */
+static int mc_ws__header(const uint8_t* buf, uint32_t head, const char* name, char* out, uint32_t cap) {
+    uint32_t nlen = (uint32_t)strlen(name), i = 0;
+    while (i < head) {
+        uint32_t eol = i, k;
+        while (eol + 1 < head && !(buf[eol] == '\r' && buf[eol + 1] == '\n')) eol++;
+        if (eol - i > nlen && buf[i + nlen] == ':') {
+            for (k = 0; k < nlen && mc_ws__lower(buf[i + k]) == name[k]; k++) { }
+            if (k == nlen) {
+                uint32_t s = i + nlen + 1, e = eol;
+                while (s < e && (buf[s] == ' ' || buf[s] == '\t')) s++;
+                while (e > s && (buf[e - 1] == ' ' || buf[e - 1] == '\t')) e--;
+                if (e - s >= cap) return -1;
+                memcpy(out, buf + s, e - s);
+                out[e - s] = '\0';
+                return 0;
+            }
+        }
+        i = eol + 2;
+    }
+    return -1;
+}
+
+/* Does the comma-separated header value contain `token` (lowercase)? */
+static int mc_ws__has_token(const char* value, const char* token) {
+    uint32_t tlen = (uint32_t)strlen(token), i = 0;
+    while (value[i] != '\0') {
+        uint32_t k;
+        while (value[i] == ' ' || value[i] == ',') i++;
+        for (k = 0; k < tlen && mc_ws__lower(value[i + k]) == token[k]; k++) { }
+        if (k == tlen && (value[i + k] == '\0' || value[i + k] == ',' || value[i + k] == ' ')) return 1;
+        while (value[i] != '\0' && value[i] != ',') i++;
+    }
+    return 0;
+}
+
+/* Server side. Parse a client's upgrade request from the start of buf.
+ * Returns bytes consumed and fills key_out, 0 if more bytes are needed,
+ * or -1 if it isn't a WebSocket upgrade (or is too long). */
+static int32_t mc_ws_parse_request(const uint8_t* buf, uint32_t len, char key_out[MC_WS_KEY_LEN + 1]) {
+    char value[256];
+    uint32_t head = mc_ws__head_len(buf, len);
+    if (head == 0) return (len >= MC_WS_MAX_HANDSHAKE) ? -1 : 0;
+    if (head < 4 || memcmp(buf, "GET ", 4) != 0) return -1;
+    if (mc_ws__header(buf, head, "upgrade", value, sizeof(value)) != 0 ||
+        !mc_ws__has_token(value, "websocket")) return -1;
+    if (mc_ws__header(buf, head, "connection", value, sizeof(value)) != 0 ||
+        !mc_ws__has_token(value, "upgrade")) return -1;
+    if (mc_ws__header(buf, head, "sec-websocket-key", value, sizeof(value)) != 0 ||
+        strlen(value) != MC_WS_KEY_LEN) return -1;
+    memcpy(key_out, value, MC_WS_KEY_LEN + 1);
+    return (int32_t)head;
+}
+
+/* The 101 Switching Protocols reply. Returns bytes written, 0 if cap is
+ * too small. */
+static uint32_t mc_ws_write_response(const char* key, uint8_t* out, uint32_t cap) {
+    static const char a[] = "HTTP/1.1 101 Switching Protocols\r\n"
+                            "Upgrade: websocket\r\n"
+                            "Connection: Upgrade\r\n"
+                            "Sec-WebSocket-Accept: ";
+    char accept[MC_WS_ACCEPT_LEN + 1];
+    uint32_t alen = (uint32_t)sizeof(a) - 1;
+    uint32_t n = alen + MC_WS_ACCEPT_LEN + 4;
+    if (cap < n) return 0;
+    mc_ws_accept_key(key, accept);
+    memcpy(out, a, alen);
+    memcpy(out + alen, accept, MC_WS_ACCEPT_LEN);
+    memcpy(out + alen + MC_WS_ACCEPT_LEN, "\r\n\r\n", 4);
+    return n;
+}
+
+/* Client side. key is MC_WS_KEY_LEN base64 chars (16 random bytes).
+ * Returns bytes written, 0 if cap is too small. */
+static uint32_t mc_ws_write_request(const char* host, const char* path, const char* key,
+                                    uint8_t* out, uint32_t cap) {
+    const char* parts[7];
+    uint32_t i, n = 0;
+    parts[0] = "GET ";   parts[1] = path;
+    parts[2] = " HTTP/1.1\r\nHost: "; parts[3] = host;
+    parts[4] = "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: ";
+    parts[5] = key;
+    parts[6] = "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    for (i = 0; i < 7; i++) {
+        uint32_t l = (uint32_t)strlen(parts[i]);
+        if (n + l > cap) return 0;
+        memcpy(out + n, parts[i], l);
+        n += l;
+    }
+    return n;
+}
+
+/* Client side. Check the server's reply to a request sent with `key`.
+ * Returns bytes consumed, 0 if more are needed, -1 if refused. */
+static int32_t mc_ws_check_response(const uint8_t* buf, uint32_t len, const char* key) {
+    char value[256], expect[MC_WS_ACCEPT_LEN + 1];
+    uint32_t head = mc_ws__head_len(buf, len);
+    if (head == 0) return (len >= MC_WS_MAX_HANDSHAKE) ? -1 : 0;
+    if (head < 12 || memcmp(buf, "HTTP/1.1 101", 12) != 0) return -1;
+    if (mc_ws__header(buf, head, "sec-websocket-accept", value, sizeof(value)) != 0) return -1;
+    mc_ws_accept_key(key, expect);
+    return (strcmp(value, expect) == 0) ? (int32_t)head : -1;
+}
+
+/* =========================================================================
+ * SECTION 3: FRAMES
+ * ========================================================================= */
+
+typedef struct {
+    uint8_t  opcode;
+    uint32_t payload_off;   /* from the start of the frame */
+    uint32_t payload_len;
+} McWsFrame;
+
+/* Parse one frame at the start of buf, unmasking the payload in place.
+ * `from_client` says which side sent it (client frames must be masked,
+ * server frames must not be). Returns the frame's total length, 0 if it
+ * hasn't all arrived, or -1 on a protocol error or a payload over
+ * max_payload. */
+static int32_t mc_ws_parse_frame(uint8_t* buf, uint32_t len, int from_client, uint32_t max_payload,
+                                 McWsFrame* f) {
+    uint32_t hdr = 2, i;
+    uint64_t plen;
+    uint8_t masked, op;
+
+    if (len < 2) return 0;
+    op = buf[0] & 0x0F;
+    if ((buf[0] & 0x70) != 0 || !(buf[0] & 0x80)) return -1;       /* RSV, fragments */
+    if (op != MC_WS_OP_TEXT && op != MC_WS_OP_BINARY && op != MC_WS_OP_CLOSE &&
+        op != MC_WS_OP_PING && op != MC_WS_OP_PONG) return -1;
+    masked = (uint8_t)(buf[1] >> 7);
+    if (masked != (from_client ? 1 : 0)) return -1;
+    plen = buf[1] & 0x7F;
+    if (plen == 126) {
+        if (len < 4) return 0;
+        plen = ((uint32_t)buf[2] << 8) | buf[3];
+        hdr = 4;
+    } else if (plen == 127) {
+        if (len < 10) return 0;
+        plen = 0;
+        for (i = 0; i < 8; i++) plen = (plen << 8) | buf[2 + i];
+        hdr = 10;
+    }
+    if (op >= MC_WS_OP_CLOSE && plen > 125) return -1;
+    if (plen > max_payload) return -1;
+    if (masked) hdr += 4;
+    if ((uint64_t)len < hdr + plen) return 0;
+
+    if (masked) {
+        const uint8_t* key = buf + hdr - 4;
+        for (i = 0; i < (uint32_t)plen; i++) buf[hdr + i] ^= key[i & 3];
+    }
+    f->opcode      = op;
+    f->payload_off = hdr;
+    f->payload_len = (uint32_t)plen;
+    return (int32_t)(hdr + plen);
+}
+
+/* Write a whole frame. Clients pass masked = 1 and a mask key (RFC 6455
+ * wants it unpredictable); servers pass 0. Returns bytes written, 0 if
+ * cap is too small. */
+static uint32_t mc_ws_write_frame(uint8_t* out, uint32_t cap, uint8_t opcode, const uint8_t* payload,
+                                  uint32_t len, int masked, uint32_t mask_key) {
+    uint32_t hdr = 2, i;
+    uint8_t key[4];
+    if (len < 126) {
+        hdr = 2;
+    } else if (len <= 0xFFFF) {
+        hdr = 4;
+    } else {
+        hdr = 10;
+    }
+    if (masked) hdr += 4;
+    if ((uint64_t)hdr + len > cap) return 0;
+
+    out[0] = (uint8_t)(0x80 | opcode);
+    if (len < 126) {
+        out[1] = (uint8_t)len;
+    } else if (len <= 0xFFFF) {
+        out[1] = 126;
+        out[2] = (uint8_t)(len >> 8);
+        out[3] = (uint8_t)len;
+    } else {
+        out[1] = 127;
+        for (i = 0; i < 8; i++) out[2 + i] = (i < 4) ? 0 : (uint8_t)(len >> ((7 - i) * 8));
+    }
+    if (masked) {
+        out[1] |= 0x80;
+        for (i = 0; i < 4; i++) key[i] = (uint8_t)(mask_key >> (i * 8));
+        memcpy(out + hdr - 4, key, 4);
+        for (i = 0; i < len; i++) out[hdr + i] = payload[i] ^ key[i & 3];
+    } else if (len > 0) {
+        memmove(out + hdr, payload, len);
+    }
+    return hdr + len;
+}
+
+/* Close frame carrying a status code */
+static uint32_t mc_ws_write_close(uint8_t* out, uint32_t cap, uint16_t code, int masked, uint32_t mask_key) {
+    uint8_t p[2];
+    p[0] = (uint8_t)(code >> 8);
+    p[1] = (uint8_t)code;
+    return mc_ws_write_frame(out, cap, MC_WS_OP_CLOSE, p, 2, masked, mask_key);
+}
+
+#endif /* MARBLE_WS_H */
@@ -18,9 +18,25 @@
  * PACKET FORMAT:
  *   All packets are fixed-size (16 bytes for commands).
  *   This allows the command queue to be a flat array of structs.
+ *   net_batch_write() packs several commands from one client into one
+ *   varint packet (1-4 bytes per command); it decodes to the same structs.
+ *
+ * SNAPSHOT WIRE FORMAT:
+ *   20-byte header + 16 bytes per entity, explicit little-endian packing.
+ *   The header carries the authority's 64-bit world state hash; a client
+ *   that mirrors the simulation compares it against its own to catch a
+ *   desync on the tick it happens (include/marble_hash.h).
+ *   net_snapshot_write_lz() streams the same bytes through an LZ frame
+ *   (include/marble_lz.h); entity rows repeat most fields tick to tick.
+ *   net_snapshot_write_for_client() sends a varint delta against the
+ *   snapshot that client last acknowledged instead, and
+ *   net_snapshot_write_bits() packs each field to its declared range.
+ *   net_build_snapshot_for() limits a client's snapshot to what its
+ *   avatar can see (area of interest, optional line of sight).
  *
  * BUILD:
  *   Header-only. Include once with MARBLE_NET_IMPLEMENTATION defined.
+ *   Needs -Iinclude (marble_lz.h, marble_hash.h).
  */
 
 #ifndef MARBLE_NET_H
@@ -30,6 +46,10 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "marble_lz.h"
+#include "marble_hash.h"
+#include "marble_atomic.h"
+
 /* =========================================================================
  * COMPILE-TIME LIMITS (NASA Rule 3: no dynamic allocation)
  * ========================================================================= */
@@ -37,7 +57,7 @@
 #define NET_MAX_CMD_QUEUE        128   /* Max pending commands per tick     */
 #define NET_MAX_SNAPSHOT_ENTS    256   /* Max entities in a snapshot        */
 #define NET_CMD_SIZE              16   /* Fixed packet size in bytes        */
-#define NET_PROTOCOL_VERSION       1   /* Bump on breaking changes          */
+#define NET_PROTOCOL_VERSION       2   /* Bump on breaking changes          */
 #define NET_TICK_INTERVAL_MS     600   /* 0.6 seconds per tick              */
 
 /* =========================================================================
@@ -162,6 +182,7 @@ typedef struct {
     uint16_t       last_ack_sequence;  /* Last command the server processed */
     uint8_t        protocol_version;
     uint8_t        _pad;
+    uint64_t       state_hash;         /* NetWorld.state_hash at this tick  */
 } Snapshot;
 
 /* =========================================================================
@@ -361,6 +382,657 @@ static inline int net_snapshot_add_entity(Snapshot* s, const SnapshotEntity* ent
     return 0;
 }
 
+/* =========================================================================
+ * SNAPSHOT SERIALIZATION
+ *
+ * Header: tick_number u32, entity_count u32, last_ack u16, version u8, pad,
+ *         state_hash u64
+ * Entity: entity_id u32, x u16, y u16, glyph u8, type u8, hp i16,
+ *         max_hp i16, flags u8, sprite_id u8
+ * ========================================================================= */
+
+#define NET_SNAPSHOT_HEADER_SIZE 20
+#define NET_SNAPSHOT_ENTITY_SIZE 16
+#define NET_SNAPSHOT_WIRE_MAX    (NET_SNAPSHOT_HEADER_SIZE + NET_MAX_SNAPSHOT_ENTS * NET_SNAPSHOT_ENTITY_SIZE)
+
+static inline void net_put_u16(uint8_t* out, uint16_t v) {
+    out[0] = (uint8_t)(v & 0xFF);
+    out[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+static inline void net_put_u32(uint8_t* out, uint32_t v) {
+    out[0] = (uint8_t)(v & 0xFF);
+    out[1] = (uint8_t)((v >> 8) & 0xFF);
+    out[2] = (uint8_t)((v >> 16) & 0xFF);
+    out[3] = (uint8_t)((v >> 24) & 0xFF);
+}
+
+static inline uint16_t net_get_u16(const uint8_t* in) {
+    return (uint16_t)((uint16_t)in[0] | ((uint16_t)in[1] << 8));
+}
+
+static inline uint32_t net_get_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8)
+         | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static inline uint32_t net_snapshot_wire_size(const Snapshot* s) {
+    return NET_SNAPSHOT_HEADER_SIZE + s->entity_count * NET_SNAPSHOT_ENTITY_SIZE;
+}
+
+static inline void net_pack_snapshot_header(const Snapshot* s, uint8_t out[NET_SNAPSHOT_HEADER_SIZE]) {
+    net_put_u32(out, s->tick_number);
+    net_put_u32(out + 4, s->entity_count);
+    net_put_u16(out + 8, s->last_ack_sequence);
+    out[10] = s->protocol_version;
+    out[11] = 0;
+    net_put_u32(out + 12, (uint32_t)s->state_hash);
+    net_put_u32(out + 16, (uint32_t)(s->state_hash >> 32));
+}
+
+static inline void net_pack_snapshot_entity(const SnapshotEntity* e, uint8_t out[NET_SNAPSHOT_ENTITY_SIZE]) {
+    net_put_u32(out, e->entity_id);
+    net_put_u16(out + 4, e->x);
+    net_put_u16(out + 6, e->y);
+    out[8] = e->glyph;
+    out[9] = e->entity_type;
+    net_put_u16(out + 10, (uint16_t)e->hp);
+    net_put_u16(out + 12, (uint16_t)e->max_hp);
+    out[14] = e->flags;
+    out[15] = e->sprite_id;
+}
+
+/* Returns bytes written, 0 if `cap` is too small. */
+static inline uint32_t net_snapshot_write(const Snapshot* s, uint8_t* out, uint32_t cap) {
+    uint32_t i, size = net_snapshot_wire_size(s);
+    if (size > cap) return 0;
+    net_pack_snapshot_header(s, out);
+    for (i = 0; i < s->entity_count; i++) {
+        net_pack_snapshot_entity(&s->entities[i],
+                                 out + NET_SNAPSHOT_HEADER_SIZE + i * NET_SNAPSHOT_ENTITY_SIZE);
+    }
+    return size;
+}
+
+/* Returns 0 on success, -1 if the bytes aren't a complete snapshot. */
+static inline int net_snapshot_read(Snapshot* s, const uint8_t* in, uint32_t len) {
+    uint32_t i, count;
+    if (len < NET_SNAPSHOT_HEADER_SIZE) return -1;
+    count = net_get_u32(in + 4);
+    if (count > NET_MAX_SNAPSHOT_ENTS) return -1;
+    if (len != NET_SNAPSHOT_HEADER_SIZE + count * NET_SNAPSHOT_ENTITY_SIZE) return -1;
+
+    net_snapshot_init(s);
+    s->tick_number       = net_get_u32(in);
+    s->entity_count      = count;
+    s->last_ack_sequence = net_get_u16(in + 8);
+    s->protocol_version  = in[10];
+    s->state_hash        = (uint64_t)net_get_u32(in + 12)
+                         | ((uint64_t)net_get_u32(in + 16) << 32);
+    for (i = 0; i < count; i++) {
+        const uint8_t* p = in + NET_SNAPSHOT_HEADER_SIZE + i * NET_SNAPSHOT_ENTITY_SIZE;
+        SnapshotEntity* e = &s->entities[i];
+        e->entity_id   = net_get_u32(p);
+        e->x           = net_get_u16(p + 4);
+        e->y           = net_get_u16(p + 6);
+        e->glyph       = p[8];
+        e->entity_type = p[9];
+        e->hp          = (int16_t)net_get_u16(p + 10);
+        e->max_hp      = (int16_t)net_get_u16(p + 12);
+        e->flags       = p[14];
+        e->sprite_id   = p[15];
+    }
+    return 0;
+}
+
+/* Stream the snapshot through an LZ frame; no intermediate buffer.
+ * Returns frame bytes, 0 if `cap` is too small. */
+static inline uint32_t net_snapshot_write_lz(const Snapshot* s, McLzWriter* lz, uint8_t* out, uint32_t cap) {
+    uint8_t row[NET_SNAPSHOT_ENTITY_SIZE];
+    uint8_t hdr[NET_SNAPSHOT_HEADER_SIZE];
+    uint32_t i;
+    mc_lz_writer_begin(lz, out, cap);
+    net_pack_snapshot_header(s, hdr);
+    mc_lz_writer_write(lz, hdr, sizeof(hdr));
+    for (i = 0; i < s->entity_count; i++) {
+        net_pack_snapshot_entity(&s->entities[i], row);
+        mc_lz_writer_write(lz, row, sizeof(row));
+    }
+    return mc_lz_writer_end(lz);
+}
+
+static inline int net_snapshot_read_lz(Snapshot* s, const uint8_t* in, uint32_t len) {
+    uint8_t raw[NET_SNAPSHOT_WIRE_MAX];
+    uint32_t raw_len;
+    if (mc_lz_frame_decompress(in, len, raw, sizeof(raw), &raw_len) != 0) return -1;
+    return net_snapshot_read(s, raw, raw_len);
+}
+
+/* =========================================================================
+ * DELTA SNAPSHOTS
+ *
+ * A delta frame encodes the current snapshot against a base the client
+ * already holds (the last one it acknowledged), so a mostly static scene
+ * costs a header and three zero counts instead of 16 bytes per entity.
+ *
+ * Header: tick_number u32, base_tick u32 (NET_SNAPSHOT_NO_BASE = none,
+ *         every entity sent as created), last_ack u16, version u8,
+ *         pad u8, state_hash u64
+ * Body, all varints (LEB128; signed values zigzag-encoded):
+ *   removed  count, then ids
+ *   created  count, then id, x, y, hp, max_hp, glyph, type, flags, sprite
+ *   changed  count, then id, field mask u8, then each masked field:
+ *            x, y, hp, max_hp as deltas from the base; the u8 fields raw
+ *   Ids in each list ascend and are sent as the gap from the previous one.
+ *
+ * Decoded entity order is the base's order minus removed entities, then
+ * created ones by ascending id. Order isn't part of the state; clients
+ * key entities by entity_id.
+ * ========================================================================= */
+
+#define NET_SNAPSHOT_NO_BASE   0xFFFFFFFFu
+#ifndef NET_SNAPSHOT_HISTORY
+#define NET_SNAPSHOT_HISTORY   32      /* ticks of sent snapshots kept per client */
+#endif
+#define NET_SNAPSHOT_DELTA_MAX (NET_SNAPSHOT_HEADER_SIZE + 15 + NET_MAX_SNAPSHOT_ENTS * 27)
+
+#define NET_DELTA_X      0x01
+#define NET_DELTA_Y      0x02
+#define NET_DELTA_HP     0x04
+#define NET_DELTA_MAX_HP 0x08
+#define NET_DELTA_GLYPH  0x10
+#define NET_DELTA_TYPE   0x20
+#define NET_DELTA_FLAGS  0x40
+#define NET_DELTA_SPRITE 0x80
+
+static inline uint32_t net_zigzag(int32_t v) {
+    return (v < 0) ? ((~(uint32_t)v) << 1) | 1u : (uint32_t)v << 1;
+}
+
+static inline int32_t net_unzigzag(uint32_t v) {
+    return (int32_t)((v >> 1) ^ (0u - (v & 1u)));
+}
+
+/* Append a varint at *pos. Returns 0, or -1 if it doesn't fit. */
+static inline int net_put_varint(uint8_t* out, uint32_t cap, uint32_t* pos, uint32_t v) {
+    do {
+        uint8_t b = (uint8_t)(v & 0x7F);
+        v >>= 7;
+        if (*pos >= cap) return -1;
+        out[(*pos)++] = (uint8_t)(b | (v ? 0x80 : 0));
+    } while (v);
+    return 0;
+}
+
+/* Read a varint at *pos. Returns 0, or -1 if truncated, over 5 bytes,
+ * or wider than 32 bits (5th byte above 0x0F). network.lua's read_varint
+ * applies the same rule, so both ends accept exactly the same packets. */
+static inline int net_get_varint(const uint8_t* in, uint32_t len, uint32_t* pos, uint32_t* v) {
+    uint32_t shift = 0, r = 0;
+    while (shift < 35) {
+        uint8_t b;
+        if (*pos >= len) return -1;
+        b = in[(*pos)++];
+        if (shift == 28 && b > 0x0F) return -1;
+        r |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = r;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+/* Indices of s->entities ordered by entity_id. Insertion sort: snapshots
+ * are built in slot order, which is nearly sorted by id already. */
+static inline void net_snapshot__sort_ids(const Snapshot* s, uint16_t* order) {
+    uint32_t i, j;
+    for (i = 0; i < s->entity_count; i++) {
+        uint16_t x = (uint16_t)i;
+        uint32_t id = s->entities[i].entity_id;
+        j = i;
+        while (j > 0 && s->entities[order[j - 1]].entity_id > id) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = x;
+    }
+}
+
+static inline uint8_t net_snapshot__diff(const SnapshotEntity* a, const SnapshotEntity* b) {
+    uint8_t m = 0;
+    if (a->x != b->x)                     m |= NET_DELTA_X;
+    if (a->y != b->y)                     m |= NET_DELTA_Y;
+    if (a->hp != b->hp)                   m |= NET_DELTA_HP;
+    if (a->max_hp != b->max_hp)           m |= NET_DELTA_MAX_HP;
+    if (a->glyph != b->glyph)             m |= NET_DELTA_GLYPH;
+    if (a->entity_type != b->entity_type) m |= NET_DELTA_TYPE;
+    if (a->flags != b->flags)             m |= NET_DELTA_FLAGS;
+    if (a->sprite_id != b->sprite_id)     m |= NET_DELTA_SPRITE;
+    return m;
+}
+
+/* Encode `cur` against `base` (NULL = no base). Returns bytes written,
+ * 0 if `cap` is too small. */
+static inline uint32_t net_snapshot_write_delta(const Snapshot* base, const Snapshot* cur,
+                                                uint8_t* out, uint32_t cap) {
+    static const Snapshot empty;   /* zero entities */
+    uint16_t bo[NET_MAX_SNAPSHOT_ENTS], co[NET_MAX_SNAPSHOT_ENTS];
+    uint16_t removed[NET_MAX_SNAPSHOT_ENTS], created[NET_MAX_SNAPSHOT_ENTS];
+    uint16_t changed_b[NET_MAX_SNAPSHOT_ENTS], changed_c[NET_MAX_SNAPSHOT_ENTS];
+    uint32_t nr = 0, nc = 0, nch = 0, i = 0, j = 0, k, prev, pos;
+    const Snapshot* b = (base != NULL) ? base : &empty;
+    int err = 0;
+
+    if (cap < NET_SNAPSHOT_HEADER_SIZE) return 0;
+    net_put_u32(out, cur->tick_number);
+    net_put_u32(out + 4, (base != NULL) ? base->tick_number : NET_SNAPSHOT_NO_BASE);
+    net_put_u16(out + 8, cur->last_ack_sequence);
+    out[10] = cur->protocol_version;
+    out[11] = 0;
+    net_put_u32(out + 12, (uint32_t)cur->state_hash);
+    net_put_u32(out + 16, (uint32_t)(cur->state_hash >> 32));
+    pos = NET_SNAPSHOT_HEADER_SIZE;
+
+    /* Merge-join both entity lists by id */
+    net_snapshot__sort_ids(b, bo);
+    net_snapshot__sort_ids(cur, co);
+    while (i < b->entity_count || j < cur->entity_count) {
+        uint32_t bid = (i < b->entity_count) ? b->entities[bo[i]].entity_id : UINT32_MAX;
+        uint32_t cid = (j < cur->entity_count) ? cur->entities[co[j]].entity_id : UINT32_MAX;
+        if (j >= cur->entity_count || (i < b->entity_count && bid < cid)) {
+            removed[nr++] = bo[i++];
+        } else if (i >= b->entity_count || cid < bid) {
+            created[nc++] = co[j++];
+        } else {
+            if (net_snapshot__diff(&b->entities[bo[i]], &cur->entities[co[j]]) != 0) {
+                changed_b[nch] = bo[i];
+                changed_c[nch] = co[j];
+                nch++;
+            }
+            i++;
+            j++;
+        }
+    }
+
+    err |= net_put_varint(out, cap, &pos, nr);
+    for (k = 0, prev = 0; k < nr; k++) {
+        uint32_t id = b->entities[removed[k]].entity_id;
+        err |= net_put_varint(out, cap, &pos, id - prev);
+        prev = id;
+    }
+
+    err |= net_put_varint(out, cap, &pos, nc);
+    for (k = 0, prev = 0; k < nc; k++) {
+        const SnapshotEntity* e = &cur->entities[created[k]];
+        err |= net_put_varint(out, cap, &pos, e->entity_id - prev);
+        err |= net_put_varint(out, cap, &pos, e->x);
+        err |= net_put_varint(out, cap, &pos, e->y);
+        err |= net_put_varint(out, cap, &pos, net_zigzag(e->hp));
+        err |= net_put_varint(out, cap, &pos, net_zigzag(e->max_hp));
+        err |= net_put_varint(out, cap, &pos, e->glyph);
+        err |= net_put_varint(out, cap, &pos, e->entity_type);
+        err |= net_put_varint(out, cap, &pos, e->flags);
+        err |= net_put_varint(out, cap, &pos, e->sprite_id);
+        prev = e->entity_id;
+    }
+
+    err |= net_put_varint(out, cap, &pos, nch);
+    for (k = 0, prev = 0; k < nch; k++) {
+        const SnapshotEntity* o = &b->entities[changed_b[k]];
+        const SnapshotEntity* e = &cur->entities[changed_c[k]];
+        uint8_t m = net_snapshot__diff(o, e);
+        err |= net_put_varint(out, cap, &pos, e->entity_id - prev);
+        err |= net_put_varint(out, cap, &pos, m);
+        if (m & NET_DELTA_X)      err |= net_put_varint(out, cap, &pos, net_zigzag((int32_t)e->x - (int32_t)o->x));
+        if (m & NET_DELTA_Y)      err |= net_put_varint(out, cap, &pos, net_zigzag((int32_t)e->y - (int32_t)o->y));
+        if (m & NET_DELTA_HP)     err |= net_put_varint(out, cap, &pos, net_zigzag((int32_t)e->hp - (int32_t)o->hp));
+        if (m & NET_DELTA_MAX_HP) err |= net_put_varint(out, cap, &pos, net_zigzag((int32_t)e->max_hp - (int32_t)o->max_hp));
+        if (m & NET_DELTA_GLYPH)  err |= net_put_varint(out, cap, &pos, e->glyph);
+        if (m & NET_DELTA_TYPE)   err |= net_put_varint(out, cap, &pos, e->entity_type);
+        if (m & NET_DELTA_FLAGS)  err |= net_put_varint(out, cap, &pos, e->flags);
+        if (m & NET_DELTA_SPRITE) err |= net_put_varint(out, cap, &pos, e->sprite_id);
+        prev = e->entity_id;
+    }
+    return err ? 0 : pos;
+}
+
+/* Base tick a delta frame was encoded against, NET_SNAPSHOT_NO_BASE if
+ * none (or if the frame is too short to say). */
+static inline uint32_t net_snapshot_delta_base(const uint8_t* in, uint32_t len) {
+    if (len < NET_SNAPSHOT_HEADER_SIZE) return NET_SNAPSHOT_NO_BASE;
+    return net_get_u32(in + 4);
+}
+
+/* Read one varint-coded u8/u16 field; -1 if out of range */
+static inline int net_snapshot__get_small(const uint8_t* in, uint32_t len, uint32_t* pos,
+                                          uint32_t max, uint32_t* v) {
+    if (net_get_varint(in, len, pos, v) != 0 || *v > max) return -1;
+    return 0;
+}
+
+/* Apply a zigzag delta to `old`; -1 if the result leaves [lo, hi] */
+static inline int net_snapshot__get_delta(const uint8_t* in, uint32_t len, uint32_t* pos,
+                                          int32_t old, int32_t lo, int32_t hi, int32_t* v) {
+    uint32_t z;
+    int64_t r;
+    if (net_get_varint(in, len, pos, &z) != 0) return -1;
+    r = (int64_t)old + net_unzigzag(z);
+    if (r < lo || r > hi) return -1;
+    *v = (int32_t)r;
+    return 0;
+}
+
+/* Decode a delta frame. `base` must be the snapshot with the frame's base
+ * tick (NULL when it has none). Returns 0, or -1 if the frame is
+ * malformed, refers to ids the base doesn't have, or the base is wrong. */
+static inline int net_snapshot_read_delta(Snapshot* s, const Snapshot* base,
+                                          const uint8_t* in, uint32_t len) {
+    static const Snapshot empty;
+    uint16_t bo[NET_MAX_SNAPSHOT_ENTS];
+    uint8_t  gone[NET_MAX_SNAPSHOT_ENTS];
+    uint32_t base_tick, pos = NET_SNAPSHOT_HEADER_SIZE, n, k, i, id, gap, v;
+    const Snapshot* b;
+
+    if (len < NET_SNAPSHOT_HEADER_SIZE) return -1;
+    base_tick = net_get_u32(in + 4);
+    if ((base_tick == NET_SNAPSHOT_NO_BASE) != (base == NULL)) return -1;
+    if (base != NULL && base->tick_number != base_tick) return -1;
+    b = (base != NULL) ? base : &empty;
+
+    net_snapshot_init(s);
+    s->tick_number       = net_get_u32(in);
+    s->last_ack_sequence = net_get_u16(in + 8);
+    s->protocol_version  = in[10];
+    s->state_hash        = (uint64_t)net_get_u32(in + 12)
+                         | ((uint64_t)net_get_u32(in + 16) << 32);
+
+    net_snapshot__sort_ids(b, bo);
+    memset(gone, 0, sizeof(gone));
+
+    /* Removed: ids ascend, so one cursor walks the sorted base */
+    if (net_get_varint(in, len, &pos, &n) != 0 || n > b->entity_count) return -1;
+    for (k = 0, i = 0, id = 0; k < n; k++) {
+        if (net_get_varint(in, len, &pos, &gap) != 0) return -1;
+        if ((k > 0 && gap == 0) || gap > UINT32_MAX - id) return -1;
+        id += gap;
+        while (i < b->entity_count && b->entities[bo[i]].entity_id < id) i++;
+        if (i >= b->entity_count || b->entities[bo[i]].entity_id != id) return -1;
+        gone[bo[i]] = 1;
+    }
+    for (i = 0; i < b->entity_count; i++) {
+        if (!gone[i]) s->entities[s->entity_count++] = b->entities[i];
+    }
+
+    /* Created: appended; must not collide with a surviving base id */
+    if (net_get_varint(in, len, &pos, &n) != 0) return -1;
+    if (n > NET_MAX_SNAPSHOT_ENTS - s->entity_count) return -1;
+    for (k = 0, i = 0, id = 0; k < n; k++) {
+        SnapshotEntity* e = &s->entities[s->entity_count];
+        if (net_get_varint(in, len, &pos, &gap) != 0) return -1;
+        if ((k > 0 && gap == 0) || gap > UINT32_MAX - id) return -1;
+        id += gap;
+        while (i < b->entity_count && b->entities[bo[i]].entity_id < id) i++;
+        if (i < b->entity_count && b->entities[bo[i]].entity_id == id && !gone[bo[i]]) return -1;
+        e->entity_id = id;
+        if (net_snapshot__get_small(in, len, &pos, 0xFFFF, &v) != 0) return -1;
+        e->x = (uint16_t)v;
+        if (net_snapshot__get_small(in, len, &pos, 0xFFFF, &v) != 0) return -1;
+        e->y = (uint16_t)v;
+        if (net_get_varint(in, len, &pos, &v) != 0) return -1;
+        if (net_unzigzag(v) < INT16_MIN || net_unzigzag(v) > INT16_MAX) return -1;
+        e->hp = (int16_t)net_unzigzag(v);
+        if (net_get_varint(in, len, &pos, &v) != 0) return -1;
+        if (net_unzigzag(v) < INT16_MIN || net_unzigzag(v) > INT16_MAX) return -1;
+        e->max_hp = (int16_t)net_unzigzag(v);
+        if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+        e->glyph = (uint8_t)v;
+        if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+        e->entity_type = (uint8_t)v;
+        if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+        e->flags = (uint8_t)v;
+        if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+        e->sprite_id = (uint8_t)v;
+        s->entity_count++;
+    }
+
+    /* Changed: must name surviving base entities. Survivors keep their
+     * base index order in s, so find them through the sorted base. */
+    if (net_get_varint(in, len, &pos, &n) != 0 || n > b->entity_count) return -1;
+    {
+        uint16_t dst[NET_MAX_SNAPSHOT_ENTS];   /* base index -> index in s */
+        uint32_t d = 0;
+        for (i = 0; i < b->entity_count; i++) {
+            if (!gone[i]) dst[i] = (uint16_t)d++;
+        }
+        for (k = 0, i = 0, id = 0; k < n; k++) {
+            SnapshotEntity* e;
+            uint32_t m;
+            int32_t r;
+            if (net_get_varint(in, len, &pos, &gap) != 0) return -1;
+            if ((k > 0 && gap == 0) || gap > UINT32_MAX - id) return -1;
+            id += gap;
+            while (i < b->entity_count && b->entities[bo[i]].entity_id < id) i++;
+            if (i >= b->entity_count || b->entities[bo[i]].entity_id != id || gone[bo[i]]) return -1;
+            e = &s->entities[dst[bo[i]]];
+            if (net_snapshot__get_small(in, len, &pos, 0xFF, &m) != 0 || m == 0) return -1;
+            if (m & NET_DELTA_X) {
+                if (net_snapshot__get_delta(in, len, &pos, e->x, 0, 0xFFFF, &r) != 0) return -1;
+                e->x = (uint16_t)r;
+            }
+            if (m & NET_DELTA_Y) {
+                if (net_snapshot__get_delta(in, len, &pos, e->y, 0, 0xFFFF, &r) != 0) return -1;
+                e->y = (uint16_t)r;
+            }
+            if (m & NET_DELTA_HP) {
+                if (net_snapshot__get_delta(in, len, &pos, e->hp, INT16_MIN, INT16_MAX, &r) != 0) return -1;
+                e->hp = (int16_t)r;
+            }
+            if (m & NET_DELTA_MAX_HP) {
+                if (net_snapshot__get_delta(in, len, &pos, e->max_hp, INT16_MIN, INT16_MAX, &r) != 0) return -1;
+                e->max_hp = (int16_t)r;
+            }
+            if (m & NET_DELTA_GLYPH) {
+                if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+                e->glyph = (uint8_t)v;
+            }
+            if (m & NET_DELTA_TYPE) {
+                if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+                e->entity_type = (uint8_t)v;
+            }
+            if (m & NET_DELTA_FLAGS) {
+                if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+                e->flags = (uint8_t)v;
+            }
+            if (m & NET_DELTA_SPRITE) {
+                if (net_snapshot__get_small(in, len, &pos, 0xFF, &v) != 0) return -1;
+                e->sprite_id = (uint8_t)v;
+            }
+        }
+    }
+    return (pos == len) ? 0 : -1;
+}
+
+/* =========================================================================
+ * PER-CLIENT SNAPSHOT HISTORY
+ *
+ * The server keeps the last NET_SNAPSHOT_HISTORY snapshots it sent each
+ * client, keyed by tick_number, and the newest tick the client has
+ * acknowledged. Each send is a delta against that ack; if the client has
+ * never acked, or has fallen further behind than the ring, it gets a
+ * frame with no base. The client keeps the same ring of what it decoded,
+ * so it always has the base the server picks.
+ * ========================================================================= */
+
+typedef struct {
+    Snapshot ring[NET_SNAPSHOT_HISTORY];
+    uint8_t  used[NET_SNAPSHOT_HISTORY];
+    uint32_t acked_tick;     /* NET_SNAPSHOT_NO_BASE until the first ack */
+} NetSnapshotHistory;
+
+static inline void net_history_init(NetSnapshotHistory* h) {
+    memset(h->used, 0, sizeof(h->used));
+    h->acked_tick = NET_SNAPSHOT_NO_BASE;
+}
+
+static inline void net_history_store(NetSnapshotHistory* h, const Snapshot* s) {
+    uint32_t slot = s->tick_number % NET_SNAPSHOT_HISTORY;
+    h->ring[slot] = *s;
+    h->used[slot] = 1;
+}
+
+static inline const Snapshot* net_history_find(const NetSnapshotHistory* h, uint32_t tick) {
+    uint32_t slot = tick % NET_SNAPSHOT_HISTORY;
+    if (tick == NET_SNAPSHOT_NO_BASE || !h->used[slot]) return NULL;
+    if (h->ring[slot].tick_number != tick) return NULL;
+    return &h->ring[slot];
+}
+
+/* Client acknowledged `tick`. Stale or unknown acks are ignored (-1). */
+static inline int net_history_ack(NetSnapshotHistory* h, uint32_t tick) {
+    if (net_history_find(h, tick) == NULL) return -1;
+    if (h->acked_tick != NET_SNAPSHOT_NO_BASE && tick <= h->acked_tick) return -1;
+    h->acked_tick = tick;
+    return 0;
+}
+
+/* Encode `cur` for one client against its last ack, then remember it.
+ * Returns bytes written, 0 if `cap` is too small. */
+static inline uint32_t net_snapshot_write_for_client(NetSnapshotHistory* h, const Snapshot* cur,
+                                                     uint8_t* out, uint32_t cap) {
+    uint32_t n = net_snapshot_write_delta(net_history_find(h, h->acked_tick), cur, out, cap);
+    if (n > 0) net_history_store(h, cur);
+    return n;
+}
+
+/* =========================================================================
+ * BATCHED COMMAND PACKETS
+ *
+ * One client's commands for a tick in a single packet:
+ *
+ *   varint count, varint entity_id, varint base_sequence
+ *   count x { opcode byte, then that opcode's fields }
+ *
+ * Command i gets sequence base_sequence + i. Each opcode carries only
+ * the fields it uses (net_batch_layout), in the order param1 (raw byte),
+ * target_x, target_y, target_id (varints). A move or heartbeat is 1 byte,
+ * an attack on a low id 2-3, against 16 in the fixed format. Opcodes
+ * without a known layout send all four fields. network.lua packs the
+ * same format (M.packBatch).
+ * ========================================================================= */
+
+#define NET_BATCH_MAX_CMDS   NET_MAX_CMD_QUEUE
+#define NET_BATCH_MAX_SIZE   (13 + NET_BATCH_MAX_CMDS * 13)
+
+#define NET_BATCH_PARAM1     0x01
+#define NET_BATCH_TARGET_X   0x02
+#define NET_BATCH_TARGET_Y   0x04
+#define NET_BATCH_TARGET_ID  0x08
+#define NET_BATCH_ALL        0x0F
+
+/* Fields an opcode carries in a batch */
+static inline uint8_t net_batch_layout(uint8_t op) {
+    switch (op) {
+    case OP_TELEPORT:
+    case OP_INTERACT_DOOR: case OP_SEARCH: case OP_DISARM_TRAP: case OP_ACTIVATE:
+        return NET_BATCH_TARGET_X | NET_BATCH_TARGET_Y;
+    case OP_MELEE_ATTACK:
+    case OP_ARENA_CHALLENGE: case OP_ARENA_ACCEPT: case OP_ARENA_DECLINE:
+        return NET_BATCH_TARGET_ID;
+    case OP_RANGED_ATTACK:
+        return NET_BATCH_TARGET_X | NET_BATCH_TARGET_Y | NET_BATCH_TARGET_ID;
+    case OP_USE_SKILL:
+    case OP_PICK_UP: case OP_DROP: case OP_EQUIP: case OP_CONSUME: case OP_USE_ITEM:
+        return NET_BATCH_PARAM1 | NET_BATCH_TARGET_ID;
+    case OP_DEFEND: case OP_USE_MEDKIT:
+    case OP_HEARTBEAT: case OP_LOGIN: case OP_LOGOUT: case OP_SYNC_REQUEST: case OP_NOP:
+        return 0;
+    default:
+        return (op < OP_TELEPORT) ? 0 : NET_BATCH_ALL;   /* plain moves, stairs */
+    }
+}
+
+/* Encode n commands from one entity with consecutive sequence numbers.
+ * Returns bytes written, or 0 if they can't share a batch (mixed
+ * entities, a sequence gap, a field the opcode's layout doesn't carry)
+ * or `cap` is too small. */
+static inline uint32_t net_batch_write(const InteractionCommand* cmds, uint32_t n,
+                                       uint8_t* out, uint32_t cap) {
+    uint32_t pos = 0, i;
+    if (n == 0 || n > NET_BATCH_MAX_CMDS) return 0;
+    if (net_put_varint(out, cap, &pos, n) != 0 ||
+        net_put_varint(out, cap, &pos, cmds[0].entity_id) != 0 ||
+        net_put_varint(out, cap, &pos, cmds[0].sequence) != 0) return 0;
+    for (i = 0; i < n; i++) {
+        const InteractionCommand* c = &cmds[i];
+        uint8_t m = net_batch_layout(c->opcode);
+        if (c->entity_id != cmds[0].entity_id) return 0;
+        if (c->sequence != (uint16_t)(cmds[0].sequence + i)) return 0;
+        if ((c->param1    && !(m & NET_BATCH_PARAM1))   ||
+            (c->target_x  && !(m & NET_BATCH_TARGET_X)) ||
+            (c->target_y  && !(m & NET_BATCH_TARGET_Y)) ||
+            (c->target_id && !(m & NET_BATCH_TARGET_ID))) return 0;
+        if (pos >= cap) return 0;
+        out[pos++] = c->opcode;
+        if (m & NET_BATCH_PARAM1) {
+            if (pos >= cap) return 0;
+            out[pos++] = c->param1;
+        }
+        if ((m & NET_BATCH_TARGET_X)  && net_put_varint(out, cap, &pos, c->target_x) != 0)  return 0;
+        if ((m & NET_BATCH_TARGET_Y)  && net_put_varint(out, cap, &pos, c->target_y) != 0)  return 0;
+        if ((m & NET_BATCH_TARGET_ID) && net_put_varint(out, cap, &pos, c->target_id) != 0) return 0;
+    }
+    return pos;
+}
+
+/* Decode a batch into out[0..cap). Returns the command count, or -1 if
+ * the packet is truncated, has trailing bytes, a field out of range, or
+ * more commands than `cap`. */
+static inline int net_batch_read(const uint8_t* in, uint32_t len, InteractionCommand* out, uint32_t cap) {
+    uint32_t pos = 0, n, eid, seq, v, i;
+    if (net_get_varint(in, len, &pos, &n) != 0 || n == 0 || n > NET_BATCH_MAX_CMDS || n > cap) return -1;
+    if (net_get_varint(in, len, &pos, &eid) != 0) return -1;
+    if (net_get_varint(in, len, &pos, &seq) != 0 || seq > 0xFFFF) return -1;
+    for (i = 0; i < n; i++) {
+        InteractionCommand* c = &out[i];
+        uint8_t m;
+        memset(c, 0, sizeof(*c));
+        if (pos >= len) return -1;
+        c->entity_id = eid;
+        c->opcode    = in[pos++];
+        c->sequence  = (uint16_t)(seq + i);
+        m = net_batch_layout(c->opcode);
+        if (m & NET_BATCH_PARAM1) {
+            if (pos >= len) return -1;
+            c->param1 = in[pos++];
+        }
+        if (m & NET_BATCH_TARGET_X) {
+            if (net_get_varint(in, len, &pos, &v) != 0 || v > 0xFFFF) return -1;
+            c->target_x = (uint16_t)v;
+        }
+        if (m & NET_BATCH_TARGET_Y) {
+            if (net_get_varint(in, len, &pos, &v) != 0 || v > 0xFFFF) return -1;
+            c->target_y = (uint16_t)v;
+        }
+        if ((m & NET_BATCH_TARGET_ID) && net_get_varint(in, len, &pos, &c->target_id) != 0) return -1;
+    }
+    return (pos == len) ? (int)n : -1;
+}
+
+/* Decode a batch and push its commands. A malformed packet pushes
+ * nothing and returns -1; otherwise returns how many were queued (the
+ * rest were dropped, as with net_queue_push). */
+static inline int net_queue_push_batch(CommandQueue* q, const uint8_t* in, uint32_t len) {
+    InteractionCommand cmds[NET_BATCH_MAX_CMDS];
+    int n = net_batch_read(in, len, cmds, NET_BATCH_MAX_CMDS);
+    int i, pushed = 0;
+    for (i = 0; i < n; i++) {
+        if (net_queue_push(q, &cmds[i]) == 0) pushed++;
+    }
+    return (n < 0) ? -1 : pushed;
+}
+
 /* =========================================================================
  * SIMPLE TILE MAP FOR VALIDATION (static, fixed bounds)
  * ========================================================================= */
@@ -381,6 +1053,240 @@ static inline int net_map_walkable(const TileMap* m, int x, int y) {
     return m->tiles[y][x] == 0;
 }
 
+/* =========================================================================
+ * BIT-PACKED SNAPSHOTS
+ *
+ * Each field is written with just the bits its range needs, LSB-first:
+ *
+ *   Header   tick 32, last_ack 16, version 8, state_hash 64, count 9
+ *   Entity   id            exp-Golomb gap from the previous id (sorted)
+ *            x, y          NET_SNAP_BITS_X / _Y (map coordinates)
+ *            max_hp        NET_SNAP_BITS_HP, biased by NET_SNAP_HP_BIAS
+ *            hp_full 1     hp == max_hp; otherwise hp follows, same width
+ *            same_look 1   glyph/type/flags/sprite equal the previous
+ *                          entity's; otherwise they follow at
+ *                          7 / 3 / 4 / NET_SNAP_BITS_SPRITE bits
+ *
+ * A typical entity costs ~25 bits against 16 bytes in memory. Values
+ * outside a field's range make the writer fail rather than wrap. Entities
+ * come back ordered by id.
+ * ========================================================================= */
+
+#define NET_SNAP_BITS_X      5     /* 0 .. NET_MAP_W - 1 */
+#define NET_SNAP_BITS_Y      5     /* 0 .. NET_MAP_H - 1 */
+#define NET_SNAP_BITS_HP    12     /* -2048 .. 2047       */
+#define NET_SNAP_HP_BIAS  2048
+#define NET_SNAP_BITS_GLYPH  7     /* ASCII               */
+#define NET_SNAP_BITS_TYPE   3
+#define NET_SNAP_BITS_FLAGS  4
+#ifndef NET_SNAP_BITS_SPRITE
+#define NET_SNAP_BITS_SPRITE 6     /* sprite table size   */
+#endif
+#define NET_SNAP_BITS_COUNT  9     /* 0 .. NET_MAX_SNAPSHOT_ENTS */
+
+#if (1 << NET_SNAP_BITS_X) < NET_MAP_W || (1 << NET_SNAP_BITS_Y) < NET_MAP_H
+#error "NET_SNAP_BITS_X/Y too narrow for the map"
+#endif
+#if (1 << NET_SNAP_BITS_COUNT) <= NET_MAX_SNAPSHOT_ENTS
+#error "NET_SNAP_BITS_COUNT too narrow for NET_MAX_SNAPSHOT_ENTS"
+#endif
+
+#define NET_SNAPSHOT_BITS_MAX ((129 + NET_MAX_SNAPSHOT_ENTS * 121 + 7) / 8)
+
+typedef struct {
+    uint8_t* buf;
+    uint32_t cap;       /* bytes */
+    uint32_t pos;       /* bits written */
+    int      overflow;
+} NetBitWriter;
+
+typedef struct {
+    const uint8_t* buf;
+    uint32_t len;       /* bytes */
+    uint32_t pos;       /* bits read */
+    int      overflow;
+} NetBitReader;
+
+static inline void net_bits_writer_init(NetBitWriter* w, uint8_t* buf, uint32_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->pos = 0;
+    w->overflow = 0;
+}
+
+static inline void net_bits_reader_init(NetBitReader* r, const uint8_t* buf, uint32_t len) {
+    r->buf = buf;
+    r->len = len;
+    r->pos = 0;
+    r->overflow = 0;
+}
+
+/* Low `n` bits of v (n <= 32). Sets overflow instead of writing past cap. */
+static inline void net_bits_write(NetBitWriter* w, uint32_t v, uint32_t n) {
+    if (w->overflow || (uint64_t)w->pos + n > (uint64_t)w->cap * 8) {
+        w->overflow = 1;
+        return;
+    }
+    while (n > 0) {
+        uint32_t off  = w->pos & 7;
+        uint32_t take = (8 - off < n) ? 8 - off : n;
+        uint8_t* b    = &w->buf[w->pos >> 3];
+        if (off == 0) *b = 0;
+        *b |= (uint8_t)((v & ((1u << take) - 1u)) << off);
+        v = (take < 32) ? v >> take : 0;
+        w->pos += take;
+        n -= take;
+    }
+}
+
+/* Read `n` bits (n <= 32). Past the end: returns 0 and sets overflow. */
+static inline uint32_t net_bits_read(NetBitReader* r, uint32_t n) {
+    uint32_t v = 0, got = 0;
+    if (r->overflow || (uint64_t)r->pos + n > (uint64_t)r->len * 8) {
+        r->overflow = 1;
+        return 0;
+    }
+    while (got < n) {
+        uint32_t off  = r->pos & 7;
+        uint32_t take = (8 - off < n - got) ? 8 - off : n - got;
+        v |= (uint32_t)((r->buf[r->pos >> 3] >> off) & ((1u << take) - 1u)) << got;
+        r->pos += take;
+        got += take;
+    }
+    return v;
+}
+
+/* Order-0 exp-Golomb: small values in few bits, any uint32 in <= 65 */
+static inline void net_bits_write_egolomb(NetBitWriter* w, uint32_t v) {
+    uint64_t u = (uint64_t)v + 1;
+    uint32_t n = 0;
+    while ((u >> (n + 1)) != 0) n++;          /* u has n + 1 significant bits */
+    net_bits_write(w, 0, n);
+    net_bits_write(w, 1, 1);
+    net_bits_write(w, (uint32_t)(u & ((1ull << n) - 1)), n);
+}
+
+static inline uint32_t net_bits_read_egolomb(NetBitReader* r) {
+    uint32_t zeros = 0;
+    uint64_t u;
+    while (net_bits_read(r, 1) == 0) {
+        if (r->overflow || ++zeros > 32) {
+            r->overflow = 1;
+            return 0;
+        }
+    }
+    u = ((uint64_t)1 << zeros) | net_bits_read(r, zeros);
+    if (u - 1 > UINT32_MAX) {
+        r->overflow = 1;
+        return 0;
+    }
+    return (uint32_t)(u - 1);
+}
+
+static inline int net_snap__hp_ok(int32_t v) {
+    return v >= -NET_SNAP_HP_BIAS && v < (1 << NET_SNAP_BITS_HP) - NET_SNAP_HP_BIAS;
+}
+
+/* Returns bytes written; 0 if `cap` is too small or a field is out of
+ * its packed range. */
+static inline uint32_t net_snapshot_write_bits(const Snapshot* s, uint8_t* out, uint32_t cap) {
+    uint16_t order[NET_MAX_SNAPSHOT_ENTS];
+    const SnapshotEntity* prev = NULL;
+    NetBitWriter w;
+    uint32_t i;
+
+    net_bits_writer_init(&w, out, cap);
+    net_bits_write(&w, s->tick_number, 32);
+    net_bits_write(&w, s->last_ack_sequence, 16);
+    net_bits_write(&w, s->protocol_version, 8);
+    net_bits_write(&w, (uint32_t)s->state_hash, 32);
+    net_bits_write(&w, (uint32_t)(s->state_hash >> 32), 32);
+    net_bits_write(&w, s->entity_count, NET_SNAP_BITS_COUNT);
+
+    net_snapshot__sort_ids(s, order);
+    for (i = 0; i < s->entity_count; i++) {
+        const SnapshotEntity* e = &s->entities[order[i]];
+        if (e->x >= (1u << NET_SNAP_BITS_X) || e->y >= (1u << NET_SNAP_BITS_Y)) return 0;
+        if (!net_snap__hp_ok(e->hp) || !net_snap__hp_ok(e->max_hp)) return 0;
+        if (e->glyph >= (1u << NET_SNAP_BITS_GLYPH) || e->entity_type >= (1u << NET_SNAP_BITS_TYPE)
+            || e->flags >= (1u << NET_SNAP_BITS_FLAGS) || e->sprite_id >= (1u << NET_SNAP_BITS_SPRITE)) return 0;
+        if (prev != NULL && e->entity_id == prev->entity_id) return 0;
+
+        net_bits_write_egolomb(&w, (prev == NULL) ? e->entity_id : e->entity_id - prev->entity_id - 1);
+        net_bits_write(&w, e->x, NET_SNAP_BITS_X);
+        net_bits_write(&w, e->y, NET_SNAP_BITS_Y);
+        net_bits_write(&w, (uint32_t)(e->max_hp + NET_SNAP_HP_BIAS), NET_SNAP_BITS_HP);
+        net_bits_write(&w, e->hp == e->max_hp, 1);
+        if (e->hp != e->max_hp) net_bits_write(&w, (uint32_t)(e->hp + NET_SNAP_HP_BIAS), NET_SNAP_BITS_HP);
+        if (prev != NULL && e->glyph == prev->glyph && e->entity_type == prev->entity_type
+            && e->flags == prev->flags && e->sprite_id == prev->sprite_id) {
+            net_bits_write(&w, 1, 1);
+        } else {
+            net_bits_write(&w, 0, 1);
+            net_bits_write(&w, e->glyph, NET_SNAP_BITS_GLYPH);
+            net_bits_write(&w, e->entity_type, NET_SNAP_BITS_TYPE);
+            net_bits_write(&w, e->flags, NET_SNAP_BITS_FLAGS);
+            net_bits_write(&w, e->sprite_id, NET_SNAP_BITS_SPRITE);
+        }
+        prev = e;
+    }
+    if (w.overflow) return 0;
+    return (w.pos + 7) / 8;
+}
+
+/* Returns 0, or -1 if the bytes aren't exactly one valid packed snapshot
+ * (truncated, trailing data, nonzero padding, ids not ascending). */
+static inline int net_snapshot_read_bits(Snapshot* s, const uint8_t* in, uint32_t len) {
+    NetBitReader r;
+    uint32_t i, count, lo, hi;
+
+    net_bits_reader_init(&r, in, len);
+    net_snapshot_init(s);
+    s->tick_number       = net_bits_read(&r, 32);
+    s->last_ack_sequence = (uint16_t)net_bits_read(&r, 16);
+    s->protocol_version  = (uint8_t)net_bits_read(&r, 8);
+    lo = net_bits_read(&r, 32);
+    hi = net_bits_read(&r, 32);
+    s->state_hash = (uint64_t)lo | ((uint64_t)hi << 32);
+    count = net_bits_read(&r, NET_SNAP_BITS_COUNT);
+    if (r.overflow || count > NET_MAX_SNAPSHOT_ENTS) return -1;
+
+    for (i = 0; i < count; i++) {
+        SnapshotEntity* e = &s->entities[i];
+        uint32_t gap = net_bits_read_egolomb(&r);
+        if (i == 0) {
+            e->entity_id = gap;
+        } else {
+            uint32_t last = s->entities[i - 1].entity_id;
+            if (gap >= UINT32_MAX - last) return -1;
+            e->entity_id = last + gap + 1;
+        }
+        e->x      = (uint16_t)net_bits_read(&r, NET_SNAP_BITS_X);
+        e->y      = (uint16_t)net_bits_read(&r, NET_SNAP_BITS_Y);
+        e->max_hp = (int16_t)((int32_t)net_bits_read(&r, NET_SNAP_BITS_HP) - NET_SNAP_HP_BIAS);
+        if (net_bits_read(&r, 1)) e->hp = e->max_hp;
+        else e->hp = (int16_t)((int32_t)net_bits_read(&r, NET_SNAP_BITS_HP) - NET_SNAP_HP_BIAS);
+        if (net_bits_read(&r, 1)) {
+            if (i == 0) return -1;
+            e->glyph       = s->entities[i - 1].glyph;
+            e->entity_type = s->entities[i - 1].entity_type;
+            e->flags       = s->entities[i - 1].flags;
+            e->sprite_id   = s->entities[i - 1].sprite_id;
+        } else {
+            e->glyph       = (uint8_t)net_bits_read(&r, NET_SNAP_BITS_GLYPH);
+            e->entity_type = (uint8_t)net_bits_read(&r, NET_SNAP_BITS_TYPE);
+            e->flags       = (uint8_t)net_bits_read(&r, NET_SNAP_BITS_FLAGS);
+            e->sprite_id   = (uint8_t)net_bits_read(&r, NET_SNAP_BITS_SPRITE);
+        }
+        if (r.overflow) return -1;
+    }
+    s->entity_count = count;
+
+    if ((r.pos + 7) / 8 != len) return -1;
+    if ((r.pos & 7) != 0 && net_bits_read(&r, 8 - (r.pos & 7)) != 0) return -1;
+    return 0;
+}
+
 /* =========================================================================
  * TICK-LEVEL COMMAND PROCESSOR
  *
@@ -396,41 +1302,183 @@ typedef struct {
     uint8_t  glyph;
 } NetEntity;
 
-#define NET_MAX_ENTITIES 64
+/* Entities live packed in entities[0..entity_count) with an id -> slot
+ * sparse map beside them (the SparseSet layout from include/marble_core.h),
+ * so lookup is O(1) and despawn is a swap-remove. Entity ids index the
+ * map directly and must be below NET_MAX_ENTITY_ID.
+ *
+ * A world holds up to NET_MAX_ENTITIES, far more than one snapshot's
+ * NET_MAX_SNAPSHOT_ENTS: clients are meant to get area-of-interest
+ * snapshots. Both builders report what didn't fit rather than dropping
+ * it silently (net_build_snapshot()'s return, NetInterest.truncated). */
+#ifndef NET_MAX_ENTITIES
+#define NET_MAX_ENTITIES  4096
+#endif
+#ifndef NET_MAX_ENTITY_ID
+#define NET_MAX_ENTITY_ID 65536
+#endif
+
+#if NET_MAX_ENTITIES >= 0xFFFF
+#error "NET_MAX_ENTITIES must fit the uint16_t slot map"
+#endif
+
+/* Interest grid: the map split into NET_AOI_CELL x NET_AOI_CELL tile
+ * cells, each holding an intrusive list of the entity slots inside it.
+ * Positions off the map clamp to the nearest edge cell. */
+#ifndef NET_AOI_CELL
+#define NET_AOI_CELL 4
+#endif
+#define NET_AOI_COLS  ((NET_MAP_W + NET_AOI_CELL - 1) / NET_AOI_CELL)
+#define NET_AOI_ROWS  ((NET_MAP_H + NET_AOI_CELL - 1) / NET_AOI_CELL)
+#define NET_AOI_CELLS (NET_AOI_COLS * NET_AOI_ROWS)
+#define NET_AOI_NONE  0xFFFF
 
 typedef struct {
-    NetEntity  entities[NET_MAX_ENTITIES];
+    NetEntity  entities[NET_MAX_ENTITIES];     /* dense, packed            */
+    uint16_t   slot_of[NET_MAX_ENTITY_ID];     /* sparse: id -> dense slot */
     uint32_t   entity_count;
     TileMap    map;
     uint32_t   tick;
     uint32_t   cmds_applied;
     uint32_t   cmds_rejected;
+    uint64_t   state_hash;   /* XOR of net_entity_hash() over entities */
+    uint16_t   aoi_head[NET_AOI_CELLS];        /* first slot in each cell  */
+    uint16_t   aoi_next[NET_MAX_ENTITIES];     /* per slot                 */
+    uint16_t   aoi_prev[NET_MAX_ENTITIES];
+    uint16_t   aoi_cell[NET_MAX_ENTITIES];
 } NetWorld;
 
 static inline void net_world_init(NetWorld* w) {
     memset(w, 0, sizeof(NetWorld));
+    memset(w->aoi_head, 0xFF, sizeof(w->aoi_head));
 }
 
-static inline NetEntity* net_world_find_entity(NetWorld* w, uint32_t id) {
+static inline uint32_t net_aoi_cell_of(int x, int y) {
+    int cx = x / NET_AOI_CELL, cy = y / NET_AOI_CELL;
+    if (x < 0) cx = 0;
+    if (y < 0) cy = 0;
+    if (cx >= NET_AOI_COLS) cx = NET_AOI_COLS - 1;
+    if (cy >= NET_AOI_ROWS) cy = NET_AOI_ROWS - 1;
+    return (uint32_t)(cy * NET_AOI_COLS + cx);
+}
+
+static inline void net_world__aoi_link(NetWorld* w, uint32_t slot) {
+    const NetEntity* e = &w->entities[slot];
+    uint32_t c = net_aoi_cell_of(e->x, e->y);
+    uint16_t head = w->aoi_head[c];
+    w->aoi_cell[slot] = (uint16_t)c;
+    w->aoi_prev[slot] = NET_AOI_NONE;
+    w->aoi_next[slot] = head;
+    if (head != NET_AOI_NONE) w->aoi_prev[head] = (uint16_t)slot;
+    w->aoi_head[c] = (uint16_t)slot;
+}
+
+static inline void net_world__aoi_unlink(NetWorld* w, uint32_t slot) {
+    uint16_t p = w->aoi_prev[slot], n = w->aoi_next[slot];
+    if (p != NET_AOI_NONE) w->aoi_next[p] = n;
+    else w->aoi_head[w->aoi_cell[slot]] = n;
+    if (n != NET_AOI_NONE) w->aoi_prev[n] = p;
+}
+
+/* Point the neighbours of the entity that was in slot `from` at `to`,
+ * after a swap-remove copied it there. */
+static inline void net_world__aoi_relocate(NetWorld* w, uint32_t from, uint32_t to) {
+    uint16_t p = w->aoi_prev[from], n = w->aoi_next[from];
+    w->aoi_prev[to] = p;
+    w->aoi_next[to] = n;
+    w->aoi_cell[to] = w->aoi_cell[from];
+    if (p != NET_AOI_NONE) w->aoi_next[p] = (uint16_t)to;
+    else w->aoi_head[w->aoi_cell[to]] = (uint16_t)to;
+    if (n != NET_AOI_NONE) w->aoi_prev[n] = (uint16_t)to;
+}
+
+/* Hash of one entity's replicated fields, packed little-endian so every
+ * peer hashes the same bytes. XOR-combined into NetWorld.state_hash: a
+ * mutation XORs the old value out and the new one in. */
+static inline uint64_t net_entity_hash(const NetEntity* e) {
+    uint8_t b[14];
+    net_put_u32(b, e->entity_id);
+    net_put_u16(b + 4, e->x);
+    net_put_u16(b + 6, e->y);
+    net_put_u16(b + 8, (uint16_t)e->hp);
+    net_put_u16(b + 10, (uint16_t)e->max_hp);
+    b[12] = e->alive;
+    b[13] = e->glyph;
+    return mc_hash64(b, sizeof(b), 0);
+}
+
+/* Full recompute; the running hash must always equal this. */
+static inline uint64_t net_world_compute_hash(const NetWorld* w) {
+    uint64_t h = 0;
     uint32_t i;
-    for (i = 0; i < w->entity_count; i++) {
-        if (w->entities[i].entity_id == id) return &w->entities[i];
-    }
-    return NULL;
+    for (i = 0; i < w->entity_count; i++) h ^= net_entity_hash(&w->entities[i]);
+    return h;
 }
 
+/* O(1). A stale map entry is harmless: the slot must be live and hold
+ * the same id to count as a hit. */
+static inline NetEntity* net_world_find_entity(NetWorld* w, uint32_t id) {
+    uint32_t slot;
+    if (id >= NET_MAX_ENTITY_ID) return NULL;
+    slot = w->slot_of[id];
+    if (slot >= w->entity_count || w->entities[slot].entity_id != id) return NULL;
+    return &w->entities[slot];
+}
+
+/* Returns 0, or -1 if the world is full, the id is out of range or the
+ * id is already present. */
 static inline int net_world_add_entity(NetWorld* w, uint32_t id, uint16_t x, uint16_t y,
                                         int16_t hp, int16_t max_hp, uint8_t glyph) {
+    NetEntity* e;
     if (w->entity_count >= NET_MAX_ENTITIES) return -1;
-    NetEntity* e = &w->entities[w->entity_count++];
+    if (id >= NET_MAX_ENTITY_ID || net_world_find_entity(w, id) != NULL) return -1;
+    w->slot_of[id] = (uint16_t)w->entity_count;
+    e = &w->entities[w->entity_count++];
     e->entity_id = id;
     e->x = x; e->y = y;
     e->hp = hp; e->max_hp = max_hp;
     e->alive = 1;
     e->glyph = glyph;
+    w->state_hash ^= net_entity_hash(e);
+    net_world__aoi_link(w, w->entity_count - 1);
+    return 0;
+}
+
+/* Despawn: the last entity moves into the freed slot. Snapshot order
+ * follows slot order, so it changes for the moved entity. Returns 0, or
+ * -1 if the id isn't present. */
+static inline int net_world_remove_entity(NetWorld* w, uint32_t id) {
+    NetEntity* e = net_world_find_entity(w, id);
+    uint32_t slot, last;
+    if (e == NULL) return -1;
+    w->state_hash ^= net_entity_hash(e);
+    slot = (uint32_t)(e - w->entities);
+    last = w->entity_count - 1;
+    net_world__aoi_unlink(w, slot);
+    if (slot != last) {
+        w->entities[slot] = w->entities[last];
+        w->slot_of[w->entities[slot].entity_id] = (uint16_t)slot;
+        net_world__aoi_relocate(w, last, slot);
+    }
+    w->entity_count--;
     return 0;
 }
 
+/* Move an entity, keeping state_hash and the interest grid current.
+ * Positions must change through here (or net_process_command) for
+ * net_build_snapshot_for() to see them. */
+static inline void net_world_set_position(NetWorld* w, NetEntity* e, uint16_t x, uint16_t y) {
+    uint32_t slot = (uint32_t)(e - w->entities);
+    w->state_hash ^= net_entity_hash(e);
+    e->x = x;
+    e->y = y;
+    w->state_hash ^= net_entity_hash(e);
+    if (net_aoi_cell_of(x, y) != w->aoi_cell[slot]) {
+        net_world__aoi_unlink(w, slot);
+        net_world__aoi_link(w, slot);
+    }
+}
+
 /* Validate + apply a single command against the world state.
  * Returns VALIDATE_OK if applied, or a failure code. */
 static inline ValidateResult net_process_command(NetWorld* w, const InteractionCommand* cmd) {
@@ -451,8 +1499,7 @@ static inline ValidateResult net_process_command(NetWorld* w, const InteractionC
 
         /* Check for entity collision (bump-to-attack becomes melee) */
         /* For now, just move */
-        actor->x = (uint16_t)nx;
-        actor->y = (uint16_t)ny;
+        net_world_set_position(w, actor, (uint16_t)nx, (uint16_t)ny);
         w->cmds_applied++;
         return VALIDATE_OK;
     }
@@ -462,11 +1509,13 @@ static inline ValidateResult net_process_command(NetWorld* w, const InteractionC
         if (!target) return VALIDATE_FAIL_NO_TARGET;
         if (!target->alive) return VALIDATE_FAIL_NO_TARGET;
         /* Simple damage for demo */
+        w->state_hash ^= net_entity_hash(target);
         target->hp -= 5;
         if (target->hp <= 0) {
             target->hp = 0;
             target->alive = 0;
         }
+        w->state_hash ^= net_entity_hash(target);
         w->cmds_applied++;
         return VALIDATE_OK;
     }
@@ -498,28 +1547,483 @@ static inline uint32_t net_tick(NetWorld* w, CommandQueue* q) {
     return applied;
 }
 
-/* Build a snapshot from current world state */
-static inline void net_build_snapshot(const NetWorld* w, Snapshot* s) {
+/* Replicated view of one entity */
+static inline void net_world__to_snapshot(const NetEntity* e, uint8_t type, SnapshotEntity* se) {
+    memset(se, 0, sizeof(*se));
+    se->entity_id   = e->entity_id;
+    se->x           = e->x;
+    se->y           = e->y;
+    se->hp          = e->hp;
+    se->max_hp      = e->max_hp;
+    se->glyph       = e->glyph;
+    se->entity_type = type;
+    se->flags       = e->alive ? 0x01 : 0x00;
+}
+
+/* Build a snapshot of the whole world. Every client gets every entity;
+ * see net_build_snapshot_for() for per-client filtering. A world can
+ * hold NET_MAX_ENTITIES but a snapshot only NET_MAX_SNAPSHOT_ENTS, so
+ * this returns how many entities (the highest slots) were left out:
+ * 0 means the snapshot is the whole world. */
+static inline uint32_t net_build_snapshot(const NetWorld* w, Snapshot* s) {
     uint32_t i;
     net_snapshot_init(s);
     s->tick_number = w->tick;
+    s->state_hash  = w->state_hash;
 
     for (i = 0; i < w->entity_count && i < NET_MAX_SNAPSHOT_ENTS; i++) {
-        const NetEntity* e = &w->entities[i];
         SnapshotEntity se;
-        memset(&se, 0, sizeof(se));
-        se.entity_id   = e->entity_id;
-        se.x           = e->x;
-        se.y           = e->y;
-        se.hp          = e->hp;
-        se.max_hp      = e->max_hp;
-        se.glyph       = e->glyph;
-        se.entity_type = (i == 0) ? 0 : 1; /* first entity = player */
-        se.flags       = e->alive ? 0x01 : 0x00;
+        net_world__to_snapshot(&w->entities[i], (i == 0) ? 0 : 1, &se); /* first entity = player */
+        net_snapshot_add_entity(s, &se);
+    }
+    return w->entity_count - s->entity_count;
+}
+
+/* =========================================================================
+ * AREA OF INTEREST
+ *
+ * Each client sees only what is near its avatar: entities within
+ * `radius` tiles (a square, like the move set), and with line_of_sight
+ * set, only those whose straight line from the viewer crosses no wall.
+ * The snapshot walks just the interest-grid cells that square overlaps,
+ * so its cost and size follow local density, not world population, and
+ * nothing outside the view is ever put on the wire.
+ *
+ * The previous tick's visible ids are kept sorted per client; each build
+ * diffs against them to produce enter/leave events.
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t viewer_id;
+    uint16_t radius;                                /* tiles               */
+    uint8_t  line_of_sight;                         /* nonzero: walls hide */
+    uint8_t  _pad;
+    uint32_t visible[NET_MAX_SNAPSHOT_ENTS];        /* sorted by id        */
+    uint32_t visible_count;
+    uint32_t entered[NET_MAX_SNAPSHOT_ENTS];        /* last build's events */
+    uint32_t entered_count;
+    uint32_t left[NET_MAX_SNAPSHOT_ENTS];
+    uint32_t left_count;
+    uint32_t truncated;                             /* visible, over cap   */
+} NetInterest;
+
+static inline void net_interest_init(NetInterest* in, uint32_t viewer_id, uint16_t radius,
+                                     uint8_t line_of_sight) {
+    memset(in, 0, sizeof(NetInterest));
+    in->viewer_id     = viewer_id;
+    in->radius        = radius;
+    in->line_of_sight = line_of_sight;
+}
+
+/* Bresenham walk from (x0,y0) to (x1,y1). Only the tiles strictly between
+ * the ends are tested, so a viewer can see an entity standing in a
+ * doorway. Off-map tiles block. */
+static inline int net_map_line_of_sight(const TileMap* m, int x0, int y0, int x1, int y1) {
+    int dx = (x1 > x0) ? x1 - x0 : x0 - x1;
+    int dy = (y1 > y0) ? y0 - y1 : y1 - y0;
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx + dy;
+    int x = x0, y = y0;
+    if (x0 == x1 && y0 == y1) return 1;
+    for (;;) {
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x += sx; }
+        if (e2 <= dx) { err += dx; y += sy; }
+        if (x == x1 && y == y1) return 1;
+        if (!net_map_walkable(m, x, y)) return 0;
+    }
+}
+
+/* Snapshot of what `in->viewer_id` can see, and in->entered / in->left
+ * relative to the previous call. The viewer is always included (as
+ * entity_type 0). Past NET_MAX_SNAPSHOT_ENTS further visible entities
+ * are counted in in->truncated instead. If the viewer doesn't exist the
+ * snapshot is empty, everything previously visible leaves, and -1 is
+ * returned. */
+static inline int net_build_snapshot_for(const NetWorld* w, NetInterest* in, Snapshot* s) {
+    uint32_t ids[NET_MAX_SNAPSHOT_ENTS];
+    uint16_t order[NET_MAX_SNAPSHOT_ENTS];
+    uint32_t slot, i, a, b;
+    int rc = -1;
+
+    net_snapshot_init(s);
+    s->tick_number = w->tick;
+    s->state_hash  = w->state_hash;
+    in->truncated  = 0;
+
+    slot = (in->viewer_id < NET_MAX_ENTITY_ID) ? w->slot_of[in->viewer_id] : NET_AOI_NONE;
+    if (slot < w->entity_count && w->entities[slot].entity_id == in->viewer_id) {
+        const NetEntity* v = &w->entities[slot];
+        int r = in->radius;
+        int x0 = (int)v->x - r, x1 = (int)v->x + r;
+        int y0 = (int)v->y - r, y1 = (int)v->y + r;
+        uint32_t c0 = net_aoi_cell_of(x0, y0), c1 = net_aoi_cell_of(x1, y1);
+        uint32_t cx, cy;
+        SnapshotEntity se;
+
+        net_world__to_snapshot(v, 0, &se);
         net_snapshot_add_entity(s, &se);
+        for (cy = c0 / NET_AOI_COLS; cy <= c1 / NET_AOI_COLS; cy++) {
+            for (cx = c0 % NET_AOI_COLS; cx <= c1 % NET_AOI_COLS; cx++) {
+                uint16_t k = w->aoi_head[cy * NET_AOI_COLS + cx];
+                for (; k != NET_AOI_NONE; k = w->aoi_next[k]) {
+                    const NetEntity* e = &w->entities[k];
+                    if (k == slot) continue;
+                    if ((int)e->x < x0 || (int)e->x > x1 || (int)e->y < y0 || (int)e->y > y1) continue;
+                    if (in->line_of_sight &&
+                        !net_map_line_of_sight(&w->map, v->x, v->y, e->x, e->y)) continue;
+                    net_world__to_snapshot(e, 1, &se);
+                    if (net_snapshot_add_entity(s, &se) != 0) in->truncated++;
+                }
+            }
+        }
+        rc = 0;
     }
+
+    /* Diff the sorted id lists: ids only in the new set entered, ids only
+     * in the old one left. */
+    net_snapshot__sort_ids(s, order);
+    for (i = 0; i < s->entity_count; i++) ids[i] = s->entities[order[i]].entity_id;
+    in->entered_count = in->left_count = 0;
+    a = b = 0;
+    while (a < in->visible_count || b < s->entity_count) {
+        if (b == s->entity_count || (a < in->visible_count && in->visible[a] < ids[b])) {
+            in->left[in->left_count++] = in->visible[a++];
+        } else if (a == in->visible_count || ids[b] < in->visible[a]) {
+            in->entered[in->entered_count++] = ids[b++];
+        } else {
+            a++;
+            b++;
+        }
+    }
+    memcpy(in->visible, ids, s->entity_count * sizeof(uint32_t));
+    in->visible_count = s->entity_count;
+    return rc;
 }
 
+/* =========================================================================
+ * PER-CLIENT INGRESS
+ *
+ * Each client gets its own small bounded queue instead of sharing one
+ * CommandQueue, so a client that floods only fills (and drops from) its
+ * own ring. The tick drains the queues deficit-round-robin: every
+ * backlogged client may run up to `quantum` commands per round, rounds
+ * repeat until the queues are empty or the tick budget is spent, and the
+ * next tick starts after the last client served. Tick cost stays bounded
+ * by the budget, and under overload every client gets an equal share.
+ *
+ * A token bucket per client limits the sustained rate: `rate` tokens per
+ * tick up to `burst`, in 1/NET_RATE_ONE command units, refilled lazily on
+ * push. A command with no token is refused and counted, before it ever
+ * takes a queue slot.
+ *
+ * A client's queue is only written by that client's connection, so
+ * ingress for different clients touches disjoint state; there is no
+ * shared queue or lock.
+ * ========================================================================= */
+
+#ifndef NET_MAX_CLIENTS
+#define NET_MAX_CLIENTS     64
+#endif
+#ifndef NET_CLIENT_QUEUE
+#define NET_CLIENT_QUEUE    32    /* commands buffered per client        */
+#endif
+#define NET_DRR_QUANTUM      4    /* commands per client per round       */
+#define NET_TICK_BUDGET      NET_MAX_CMD_QUEUE  /* commands per tick, all clients */
+#define NET_RATE_ONE       256    /* token units per command             */
+#define NET_RATE_DEFAULT   (2 * NET_RATE_ONE)   /* sustained: 2 per tick */
+#define NET_BURST_DEFAULT  (8 * NET_RATE_ONE)
+
+typedef struct {
+    InteractionCommand cmds[NET_CLIENT_QUEUE];
+    uint32_t head;
+    uint32_t count;
+    uint32_t deficit;        /* commands owed from an interrupted round */
+    uint32_t tokens;         /* NET_RATE_ONE per command                */
+    uint32_t refill_tick;    /* ingress tick tokens were last topped up */
+    uint8_t  connected;
+    uint16_t last_sequence;  /* of the newest command drained           */
+    uint32_t accepted;
+    uint32_t dropped_full;
+    uint32_t dropped_rate;
+    uint32_t drained;
+} NetClientQueue;
+
+typedef struct {
+    NetClientQueue clients[NET_MAX_CLIENTS];
+    uint32_t next_client;    /* where the next tick's first round starts */
+    uint32_t quantum;
+    uint32_t rate;
+    uint32_t burst;
+    uint32_t tick;
+} NetIngress;
+
+/* quantum 0 -> NET_DRR_QUANTUM; rate/burst 0 -> the defaults */
+static inline void net_ingress_init(NetIngress* in, uint32_t quantum, uint32_t rate, uint32_t burst) {
+    memset(in, 0, sizeof(NetIngress));
+    in->quantum = quantum ? quantum : NET_DRR_QUANTUM;
+    in->rate    = rate ? rate : NET_RATE_DEFAULT;
+    in->burst   = burst ? burst : NET_BURST_DEFAULT;
+}
+
+/* Start a client with an empty queue, zeroed counters and a full bucket.
+ * Returns 0, or -1 for a bad client index. */
+static inline int net_ingress_connect(NetIngress* in, uint32_t client) {
+    NetClientQueue* c;
+    if (client >= NET_MAX_CLIENTS) return -1;
+    c = &in->clients[client];
+    memset(c, 0, sizeof(*c));
+    c->connected   = 1;
+    c->tokens      = in->burst;
+    c->refill_tick = in->tick;
+    return 0;
+}
+
+/* Drop the client and anything it still has queued */
+static inline void net_ingress_disconnect(NetIngress* in, uint32_t client) {
+    if (client < NET_MAX_CLIENTS) in->clients[client].connected = 0;
+}
+
+static inline void net_ingress__refill(const NetIngress* in, NetClientQueue* c) {
+    uint32_t elapsed = in->tick - c->refill_tick;
+    c->refill_tick = in->tick;
+    if (elapsed >= (in->burst / in->rate) + 1) {
+        c->tokens = in->burst;
+    } else {
+        c->tokens += elapsed * in->rate;
+        if (c->tokens > in->burst) c->tokens = in->burst;
+    }
+}
+
+/* Queue a command from `client`. Returns 0, or -1 if the client isn't
+ * connected, is over its rate (dropped_rate) or its queue is full
+ * (dropped_full). */
+static inline int net_ingress_push(NetIngress* in, uint32_t client, const InteractionCommand* cmd) {
+    NetClientQueue* c;
+    if (client >= NET_MAX_CLIENTS || !in->clients[client].connected) return -1;
+    c = &in->clients[client];
+    net_ingress__refill(in, c);
+    if (c->tokens < NET_RATE_ONE) {
+        c->dropped_rate++;
+        return -1;
+    }
+    if (c->count >= NET_CLIENT_QUEUE) {
+        c->dropped_full++;
+        return -1;
+    }
+    c->tokens -= NET_RATE_ONE;
+    c->cmds[(c->head + c->count) % NET_CLIENT_QUEUE] = *cmd;
+    c->count++;
+    c->accepted++;
+    return 0;
+}
+
+/* Decode a batch (net_batch_read) and queue its commands. Returns how
+ * many were queued, or -1 for a malformed packet. */
+static inline int net_ingress_push_batch(NetIngress* in, uint32_t client, const uint8_t* buf, uint32_t len) {
+    InteractionCommand cmds[NET_BATCH_MAX_CMDS];
+    int n = net_batch_read(buf, len, cmds, NET_BATCH_MAX_CMDS);
+    int i, pushed = 0;
+    for (i = 0; i < n; i++) {
+        if (net_ingress_push(in, client, &cmds[i]) == 0) pushed++;
+    }
+    return (n < 0) ? -1 : pushed;
+}
+
+/* Take this tick's commands in deficit-round-robin order, at most
+ * min(cap, NET_TICK_BUDGET). Commands left over wait for the next tick.
+ * Advances the ingress tick (token refills count in ticks). */
+static inline uint32_t net_ingress_drain(NetIngress* in, InteractionCommand* out, uint32_t cap) {
+    uint32_t budget = (cap < NET_TICK_BUDGET) ? cap : NET_TICK_BUDGET;
+    uint32_t n = 0, idle = 0, k = in->next_client;
+
+    /* Stop once a full lap finds nothing to take */
+    while (n < budget && idle < NET_MAX_CLIENTS) {
+        NetClientQueue* c = &in->clients[k];
+        uint32_t next = (k + 1) % NET_MAX_CLIENTS;
+        if (!c->connected || c->count == 0) {
+            c->deficit = 0;
+            idle++;
+            k = next;
+            continue;
+        }
+        idle = 0;
+        if (c->deficit == 0) c->deficit = in->quantum;
+        while (c->deficit > 0 && c->count > 0 && n < budget) {
+            out[n] = c->cmds[c->head];
+            c->last_sequence = out[n].sequence;
+            c->head = (c->head + 1) % NET_CLIENT_QUEUE;
+            c->count--;
+            c->deficit--;
+            c->drained++;
+            n++;
+        }
+        if (c->count == 0) c->deficit = 0;
+        if (c->deficit > 0) break;    /* budget ran out mid-turn: resume here */
+        k = next;
+    }
+    in->next_client = k;
+    in->tick++;
+    return n;
+}
+
+/* net_tick() over per-client queues: drain fairly, then validate and
+ * apply in drained order. Returns count applied. */
+static inline uint32_t net_tick_ingress(NetWorld* w, NetIngress* in) {
+    InteractionCommand cmds[NET_TICK_BUDGET];
+    uint32_t n = net_ingress_drain(in, cmds, NET_TICK_BUDGET);
+    uint32_t applied = 0, i;
+    for (i = 0; i < n; i++) {
+        if (net_process_command(w, &cmds[i]) == VALIDATE_OK) {
+            applied++;
+        } else {
+            w->cmds_rejected++;
+        }
+    }
+    w->tick++;
+    return applied;
+}
+
+/* =========================================================================
+ * MPSC INGRESS RING
+ *
+ * Lets socket threads hand commands to the simulation without a lock.
+ * Any number of producers push; the tick thread is the only consumer.
+ *
+ *   Producer  claims k slots at once with one CAS on `tail` (k = what
+ *             fits), fills them, then publishes each by storing its
+ *             sequence number (release). It never waits on the consumer:
+ *             a full ring drops the excess and counts it.
+ *   Consumer  at tick start, takes slots in order while each is
+ *             published (acquire), then frees them all with one store
+ *             to `head`. A slot claimed but not yet written stops the
+ *             drain there; it's picked up next tick.
+ *
+ * head, tail and the drop counter each sit on their own cache line so
+ * producers don't invalidate the consumer's line. Positions are free-
+ * running uint32; NET_MPSC_CAP must be a power of two so they wrap
+ * cleanly.
+ *
+ * Atomics come from marble_atomic.h (McAtomicU32).
+ * ========================================================================= */
+
+#ifndef NET_MPSC_CAP
+#define NET_MPSC_CAP   1024
+#endif
+#define NET_CACHE_LINE   64
+
+#if (NET_MPSC_CAP & (NET_MPSC_CAP - 1)) != 0
+#error "NET_MPSC_CAP must be a power of two"
+#endif
+
+typedef struct {
+    InteractionCommand cmd;
+    uint32_t           client;
+    McAtomicU32        ready;    /* position + 1 once written */
+} NetMpscSlot;
+
+typedef struct {
+    uint8_t     _pad0[NET_CACHE_LINE];
+    McAtomicU32 tail;         /* next position to claim (producers) */
+    uint8_t     _pad1[NET_CACHE_LINE - sizeof(McAtomicU32)];
+    McAtomicU32 head;         /* next position to read (consumer)   */
+    uint8_t     _pad2[NET_CACHE_LINE - sizeof(McAtomicU32)];
+    McAtomicU32 dropped;      /* commands refused: ring full        */
+    uint8_t     _pad3[NET_CACHE_LINE - sizeof(McAtomicU32)];
+    NetMpscSlot slots[NET_MPSC_CAP];
+} NetMpscRing;
+
+/* Not thread-safe: call before any producer starts. Slot i starts
+ * unpublished (ready == 0 never matches position + 1 on the first lap). */
+static inline void net_mpsc_init(NetMpscRing* r) {
+    memset(r, 0, sizeof(NetMpscRing));
+}
+
+/* Any thread. Enqueue n commands from `client`, in order. Returns how
+ * many fit; the rest are counted in `dropped`. Never blocks: a failed
+ * CAS means another producer claimed first, and the retry re-reads. */
+static inline uint32_t net_mpsc_push(NetMpscRing* r, uint32_t client,
+                                     const InteractionCommand* cmds, uint32_t n) {
+    uint32_t t = mc_atomic_load_relaxed(&r->tail);
+    uint32_t k, i;
+    for (;;) {
+        uint32_t used = t - mc_atomic_load_acquire(&r->head);
+        if (used > NET_MPSC_CAP) {              /* t is older than head: reload */
+            t = mc_atomic_load_relaxed(&r->tail);
+            continue;
+        }
+        k = (n < NET_MPSC_CAP - used) ? n : NET_MPSC_CAP - used;
+        if (k == 0 || mc_atomic_cas(&r->tail, &t, t + k)) break;
+    }
+    for (i = 0; i < k; i++) {
+        NetMpscSlot* s = &r->slots[(t + i) & (NET_MPSC_CAP - 1)];
+        s->cmd    = cmds[i];
+        s->client = client;
+        mc_atomic_store_release(&s->ready, t + i + 1);
+    }
+    if (k < n) (void)mc_atomic_fetch_add_relaxed(&r->dropped, n - k);
+    return k;
+}
+
+/* Tick thread only. Take up to `cap` published commands in claim order.
+ * clients[] (may be NULL) receives each command's client. */
+static inline uint32_t net_mpsc_drain(NetMpscRing* r, InteractionCommand* out,
+                                      uint32_t* clients, uint32_t cap) {
+    uint32_t h = mc_atomic_load_relaxed(&r->head);
+    uint32_t n = 0;
+    while (n < cap) {
+        NetMpscSlot* s = &r->slots[h & (NET_MPSC_CAP - 1)];
+        if (mc_atomic_load_acquire(&s->ready) != h + 1) break;
+        out[n] = s->cmd;
+        if (clients != NULL) clients[n] = s->client;
+        n++;
+        h++;
+    }
+    if (n > 0) mc_atomic_store_release(&r->head, h);
+    return n;
+}
+
+/* Tick start: move everything the socket threads published into the
+ * per-client queues (rate limits and queue bounds apply there). Returns
+ * commands moved, including ones the client queues then refused. */
+static inline uint32_t net_ingress_receive(NetIngress* in, NetMpscRing* r) {
+    InteractionCommand cmds[NET_TICK_BUDGET];
+    uint32_t clients[NET_TICK_BUDGET];
+    uint32_t total = 0, n, i;
+    do {
+        n = net_mpsc_drain(r, cmds, clients, NET_TICK_BUDGET);
+        for (i = 0; i < n; i++) net_ingress_push(in, clients[i], &cmds[i]);
+        total += n;
+    } while (n == NET_TICK_BUDGET && total < NET_MPSC_CAP);
+    return total;
+}
+
+/* =========================================================================
+ * SERVER MESSAGES
+ *
+ * What src/net_server.c and its clients exchange, one binary WebSocket
+ * message each, tagged by the first byte:
+ *
+ *   client -> server
+ *     NET_MSG_COMMANDS  batch packet (net_batch_write); the server acts
+ *                       as the connection's own entity whatever id the
+ *                       batch names
+ *     NET_MSG_ACK       u32 tick of the newest snapshot decoded
+ *   server -> client
+ *     NET_MSG_WELCOME   u32 your entity_id, u16 view radius, u16 map w,
+ *                       u16 map h, then w*h tiles row-major (0 floor)
+ *     NET_MSG_SNAPSHOT  delta frame (net_snapshot_write_for_client) of
+ *                       what your entity can see
+ * ========================================================================= */
+
+#define NET_MSG_COMMANDS   0x01
+#define NET_MSG_ACK        0x02
+#define NET_MSG_WELCOME    0x81
+#define NET_MSG_SNAPSHOT   0x82
+
+#define NET_WELCOME_SIZE   (11 + NET_MAP_W * NET_MAP_H)
+
 /* =========================================================================
  * STRING TABLES (implementation in guarded block)
  * ========================================================================= */
@@ -67,7 +67,7 @@ if "!EMCC_PATH!"=="" (
 set "PATH=!EMCC_PATH!;%EMSDK_DIR%;%PATH%"
 
 echo [BUILD] emcc -std=c99 -O2 test_net.c -o test_net.js
-call emcc -std=c99 -O2 test_net.c -o test_net.js -sENVIRONMENT=node
+call emcc -std=c99 -O2 test_net.c -o test_net.js -Iinclude -sENVIRONMENT=node
 if %ERRORLEVEL% neq 0 goto :web_fail
 echo [BUILD] OK
 echo.
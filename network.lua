@@ -149,6 +149,127 @@ function M.unpackCommand(data)
     }
 end
 
+-- =========================================================================
+-- BATCHED PACKETS (matches net_batch_write / net_batch_read in C)
+--
+-- varint count, varint entity_id, varint base_sequence, then per command
+-- the opcode byte and only the fields its layout carries.
+-- =========================================================================
+
+M.BATCH_MAX_CMDS = M.MAX_CMD_QUEUE
+
+local F_PARAM1, F_TX, F_TY, F_TID = 1, 2, 4, 8
+
+local BATCH_LAYOUT = {
+    [M.OP.TELEPORT] = F_TX + F_TY,
+    [M.OP.INTERACT_DOOR] = F_TX + F_TY, [M.OP.SEARCH] = F_TX + F_TY,
+    [M.OP.DISARM_TRAP] = F_TX + F_TY,   [M.OP.ACTIVATE] = F_TX + F_TY,
+    [M.OP.MELEE_ATTACK] = F_TID,
+    [M.OP.ARENA_CHALLENGE] = F_TID, [M.OP.ARENA_ACCEPT] = F_TID, [M.OP.ARENA_DECLINE] = F_TID,
+    [M.OP.RANGED_ATTACK] = F_TX + F_TY + F_TID,
+    [M.OP.USE_SKILL] = F_PARAM1 + F_TID,
+    [M.OP.PICK_UP] = F_PARAM1 + F_TID, [M.OP.DROP] = F_PARAM1 + F_TID,
+    [M.OP.EQUIP] = F_PARAM1 + F_TID,   [M.OP.CONSUME] = F_PARAM1 + F_TID,
+    [M.OP.USE_ITEM] = F_PARAM1 + F_TID,
+    [M.OP.DEFEND] = 0, [M.OP.USE_MEDKIT] = 0,
+    [M.OP.HEARTBEAT] = 0, [M.OP.LOGIN] = 0, [M.OP.LOGOUT] = 0,
+    [M.OP.SYNC_REQUEST] = 0, [M.OP.NOP] = 0,
+}
+
+function M.batchLayout(op)
+    local m = BATCH_LAYOUT[op]
+    if m then return m end
+    if op < M.OP.TELEPORT then return 0 end  -- plain moves, stairs
+    return F_PARAM1 + F_TX + F_TY + F_TID
+end
+
+local function has(mask, bit) return math.floor(mask / bit) % 2 == 1 end
+
+local function varint(v)
+    local out = {}
+    repeat
+        local b = v % 128
+        v = math.floor(v / 128)
+        out[#out + 1] = string.char(v > 0 and b + 128 or b)
+    until v == 0
+    return table.concat(out)
+end
+
+local function read_varint(s, pos)
+    local v, mul = 0, 1
+    for i = 1, 5 do
+        local b = string.byte(s, pos)
+        if not b then return nil end
+        if i == 5 and b > 0x0F then return nil end   -- wider than 32 bits
+        pos = pos + 1
+        v = v + (b % 128) * mul
+        if b < 128 then return v, pos end
+        mul = mul * 128
+    end
+    return nil
+end
+
+-- Pack commands from one entity with consecutive sequence numbers.
+-- Returns the packet string, or nil and a reason.
+function M.packBatch(cmds)
+    local n = #cmds
+    if n == 0 or n > M.BATCH_MAX_CMDS then return nil, "bad batch size: " .. n end
+    local eid, seq = cmds[1].entity_id, cmds[1].sequence
+    local parts = { varint(n), varint(eid), varint(seq) }
+    for i, cmd in ipairs(cmds) do
+        local m = M.batchLayout(cmd.opcode)
+        if cmd.entity_id ~= eid then return nil, "mixed entities" end
+        if cmd.sequence ~= (seq + i - 1) % 65536 then return nil, "sequence gap" end
+        if (cmd.param1 ~= 0 and not has(m, F_PARAM1)) or (cmd.target_x ~= 0 and not has(m, F_TX))
+            or (cmd.target_y ~= 0 and not has(m, F_TY)) or (cmd.target_id ~= 0 and not has(m, F_TID)) then
+            return nil, "field not in layout: " .. M.debugCommand(cmd)
+        end
+        parts[#parts + 1] = string.char(cmd.opcode)
+        if has(m, F_PARAM1) then parts[#parts + 1] = string.char(cmd.param1) end
+        if has(m, F_TX)     then parts[#parts + 1] = varint(cmd.target_x) end
+        if has(m, F_TY)     then parts[#parts + 1] = varint(cmd.target_y) end
+        if has(m, F_TID)    then parts[#parts + 1] = varint(cmd.target_id) end
+    end
+    return table.concat(parts)
+end
+
+function M.unpackBatch(data)
+    local n, eid, seq
+    local pos = 1
+    n, pos = read_varint(data, pos)
+    if not n or n == 0 or n > M.BATCH_MAX_CMDS then return nil, "bad batch header" end
+    eid, pos = read_varint(data, pos)
+    if not eid then return nil, "truncated header" end
+    seq, pos = read_varint(data, pos)
+    if not seq or seq > 65535 then return nil, "bad base sequence" end
+    local cmds = {}
+    for i = 1, n do
+        local op = string.byte(data, pos)
+        if not op then return nil, "truncated batch" end
+        pos = pos + 1
+        local cmd = { entity_id = eid, opcode = op, param1 = 0, target_x = 0, target_y = 0,
+                      target_id = 0, sequence = (seq + i - 1) % 65536 }
+        local m = M.batchLayout(op)
+        if has(m, F_PARAM1) then
+            cmd.param1 = string.byte(data, pos)
+            if not cmd.param1 then return nil, "truncated batch" end
+            pos = pos + 1
+        end
+        for _, f in ipairs({ { F_TX, "target_x", 65535 }, { F_TY, "target_y", 65535 },
+                             { F_TID, "target_id", 4294967295 } }) do
+            if has(m, f[1]) then
+                local v
+                v, pos = read_varint(data, pos)
+                if not v or v > f[3] then return nil, "bad " .. f[2] end
+                cmd[f[2]] = v
+            end
+        end
+        cmds[i] = cmd
+    end
+    if pos ~= #data + 1 then return nil, "trailing bytes" end
+    return cmds
+end
+
 -- =========================================================================
 -- BRIDGE SUBMISSION
 -- =========================================================================
@@ -183,6 +304,23 @@ function M.submitMove(entity_id, keyName)
     return false
 end
 
+-- Send one tick's commands as a single batch packet when the bridge
+-- accepts them; otherwise (or if they can't share a batch) one by one.
+function M.submitBatch(cmds)
+    local packed = (#cmds > 0) and M.packBatch(cmds)
+    if packed and bridge and bridge.submitBatch then
+        local ok = bridge.submitBatch(packed)
+        if ok then queue_stats.submitted = queue_stats.submitted + #cmds
+        else queue_stats.dropped = queue_stats.dropped + #cmds end
+        return ok
+    end
+    local all_ok = true
+    for _, cmd in ipairs(cmds) do
+        if not M.submitCommand(cmd) then all_ok = false end
+    end
+    return all_ok
+end
+
 -- =========================================================================
 -- SNAPSHOT (C -> Lua, read-only)
 -- =========================================================================
@@ -254,6 +392,21 @@ function M.selfTest()
     check("HEARTBEAT is sys",  M.isSystem(M.OP.HEARTBEAT), true)
     check("MELEE not movement", M.isMovement(M.OP.MELEE_ATTACK), false)
 
+    -- Batch: byte-exact with net_batch_write (test_net.c uses the same vector)
+    local b = { M.moveNorth(300), M.heartbeat(300), M.meleeAttack(300, 7), M.useItem(300, 2) }
+    for i, c in ipairs(b) do c.sequence = 999 + i end
+    local pb = M.packBatch(b)
+    check("batch bytes", pb, string.char(4, 0xAC, 0x02, 0xE8, 0x07, 0x00, 0xF0, 0x10, 0x07, 0x34, 0x02, 0x00))
+    local rb = M.unpackBatch(pb)
+    check("batch count", rb and #rb, 4)
+    check("batch target_id", rb and rb[3].target_id, 7)
+    check("batch param1", rb and rb[4].param1, 2)
+    check("batch sequence", rb and rb[4].sequence, 1003)
+    check("batch truncated", M.unpackBatch(pb:sub(1, #pb - 1)), nil)
+    check("batch trailing", M.unpackBatch(pb .. "\0"), nil)
+    b[2].target_x = 5
+    check("batch field outside layout", M.packBatch(b), nil)
+
     -- Queue overflow
     M.clearLocalQueue(); M.resetSequence()
     queue_stats.submitted = 0; queue_stats.dropped = 0
@@ -9,6 +9,8 @@
 -- Usage:
 --   lua marble_compile.lua oak_forest.marble
 --   lua marble_compile.lua oak_forest.marble -o marble_gen.h
+--   lua marble_compile.lua oak_forest.marble -o marble_gen.h --mbin oak_forest.mbin
+--   lua marble_compile.lua oak_forest.marble --recipes marble_gen_recipes.h
 --
 -- Compatible with Lua 5.3+ (also works under texlua/luatex)
 --
@@ -25,6 +27,10 @@
 --   - SystemID enum + SYSTEM_FREQ[]
 --   - Layer template initializer functions
 --   - World config #defines
+--   - RecipeDef table GEN_RECIPES[] (only if recipes are declared);
+--     --recipes also writes it alone, for TUs using marble_craft.h
+--   - (--mbin) binary world manifest: entity components pre-packed
+--     per pool, loaded by Loader_LoadWorldBinary (marble_mbin.h)
 --
 -- WHAT IT DOES NOT GENERATE (yet):
 --   - component struct definitions (Phase 2)
@@ -100,6 +106,8 @@ local function parse(source)
         systems = {},
         layers = {},
         rules = {},
+        recipes = {},
+        entities = {},
     }
 
     local i = 1
@@ -369,9 +377,51 @@ local function parse(source)
                     i = i + 1
                 end
                 ast.rules[#ast.rules + 1] = block
+            elseif keyword == "recipe" then
+                -- recipe Name { output <def_id> / yield <n> /
+                --               item <def_id> count <n> / tag <ItemTag> count <n> }
+                local block = { name = tokens[2], output = 0, yield = 1, ingredients = {} }
+                i = i + 1
+                while i <= #lines do
+                    local t = tokenize_line(lines[i])
+                    if #t >= 1 and t[1] == "}" then break end
+                    if #t >= 2 then
+                        if t[1] == "output" then
+                            block.output = tonumber(t[2]) or 0
+                        elseif t[1] == "yield" then
+                            block.yield = tonumber(t[2]) or 1
+                        elseif t[1] == "item" or t[1] == "tag" then
+                            local cnt = 1
+                            if t[3] == "count" then cnt = tonumber(t[4]) or 1 end
+                            block.ingredients[#block.ingredients + 1] = {
+                                kind = t[1], key = t[2], count = cnt
+                            }
+                        end
+                    end
+                    i = i + 1
+                end
+                ast.recipes[#ast.recipes + 1] = block
+
+            elseif keyword == "entity" then
+                -- entity Name { <Component> { ... } | <Component> template <Layer> }
+                -- Components are kept raw; only --mbin encodes them.
+                local block = { name = tokens[2], comps = {} }
+                i = i + 1
+                while i <= #lines do
+                    local t = tokenize_line(lines[i])
+                    if #t >= 1 and t[1] == "}" then break end
+                    if #t >= 1 then
+                        block.comps[#block.comps + 1] = {
+                            kind = t[1],
+                            body = lines[i]:match("{(.-)}") or "",
+                            template = lines[i]:match("template%s+([%w_]+)"),
+                        }
+                    end
+                    i = i + 1
+                end
+                ast.entities[#ast.entities + 1] = block
 
             end
-            -- entity blocks: skip for now (Phase 2)
         end
 
         i = i + 1
@@ -400,6 +450,92 @@ local function find_index(list, name)
     return nil
 end
 
+-- ItemTag bit order -- must match the ItemTag enum in marble_items.h
+local ITEM_TAGS = {
+    "Weapon", "Metal", "Consumable", "Liquid", "Healing", "Food",
+    "Container", "Glass", "Crafting", "Trash", "Sharp", "Material",
+    "Organic", "Seed", "Plant", "Tool", "Fire", "Magic", "Document",
+    "Leather", "Ore", "Refined", "Spoiled", "Rare", "Blunt", "Bone",
+    "Inscribed", "Light", "Burning", "Meat", "Fruit",
+}
+
+local function item_tag_bit(name)
+    for idx, tag in ipairs(ITEM_TAGS) do
+        if tag == name then return idx - 1 end
+    end
+    return nil
+end
+
+-- ============================================================
+-- RECIPE TABLE
+--
+-- GEN_RECIPES[] over the RecipeDef in marble_recipe.h, the same
+-- type marble_craft.h uses. Guarded, so it can sit both in
+-- marble_gen.h and in a standalone --recipes header; the latter
+-- is what a TU that also includes marble_craft.h pulls in.
+-- ============================================================
+
+local function recipe_lines(ast)
+    local out = {}
+    local function emit(s) out[#out + 1] = s end
+    local function emitf(fmt, ...) out[#out + 1] = string.format(fmt, ...) end
+    if #ast.recipes == 0 then return out end
+
+    emit("/* ---- Crafting Recipes ---- */")
+    emit("#ifndef MARBLE_GEN_RECIPES_H")
+    emit("#define MARBLE_GEN_RECIPES_H")
+    emit("")
+    emit('#include "marble_recipe.h"')
+    emit("")
+    emitf("#define GEN_RECIPE_COUNT %d", #ast.recipes)
+    emit("")
+    emitf("static const RecipeDef GEN_RECIPES[%d] = {", #ast.recipes)
+    for idx, rec in ipairs(ast.recipes) do
+        if #rec.ingredients == 0 or #rec.ingredients > 6 then
+            io.stderr:write("ERROR: recipe " .. rec.name .. " needs 1-6 ingredients\n")
+            os.exit(1)
+        end
+        emitf("    /* %s */ {", rec.name)
+        emitf("        %d, %d, %d,", idx, rec.output, rec.yield)
+        emit("        {")
+        for _, ing in ipairs(rec.ingredients) do
+            if ing.kind == "tag" then
+                local bit = item_tag_bit(ing.key)
+                if not bit then
+                    io.stderr:write("ERROR: recipe " .. rec.name .. ": unknown tag " .. ing.key .. "\n")
+                    os.exit(1)
+                end
+                emitf("            { RECIPE_ING_TAG, (1u << %d) /*TAG_%s*/, %d },", bit, to_upper_snake(ing.key), ing.count)
+            else
+                emitf("            { RECIPE_ING_ITEM, %d, %d },", tonumber(ing.key) or 0, ing.count)
+            end
+        end
+        emitf("        }, %d", #rec.ingredients)
+        emit("    },")
+    end
+    emit("};")
+    emit("")
+    emit("#endif /* MARBLE_GEN_RECIPES_H */")
+    emit("")
+    return out
+end
+
+local function generate_recipes(ast)
+    local lines = {
+        "/*",
+        " * marble_gen_recipes.h -- AUTO-GENERATED by marble_compile.lua v" .. VERSION,
+        " * Source: " .. (ast._source_file or "unknown"),
+        " * DO NOT EDIT -- regenerate from .marble source",
+        " *",
+        " * Recipes only: safe to include next to marble_craft.h, then",
+        " *   mc_recipe_table_load(&table, GEN_RECIPES, GEN_RECIPE_COUNT);",
+        " */",
+        "",
+    }
+    for _, line in ipairs(recipe_lines(ast)) do lines[#lines + 1] = line end
+    return table.concat(lines, "\n") .. "\n"
+end
+
 -- ============================================================
 -- CODE GENERATOR v0.2
 --
@@ -727,6 +863,9 @@ local function generate(ast)
         emit("")
     end
 
+    -- RECIPE DATA (RecipeDef from marble_recipe.h)
+    for _, line in ipairs(recipe_lines(ast)) do emit(line) end
+
     -- CONDITION EVALUATOR
     emit("/* ---- Condition Evaluator (generated) ---- */")
     emit("static int gen_evaluate_condition(ConditionID cond, EntityID actor, EntityID target, const SparseSet* pool_tool, const SparseSet* pool_layers) {")
@@ -762,6 +901,172 @@ local function generate(ast)
     return table.concat(out, "\n") .. "\n"
 end
 
+-- ============================================================
+-- BINARY MANIFEST WRITER (.mbin)
+--
+-- Mirrors marble_mbin.h: 32-byte header, 32-byte pool descriptors,
+-- then per pool a 64-byte aligned dense[] block and data[] block.
+-- Component payloads are packed to match the C structs byte for byte
+-- (all fields are 4-byte ints/floats/enums, so there is no padding).
+-- ============================================================
+
+local MBIN_MAGIC   = 0x4E49424D  -- "MBIN"
+local MBIN_VERSION = 1
+local MBIN_ALIGN   = 64
+
+-- Must match the ComponentType enum in marble_loader.h
+local COMP_TYPES = {
+    Health = 0, Position = 1, Layers = 2, Skills = 3, Anatomy = 4,
+    Capabilities = 5, Affordances = 6, Tool = 7, BodyParts = 8, Behavior = 9,
+}
+
+local function mbin_fail(ent, msg)
+    io.stderr:write("ERROR: entity " .. ent.name .. ": " .. msg .. "\n")
+    os.exit(1)
+end
+
+local function mbin_lookup(ent, list, name, what)
+    local idx = find_index(list, name)
+    if not idx then mbin_fail(ent, "unknown " .. what .. " " .. name) end
+    return idx
+end
+
+local function mbin_fields(body)
+    local f = {}
+    for k, v in body:gmatch("([%w_]+)%s+([%-%d%.]+)") do f[k] = tonumber(v) end
+    return f
+end
+
+-- Encode one component; returns the packed struct bytes.
+local function mbin_encode(ast, ent, comp)
+    local w = ast.world or {}
+    local max_layers = w.max_layers or 4
+    local max_skills = w.max_skills or 8
+    local max_parts  = w.max_body_parts or 6
+    local k = comp.kind
+
+    if k == "Health" then
+        local f = mbin_fields(comp.body)
+        return string.pack("<i4i4", f.hp or 0, f.max_hp or 0)
+    elseif k == "Position" then
+        local f = mbin_fields(comp.body)
+        return string.pack("<ff", f.x or 0, f.y or 0)
+    elseif k == "Anatomy" or k == "Capabilities" or k == "Affordances" then
+        local flags = 0
+        for name in comp.body:gmatch("[%w_]+") do
+            if k == "Anatomy" then
+                flags = flags | (1 << (mbin_lookup(ent, ast.anatomy, name, "anatomy") - 1))
+            elseif k == "Capabilities" then
+                flags = flags | (1 << mbin_lookup(ent, ast.capabilities, name, "capability"))
+            else
+                flags = flags | (1 << mbin_lookup(ent, ast.affordances, name, "affordance"))
+            end
+        end
+        return string.pack("<I4", flags)
+    elseif k == "Skills" then
+        local level = {}
+        for idx = 0, max_skills - 1 do level[idx] = 0 end
+        for name, lv in comp.body:gmatch("([%w_]+)%s+(%-?%d+)") do
+            level[mbin_lookup(ent, ast.skills, name, "skill")] = tonumber(lv)
+        end
+        local parts = {}
+        for idx = 0, max_skills - 1 do parts[#parts + 1] = string.pack("<i4", level[idx]) end
+        return table.concat(parts)
+    elseif k == "Tool" then
+        local mat = comp.body:match("material%s+([%w_]+)")
+        return string.pack("<I4", mat and mbin_lookup(ent, ast.materials, mat, "material") or 0)
+    elseif k == "BodyParts" then
+        local slot = {}
+        for idx = 0, max_parts - 1 do slot[idx] = 0xFFFFFFFF end
+        for part, ref in comp.body:gmatch("([%w_]+)%s*%->%s*@([%w_]+)") do
+            local bp = mbin_lookup(ent, ast.bodyparts, part, "body part")
+            slot[bp] = mbin_lookup(ent, ast.entities, ref, "entity reference") - 1
+        end
+        local parts = {}
+        for idx = 0, max_parts - 1 do parts[#parts + 1] = string.pack("<I4", slot[idx]) end
+        return table.concat(parts)
+    elseif k == "Layers" then
+        if not comp.template then mbin_fail(ent, "Layers needs 'template <Name>'") end
+        local tmpl = ast.layers[mbin_lookup(ent, ast.layers, comp.template, "layer template")]
+        local parts = {}
+        for idx = 1, max_layers do
+            local e = tmpl.entries[idx]
+            if e then
+                local mat = mbin_lookup(ent, ast.materials, e.material, "material")
+                parts[#parts + 1] = string.pack("<I4i4i4", mat, e.integrity, e.integrity)
+            else
+                parts[#parts + 1] = string.pack("<I4i4i4", 0, 0, 0)
+            end
+        end
+        parts[#parts + 1] = string.pack("<I4", math.min(#tmpl.entries, max_layers))
+        return table.concat(parts)
+    end
+    mbin_fail(ent, "component " .. k .. " has no binary encoding")
+end
+
+local function mbin_align(off)
+    return (off + MBIN_ALIGN - 1) & ~(MBIN_ALIGN - 1)
+end
+
+local function fnv1a(bytes, from)
+    local h = 2166136261
+    for idx = from, #bytes do
+        h = ((h ~ bytes:byte(idx)) * 16777619) & 0xFFFFFFFF
+    end
+    return h
+end
+
+local function build_mbin(ast)
+    -- Group components into pools, ordered by ComponentType
+    local pools = {}
+    for idx, ent in ipairs(ast.entities) do
+        for _, comp in ipairs(ent.comps) do
+            local ct = COMP_TYPES[comp.kind]
+            if not ct then mbin_fail(ent, "unknown component " .. comp.kind) end
+            pools[ct] = pools[ct] or { type = ct, dense = {}, data = {} }
+            local pool = pools[ct]
+            pool.dense[#pool.dense + 1] = idx - 1
+            pool.data[#pool.data + 1] = mbin_encode(ast, ent, comp)
+            pool.stride = pool.stride or #pool.data[#pool.data]
+        end
+    end
+    local order = {}
+    for ct = 0, 9 do if pools[ct] then order[#order + 1] = pools[ct] end end
+
+    -- Lay out blocks
+    local body = {}
+    local descs = {}
+    local off = mbin_align(32 + 32 * #order)
+    local function pad_to(target)
+        local cur = 32 + 32 * #order
+        for _, b in ipairs(body) do cur = cur + #b end
+        if target > cur then body[#body + 1] = string.rep("\0", target - cur) end
+    end
+    pad_to(off)
+    for _, pool in ipairs(order) do
+        local count = #pool.dense
+        local dense_off = off
+        local d = {}
+        for _, eid in ipairs(pool.dense) do d[#d + 1] = string.pack("<I4", eid) end
+        body[#body + 1] = table.concat(d)
+        off = mbin_align(off + 4 * count)
+        pad_to(off)
+        local data_off = off
+        body[#body + 1] = table.concat(pool.data)
+        off = mbin_align(off + pool.stride * count)
+        pad_to(off)
+        descs[#descs + 1] = string.pack("<I4I4I4I4I4I4I4I4",
+            pool.type, pool.stride, count, dense_off, data_off, 0, 0, 0)
+        pool.count = count
+    end
+
+    local tail = table.concat(descs) .. table.concat(body)
+    local checksum = fnv1a(tail, 1)
+    local header = string.pack("<I4I2I2I4I4I4I4I4I4",
+        MBIN_MAGIC, MBIN_VERSION, 32, #ast.entities, #order, 32 + #tail, checksum, 0, 0)
+    return header .. tail, order
+end
+
 -- ============================================================
 -- MAIN
 -- ============================================================
@@ -770,10 +1075,16 @@ local function main()
     local input_file = arg[1]
     local output_file = "marble_gen.h"
     if not input_file then
-        io.stderr:write("Usage: lua marble_compile.lua <input.marble> [-o output.h]\n")
+        io.stderr:write("Usage: lua marble_compile.lua <input.marble> [-o output.h] [--mbin output.mbin] [--recipes recipes.h]\n")
         os.exit(1)
     end
-    if arg[2] == "-o" and arg[3] then output_file = arg[3] end
+    local mbin_file = nil
+    local recipes_file = nil
+    for idx = 2, #arg do
+        if arg[idx] == "-o" and arg[idx + 1] then output_file = arg[idx + 1] end
+        if arg[idx] == "--mbin" and arg[idx + 1] then mbin_file = arg[idx + 1] end
+        if arg[idx] == "--recipes" and arg[idx + 1] then recipes_file = arg[idx + 1] end
+    end
 
     io.write("marble_compile v" .. VERSION .. "\n")
     io.write("  Input:  " .. input_file .. "\n")
@@ -796,6 +1107,8 @@ local function main()
     io.write("    systems:      " .. #ast.systems .. "\n")
     io.write("    layers:       " .. #ast.layers .. "\n")
     io.write("    rules:        " .. #ast.rules .. "\n")
+    io.write("    recipes:      " .. #ast.recipes .. "\n")
+    io.write("    entities:     " .. #ast.entities .. "\n")
 
     local code = generate(ast)
     local f = io.open(output_file, "w")
@@ -807,6 +1120,31 @@ local function main()
     f:close()
 
     io.write("  Generated: " .. output_file .. " (" .. #code .. " bytes)\n")
+
+    if recipes_file then
+        local rcode = generate_recipes(ast)
+        local rf = io.open(recipes_file, "w")
+        if not rf then
+            io.stderr:write("ERROR: cannot write to " .. recipes_file .. "\n")
+            os.exit(1)
+        end
+        rf:write(rcode)
+        rf:close()
+        io.write("  Generated: " .. recipes_file .. " (" .. #ast.recipes .. " recipes)\n")
+    end
+
+    if mbin_file then
+        local image, pools = build_mbin(ast)
+        local mf = io.open(mbin_file, "wb")
+        if not mf then
+            io.stderr:write("ERROR: cannot write to " .. mbin_file .. "\n")
+            os.exit(1)
+        end
+        mf:write(image)
+        mf:close()
+        io.write("  Generated: " .. mbin_file .. " (" .. #image .. " bytes, "
+                 .. #pools .. " pools)\n")
+    end
     io.write("  Done.\n")
 end
 
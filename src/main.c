@@ -2,23 +2,44 @@
  * main.c -- MarbleEngine Phase 0.2 Validation
  *
  * NEW IN 0.2:
- *   - Deterministic PRNG (SplitMix32): same seed = same simulation on
- *     all platforms. No more rand(). Seeded per-interaction with
- *     (world_seed ^ tick ^ actor_id ^ target_id) for full reproducibility.
+ *   - Deterministic PRNG: same seed = same simulation on all platforms.
+ *     No more rand(). Each interaction's seed is drawn from the counter
+ *     RNG (Philox4x32, marble_rng.h) keyed by the world seed, at
+ *     (tick, actor_id, target_id), so it does not depend on queue order.
+ *     The rolls inside the interaction use a SplitMix32 McRng seeded
+ *     with it.
  *   - Entity ID Allocator: monotonic bump allocator, no more magic numbers.
  *     Entity IDs are assigned at init and printed in the log.
  *
  * SCENARIO: Same as 0.1b (lumberjack chops tree, crit fail damages hand)
  *
+ * PROFILING:
+ *   Every tick, every system that runs and the command flush is a zone
+ *   (marble_profile.h). A tick over budget dumps marble_slow_tick.json;
+ *   `--trace out.json` dumps the last ticks on exit. A p50/p99/max
+ *   table per zone prints at the end.
+ *
+ * PACING:
+ *   Between ticks the loop sleeps until the next tick's deadline
+ *   (mc_platform_sleep_until_us). Each tick's start lateness goes into
+ *   a TickJitter; mean/p99/max and the catch-up count print at the end.
+ *
  * BUILD (GCC/MinGW):
- *   gcc -std=c99 -Wall -Wextra -O2 main.c -o marble_phase0_2.exe
+ *   gcc -std=c99 -Wall -Wextra -O2 main.c -o marble_phase0_2.exe -lwinmm
  *
  * BUILD (MSVC):
  *   cl /std:c11 /W4 /O2 main.c /Fe:marble_phase0_2.exe
  */
 
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L   /* clock_gettime, clock_nanosleep */
+#endif
+
 #include "marble_core.h"
 #include "marble_interact.h"
+#include "marble_world.h"
+#include "marble_profile.h"
+#include "marble_sched.h"
 
 #ifdef _WIN32
 #include "marble_platform_win32.h"
@@ -41,44 +62,28 @@ typedef struct {
 } CPosition;
 
 /* =========================================================================
- * GLOBALS
+ * DEMO WORLD
+ *
+ * All simulation state lives in the World (marble_world.h); the demo
+ * only adds the well-known entity IDs its systems look up. In Phase 1+
+ * these come from the world definition.
  * ========================================================================= */
 
-/* Entity allocator -- all entity IDs come from here */
-static EntityAllocator g_alloc;
-
 /* World PRNG seed -- set once, used to derive per-interaction seeds */
 #define WORLD_SEED 42u
 
-/* Component pools */
-static SparseSet g_pool_health;
-static SparseSet g_pool_position;
-static SparseSet g_pool_layers;
-static SparseSet g_pool_skills;
-static SparseSet g_pool_anatomy;
-static SparseSet g_pool_capabilities;
-static SparseSet g_pool_affordances;
-static SparseSet g_pool_tool;
-static SparseSet g_pool_body_parts;
-
-/* Well-known entity IDs -- assigned by allocator at init, stored for
- * system lookups. In Phase 1+ these come from the world definition. */
-static EntityID g_eid_lumberjack;
-static EntityID g_eid_right_hand;
-static EntityID g_eid_oak_tree;
-
-/* Interaction request queue */
-static InteractionRequest g_requests[MAX_INTERACTION_REQUESTS];
-static uint32_t           g_request_count = 0;
-
-static void push_request(EntityID actor, EntityID target, VerbID verb) {
-    if (g_request_count < MAX_INTERACTION_REQUESTS) {
-        g_requests[g_request_count].actor  = actor;
-        g_requests[g_request_count].target = target;
-        g_requests[g_request_count].verb   = verb;
-        g_request_count++;
-    }
-}
+typedef struct {
+    World    world;
+    EntityID eid_lumberjack;
+    EntityID eid_right_hand;
+    EntityID eid_oak_tree;
+} DemoWorld;
+
+static const uint32_t DEMO_STRIDES[LOADER_POOL_COUNT] = {
+    sizeof(CHealth), sizeof(CPosition), sizeof(CLayerStack), sizeof(CSkills),
+    sizeof(CAnatomy), sizeof(CCapabilities), sizeof(CAffordances), sizeof(CTool),
+    sizeof(CBodyParts), 0 /* no behavior pool in this demo */
+};
 
 /* =========================================================================
  * SYSTEMS
@@ -97,56 +102,49 @@ static const uint32_t SYSTEM_FREQ[SYS_COUNT] = {
     3, /* SYS_WORLD_STATUS: every 3 ticks */
 };
 
+/* Relative cost estimates for phase balancing (marble_sched.h) */
+static const uint32_t SYSTEM_COST[SYS_COUNT] = {
+    1, /* SYS_TICK_LOG:     one printf */
+    4, /* SYS_INTERACTION:  resolves every queued request */
+    2, /* SYS_WORLD_STATUS: walks two layer stacks */
+};
+
+static const char* SYSTEM_NAMES[SYS_COUNT] = {
+    "SYS_TICK_LOG", "SYS_INTERACTION", "SYS_WORLD_STATUS"
+};
+
 /* --- System: Tick Log (freq 1) --- */
 static void System_TickLog(uint64_t tick) {
     printf("=== TICK %llu ===\n", (unsigned long long)tick);
 }
 
 /* --- System: Interaction Processor (freq 2) ---
- * Seeds the PRNG per-interaction for deterministic replay. */
-static void System_Interaction(uint64_t tick) {
+ * The world seeds a McRng per interaction from the counter RNG, for
+ * deterministic replay. */
+static void System_Interaction(DemoWorld* d, uint64_t tick) {
+    World* w = &d->world;
     uint32_t i;
 
-    push_request(g_eid_lumberjack, g_eid_oak_tree, VERB_CHOP);
-
-    printf("  [InteractionSystem] Processing %u request(s)...\n", g_request_count);
-
-    for (i = 0; i < g_request_count; i++) {
-        InteractResult result;
-        McRng rng;
-
-        /* Seed PRNG deterministically: same tick + same entities = same roll.
-         * This is the key property that enables replay and network sync. */
-        mc_rng_seed(&rng, WORLD_SEED
-                    ^ (uint32_t)tick
-                    ^ (g_requests[i].actor * 2654435761u)
-                    ^ (g_requests[i].target * 2246822519u));
-
-        result = process_interaction(
-            &g_requests[i],
-            &g_pool_capabilities,
-            &g_pool_affordances,
-            &g_pool_anatomy,
-            &g_pool_skills,
-            &g_pool_tool,
-            &g_pool_body_parts,
-            &g_pool_layers,
-            &rng
-        );
+    mc_world_push_request(w, d->eid_lumberjack, d->eid_oak_tree, VERB_CHOP);
+
+    printf("  [InteractionSystem] Processing %u request(s)...\n", w->request_count);
 
+    mc_world_process_requests(w, tick);
+
+    for (i = 0; i < w->interaction_count; i++) {
+        const WorldInteraction* in = &w->interactions[i];
         printf("    [t%llu] eid %u -> CHOP -> eid %u : %s (roll seed: 0x%08X)\n",
                (unsigned long long)tick,
-               g_requests[i].actor,
-               g_requests[i].target,
-               INTERACT_RESULT_NAMES[result],
-               rng.state);  /* print final RNG state for debug/replay */
+               in->request.actor,
+               in->request.target,
+               INTERACT_RESULT_NAMES[in->result],
+               in->rng_state);  /* print final RNG state for debug/replay */
     }
-
-    g_request_count = 0;
 }
 
 /* --- System: World Status (freq 3) --- */
-static void System_WorldStatus(uint64_t tick) {
+static void System_WorldStatus(DemoWorld* d, uint64_t tick) {
+    const SparseSet* layers = mc_world_pool(&d->world, COMP_TYPE_LAYERS);
     const CLayerStack* tree_layers;
     const CLayerStack* hand_layers;
     uint32_t i;
@@ -155,10 +153,10 @@ static void System_WorldStatus(uint64_t tick) {
     printf("  [WorldStatus] --- Snapshot ---\n");
 
     tree_layers = (const CLayerStack*)mc_sparse_set_get_const(
-        &g_pool_layers, g_eid_oak_tree);
+        layers, d->eid_oak_tree);
     if (tree_layers != NULL && tree_layers->layer_count > 0) {
         printf("    Oak Tree (eid %u): %u layer(s)\n",
-               g_eid_oak_tree, tree_layers->layer_count);
+               d->eid_oak_tree, tree_layers->layer_count);
         for (i = 0; i < tree_layers->layer_count; i++) {
             printf("      [%u] %s  integrity=%d/%d\n", i,
                    MATERIAL_NAMES[tree_layers->layers[i].material],
@@ -166,14 +164,14 @@ static void System_WorldStatus(uint64_t tick) {
                    tree_layers->layers[i].max_integrity);
         }
     } else {
-        printf("    Oak Tree (eid %u): FULLY DESTROYED\n", g_eid_oak_tree);
+        printf("    Oak Tree (eid %u): FULLY DESTROYED\n", d->eid_oak_tree);
     }
 
     hand_layers = (const CLayerStack*)mc_sparse_set_get_const(
-        &g_pool_layers, g_eid_right_hand);
+        layers, d->eid_right_hand);
     if (hand_layers != NULL && hand_layers->layer_count > 0) {
         printf("    Right Hand (eid %u): %u layer(s)\n",
-               g_eid_right_hand, hand_layers->layer_count);
+               d->eid_right_hand, hand_layers->layer_count);
         for (i = 0; i < hand_layers->layer_count; i++) {
             printf("      [%u] %s  integrity=%d/%d\n", i,
                    MATERIAL_NAMES[hand_layers->layers[i].material],
@@ -182,7 +180,7 @@ static void System_WorldStatus(uint64_t tick) {
         }
     } else {
         printf("    Right Hand (eid %u): DESTROYED -- fine motor LOST\n",
-               g_eid_right_hand);
+               d->eid_right_hand);
     }
 
     printf("  --------------------------\n");
@@ -192,15 +190,33 @@ static void System_WorldStatus(uint64_t tick) {
  * DISPATCHER
  * ========================================================================= */
 
-static void dispatch_system(SystemID sys, uint64_t tick) {
-    if (tick % SYSTEM_FREQ[sys] != 0) return;
+static void dispatch_system(DemoWorld* d, const McSchedule* sched, McProfiler* prof,
+                            SystemID sys, uint64_t tick) {
+    if (!mc_sched_due(sched, (uint32_t)sys, tick)) return;
 
+    MC_PROF_BEGIN(prof, 0, MC_PROF_ZONE_FIRST_SYSTEM + (uint32_t)sys);
     switch (sys) {
         case SYS_TICK_LOG:     System_TickLog(tick);     break;
-        case SYS_INTERACTION:  System_Interaction(tick);  break;
-        case SYS_WORLD_STATUS: System_WorldStatus(tick);  break;
+        case SYS_INTERACTION:  System_Interaction(d, tick);  break;
+        case SYS_WORLD_STATUS: System_WorldStatus(d, tick);  break;
         default: break;
     }
+    MC_PROF_END(prof, 0);
+}
+
+/* Due timers + queued commands, after the systems that queue them */
+static void flush_commands(DemoWorld* d, McProfiler* prof, uint64_t tick) {
+    World* w = &d->world;
+    PoolPtrs pp;
+    pp.layers     = w->ctx.pool_layers;
+    pp.item_defs  = NULL;
+    pp.positions  = w->ctx.pool_position;
+    pp.grid       = &w->grid;
+    pp.containers = NULL;
+
+    MC_PROF_BEGIN(prof, 0, MC_PROF_ZONE_CMD_FLUSH);
+    mc_cmd_flush_timed(&w->commands, &pp, &w->timers, tick);
+    MC_PROF_END(prof, 0);
 }
 
 /* =========================================================================
@@ -210,61 +226,84 @@ static void dispatch_system(SystemID sys, uint64_t tick) {
 #define MAX_CATCHUP_TICKS 3
 #define TOTAL_DEMO_TICKS  30
 
-static void run_tick_loop(void) {
-    TickState ts;
+static void run_tick_loop(DemoWorld* d, McProfiler* prof) {
+    static TickJitter jitter;
+    static McSchedule sched;
+    TickState* ts = &d->world.tick;
     uint64_t now_us;
     int ticks_this_frame;
     int sys;
 
     now_us = mc_platform_time_us();
-    mc_tick_state_init(&ts, now_us);
+    mc_tick_state_init(ts, now_us);
+    mc_tick_jitter_init(&jitter);
+    mc_sched_init(&sched, SYSTEM_FREQ, SYSTEM_COST, NULL, SYS_COUNT);
 
     printf("\n========================================\n");
     printf("  MarbleEngine Phase 0.2\n");
     printf("  Tick interval: %d ms\n", MC_TICK_INTERVAL_US / 1000);
     printf("  World seed: %u\n", WORLD_SEED);
-    printf("  PRNG: SplitMix32 (deterministic)\n");
+    printf("  PRNG: Philox4x32 interaction seeds, SplitMix32 rolls (deterministic)\n");
     printf("  Entity allocator: monotonic bump\n");
     printf("  Systems:\n");
-    printf("    SYS_TICK_LOG     freq=1\n");
-    printf("    SYS_INTERACTION  freq=2\n");
-    printf("    SYS_WORLD_STATUS freq=3\n");
+    for (sys = 0; sys < SYS_COUNT; sys++) {
+        printf("    %-16s freq=%u phase=%u\n",
+               SYSTEM_NAMES[sys], sched.freq[sys], sched.phase[sys]);
+    }
+    printf("  Est. tick cost: peak %u, mean %u\n",
+           mc_sched_peak_load(&sched), mc_sched_mean_load(&sched));
     printf("  Running %d ticks.\n", TOTAL_DEMO_TICKS);
     printf("========================================\n\n");
 
-    while (ts.tick_number < TOTAL_DEMO_TICKS) {
+    while (ts->tick_number < TOTAL_DEMO_TICKS) {
         now_us = mc_platform_time_us();
-        ts.accumulated_us += (now_us - ts.last_time_us);
-        ts.last_time_us = now_us;
+        ts->accumulated_us += (now_us - ts->last_time_us);
+        ts->last_time_us = now_us;
 
         ticks_this_frame = 0;
 
-        while (ts.accumulated_us >= MC_TICK_INTERVAL_US
+        while (ts->accumulated_us >= MC_TICK_INTERVAL_US
                && ticks_this_frame < MAX_CATCHUP_TICKS
-               && ts.tick_number < TOTAL_DEMO_TICKS) {
+               && ts->tick_number < TOTAL_DEMO_TICKS) {
+
+            /* Due when the accumulator reached one interval; catch-up
+             * ticks also wait for the ones run before them this frame */
+            mc_tick_jitter_record(&jitter, ts->accumulated_us - MC_TICK_INTERVAL_US
+                                           + (mc_platform_time_us() - now_us));
+            if (ticks_this_frame > 0) jitter.catchup_ticks++;
 
+            mc_prof_tick_begin(prof, 0, ts->tick_number);
             for (sys = 0; sys < SYS_COUNT; sys++) {
-                dispatch_system((SystemID)sys, ts.tick_number);
+                dispatch_system(d, &sched, prof, (SystemID)sys, ts->tick_number);
+            }
+            flush_commands(d, prof, ts->tick_number);
+            if (mc_prof_tick_end(prof, 0)) {
+                printf("  [Profiler] tick %llu over budget: %s took %.1f ms\n",
+                       (unsigned long long)ts->tick_number,
+                       prof->zone_names[prof->last_slow.worst_zone],
+                       (double)prof->last_slow.worst_ns / 1e6);
             }
             printf("\n");
 
-            ts.accumulated_us -= MC_TICK_INTERVAL_US;
-            ts.tick_number++;
+            ts->accumulated_us -= MC_TICK_INTERVAL_US;
+            ts->tick_number++;
             ticks_this_frame++;
         }
 
-        if (ts.accumulated_us < MC_TICK_INTERVAL_US) {
-            uint64_t remaining = MC_TICK_INTERVAL_US - ts.accumulated_us;
-            if (remaining > 10000) {
-                mc_platform_sleep_us(remaining - 5000);
-            } else {
-                mc_platform_sleep_us(1000);
-            }
+        if (ts->accumulated_us < MC_TICK_INTERVAL_US) {
+            mc_platform_sleep_until_us(now_us + (MC_TICK_INTERVAL_US - ts->accumulated_us));
         }
     }
 
     printf("=== Phase 0.2 complete: %llu ticks ===\n",
-           (unsigned long long)ts.tick_number);
+           (unsigned long long)ts->tick_number);
+    printf("Tick start jitter: mean %llu us, p99 %llu us, max %llu us, %llu catch-up tick(s)\n",
+           (unsigned long long)mc_tick_jitter_mean(&jitter),
+           (unsigned long long)mc_tick_jitter_quantile(&jitter, 0.99),
+           (unsigned long long)jitter.max_us,
+           (unsigned long long)jitter.catchup_ticks);
+    printf("\nProfile:\n");
+    mc_prof_report(prof, stdout);
 }
 
 /* =========================================================================
@@ -273,30 +312,22 @@ static void run_tick_loop(void) {
  * All entity IDs are now assigned by the allocator.
  * ========================================================================= */
 
-static void init_world(void) {
-    /* Init allocator and all pools */
-    mc_entity_alloc_init(&g_alloc);
+static void init_world(DemoWorld* d) {
+    World* w = &d->world;
 
-    mc_sparse_set_init(&g_pool_health,       sizeof(CHealth));
-    mc_sparse_set_init(&g_pool_position,     sizeof(CPosition));
-    mc_sparse_set_init(&g_pool_layers,       sizeof(CLayerStack));
-    mc_sparse_set_init(&g_pool_skills,       sizeof(CSkills));
-    mc_sparse_set_init(&g_pool_anatomy,      sizeof(CAnatomy));
-    mc_sparse_set_init(&g_pool_capabilities, sizeof(CCapabilities));
-    mc_sparse_set_init(&g_pool_affordances,  sizeof(CAffordances));
-    mc_sparse_set_init(&g_pool_tool,         sizeof(CTool));
-    mc_sparse_set_init(&g_pool_body_parts,   sizeof(CBodyParts));
+    /* Init allocator, all pools and the world's queues */
+    mc_world_init(w, 0, WORLD_SEED, DEMO_STRIDES);
 
     /* === Allocate all entity IDs up front === */
-    g_eid_lumberjack = mc_entity_create(&g_alloc);  /* 0 */
-    g_eid_right_hand = mc_entity_create(&g_alloc);  /* 1 */
-    g_eid_oak_tree   = mc_entity_create(&g_alloc);  /* 2 */
+    d->eid_lumberjack = mc_entity_create(&w->alloc);  /* 0 */
+    d->eid_right_hand = mc_entity_create(&w->alloc);  /* 1 */
+    d->eid_oak_tree   = mc_entity_create(&w->alloc);  /* 2 */
 
     printf("Entity IDs assigned by allocator:\n");
-    printf("  Lumberjack:  eid %u\n", g_eid_lumberjack);
-    printf("  Right Hand:  eid %u\n", g_eid_right_hand);
-    printf("  Oak Tree:    eid %u\n", g_eid_oak_tree);
-    printf("  Next free:   eid %u\n\n", g_alloc.next_id);
+    printf("  Lumberjack:  eid %u\n", d->eid_lumberjack);
+    printf("  Right Hand:  eid %u\n", d->eid_right_hand);
+    printf("  Oak Tree:    eid %u\n", d->eid_oak_tree);
+    printf("  Next free:   eid %u\n\n", w->alloc.next_id);
 
     /* === Entity: Lumberjack's Right Hand === */
     {
@@ -309,9 +340,9 @@ static void init_world(void) {
         hand_ls.layers[1].integrity     = 1;
         hand_ls.layers[1].max_integrity = 1;
 
-        mc_sparse_set_add(&g_pool_layers, g_eid_right_hand, &hand_ls);
+        mc_sparse_set_add(w->ctx.pool_layers, d->eid_right_hand, &hand_ls);
 
-        printf("Entity %u: Lumberjack's Right Hand\n", g_eid_right_hand);
+        printf("Entity %u: Lumberjack's Right Hand\n", d->eid_right_hand);
         printf("  Layer 0: Flesh (integrity %d/%d) -- fragile!\n",
                hand_ls.layers[0].integrity, hand_ls.layers[0].max_integrity);
         printf("  Layer 1: Bone (integrity %d/%d)\n\n",
@@ -340,22 +371,22 @@ static void init_world(void) {
         for (i = 0; i < MAX_BODY_PARTS; i++) {
             bp.part_entity[i] = MC_INVALID_INDEX;
         }
-        bp.part_entity[BODYPART_RIGHT_HAND] = g_eid_right_hand;
+        bp.part_entity[BODYPART_RIGHT_HAND] = d->eid_right_hand;
 
-        mc_sparse_set_add(&g_pool_health,       g_eid_lumberjack, &h);
-        mc_sparse_set_add(&g_pool_position,     g_eid_lumberjack, &p);
-        mc_sparse_set_add(&g_pool_anatomy,      g_eid_lumberjack, &anat);
-        mc_sparse_set_add(&g_pool_skills,       g_eid_lumberjack, &skills);
-        mc_sparse_set_add(&g_pool_capabilities, g_eid_lumberjack, &caps);
-        mc_sparse_set_add(&g_pool_tool,         g_eid_lumberjack, &tool);
-        mc_sparse_set_add(&g_pool_body_parts,   g_eid_lumberjack, &bp);
+        mc_sparse_set_add(w->ctx.pool_health,       d->eid_lumberjack, &h);
+        mc_sparse_set_add(w->ctx.pool_position,     d->eid_lumberjack, &p);
+        mc_sparse_set_add(w->ctx.pool_anatomy,      d->eid_lumberjack, &anat);
+        mc_sparse_set_add(w->ctx.pool_skills,       d->eid_lumberjack, &skills);
+        mc_sparse_set_add(w->ctx.pool_capabilities, d->eid_lumberjack, &caps);
+        mc_sparse_set_add(w->ctx.pool_tool,         d->eid_lumberjack, &tool);
+        mc_sparse_set_add(w->ctx.pool_body_parts,   d->eid_lumberjack, &bp);
 
-        printf("Entity %u: Lumberjack\n", g_eid_lumberjack);
+        printf("Entity %u: Lumberjack\n", d->eid_lumberjack);
         printf("  Anatomy: Arms+Hands+Legs\n");
         printf("  Skill: Woodcutting %d\n", skills.level[SKILL_WOODCUTTING]);
         printf("  Capability: CHOP (requires fine motor on right hand)\n");
         printf("  Tool: Iron Axe (hardness %d)\n", MATERIAL_HARDNESS[MAT_IRON]);
-        printf("  Body: right_hand -> eid %u\n\n", g_eid_right_hand);
+        printf("  Body: right_hand -> eid %u\n\n", d->eid_right_hand);
     }
 
     /* === Entity: Oak Tree === */
@@ -375,11 +406,11 @@ static void init_world(void) {
         ls.layers[1].integrity     = 10;
         ls.layers[1].max_integrity = 10;
 
-        mc_sparse_set_add(&g_pool_position,    g_eid_oak_tree, &p);
-        mc_sparse_set_add(&g_pool_layers,      g_eid_oak_tree, &ls);
-        mc_sparse_set_add(&g_pool_affordances, g_eid_oak_tree, &affs);
+        mc_sparse_set_add(w->ctx.pool_position,    d->eid_oak_tree, &p);
+        mc_sparse_set_add(w->ctx.pool_layers,      d->eid_oak_tree, &ls);
+        mc_sparse_set_add(w->ctx.pool_affordances, d->eid_oak_tree, &affs);
 
-        printf("Entity %u: Oak Tree\n", g_eid_oak_tree);
+        printf("Entity %u: Oak Tree\n", d->eid_oak_tree);
         printf("  Layer 0: Bark (hardness %d, integrity %d/%d)\n",
                MATERIAL_HARDNESS[MAT_BARK],
                ls.layers[0].integrity, ls.layers[0].max_integrity);
@@ -388,15 +419,38 @@ static void init_world(void) {
                ls.layers[1].integrity, ls.layers[1].max_integrity);
         printf("  Affordance: CHOPPABLE (crit_fail_threshold=15)\n\n");
     }
+
+    /* Positions were written directly, not via CMD_MOVE_ENTITY */
+    mc_world_reindex(w);
 }
 
 /* =========================================================================
  * ENTRY POINT
  * ========================================================================= */
 
-int main(void) {
+int main(int argc, char** argv) {
+    /* ~1 MB of pools: static storage, not the stack */
+    static DemoWorld demo;
+    static McProfiler prof;
+    int sys;
+
+    mc_prof_init(&prof);
+    mc_prof_thread_name(&prof, 0, "main");
+    for (sys = 0; sys < SYS_COUNT; sys++) {
+        mc_prof_zone_name(&prof, MC_PROF_ZONE_FIRST_SYSTEM + (uint32_t)sys, SYSTEM_NAMES[sys]);
+    }
+    mc_prof_set_slow_trigger(&prof, MC_TICK_INTERVAL_US, "marble_slow_tick.json", 1);
+
     mc_platform_init();
-    init_world();
-    run_tick_loop();
+    init_world(&demo);
+    run_tick_loop(&demo, &prof);
+
+    if (argc == 3 && strcmp(argv[1], "--trace") == 0) {
+        if (mc_prof_write_trace_file(&prof, argv[2]) == 0) {
+            printf("Trace written to %s\n", argv[2]);
+        } else {
+            printf("Could not write trace to %s\n", argv[2]);
+        }
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,383 @@
+/*
+ * montecarlo.c -- MarbleEngine Batch Monte Carlo Runner
+ *
+ * PURPOSE:
+ *   Balance analysis. Runs the lumberjack scenario from main.c under
+ *   thousands of world seeds and aggregates the outcomes into histograms:
+ *   ticks to fell the tree, crit fails per run, and how the run ended
+ *   (tree felled, right hand destroyed, or out of ticks).
+ *
+ * HOW:
+ *   Each worker thread owns one World (marble_world.h) and runs seeds
+ *   k, k + W, k + 2W, ... through it back to back, re-initializing the
+ *   world between seeds. Every worker fills its own McStats; the main
+ *   thread merges them after the join, so workers share nothing.
+ *   The build defines MC_QUIET, so no simulation logging is compiled in.
+ *
+ *   Run i uses world seed mc__world_seed(base_seed, i): the index is
+ *   hashed through SplitMix32 so runs get unrelated Philox keys.
+ *
+ * OUTPUT (CSV):
+ *   metric,bucket,count,fraction
+ *   ticks_to_fell,<tick>,...      one row per tick at which a tree fell
+ *   crit_fails,<n>,...            crit fails per run
+ *   hand_destroyed_at,<tick>,...  tick the right hand was lost
+ *   outcome,<felled|hand_lost|timeout>,...
+ *   summary,<name>,<value>,<rate>
+ *
+ * USAGE:
+ *   marble_montecarlo [runs] [workers] [out.csv] [base_seed]
+ *   defaults: 10000 runs, one worker per CPU, montecarlo.csv, seed 42
+ *   runs must be a positive integer and workers/base_seed non-negative
+ *   integers (workers 0 = one per CPU); anything else -- including
+ *   --help -- prints this usage and exits 1 without touching out.csv.
+ *
+ * BUILD (GCC/MinGW):
+ *   gcc -std=c99 -Wall -Wextra -O2 montecarlo.c -o marble_montecarlo.exe -lpthread
+ */
+
+#define MC_QUIET
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "marble_core.h"
+#include "marble_interact.h"
+#include "marble_world.h"
+#include "marble_thread.h"
+
+/* =========================================================================
+ * BASIC COMPONENTS (same as main.c)
+ * ========================================================================= */
+
+typedef struct {
+    int32_t hp;
+    int32_t max_hp;
+} CHealth;
+
+typedef struct {
+    float x;
+    float y;
+} CPosition;
+
+static const uint32_t MC_STRIDES[LOADER_POOL_COUNT] = {
+    sizeof(CHealth), sizeof(CPosition), sizeof(CLayerStack), sizeof(CSkills),
+    sizeof(CAnatomy), sizeof(CCapabilities), sizeof(CAffordances), sizeof(CTool),
+    sizeof(CBodyParts), 0
+};
+
+/* =========================================================================
+ * SCENARIO
+ * ========================================================================= */
+
+#define MC_RUN_MAX_TICKS    400   /* a run that has not ended by now times out */
+#define MC_CHOP_INTERVAL    2     /* matches SYS_INTERACTION freq in main.c */
+#define MC_MAX_CRIT_BUCKET  31    /* crit fail histogram clamps here */
+
+#define EID_LUMBERJACK 0
+#define EID_RIGHT_HAND 1
+#define EID_OAK_TREE   2
+
+typedef enum {
+    OUTCOME_FELLED    = 0,
+    OUTCOME_HAND_LOST = 1,
+    OUTCOME_TIMEOUT   = 2,
+    OUTCOME_COUNT
+} RunOutcome;
+
+static const char* OUTCOME_NAMES[OUTCOME_COUNT] = {
+    "felled", "hand_lost", "timeout"
+};
+
+/* Same entities and numbers as init_world() in main.c, without the log */
+static void scenario_init(World* w, uint32_t seed) {
+    CLayerStack hand_ls, tree_ls;
+    CHealth h;
+    CPosition p;
+    CAnatomy anat;
+    CSkills skills;
+    CCapabilities caps;
+    CTool tool;
+    CBodyParts bp;
+    CAffordances affs;
+    uint32_t i;
+
+    mc_world_init(w, 0, seed, MC_STRIDES);
+    mc_entity_create(&w->alloc);   /* EID_LUMBERJACK */
+    mc_entity_create(&w->alloc);   /* EID_RIGHT_HAND */
+    mc_entity_create(&w->alloc);   /* EID_OAK_TREE */
+
+    memset(&hand_ls, 0, sizeof(hand_ls));
+    hand_ls.layer_count = 2;
+    hand_ls.layers[0].material = MAT_FLESH; hand_ls.layers[0].integrity = 1; hand_ls.layers[0].max_integrity = 1;
+    hand_ls.layers[1].material = MAT_BONE;  hand_ls.layers[1].integrity = 1; hand_ls.layers[1].max_integrity = 1;
+    mc_sparse_set_add(w->ctx.pool_layers, EID_RIGHT_HAND, &hand_ls);
+
+    h.hp = 100; h.max_hp = 100;
+    p.x = 5.0f; p.y = 3.0f;
+    anat.flags = ANAT_ARMS | ANAT_HANDS | ANAT_LEGS;
+    memset(&skills, 0, sizeof(skills));
+    skills.level[SKILL_WOODCUTTING] = 60;
+    caps.flags = (1u << CAP_CHOP);
+    tool.material = MAT_IRON;
+    for (i = 0; i < MAX_BODY_PARTS; i++) bp.part_entity[i] = MC_INVALID_INDEX;
+    bp.part_entity[BODYPART_RIGHT_HAND] = EID_RIGHT_HAND;
+
+    mc_sparse_set_add(w->ctx.pool_health,       EID_LUMBERJACK, &h);
+    mc_sparse_set_add(w->ctx.pool_position,     EID_LUMBERJACK, &p);
+    mc_sparse_set_add(w->ctx.pool_anatomy,      EID_LUMBERJACK, &anat);
+    mc_sparse_set_add(w->ctx.pool_skills,       EID_LUMBERJACK, &skills);
+    mc_sparse_set_add(w->ctx.pool_capabilities, EID_LUMBERJACK, &caps);
+    mc_sparse_set_add(w->ctx.pool_tool,         EID_LUMBERJACK, &tool);
+    mc_sparse_set_add(w->ctx.pool_body_parts,   EID_LUMBERJACK, &bp);
+
+    memset(&tree_ls, 0, sizeof(tree_ls));
+    tree_ls.layer_count = 2;
+    tree_ls.layers[0].material = MAT_BARK; tree_ls.layers[0].integrity = 3;  tree_ls.layers[0].max_integrity = 3;
+    tree_ls.layers[1].material = MAT_WOOD; tree_ls.layers[1].integrity = 10; tree_ls.layers[1].max_integrity = 10;
+    p.x = 6.0f; p.y = 3.0f;
+    affs.flags = (1u << AFF_CHOPPABLE);
+    mc_sparse_set_add(w->ctx.pool_position,    EID_OAK_TREE, &p);
+    mc_sparse_set_add(w->ctx.pool_layers,      EID_OAK_TREE, &tree_ls);
+    mc_sparse_set_add(w->ctx.pool_affordances, EID_OAK_TREE, &affs);
+}
+
+static uint32_t layers_left(World* w, EntityID eid) {
+    const CLayerStack* ls = (const CLayerStack*)mc_sparse_set_get_const(
+        mc_world_pool(w, COMP_TYPE_LAYERS), eid);
+    return ls ? ls->layer_count : 0;
+}
+
+static uint32_t mc__world_seed(uint32_t base_seed, uint32_t run) {
+    McRng r;
+    mc_rng_seed(&r, base_seed ^ (run * 2654435761u));
+    return mc_rng_next(&r);
+}
+
+/* =========================================================================
+ * STATISTICS
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t runs;
+    uint32_t outcome[OUTCOME_COUNT];
+    uint32_t fell_at[MC_RUN_MAX_TICKS + 1];
+    uint32_t hand_lost_at[MC_RUN_MAX_TICKS + 1];
+    uint32_t crit_hist[MC_MAX_CRIT_BUCKET + 1];
+    uint64_t attempts;                        /* chop interactions processed */
+    uint64_t crits;
+    uint64_t successes;
+} McStats;
+
+static void mc_stats_merge(McStats* dst, const McStats* src) {
+    uint32_t i;
+    dst->runs      += src->runs;
+    dst->attempts  += src->attempts;
+    dst->crits     += src->crits;
+    dst->successes += src->successes;
+    for (i = 0; i < OUTCOME_COUNT; i++)           dst->outcome[i]      += src->outcome[i];
+    for (i = 0; i <= MC_RUN_MAX_TICKS; i++)        dst->fell_at[i]      += src->fell_at[i];
+    for (i = 0; i <= MC_RUN_MAX_TICKS; i++)        dst->hand_lost_at[i] += src->hand_lost_at[i];
+    for (i = 0; i <= MC_MAX_CRIT_BUCKET; i++)      dst->crit_hist[i]    += src->crit_hist[i];
+}
+
+/* Run one seed to completion and fold it into st */
+static void run_scenario(World* w, uint32_t seed, McStats* st) {
+    RunOutcome outcome = OUTCOME_TIMEOUT;
+    uint32_t crits = 0;
+    uint32_t hand_lost_tick = 0;
+    int hand_lost = 0;
+    uint32_t t;
+
+    scenario_init(w, seed);
+
+    for (t = 0; t < MC_RUN_MAX_TICKS; t++) {
+        if (t % MC_CHOP_INTERVAL == 0) {
+            mc_world_push_request(w, EID_LUMBERJACK, EID_OAK_TREE, VERB_CHOP);
+        }
+        mc_world_step(w);
+
+        if (w->interaction_count > 0) {
+            InteractResult r = w->interactions[0].result;
+            st->attempts++;
+            if (r == INTERACT_CRIT_FAIL) { crits++; st->crits++; }
+            if (r == INTERACT_SUCCESS) st->successes++;
+        }
+
+        if (!hand_lost && layers_left(w, EID_RIGHT_HAND) == 0) {
+            hand_lost = 1;
+            hand_lost_tick = t;
+        }
+        if (layers_left(w, EID_OAK_TREE) == 0) {
+            outcome = OUTCOME_FELLED;
+            st->fell_at[t]++;
+            break;
+        }
+        if (hand_lost) {
+            /* Fine motor gone: every further chop fails */
+            outcome = OUTCOME_HAND_LOST;
+            break;
+        }
+    }
+
+    st->runs++;
+    st->outcome[outcome]++;
+    if (hand_lost) st->hand_lost_at[hand_lost_tick]++;
+    st->crit_hist[crits > MC_MAX_CRIT_BUCKET ? MC_MAX_CRIT_BUCKET : crits]++;
+}
+
+/* =========================================================================
+ * WORKERS
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t first;
+    uint32_t stride;
+    uint32_t runs;
+    uint32_t base_seed;
+    World    world;    /* this worker's private simulation context */
+    McStats  stats;
+} McJob;
+
+static McJob g_jobs[MC_THREAD_MAX_WORKERS];
+
+static void mc__run_job(McJob* job) {
+    uint32_t i;
+    for (i = job->first; i < job->runs; i += job->stride) {
+        run_scenario(&job->world, mc__world_seed(job->base_seed, i), &job->stats);
+    }
+}
+
+static MC_THREAD_PROC(mc__job_worker) {
+    mc__run_job((McJob*)mc_thread_arg);
+    MC_THREAD_RETURN;
+}
+
+/* =========================================================================
+ * CSV
+ * ========================================================================= */
+
+static void csv_row(FILE* f, const char* metric, uint32_t bucket, uint32_t count, uint32_t total) {
+    fprintf(f, "%s,%u,%u,%.6f\n", metric, bucket, count,
+            total ? (double)count / (double)total : 0.0);
+}
+
+static int write_csv(const char* path, const McStats* st) {
+    FILE* f = fopen(path, "w");
+    uint64_t fell_sum = 0;
+    uint32_t i;
+
+    if (f == NULL) return -1;
+
+    fprintf(f, "metric,bucket,count,fraction\n");
+    for (i = 0; i <= MC_RUN_MAX_TICKS; i++) {
+        if (st->fell_at[i]) csv_row(f, "ticks_to_fell", i, st->fell_at[i], st->runs);
+        fell_sum += (uint64_t)st->fell_at[i] * i;
+    }
+    for (i = 0; i <= MC_MAX_CRIT_BUCKET; i++) {
+        if (st->crit_hist[i]) csv_row(f, "crit_fails", i, st->crit_hist[i], st->runs);
+    }
+    for (i = 0; i <= MC_RUN_MAX_TICKS; i++) {
+        if (st->hand_lost_at[i]) csv_row(f, "hand_destroyed_at", i, st->hand_lost_at[i], st->runs);
+    }
+    for (i = 0; i < OUTCOME_COUNT; i++) {
+        fprintf(f, "outcome,%s,%u,%.6f\n", OUTCOME_NAMES[i], st->outcome[i],
+                st->runs ? (double)st->outcome[i] / (double)st->runs : 0.0);
+    }
+
+    fprintf(f, "summary,runs,%u,1.000000\n", st->runs);
+    fprintf(f, "summary,crit_fail_rate,%llu,%.6f\n", (unsigned long long)st->crits,
+            st->attempts ? (double)st->crits / (double)st->attempts : 0.0);
+    fprintf(f, "summary,hand_destroyed_probability,%u,%.6f\n", st->outcome[OUTCOME_HAND_LOST],
+            st->runs ? (double)st->outcome[OUTCOME_HAND_LOST] / (double)st->runs : 0.0);
+    fprintf(f, "summary,mean_ticks_to_fell,%u,%.6f\n", st->outcome[OUTCOME_FELLED],
+            st->outcome[OUTCOME_FELLED] ? (double)fell_sum / (double)st->outcome[OUTCOME_FELLED] : 0.0);
+
+    fclose(f);
+    return 0;
+}
+
+/* =========================================================================
+ * ENTRY POINT
+ * ========================================================================= */
+
+/* Strict decimal parse: digits only, no sign, no trailing text, fits in
+ * 32 bits. Returns 0 on success, -1 otherwise (strtoul alone turns
+ * "--help" into 0 and "-1" into 4294967295). */
+static int mc__parse_u32(const char* s, uint32_t* out) {
+    unsigned long v;
+    char* end;
+    if (*s < '0' || *s > '9') return -1;
+    errno = 0;
+    v = strtoul(s, &end, 10);
+    if (*end != '\0' || errno == ERANGE || v > 0xFFFFFFFFul) return -1;
+    *out = (uint32_t)v;
+    return 0;
+}
+
+static int mc__usage(void) {
+    fprintf(stderr,
+            "usage: marble_montecarlo [runs] [workers] [out.csv] [base_seed]\n"
+            "  runs       positive integer (default 10000)\n"
+            "  workers    integer, 0 = one per CPU (default 0)\n"
+            "  out.csv    output path (default montecarlo.csv)\n"
+            "  base_seed  integer (default 42)\n");
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    static McStats total;
+    McThread threads[MC_THREAD_MAX_WORKERS];
+    int started[MC_THREAD_MAX_WORKERS];
+    uint32_t runs      = 10000u;
+    uint32_t workers   = 0u;
+    const char* path   = (argc > 3) ? argv[3] : "montecarlo.csv";
+    uint32_t base_seed = 42u;
+    uint32_t k;
+
+    if (argc > 5) return mc__usage();
+    if (argc > 1 && (mc__parse_u32(argv[1], &runs) != 0 || runs == 0)) return mc__usage();
+    if (argc > 2 && mc__parse_u32(argv[2], &workers) != 0) return mc__usage();
+    if (argc > 4 && mc__parse_u32(argv[4], &base_seed) != 0) return mc__usage();
+
+    if (workers == 0) workers = mc_thread_cpu_count();
+    if (workers > MC_THREAD_MAX_WORKERS) workers = MC_THREAD_MAX_WORKERS;
+    if (workers > runs) workers = runs;
+    if (workers == 0) workers = 1;
+
+    for (k = 0; k < workers; k++) {
+        g_jobs[k].first     = k;
+        g_jobs[k].stride    = workers;
+        g_jobs[k].runs      = runs;
+        g_jobs[k].base_seed = base_seed;
+        memset(&g_jobs[k].stats, 0, sizeof(g_jobs[k].stats));
+    }
+
+    /* Worker 0 runs on this thread; any worker that fails to start too */
+    started[0] = 0;
+    for (k = 1; k < workers; k++) {
+        started[k] = (mc_thread_start(&threads[k], mc__job_worker, &g_jobs[k]) == 0);
+    }
+    for (k = 0; k < workers; k++) {
+        if (!started[k]) mc__run_job(&g_jobs[k]);
+    }
+    for (k = 1; k < workers; k++) {
+        if (started[k]) mc_thread_join(&threads[k]);
+    }
+
+    for (k = 0; k < workers; k++) {
+        mc_stats_merge(&total, &g_jobs[k].stats);
+    }
+
+    if (write_csv(path, &total) != 0) {
+        fprintf(stderr, "montecarlo: cannot write %s\n", path);
+        return 1;
+    }
+
+    printf("%u runs on %u worker(s), seed %u -> %s\n", total.runs, workers, base_seed, path);
+    printf("  felled %u  hand_lost %u  timeout %u  crit rate %.4f\n",
+           total.outcome[OUTCOME_FELLED], total.outcome[OUTCOME_HAND_LOST],
+           total.outcome[OUTCOME_TIMEOUT],
+           total.attempts ? (double)total.crits / (double)total.attempts : 0.0);
+    return 0;
+}
@@ -0,0 +1,318 @@
+/*
+ * net_bot.c -- Load-Test Bots for net_server.c
+ *
+ * PURPOSE:
+ *   Connects N WebSocket clients to a running marble_server and plays
+ *   them: each bot sends random move batches, decodes every snapshot
+ *   delta against its own history and acks it, as a real client must.
+ *   Exercises the whole path (handshake, masked frames, batches, DRR
+ *   ingress, AOI, delta history) and checks what comes back:
+ *
+ *     - every frame decodes against the base it names
+ *     - the bot's own entity is in every snapshot
+ *     - nothing outside the view radius is sent
+ *     - our entity moves (commands reach the simulation)
+ *
+ *   Exits 1 if any check failed, a bot was dropped, or no bot moved.
+ *
+ * USAGE:
+ *   marble_bot [host] [port] [bots] [seconds] [seed]
+ *   defaults: 127.0.0.1, 8080, 16 bots, 10 s, seed 1
+ *
+ * BUILD (from the repo root):
+ *   gcc -std=c99 -Wall -Wextra -O2 -I. -Iinclude src/net_bot.c -o marble_bot
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+/* Must match the server's ring: the client keeps the same history */
+#define NET_SNAPSHOT_HISTORY 8
+
+#include "marble_net.h"
+#include "marble_ws.h"
+#include "marble_platform_posix.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define BOT_MAX          256
+#define BOT_IN_BUF     65536
+#define BOT_SEND_US   100000u   /* a command batch every 100 ms */
+
+typedef enum {
+    BOT_DEAD = 0,
+    BOT_HANDSHAKE,
+    BOT_WELCOME,               /* upgraded, waiting for NET_MSG_WELCOME */
+    BOT_PLAYING
+} BotState;
+
+typedef struct {
+    int      fd;
+    uint8_t  state;
+    char     key[MC_WS_KEY_LEN + 1];
+    uint32_t entity_id;
+    uint16_t radius;
+    uint16_t sequence;
+    uint32_t in_len;
+    uint64_t next_send;
+    uint32_t snapshots;
+    uint32_t max_seen;         /* most entities in one snapshot */
+    uint32_t moves;            /* snapshots where our entity had moved */
+    uint16_t x, y;
+    NetSnapshotHistory history;
+    uint8_t  in[BOT_IN_BUF];
+} Bot;
+
+static Bot      g_bots[BOT_MAX];
+static Snapshot g_snap;
+static uint32_t g_rng = 1;
+
+/* Failures across all bots */
+static uint32_t g_decode_errors = 0;
+static uint32_t g_missing_self = 0;
+static uint32_t g_out_of_view = 0;
+static uint32_t g_dropped = 0;
+static uint64_t g_bytes_in = 0;
+
+static uint32_t bot_rand(void) {
+    g_rng = g_rng * 1664525u + 1013904223u;
+    return g_rng >> 8;
+}
+
+/* Blocking send of a whole buffer. Returns -1 on failure. */
+static int bot_send_all(Bot* b, const uint8_t* p, uint32_t len) {
+    while (len > 0) {
+        ssize_t n = write(b->fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (uint32_t)n;
+    }
+    return 0;
+}
+
+/* One masked binary message: tag byte + body */
+static int bot_send(Bot* b, uint8_t tag, const uint8_t* body, uint32_t len) {
+    uint8_t msg[1 + NET_BATCH_MAX_SIZE];
+    uint8_t frame[MC_WS_MAX_HEADER + sizeof(msg)];
+    uint32_t n;
+    msg[0] = tag;
+    memcpy(msg + 1, body, len);
+    n = mc_ws_write_frame(frame, sizeof(frame), MC_WS_OP_BINARY, msg, len + 1, 1, bot_rand());
+    return (n > 0) ? bot_send_all(b, frame, n) : -1;
+}
+
+static void bot_kill(Bot* b, int dropped) {
+    if (b->state == BOT_DEAD) return;
+    if (dropped) g_dropped++;
+    close(b->fd);
+    b->fd = -1;
+    b->state = BOT_DEAD;
+}
+
+static int bot_connect(Bot* b, const struct addrinfo* ai, const char* host) {
+    uint8_t nonce[16], req[512];
+    uint32_t i, n;
+    int one = 1;
+
+    memset(b, 0, sizeof(Bot));
+    b->fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (b->fd < 0) return -1;
+    if (connect(b->fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+        close(b->fd);
+        return -1;
+    }
+    setsockopt(b->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    for (i = 0; i < 16; i++) nonce[i] = (uint8_t)bot_rand();
+    mc_ws_base64(nonce, 16, b->key);
+    n = mc_ws_write_request(host, "/", b->key, req, sizeof(req));
+    b->state = BOT_HANDSHAKE;
+    net_history_init(&b->history);
+    return (n > 0) ? bot_send_all(b, req, n) : -1;
+}
+
+static void bot_check_snapshot(Bot* b, const Snapshot* s) {
+    const SnapshotEntity* self = NULL;
+    uint32_t i;
+    for (i = 0; i < s->entity_count; i++) {
+        if (s->entities[i].entity_id == b->entity_id) self = &s->entities[i];
+    }
+    if (self == NULL) {
+        g_missing_self++;
+        return;
+    }
+    for (i = 0; i < s->entity_count; i++) {
+        int dx = (int)s->entities[i].x - (int)self->x;
+        int dy = (int)s->entities[i].y - (int)self->y;
+        if (dx < -(int)b->radius || dx > (int)b->radius ||
+            dy < -(int)b->radius || dy > (int)b->radius) g_out_of_view++;
+    }
+    if (s->entity_count > b->max_seen) b->max_seen = s->entity_count;
+    if (b->snapshots > 1 && (self->x != b->x || self->y != b->y)) b->moves++;
+    b->x = self->x;
+    b->y = self->y;
+}
+
+/* One binary message from the server */
+static void bot_message(Bot* b, const uint8_t* p, uint32_t len) {
+    if (len == 0) return;
+    if (p[0] == NET_MSG_WELCOME && len == NET_WELCOME_SIZE && b->state == BOT_WELCOME) {
+        b->entity_id = net_get_u32(p + 1);
+        b->radius    = net_get_u16(p + 5);
+        b->state     = BOT_PLAYING;
+    } else if (p[0] == NET_MSG_SNAPSHOT && b->state == BOT_PLAYING) {
+        uint8_t ack[4];
+        const Snapshot* base = NULL;
+        uint32_t base_tick = net_snapshot_delta_base(p + 1, len - 1);
+        if (base_tick != NET_SNAPSHOT_NO_BASE) {
+            base = net_history_find(&b->history, base_tick);
+            if (base == NULL) {
+                g_decode_errors++;
+                return;
+            }
+        }
+        if (net_snapshot_read_delta(&g_snap, base, p + 1, len - 1) != 0) {
+            g_decode_errors++;
+            return;
+        }
+        net_history_store(&b->history, &g_snap);
+        b->snapshots++;
+        bot_check_snapshot(b, &g_snap);
+        net_put_u32(ack, g_snap.tick_number);
+        if (bot_send(b, NET_MSG_ACK, ack, 4) != 0) bot_kill(b, 1);
+    }
+}
+
+static void bot_readable(Bot* b) {
+    uint32_t used = 0;
+    ssize_t n = read(b->fd, b->in + b->in_len, BOT_IN_BUF - b->in_len);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) return;
+    if (n <= 0) {
+        bot_kill(b, 1);
+        return;
+    }
+    b->in_len += (uint32_t)n;
+    g_bytes_in += (uint64_t)n;
+
+    if (b->state == BOT_HANDSHAKE) {
+        int32_t r = mc_ws_check_response(b->in, b->in_len, b->key);
+        if (r == 0) return;
+        if (r < 0) {
+            bot_kill(b, 1);
+            return;
+        }
+        used = (uint32_t)r;
+        b->state = BOT_WELCOME;
+    }
+    while (b->state != BOT_DEAD) {
+        McWsFrame f;
+        int32_t r = mc_ws_parse_frame(b->in + used, b->in_len - used, 0,
+                                      BOT_IN_BUF - MC_WS_MAX_HEADER, &f);
+        if (r == 0) break;
+        if (r < 0 || f.opcode == MC_WS_OP_CLOSE) {
+            bot_kill(b, 1);
+            return;
+        }
+        if (f.opcode == MC_WS_OP_BINARY) bot_message(b, b->in + used + f.payload_off, f.payload_len);
+        used += (uint32_t)r;
+    }
+    if (b->state == BOT_DEAD) return;
+    memmove(b->in, b->in + used, b->in_len - used);
+    b->in_len -= used;
+}
+
+/* 1-3 random moves (the server ignores the entity id and uses ours) */
+static void bot_play(Bot* b) {
+    InteractionCommand cmds[3];
+    uint8_t pkt[NET_BATCH_MAX_SIZE];
+    uint32_t n = 1 + bot_rand() % 3, i, len;
+    for (i = 0; i < n; i++) {
+        cmds[i] = net_cmd_move(b->entity_id, (OpCode)(OP_MOVE_NORTH + bot_rand() % 8));
+        cmds[i].sequence = b->sequence++;
+    }
+    len = net_batch_write(cmds, n, pkt, sizeof(pkt));
+    if (len == 0 || bot_send(b, NET_MSG_COMMANDS, pkt, len) != 0) bot_kill(b, 1);
+}
+
+int main(int argc, char** argv) {
+    static struct pollfd fds[BOT_MAX];
+    const char* host = (argc > 1) ? argv[1] : "127.0.0.1";
+    const char* port = (argc > 2) ? argv[2] : "8080";
+    uint32_t count   = (argc > 3) ? (uint32_t)atoi(argv[3]) : 16;
+    uint32_t seconds = (argc > 4) ? (uint32_t)atoi(argv[4]) : 10;
+    struct addrinfo hints, *ai = NULL;
+    uint64_t start, end;
+    uint32_t i, playing = 0, snapshots = 0, max_seen = 0, moves = 0;
+
+    if (argc > 5) g_rng = (uint32_t)strtoul(argv[5], NULL, 10);
+    if (count > BOT_MAX) count = BOT_MAX;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &ai) != 0 || ai == NULL) {
+        fprintf(stderr, "[BOT] cannot resolve %s:%s\n", host, port);
+        return 1;
+    }
+    for (i = 0; i < count; i++) {
+        if (bot_connect(&g_bots[i], ai, host) != 0) {
+            fprintf(stderr, "[BOT] bot %u cannot connect to %s:%s\n", i, host, port);
+            freeaddrinfo(ai);
+            return 1;
+        }
+        g_bots[i].next_send = mc_platform_time_us() + bot_rand() % BOT_SEND_US;
+    }
+    freeaddrinfo(ai);
+
+    start = mc_platform_time_us();
+    end = start + (uint64_t)seconds * 1000000u;
+    while (mc_platform_time_us() < end) {
+        uint64_t now;
+        for (i = 0; i < count; i++) {
+            fds[i].fd = g_bots[i].fd;                /* -1 once dead: poll skips it */
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        if (poll(fds, count, 10) < 0 && errno != EINTR) break;
+        for (i = 0; i < count; i++) {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) bot_readable(&g_bots[i]);
+        }
+        now = mc_platform_time_us();
+        for (i = 0; i < count; i++) {
+            Bot* b = &g_bots[i];
+            if (b->state != BOT_PLAYING || now < b->next_send) continue;
+            b->next_send += BOT_SEND_US;
+            bot_play(b);
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        Bot* b = &g_bots[i];
+        if (b->state == BOT_PLAYING) playing++;
+        snapshots += b->snapshots;
+        moves += b->moves;
+        if (b->max_seen > max_seen) max_seen = b->max_seen;
+        if (b->state != BOT_DEAD) {
+            uint8_t frame[MC_WS_MAX_HEADER + 2];
+            uint32_t n = mc_ws_write_close(frame, sizeof(frame), MC_WS_CLOSE_NORMAL, 1, bot_rand());
+            bot_send_all(b, frame, n);
+            bot_kill(b, 0);
+        }
+    }
+
+    printf("[BOT] %u/%u bots playing, %u snapshots (%.1f KB/s in), %u moves, most entities in view %u\n",
+           playing, count, snapshots,
+           (double)g_bytes_in / 1024.0 / (seconds ? seconds : 1), moves, max_seen);
+    printf("[BOT] decode errors %u  missing self %u  out of view %u  dropped %u\n",
+           g_decode_errors, g_missing_self, g_out_of_view, g_dropped);
+    return (g_decode_errors || g_missing_self || g_out_of_view || g_dropped || moves == 0) ? 1 : 0;
+}
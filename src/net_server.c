@@ -0,0 +1,538 @@
+/*
+ * net_server.c -- MarbleEngine Dedicated Server (Linux, epoll)
+ *
+ * PURPOSE:
+ *   Hosts one NetWorld (marble_net.h) for WebSocket clients: the native
+ *   replacement for dedicated-server.js. No GC, no per-tick JSON: each
+ *   client gets one binary frame per tick holding a delta against the
+ *   last snapshot it acknowledged, filtered to what its entity can see.
+ *
+ * HOW:
+ *   One thread. Every socket is non-blocking and registered edge-
+ *   triggered, so each wakeup reads (or writes) until EAGAIN. Between
+ *   ticks the loop sleeps in epoll_wait() until the next tick deadline;
+ *   deadlines are absolute (start + n * interval), so tick timing does
+ *   not drift with load.
+ *
+ *   Tick:
+ *     1. net_tick_ingress(): each client's queued commands, deficit-
+ *        round-robin with per-client rate limits
+ *     2. NPCs wander (seeded LCG: same seed, same commands, same world)
+ *     3. per client: net_build_snapshot_for() -> delta vs its ack ->
+ *        one WebSocket binary frame
+ *
+ *   A client whose socket can't take this tick's frame skips it; the
+ *   next delta is still against its last ack, so nothing is lost. One
+ *   that stays backed up for NET_SERVER_STALL_TICKS is dropped.
+ *
+ * PROTOCOL:
+ *   RFC 6455 via include/marble_ws.h; messages as in marble_net.h
+ *   (SERVER MESSAGES). src/net_bot.c is a load-test client.
+ *
+ * USAGE:
+ *   marble_server [port] [tick_ms] [npcs] [seed]
+ *   defaults: 8080, NET_TICK_INTERVAL_MS, 32 NPCs, seed 1
+ *
+ * BUILD (from the repo root):
+ *   gcc -std=c99 -Wall -Wextra -O2 -I. -Iinclude src/net_server.c -o marble_server
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+/* Server sizing: more clients than the library default, and a shorter
+ * per-client snapshot history to keep BSS reasonable */
+#define NET_MAX_CLIENTS      512
+#define NET_SNAPSHOT_HISTORY 8
+
+#define MARBLE_NET_IMPLEMENTATION
+#include "marble_net.h"
+#include "marble_ws.h"
+#include "marble_platform_posix.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* =========================================================================
+ * CONFIGURATION
+ * ========================================================================= */
+
+#define NET_SERVER_IN_BUF       4096
+#define NET_SERVER_OUT_BUF     32768
+#define NET_SERVER_FRAME_MAX   (MC_WS_MAX_HEADER + 1 + NET_SNAPSHOT_DELTA_MAX)
+#define NET_SERVER_STALL_TICKS    50
+#define NET_SERVER_EVENTS        256
+#define NET_SERVER_PLAYER_ID0   1000   /* player ids: this + connection slot */
+#define NET_SERVER_VIEW_RADIUS     8
+#define NET_SERVER_STATS_US  5000000u
+
+#define LISTENER NET_MAX_CLIENTS       /* epoll tag for the listen socket */
+
+typedef enum {
+    CONN_FREE = 0,
+    CONN_HANDSHAKE,
+    CONN_OPEN
+} ConnState;
+
+typedef struct {
+    int      fd;
+    uint8_t  state;
+    uint32_t entity_id;
+    uint32_t in_len;
+    uint32_t out_off, out_len;
+    uint32_t stalled;          /* consecutive ticks a snapshot was skipped */
+    uint8_t  in[NET_SERVER_IN_BUF];
+    uint8_t  out[NET_SERVER_OUT_BUF];
+} Conn;
+
+static NetWorld           g_world;
+static NetIngress         g_ingress;
+static Conn               g_conns[NET_MAX_CLIENTS];
+static NetSnapshotHistory g_history[NET_MAX_CLIENTS];
+static NetInterest        g_interest[NET_MAX_CLIENTS];
+static Snapshot           g_snap;
+static uint8_t            g_scratch[NET_SERVER_FRAME_MAX];
+static int                g_epoll = -1;
+static uint32_t           g_rng = 1;
+static uint32_t           g_npcs = 32;
+static uint32_t           g_open = 0;
+static volatile sig_atomic_t g_stop = 0;
+
+/* Counters since the last stats line */
+static uint64_t g_bytes_out = 0;
+static uint64_t g_tick_us = 0;
+static uint32_t g_ticks = 0;
+static uint32_t g_skipped = 0;
+static uint32_t g_truncated = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+static uint32_t server_rand(uint32_t n) {
+    g_rng = g_rng * 1664525u + 1013904223u;
+    return (g_rng >> 8) % n;
+}
+
+/* =========================================================================
+ * WORLD
+ * ========================================================================= */
+
+/* Walled room with a deterministic scatter of pillars */
+static void build_map(TileMap* m) {
+    int x, y;
+    net_map_init(m);
+    for (y = 1; y < NET_MAP_H - 1; y++) {
+        for (x = 1; x < NET_MAP_W - 1; x++) {
+            uint32_t h = (uint32_t)(x * 73856093) ^ (uint32_t)(y * 19349663);
+            m->tiles[y][x] = (x % 5 == 0 && y % 4 == 0 && (h & 1)) ? 1 : 0;
+        }
+    }
+}
+
+static void random_floor(uint16_t* x, uint16_t* y) {
+    do {
+        *x = (uint16_t)server_rand(NET_MAP_W);
+        *y = (uint16_t)server_rand(NET_MAP_H);
+    } while (!net_map_walkable(&g_world.map, *x, *y));
+}
+
+static void spawn_npcs(void) {
+    uint32_t i;
+    for (i = 0; i < g_npcs; i++) {
+        uint16_t x, y;
+        random_floor(&x, &y);
+        net_world_add_entity(&g_world, 1 + i, x, y, 10, 10, 'S');
+    }
+}
+
+/* Each NPC tries a random step about one tick in three. Blocked steps
+ * are rejected by validation like any client's. */
+static void npcs_wander(void) {
+    uint32_t i;
+    for (i = 0; i < g_npcs; i++) {
+        InteractionCommand cmd;
+        if (server_rand(3) != 0) continue;
+        cmd = net_cmd_move(1 + i, (OpCode)(OP_MOVE_NORTH + server_rand(8)));
+        net_process_command(&g_world, &cmd);
+    }
+}
+
+/* =========================================================================
+ * CONNECTIONS
+ * ========================================================================= */
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) ? -1 : 0;
+}
+
+/* Write as much pending output as the socket takes. Returns -1 if the
+ * connection failed. */
+static int conn_flush(Conn* c) {
+    while (c->out_off < c->out_len) {
+        ssize_t n = write(c->fd, c->out + c->out_off, c->out_len - c->out_off);
+        if (n > 0) {
+            c->out_off += (uint32_t)n;
+            g_bytes_out += (uint64_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return -1;
+        }
+    }
+    if (c->out_off == c->out_len) {
+        c->out_off = c->out_len = 0;
+    } else if (c->out_off > NET_SERVER_OUT_BUF / 2) {
+        memmove(c->out, c->out + c->out_off, c->out_len - c->out_off);
+        c->out_len -= c->out_off;
+        c->out_off = 0;
+    }
+    return 0;
+}
+
+static uint32_t conn_room(const Conn* c) {
+    return NET_SERVER_OUT_BUF - c->out_len;
+}
+
+/* Append one binary message: tag byte + body. Returns -1 if it doesn't
+ * fit in the output buffer. */
+static int conn_send(Conn* c, uint8_t tag, const uint8_t* body, uint32_t len) {
+    uint32_t n;
+    if (len + 1 > sizeof(g_scratch)) return -1;
+    g_scratch[0] = tag;
+    memmove(g_scratch + 1, body, len);
+    n = mc_ws_write_frame(c->out + c->out_len, conn_room(c), MC_WS_OP_BINARY, g_scratch, len + 1, 0, 0);
+    if (n == 0) return -1;
+    c->out_len += n;
+    return 0;
+}
+
+static void conn_close(uint32_t i) {
+    Conn* c = &g_conns[i];
+    if (c->state == CONN_FREE) return;
+    if (c->state == CONN_OPEN) {
+        net_world_remove_entity(&g_world, c->entity_id);
+        net_ingress_disconnect(&g_ingress, i);
+        g_open--;
+        printf("[SERVER] client %u left (entity %u), %u connected\n", i, c->entity_id, g_open);
+    }
+    epoll_ctl(g_epoll, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    c->state = CONN_FREE;
+}
+
+/* Best effort: queue a close frame, push it out, then drop */
+static void conn_fail(uint32_t i, uint16_t code) {
+    Conn* c = &g_conns[i];
+    if (c->state == CONN_OPEN) {
+        uint32_t n = mc_ws_write_close(c->out + c->out_len, conn_room(c), code, 0, 0);
+        c->out_len += n;
+        conn_flush(c);
+    }
+    conn_close(i);
+}
+
+static void accept_all(int listen_fd) {
+    for (;;) {
+        struct epoll_event ev;
+        uint32_t i;
+        int one = 1;
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;                                 /* EAGAIN: drained */
+        }
+        for (i = 0; i < NET_MAX_CLIENTS && g_conns[i].state != CONN_FREE; i++) { }
+        if (i == NET_MAX_CLIENTS || set_nonblocking(fd) != 0) {
+            close(fd);
+            continue;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        memset(&g_conns[i], 0, sizeof(Conn));
+        g_conns[i].fd = fd;
+        g_conns[i].state = CONN_HANDSHAKE;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.u32 = i;
+        if (epoll_ctl(g_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            g_conns[i].state = CONN_FREE;
+        }
+    }
+}
+
+/* Handshake done: give the connection an entity and the map */
+static int conn_join(uint32_t i) {
+    Conn* c = &g_conns[i];
+    uint8_t welcome[NET_WELCOME_SIZE];
+    uint16_t x, y;
+    int row;
+
+    c->entity_id = NET_SERVER_PLAYER_ID0 + i;
+    random_floor(&x, &y);
+    if (net_world_add_entity(&g_world, c->entity_id, x, y, 30, 30, '@') != 0) return -1;
+    net_ingress_connect(&g_ingress, i);
+    net_history_init(&g_history[i]);
+    net_interest_init(&g_interest[i], c->entity_id, NET_SERVER_VIEW_RADIUS, 1);
+    c->state = CONN_OPEN;
+    g_open++;
+
+    net_put_u32(welcome, c->entity_id);
+    net_put_u16(welcome + 4, NET_SERVER_VIEW_RADIUS);
+    net_put_u16(welcome + 6, NET_MAP_W);
+    net_put_u16(welcome + 8, NET_MAP_H);
+    for (row = 0; row < NET_MAP_H; row++) {
+        memcpy(welcome + 10 + row * NET_MAP_W, g_world.map.tiles[row], NET_MAP_W);
+    }
+    printf("[SERVER] client %u joined as entity %u at (%u,%u), %u connected\n",
+           i, c->entity_id, x, y, g_open);
+    return conn_send(c, NET_MSG_WELCOME, welcome, NET_WELCOME_SIZE - 1);
+}
+
+/* One binary message from an open connection */
+static void conn_message(uint32_t i, const uint8_t* p, uint32_t len) {
+    Conn* c = &g_conns[i];
+    if (len == 0) return;
+    if (p[0] == NET_MSG_COMMANDS) {
+        InteractionCommand cmds[NET_BATCH_MAX_CMDS];
+        int n = net_batch_read(p + 1, len - 1, cmds, NET_BATCH_MAX_CMDS);
+        int k;
+        for (k = 0; k < n; k++) {
+            cmds[k].entity_id = c->entity_id;       /* clients only drive their own entity */
+            net_ingress_push(&g_ingress, i, &cmds[k]);
+        }
+    } else if (p[0] == NET_MSG_ACK && len == 5) {
+        net_history_ack(&g_history[i], net_get_u32(p + 1));
+    }
+}
+
+/* Consume whatever complete handshake/frames are buffered. Returns -1 if
+ * the connection was closed. */
+static int conn_process(uint32_t i) {
+    Conn* c = &g_conns[i];
+    uint32_t used = 0;
+
+    if (c->state == CONN_HANDSHAKE) {
+        char key[MC_WS_KEY_LEN + 1];
+        int32_t r = mc_ws_parse_request(c->in, c->in_len, key);
+        if (r == 0) return 0;
+        if (r < 0) {
+            static const char bad[] = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+            if (write(c->fd, bad, sizeof(bad) - 1) < 0) { }
+            conn_close(i);
+            return -1;
+        }
+        used = (uint32_t)r;
+        c->out_len += mc_ws_write_response(key, c->out + c->out_len, conn_room(c));
+        if (conn_join(i) != 0) {
+            conn_close(i);
+            return -1;
+        }
+    }
+
+    for (;;) {
+        McWsFrame f;
+        int32_t r = mc_ws_parse_frame(c->in + used, c->in_len - used, 1,
+                                      NET_SERVER_IN_BUF - MC_WS_MAX_HEADER, &f);
+        const uint8_t* p;
+        if (r == 0) break;
+        if (r < 0) {
+            conn_fail(i, MC_WS_CLOSE_PROTOCOL);
+            return -1;
+        }
+        p = c->in + used + f.payload_off;
+        if (f.opcode == MC_WS_OP_BINARY) {
+            conn_message(i, p, f.payload_len);
+        } else if (f.opcode == MC_WS_OP_PING) {
+            c->out_len += mc_ws_write_frame(c->out + c->out_len, conn_room(c), MC_WS_OP_PONG,
+                                            p, f.payload_len, 0, 0);
+        } else if (f.opcode == MC_WS_OP_CLOSE) {
+            conn_fail(i, MC_WS_CLOSE_NORMAL);
+            return -1;
+        }
+        used += (uint32_t)r;
+    }
+    if (used > 0) {
+        memmove(c->in, c->in + used, c->in_len - used);
+        c->in_len -= used;
+    }
+    return (conn_flush(c) == 0) ? 0 : (conn_close(i), -1);
+}
+
+/* Edge-triggered: read until EAGAIN, parsing as the buffer fills */
+static void conn_readable(uint32_t i) {
+    Conn* c = &g_conns[i];
+    for (;;) {
+        ssize_t n;
+        if (c->in_len == NET_SERVER_IN_BUF) {
+            conn_fail(i, MC_WS_CLOSE_TOO_BIG);       /* a frame bigger than we accept */
+            return;
+        }
+        n = read(c->fd, c->in + c->in_len, NET_SERVER_IN_BUF - c->in_len);
+        if (n > 0) {
+            c->in_len += (uint32_t)n;
+            if (conn_process(i) != 0) return;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            conn_close(i);                            /* EOF or error */
+            return;
+        }
+    }
+}
+
+/* =========================================================================
+ * TICK
+ * ========================================================================= */
+
+static void server_tick(void) {
+    uint64_t t0 = mc_platform_time_us();
+    uint32_t i;
+
+    net_tick_ingress(&g_world, &g_ingress);
+    npcs_wander();
+
+    for (i = 0; i < NET_MAX_CLIENTS; i++) {
+        Conn* c = &g_conns[i];
+        uint32_t n;
+        if (c->state != CONN_OPEN) continue;
+        if (conn_room(c) < NET_SERVER_FRAME_MAX) {
+            g_skipped++;
+            if (++c->stalled > NET_SERVER_STALL_TICKS) conn_close(i);
+            continue;
+        }
+        c->stalled = 0;
+        net_build_snapshot_for(&g_world, &g_interest[i], &g_snap);
+        g_truncated += g_interest[i].truncated;
+        g_snap.last_ack_sequence = g_ingress.clients[i].last_sequence;
+        n = net_snapshot_write_for_client(&g_history[i], &g_snap, g_scratch + 1, sizeof(g_scratch) - 1);
+        if (n == 0 || conn_send(c, NET_MSG_SNAPSHOT, g_scratch + 1, n) != 0) continue;
+        if (conn_flush(c) != 0) conn_close(i);
+    }
+
+    g_tick_us += mc_platform_time_us() - t0;
+    g_ticks++;
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+static int listen_on(uint16_t port) {
+    struct sockaddr_in addr;
+    struct epoll_event ev;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0 ||
+        set_nonblocking(fd) != 0) {
+        close(fd);
+        return -1;
+    }
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u32 = LISTENER;
+    if (epoll_ctl(g_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    static struct epoll_event events[NET_SERVER_EVENTS];
+    uint16_t port   = (argc > 1) ? (uint16_t)atoi(argv[1]) : 8080;
+    uint32_t tick_ms = (argc > 2) ? (uint32_t)atoi(argv[2]) : NET_TICK_INTERVAL_MS;
+    uint64_t tick_us, next_tick, next_stats;
+    int listen_fd;
+    uint32_t i;
+
+    if (argc > 3) g_npcs = (uint32_t)atoi(argv[3]);
+    if (argc > 4) g_rng = (uint32_t)strtoul(argv[4], NULL, 10);
+    if (tick_ms == 0) tick_ms = 1;
+    if (g_npcs >= NET_SERVER_PLAYER_ID0) g_npcs = NET_SERVER_PLAYER_ID0 - 1;
+    tick_us = (uint64_t)tick_ms * 1000u;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    net_init_opcode_names();
+    net_world_init(&g_world);
+    build_map(&g_world.map);
+    spawn_npcs();
+    net_ingress_init(&g_ingress, 0, 0, 0);
+    for (i = 0; i < NET_MAX_CLIENTS; i++) g_conns[i].fd = -1;
+
+    g_epoll = epoll_create1(0);
+    listen_fd = (g_epoll >= 0) ? listen_on(port) : -1;
+    if (listen_fd < 0) {
+        fprintf(stderr, "[SERVER] cannot listen on port %u: %s\n", port, strerror(errno));
+        return 1;
+    }
+    printf("[SERVER] NetWorld %dx%d, %u NPCs, tick %u ms, listening on port %u\n",
+           NET_MAP_W, NET_MAP_H, g_npcs, tick_ms, port);
+    fflush(stdout);
+
+    next_tick  = mc_platform_time_us() + tick_us;
+    next_stats = mc_platform_time_us() + NET_SERVER_STATS_US;
+    while (!g_stop) {
+        uint64_t now = mc_platform_time_us();
+        int timeout = (next_tick > now) ? (int)((next_tick - now + 999) / 1000) : 0;
+        int n = epoll_wait(g_epoll, events, NET_SERVER_EVENTS, timeout);
+        int k;
+
+        for (k = 0; k < n; k++) {
+            uint32_t tag = events[k].data.u32;
+            uint32_t ev = events[k].events;
+            if (tag == LISTENER) {
+                accept_all(listen_fd);
+                continue;
+            }
+            if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) conn_readable(tag);
+            if ((ev & EPOLLOUT) && g_conns[tag].state != CONN_FREE && conn_flush(&g_conns[tag]) != 0) {
+                conn_close(tag);
+            }
+        }
+
+        now = mc_platform_time_us();
+        if (now >= next_tick) {
+            server_tick();
+            next_tick += tick_us;
+            if (now > next_tick + 10 * tick_us) next_tick = now + tick_us;  /* stalled: resync */
+        }
+        if (now >= next_stats) {
+            printf("[SERVER] tick %u  clients %u  entities %u  tick cost %.1f us  out %.1f KB/s  skipped %u  truncated %u\n",
+                   g_world.tick, g_open, g_world.entity_count,
+                   g_ticks ? (double)g_tick_us / g_ticks : 0.0,
+                   (double)g_bytes_out / 1024.0 / (NET_SERVER_STATS_US / 1e6), g_skipped, g_truncated);
+            fflush(stdout);
+            g_bytes_out = g_tick_us = 0;
+            g_ticks = g_skipped = g_truncated = 0;
+            next_stats = now + NET_SERVER_STATS_US;
+        }
+    }
+
+    for (i = 0; i < NET_MAX_CLIENTS; i++) conn_fail(i, MC_WS_CLOSE_NORMAL);
+    close(listen_fd);
+    close(g_epoll);
+    printf("[SERVER] stopped at tick %u\n", g_world.tick);
+    return 0;
+}
@@ -8,13 +8,16 @@
  *   - Movement delta table
  *   - World validation (blocked, dead entity, bad entity, etc.)
  *   - Full tick processing (queue -> validate -> apply -> snapshot)
+ *   - Snapshot wire format (plain + LZ frame)
+ *   - Lock-free MPSC ingress ring under concurrent producers
  *   - Interactive WASD demo (when run with --demo flag)
  *
  * BUILD (GCC/MinGW):
- *   gcc -std=c99 -Wall -Wextra -O2 test_net.c -o test_net.exe
+ *   gcc -std=c99 -Wall -Wextra -O2 -Iinclude test_net.c -o test_net.exe
+ *   (Linux/macOS: add -lpthread for the MPSC producer threads)
  *
  * BUILD (Emscripten/WASM):
- *   emcc -std=c99 -Wall -Wextra -O2 test_net.c -o test_net.js
+ *   emcc -std=c99 -Wall -Wextra -O2 -Iinclude test_net.c -o test_net.js
  *
  * RUN:
  *   test_net.exe            (unit tests only)
@@ -23,6 +26,7 @@
 
 #define MARBLE_NET_IMPLEMENTATION
 #include "marble_net.h"
+#include "marble_thread.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -608,6 +612,80 @@ static void test_validate_unknown_opcode(void) {
     TEST_END();
 }
 
+static void test_world_lookup_full(void) {
+    TEST_BEGIN("world: O(1) lookup over a full world of scattered ids");
+    {
+        static NetWorld w;
+        uint32_t i, bad = 0;
+
+        net_world_init(&w);
+        for (i = 0; i < NET_MAX_ENTITIES; i++) {
+            if (net_world_add_entity(&w, (i * 7919u) % NET_MAX_ENTITY_ID, 1, 1, 10, 10, 'S') != 0) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT_EQ_U32(w.entity_count, NET_MAX_ENTITIES);
+
+        /* Full, duplicate and out-of-range ids are refused */
+        ASSERT_EQ_I32(net_world_add_entity(&w, 3, 1, 1, 10, 10, 'S'), -1);
+        net_world_init(&w);
+        ASSERT_EQ_I32(net_world_add_entity(&w, 42, 1, 1, 10, 10, 'S'), 0);
+        ASSERT_EQ_I32(net_world_add_entity(&w, 42, 2, 2, 10, 10, 'S'), -1);
+        ASSERT_EQ_I32(net_world_add_entity(&w, NET_MAX_ENTITY_ID, 1, 1, 10, 10, 'S'), -1);
+        ASSERT_NULL(net_world_find_entity(&w, NET_MAX_ENTITY_ID));
+        ASSERT_NULL(net_world_find_entity(&w, 0));   /* slot_of[0] == 0, wrong id */
+
+        net_world_init(&w);
+        for (i = 0; i < NET_MAX_ENTITIES; i++) {
+            net_world_add_entity(&w, (i * 7919u) % NET_MAX_ENTITY_ID, 1, 1, 10, 10, 'S');
+        }
+        for (i = 0; i < NET_MAX_ENTITIES; i++) {
+            uint32_t id = (i * 7919u) % NET_MAX_ENTITY_ID;
+            NetEntity* e = net_world_find_entity(&w, id);
+            if (e == NULL || e->entity_id != id) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+    }
+    TEST_END();
+}
+
+static void test_world_remove_swaps(void) {
+    TEST_BEGIN("world: despawn swap-removes and keeps lookups and hash valid");
+    {
+        static NetWorld w;
+        InteractionCommand cmd;
+
+        net_world_init(&w);
+        w.map.tiles[5][5] = 0;
+        net_world_add_entity(&w, 10, 1, 1, 10, 10, '@');
+        net_world_add_entity(&w, 20, 2, 2, 10, 10, 'S');
+        net_world_add_entity(&w, 30, 3, 3, 10, 10, 'S');
+        net_world_add_entity(&w, 40, 4, 4, 10, 10, 'S');
+
+        ASSERT_EQ_I32(net_world_remove_entity(&w, 20), 0);
+        ASSERT_EQ_I32(net_world_remove_entity(&w, 20), -1);
+        ASSERT_EQ_U32(w.entity_count, 3);
+        ASSERT_EQ_U32(w.entities[1].entity_id, 40);      /* last moved in */
+        ASSERT_NULL(net_world_find_entity(&w, 20));
+        ASSERT_NOT_NULL(net_world_find_entity(&w, 40));
+        ASSERT_EQ_U16(net_world_find_entity(&w, 40)->x, 4);
+        ASSERT(w.state_hash == net_world_compute_hash(&w));
+
+        /* Removing the last slot, then commands against the moved entity */
+        ASSERT_EQ_I32(net_world_remove_entity(&w, 30), 0);
+        cmd = net_cmd_melee(10, 40);
+        ASSERT_EQ_I32(net_process_command(&w, &cmd), VALIDATE_OK);
+        ASSERT_EQ_I32(net_world_find_entity(&w, 40)->hp, 5);
+        cmd = net_cmd_melee(10, 30);
+        ASSERT_EQ_I32(net_process_command(&w, &cmd), VALIDATE_FAIL_NO_TARGET);
+        ASSERT(w.state_hash == net_world_compute_hash(&w));
+
+        /* The id is reusable */
+        ASSERT_EQ_I32(net_world_add_entity(&w, 20, 5, 5, 10, 10, 'S'), 0);
+        ASSERT_EQ_U32(net_world_find_entity(&w, 20) - w.entities, 2);
+    }
+    TEST_END();
+}
+
 /* =========================================================================
  * SECTION 6: FULL TICK PROCESSING
  * ========================================================================= */
@@ -727,8 +805,1175 @@ static void test_snapshot_dead_entity(void) {
     TEST_END();
 }
 
+static void fill_test_snapshot(Snapshot* snap, uint32_t n) {
+    uint32_t i;
+    net_snapshot_init(snap);
+    snap->tick_number = 9001;
+    snap->last_ack_sequence = 0xBEEF;
+    snap->state_hash = 0x0123456789ABCDEFull;
+    for (i = 0; i < n; i++) {
+        SnapshotEntity e;
+        memset(&e, 0, sizeof(e));
+        e.entity_id   = 1000 + i;
+        e.x           = (uint16_t)(i % NET_MAP_W);
+        e.y           = (uint16_t)(i / NET_MAP_W);
+        e.glyph       = 'g';
+        e.entity_type = 1;
+        e.hp          = (int16_t)(-5 + (int)(i % 3));
+        e.max_hp      = 20;
+        e.flags       = 0x01;
+        e.sprite_id   = 7;
+        net_snapshot_add_entity(snap, &e);
+    }
+}
+
+static int snapshots_equal(const Snapshot* a, const Snapshot* b) {
+    uint32_t i;
+    if (a->entity_count != b->entity_count || a->tick_number != b->tick_number
+        || a->last_ack_sequence != b->last_ack_sequence
+        || a->protocol_version != b->protocol_version
+        || a->state_hash != b->state_hash) return 0;
+    for (i = 0; i < a->entity_count; i++) {
+        const SnapshotEntity* x = &a->entities[i];
+        const SnapshotEntity* y = &b->entities[i];
+        if (x->entity_id != y->entity_id || x->x != y->x || x->y != y->y
+            || x->glyph != y->glyph || x->entity_type != y->entity_type
+            || x->hp != y->hp || x->max_hp != y->max_hp
+            || x->flags != y->flags || x->sprite_id != y->sprite_id) return 0;
+    }
+    return 1;
+}
+
+static void test_snapshot_wire_roundtrip(void) {
+    TEST_BEGIN("snapshot: write/read roundtrip (explicit LE packing)");
+    {
+        static Snapshot a, b;
+        uint8_t buf[NET_SNAPSHOT_WIRE_MAX];
+        uint32_t len;
+        fill_test_snapshot(&a, 40);
+        len = net_snapshot_write(&a, buf, sizeof(buf));
+        ASSERT_EQ_U32(len, NET_SNAPSHOT_HEADER_SIZE + 40 * NET_SNAPSHOT_ENTITY_SIZE);
+        ASSERT_EQ_U8(buf[0], 0x29);             /* 9001 = 0x2329, LE */
+        ASSERT_EQ_I32(net_snapshot_read(&b, buf, len), 0);
+        ASSERT(snapshots_equal(&a, &b));
+        ASSERT_EQ_I32((int32_t)b.entities[0].hp, -5);
+
+        ASSERT_EQ_U32(net_snapshot_write(&a, buf, len - 1), 0);
+        ASSERT_EQ_I32(net_snapshot_read(&b, buf, len - 1), -1);
+    }
+    TEST_END();
+}
+
+static void test_snapshot_lz_roundtrip(void) {
+    TEST_BEGIN("snapshot: LZ frame roundtrip, smaller than raw");
+    {
+        static Snapshot a, b;
+        static McLzWriter lz;
+        uint8_t frame[NET_SNAPSHOT_WIRE_MAX + 64];
+        uint32_t len;
+        fill_test_snapshot(&a, NET_MAX_SNAPSHOT_ENTS);
+        len = net_snapshot_write_lz(&a, &lz, frame, sizeof(frame));
+        ASSERT(len > 0);
+        ASSERT(len * 4 < net_snapshot_wire_size(&a) * 3);
+        ASSERT_EQ_I32(net_snapshot_read_lz(&b, frame, len), 0);
+        ASSERT(snapshots_equal(&a, &b));
+
+        frame[len - 1] ^= 0x40;                  /* corrupt payload */
+        ASSERT_EQ_I32(net_snapshot_read_lz(&b, frame, len), -1);
+    }
+    TEST_END();
+}
+
+static void test_snapshot_state_hash(void) {
+    TEST_BEGIN("snapshot: carries the running world hash, catches divergence");
+    {
+        static NetWorld a, b;
+        static Snapshot sa, sb;
+        InteractionCommand cmd;
+
+        net_world_init(&a);
+        a.map.tiles[5][5] = 0;
+        a.map.tiles[5][6] = 0;
+        net_world_add_entity(&a, 1, 5, 5, 10, 10, '@');
+        net_world_add_entity(&a, 2, 9, 9, 15, 15, 'S');
+        b = a;
+
+        cmd = net_cmd_move(1, OP_MOVE_EAST);
+        ASSERT_EQ_I32(net_process_command(&a, &cmd), VALIDATE_OK);
+        ASSERT_EQ_I32(net_process_command(&b, &cmd), VALIDATE_OK);
+        cmd = net_cmd_melee(1, 2);
+        ASSERT_EQ_I32(net_process_command(&a, &cmd), VALIDATE_OK);
+        ASSERT_EQ_I32(net_process_command(&b, &cmd), VALIDATE_OK);
+        ASSERT(a.state_hash == net_world_compute_hash(&a));
+        ASSERT(a.state_hash == b.state_hash);
+
+        net_build_snapshot(&a, &sa);
+        ASSERT(sa.state_hash == a.state_hash);
+
+        /* Mirror drifts by one hp: the hashes disagree on this tick */
+        b.entities[1].hp -= 1;
+        b.state_hash = net_world_compute_hash(&b);
+        net_build_snapshot(&b, &sb);
+        ASSERT(sa.state_hash != sb.state_hash);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 8: DELTA SNAPSHOTS
+ * ========================================================================= */
+
+/* Same entities (matched by id) and header; order may differ */
+static int snapshots_same_by_id(const Snapshot* a, const Snapshot* b) {
+    uint32_t i, j;
+    if (a->entity_count != b->entity_count || a->tick_number != b->tick_number
+        || a->last_ack_sequence != b->last_ack_sequence
+        || a->protocol_version != b->protocol_version
+        || a->state_hash != b->state_hash) return 0;
+    for (i = 0; i < a->entity_count; i++) {
+        const SnapshotEntity* x = &a->entities[i];
+        for (j = 0; j < b->entity_count; j++) {
+            if (b->entities[j].entity_id == x->entity_id) break;
+        }
+        if (j == b->entity_count) return 0;
+        if (memcmp(x, &b->entities[j], sizeof(*x)) != 0) return 0;
+    }
+    return 1;
+}
+
+static uint32_t g_delta_lcg = 7;
+static uint32_t delta_rand(uint32_t n) {
+    g_delta_lcg = g_delta_lcg * 1664525u + 1013904223u;
+    return (g_delta_lcg >> 8) % n;
+}
+
+static void test_delta_varint(void) {
+    TEST_BEGIN("delta: varint and zigzag round-trip, reject truncation");
+    {
+        static const uint32_t vals[] = { 0, 1, 127, 128, 16383, 16384, 0x0FFFFFFFu, UINT32_MAX };
+        static const int32_t svals[] = { 0, -1, 1, -64, 64, INT16_MIN, INT16_MAX, INT32_MIN, INT32_MAX };
+        uint8_t buf[8];
+        uint32_t i, pos, v;
+        for (i = 0; i < sizeof(vals) / sizeof(vals[0]); i++) {
+            pos = 0;
+            ASSERT_EQ_I32(net_put_varint(buf, sizeof(buf), &pos, vals[i]), 0);
+            v = pos;
+            pos = 0;
+            ASSERT_EQ_I32(net_get_varint(buf, v, &pos, &v), 0);
+            ASSERT_EQ_U32(v, vals[i]);
+        }
+        for (i = 0; i < sizeof(svals) / sizeof(svals[0]); i++) {
+            ASSERT_EQ_I32(net_unzigzag(net_zigzag(svals[i])), svals[i]);
+        }
+        ASSERT_EQ_U32(net_zigzag(-1), 1);
+        ASSERT_EQ_U32(net_zigzag(1), 2);
+
+        pos = 0;
+        ASSERT_EQ_I32(net_put_varint(buf, 1, &pos, 300), -1);   /* needs 2 bytes */
+        memset(buf, 0x80, sizeof(buf));
+        pos = 0;
+        ASSERT_EQ_I32(net_get_varint(buf, 3, &pos, &v), -1);    /* runs off the end */
+        pos = 0;
+        ASSERT_EQ_I32(net_get_varint(buf, 8, &pos, &v), -1);    /* longer than 5 */
+        buf[4] = 0x0F;
+        pos = 0;
+        ASSERT_EQ_I32(net_get_varint(buf, 5, &pos, &v), 0);     /* 32 bits exactly */
+        ASSERT_EQ_U32(v, 0xF0000000u);
+        buf[4] = 0x10;
+        pos = 0;
+        ASSERT_EQ_I32(net_get_varint(buf, 5, &pos, &v), -1);    /* bit 32 set */
+    }
+    TEST_END();
+}
+
+static void test_delta_client_roundtrip(void) {
+    TEST_BEGIN("delta: evolving world decodes exactly with lagging, lost acks");
+    {
+        static NetWorld w;
+        static NetSnapshotHistory server, client;
+        static Snapshot cur, got;
+        uint8_t frame[NET_SNAPSHOT_DELTA_MAX];
+        uint32_t t, i, n, bad = 0, based = 0, next_id = 200;
+
+        net_world_init(&w);
+        for (i = 0; i < 200; i++) net_world_add_entity(&w, i, (uint16_t)(i % 30), (uint16_t)(i / 30), 20, 20, 'S');
+        net_history_init(&server);
+        net_history_init(&client);
+
+        for (t = 0; t < 300; t++) {
+            /* A few moves, hits, spawns and despawns per tick */
+            for (i = 0; i < 6; i++) {
+                NetEntity* e = &w.entities[delta_rand(w.entity_count)];
+                w.state_hash ^= net_entity_hash(e);
+                if (i & 1) e->x = (uint16_t)(e->x + delta_rand(3) - 1);
+                else       e->hp = (int16_t)(e->hp - (int16_t)delta_rand(4));
+                w.state_hash ^= net_entity_hash(e);
+            }
+            if (delta_rand(3) == 0) net_world_remove_entity(&w, w.entities[delta_rand(w.entity_count)].entity_id);
+            if (delta_rand(3) == 0) net_world_add_entity(&w, next_id++, 3, 3, 9, 9, 'N');
+            w.tick = t;
+            net_build_snapshot(&w, &cur);
+            cur.last_ack_sequence = (uint16_t)t;
+
+            n = net_snapshot_write_for_client(&server, &cur, frame, sizeof(frame));
+            if (n == 0) { bad++; continue; }
+            if (net_snapshot_delta_base(frame, n) != NET_SNAPSHOT_NO_BASE) based++;
+
+            /* Client: decode against its own copy of the base */
+            if (net_snapshot_read_delta(&got, net_history_find(&client, net_snapshot_delta_base(frame, n)),
+                                        frame, n) != 0) { bad++; continue; }
+            if (!snapshots_same_by_id(&got, &cur)) bad++;
+            net_history_store(&client, &got);
+
+            /* Ack every third tick; one in five acks is lost */
+            if (t % 3 == 0 && delta_rand(5) != 0) net_history_ack(&server, t);
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT(based > 250);
+        ASSERT_EQ_I32(net_history_ack(&server, server.acked_tick), -1);   /* stale */
+        ASSERT_EQ_I32(net_history_ack(&server, 100000), -1);              /* never sent */
+    }
+    TEST_END();
+}
+
+static void test_delta_bandwidth(void) {
+    TEST_BEGIN("delta: static scene costs 10x+ less than a full snapshot");
+    {
+        static Snapshot a, b, got;
+        uint8_t frame[NET_SNAPSHOT_DELTA_MAX];
+        uint32_t n, full, i;
+
+        fill_test_snapshot(&a, NET_MAX_SNAPSHOT_ENTS);
+        b = a;
+        b.tick_number = a.tick_number + 1;
+        full = net_snapshot_wire_size(&b);
+
+        /* Nothing changed: header + three empty lists */
+        n = net_snapshot_write_delta(&a, &b, frame, sizeof(frame));
+        ASSERT_EQ_U32(n, NET_SNAPSHOT_HEADER_SIZE + 3);
+        ASSERT(n * 10 < full);
+
+        /* 10% of entities step one tile */
+        for (i = 0; i < NET_MAX_SNAPSHOT_ENTS; i += 10) b.entities[i].x++;
+        n = net_snapshot_write_delta(&a, &b, frame, sizeof(frame));
+        ASSERT(n * 10 < full);
+        ASSERT_EQ_I32(net_snapshot_read_delta(&got, &a, frame, n), 0);
+        ASSERT(snapshots_same_by_id(&got, &b));
+
+        /* With no base it's a full list, still smaller than fixed rows */
+        n = net_snapshot_write_delta(NULL, &b, frame, sizeof(frame));
+        ASSERT(n > 0 && n < full);
+        ASSERT_EQ_I32(net_snapshot_read_delta(&got, NULL, frame, n), 0);
+        ASSERT(snapshots_same_by_id(&got, &b));
+        ASSERT_EQ_U32(net_snapshot_write_delta(NULL, &b, frame, 40), 0);   /* cap */
+    }
+    TEST_END();
+}
+
+static void test_delta_rejects_bad_frames(void) {
+    TEST_BEGIN("delta: wrong base, truncation and corruption are refused");
+    {
+        static Snapshot a, b, got, other;
+        uint8_t frame[NET_SNAPSHOT_DELTA_MAX], bent[NET_SNAPSHOT_DELTA_MAX];
+        uint32_t n, len, i, bad = 0;
+
+        fill_test_snapshot(&a, 50);
+        b = a;
+        b.tick_number++;
+        b.entities[3].hp = 99;
+        b.entities[7] = b.entities[--b.entity_count];             /* despawn */
+        b.entities[b.entity_count].entity_id = 5000;              /* spawn   */
+        b.entity_count++;
+        n = net_snapshot_write_delta(&a, &b, frame, sizeof(frame));
+        ASSERT(n > 0);
+
+        other = a;
+        other.tick_number = 1;
+        ASSERT_EQ_I32(net_snapshot_read_delta(&got, &other, frame, n), -1);  /* wrong base */
+        ASSERT_EQ_I32(net_snapshot_read_delta(&got, NULL, frame, n), -1);    /* missing base */
+        for (len = 0; len < n; len++) {
+            if (net_snapshot_read_delta(&got, &a, frame, len) == 0) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+
+        /* Random corruption must never crash; decoded counts stay sane */
+        for (i = 0; i < 2000; i++) {
+            memcpy(bent, frame, n);
+            bent[NET_SNAPSHOT_HEADER_SIZE + delta_rand(n - NET_SNAPSHOT_HEADER_SIZE)] ^= (uint8_t)(1 + delta_rand(255));
+            if (net_snapshot_read_delta(&got, &a, bent, n) == 0 && got.entity_count > NET_MAX_SNAPSHOT_ENTS) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT_EQ_I32(net_snapshot_read_delta(&got, &a, frame, n), 0);
+        ASSERT(snapshots_same_by_id(&got, &b));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 9: BIT-PACKED SNAPSHOTS
+ * ========================================================================= */
+
+/* Random snapshot with every field inside its packed range */
+static void random_packable_snapshot(Snapshot* s) {
+    uint32_t i, n = delta_rand(NET_MAX_SNAPSHOT_ENTS + 1), id = delta_rand(1000);
+    net_snapshot_init(s);
+    s->tick_number       = delta_rand(0x7FFFFFFF) * 2u + delta_rand(2);
+    s->last_ack_sequence = (uint16_t)delta_rand(65536);
+    s->state_hash        = ((uint64_t)delta_rand(0x7FFFFFFF) << 33) ^ delta_rand(0x7FFFFFFF);
+    for (i = 0; i < n; i++) {
+        SnapshotEntity e;
+        memset(&e, 0, sizeof(e));
+        e.entity_id   = id;
+        id += 1 + ((delta_rand(8) == 0) ? delta_rand(1u << 20) : 0);
+        e.x           = (uint16_t)delta_rand(NET_MAP_W);
+        e.y           = (uint16_t)delta_rand(NET_MAP_H);
+        e.max_hp      = (int16_t)((int32_t)delta_rand(4096) - 2048);
+        e.hp          = delta_rand(2) ? e.max_hp : (int16_t)((int32_t)delta_rand(4096) - 2048);
+        if (i > 0 && delta_rand(2)) {
+            e.glyph = s->entities[i - 1].glyph;
+            e.entity_type = s->entities[i - 1].entity_type;
+            e.flags = s->entities[i - 1].flags;
+            e.sprite_id = s->entities[i - 1].sprite_id;
+        } else {
+            e.glyph       = (uint8_t)delta_rand(128);
+            e.entity_type = (uint8_t)delta_rand(8);
+            e.flags       = (uint8_t)delta_rand(16);
+            e.sprite_id   = (uint8_t)delta_rand(1u << NET_SNAP_BITS_SPRITE);
+        }
+        net_snapshot_add_entity(s, &e);
+    }
+    /* Shuffle so the writer has to sort */
+    for (i = n; i > 1; i--) {
+        uint32_t j = delta_rand(i);
+        SnapshotEntity t = s->entities[i - 1];
+        s->entities[i - 1] = s->entities[j];
+        s->entities[j] = t;
+    }
+}
+
+static void test_bits_primitives(void) {
+    TEST_BEGIN("bits: fixed-width and exp-Golomb fields round-trip");
+    {
+        static const uint32_t eg[] = { 0, 1, 2, 3, 254, 255, 65535, 0x7FFFFFFFu, UINT32_MAX };
+        uint8_t buf[128];
+        NetBitWriter w;
+        NetBitReader r;
+        uint32_t i, n;
+
+        net_bits_writer_init(&w, buf, sizeof(buf));
+        for (i = 1; i <= 32; i++) net_bits_write(&w, 0xA5A5A5A5u, i);
+        for (i = 0; i < sizeof(eg) / sizeof(eg[0]); i++) net_bits_write_egolomb(&w, eg[i]);
+        ASSERT_EQ_I32(w.overflow, 0);
+        n = (w.pos + 7) / 8;
+
+        net_bits_reader_init(&r, buf, n);
+        for (i = 1; i <= 32; i++) {
+            uint32_t mask = (i == 32) ? 0xFFFFFFFFu : (1u << i) - 1u;
+            ASSERT_EQ_U32(net_bits_read(&r, i), 0xA5A5A5A5u & mask);
+        }
+        for (i = 0; i < sizeof(eg) / sizeof(eg[0]); i++) ASSERT_EQ_U32(net_bits_read_egolomb(&r), eg[i]);
+        ASSERT_EQ_I32(r.overflow, 0);
+
+        /* Small values stay small */
+        net_bits_writer_init(&w, buf, sizeof(buf));
+        net_bits_write_egolomb(&w, 0);
+        ASSERT_EQ_U32(w.pos, 1);
+        net_bits_write_egolomb(&w, 2);
+        ASSERT_EQ_U32(w.pos, 4);
+
+        /* Past the end: overflow, never a stray write or read */
+        net_bits_writer_init(&w, buf, 1);
+        net_bits_write(&w, 0x1FF, 9);
+        ASSERT_EQ_I32(w.overflow, 1);
+        net_bits_reader_init(&r, buf, 1);
+        net_bits_read(&r, 9);
+        ASSERT_EQ_I32(r.overflow, 1);
+        memset(buf, 0, 8);
+        net_bits_reader_init(&r, buf, 8);
+        net_bits_read_egolomb(&r);                  /* 64 zero bits */
+        ASSERT_EQ_I32(r.overflow, 1);
+    }
+    TEST_END();
+}
+
+static void test_bits_snapshot_fuzz_roundtrip(void) {
+    TEST_BEGIN("bits: 2000 random snapshots round-trip, sorted by id");
+    {
+        static Snapshot a, b;
+        uint8_t buf[NET_SNAPSHOT_BITS_MAX];
+        uint32_t iter, i, n, bad = 0;
+        for (iter = 0; iter < 2000; iter++) {
+            random_packable_snapshot(&a);
+            n = net_snapshot_write_bits(&a, buf, sizeof(buf));
+            if (n == 0 || net_snapshot_read_bits(&b, buf, n) != 0 || !snapshots_same_by_id(&a, &b)) {
+                bad++;
+                continue;
+            }
+            for (i = 1; i < b.entity_count; i++) {
+                if (b.entities[i].entity_id <= b.entities[i - 1].entity_id) bad++;
+            }
+        }
+        ASSERT_EQ_U32(bad, 0);
+    }
+    TEST_END();
+}
+
+static void test_bits_snapshot_size(void) {
+    TEST_BEGIN("bits: packed snapshot is several times smaller than its rows");
+    {
+        static Snapshot a, b;
+        uint8_t buf[NET_SNAPSHOT_BITS_MAX];
+        uint32_t n, i;
+
+        fill_test_snapshot(&a, NET_MAX_SNAPSHOT_ENTS);
+        for (i = 0; i < a.entity_count; i++) a.entities[i].hp = a.entities[i].max_hp;
+        n = net_snapshot_write_bits(&a, buf, sizeof(buf));
+        ASSERT(n > 0);
+        ASSERT(n * 4 < NET_MAX_SNAPSHOT_ENTS * sizeof(SnapshotEntity));
+        ASSERT(n * 4 < sizeof(Snapshot));
+        ASSERT(n * 3 < net_snapshot_wire_size(&a));
+        ASSERT_EQ_I32(net_snapshot_read_bits(&b, buf, n), 0);
+        ASSERT(snapshots_same_by_id(&a, &b));
+    }
+    TEST_END();
+}
+
+static void test_bits_snapshot_rejects(void) {
+    TEST_BEGIN("bits: out-of-range fields, truncation and garbage are refused");
+    {
+        static Snapshot a, b;
+        uint8_t buf[NET_SNAPSHOT_BITS_MAX], junk[NET_SNAPSHOT_BITS_MAX];
+        uint32_t n, len, i, bad = 0;
+
+        fill_test_snapshot(&a, 20);
+        n = net_snapshot_write_bits(&a, buf, sizeof(buf));
+        ASSERT(n > 0);
+        ASSERT_EQ_U32(net_snapshot_write_bits(&a, buf, n - 1), 0);     /* cap */
+        for (len = 0; len < n; len++) {
+            if (net_snapshot_read_bits(&b, buf, len) == 0) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+        buf[n] = 0;
+        ASSERT_EQ_I32(net_snapshot_read_bits(&b, buf, n + 1), -1);     /* trailing byte */
+
+        b = a; b.entities[3].x = NET_MAP_W < 32 ? 32 : 0xFFFF;
+        ASSERT_EQ_U32(net_snapshot_write_bits(&b, buf, sizeof(buf)), 0);
+        b = a; b.entities[3].hp = 3000;
+        ASSERT_EQ_U32(net_snapshot_write_bits(&b, buf, sizeof(buf)), 0);
+        b = a; b.entities[3].glyph = 200;
+        ASSERT_EQ_U32(net_snapshot_write_bits(&b, buf, sizeof(buf)), 0);
+        b = a; b.entities[3].entity_id = b.entities[4].entity_id;      /* duplicate */
+        ASSERT_EQ_U32(net_snapshot_write_bits(&b, buf, sizeof(buf)), 0);
+
+        /* Garbage of every length up to a few hundred bytes: no crash,
+         * and anything accepted stays within bounds */
+        for (i = 0; i < 5000; i++) {
+            uint32_t k;
+            len = delta_rand(400);
+            for (k = 0; k < len; k++) junk[k] = (uint8_t)delta_rand(256);
+            if (net_snapshot_read_bits(&b, junk, len) == 0 && b.entity_count > NET_MAX_SNAPSHOT_ENTS) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 10: AREA OF INTEREST
+ * ========================================================================= */
+
+/* Every entity is on exactly one cell list, the one for its position */
+static uint32_t aoi_index_errors(const NetWorld* w) {
+    uint32_t c, seen = 0, bad = 0;
+    for (c = 0; c < NET_AOI_CELLS; c++) {
+        uint16_t k, prev = NET_AOI_NONE;
+        for (k = w->aoi_head[c]; k != NET_AOI_NONE; k = w->aoi_next[k]) {
+            const NetEntity* e = &w->entities[k];
+            if (k >= w->entity_count || w->aoi_prev[k] != prev || w->aoi_cell[k] != c) return bad + 1;
+            if (net_aoi_cell_of(e->x, e->y) != c) bad++;
+            prev = k;
+            if (++seen > w->entity_count) return bad + 1;
+        }
+    }
+    return bad + (seen != w->entity_count);
+}
+
+/* Reference answer: scan every entity */
+static uint32_t aoi_brute_force(const NetWorld* w, const NetInterest* in, uint32_t* ids) {
+    const NetEntity* v = NULL;
+    uint32_t i, n = 0;
+    for (i = 0; i < w->entity_count; i++) {
+        if (w->entities[i].entity_id == in->viewer_id) v = &w->entities[i];
+    }
+    if (v == NULL) return 0;
+    for (i = 0; i < w->entity_count; i++) {
+        const NetEntity* e = &w->entities[i];
+        int dx = (int)e->x - (int)v->x, dy = (int)e->y - (int)v->y;
+        if (e != v) {
+            if (dx < -(int)in->radius || dx > (int)in->radius) continue;
+            if (dy < -(int)in->radius || dy > (int)in->radius) continue;
+            if (in->line_of_sight && !net_map_line_of_sight(&w->map, v->x, v->y, e->x, e->y)) continue;
+        }
+        ids[n++] = e->entity_id;
+    }
+    return n;
+}
+
+static int aoi_has(const Snapshot* s, uint32_t id) {
+    uint32_t i;
+    for (i = 0; i < s->entity_count; i++) {
+        if (s->entities[i].entity_id == id) return 1;
+    }
+    return 0;
+}
+
+/* Open room with a wall across x = 15, holed at y = 10 */
+static void aoi_world(NetWorld* w) {
+    int x, y;
+    net_world_init(w);
+    for (y = 1; y < NET_MAP_H - 1; y++) {
+        for (x = 1; x < NET_MAP_W - 1; x++) w->map.tiles[y][x] = 0;
+        if (y != 10) w->map.tiles[y][15] = 1;
+    }
+}
+
+static void test_aoi_index_churn(void) {
+    TEST_BEGIN("aoi: cell lists track add, move and swap-remove");
+    {
+        static NetWorld w;
+        uint32_t step, bad = 0;
+        aoi_world(&w);
+        for (step = 0; step < 20000; step++) {
+            uint32_t op = delta_rand(3), id = delta_rand(600);
+            NetEntity* e = net_world_find_entity(&w, id);
+            if (op == 0 && e == NULL) {
+                net_world_add_entity(&w, id, (uint16_t)delta_rand(NET_MAP_W + 8),
+                                     (uint16_t)delta_rand(NET_MAP_H + 8), 10, 10, 'S');
+            } else if (op == 1 && e != NULL) {
+                net_world_set_position(&w, e, (uint16_t)delta_rand(NET_MAP_W),
+                                       (uint16_t)delta_rand(NET_MAP_H));
+            } else if (op == 2 && e != NULL) {
+                net_world_remove_entity(&w, id);
+            }
+            if ((step & 255) == 0) bad += aoi_index_errors(&w);
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT_EQ_U32(aoi_index_errors(&w), 0);
+        ASSERT(w.state_hash == net_world_compute_hash(&w));
+    }
+    TEST_END();
+}
+
+static void test_aoi_matches_brute_force(void) {
+    TEST_BEGIN("aoi: visible set equals a full scan, with and without LOS");
+    {
+        static NetWorld w;
+        static Snapshot s;
+        NetInterest in;
+        uint32_t ids[NET_MAX_ENTITIES];
+        uint32_t i, k, n, bad = 0;
+
+        aoi_world(&w);
+        for (i = 0; i < 200; i++) {
+            net_world_add_entity(&w, i, (uint16_t)(1 + delta_rand(NET_MAP_W - 2)),
+                                 (uint16_t)(1 + delta_rand(NET_MAP_H - 2)), 10, 10, 'S');
+        }
+        for (i = 0; i < 400; i++) {
+            net_interest_init(&in, delta_rand(200), (uint16_t)delta_rand(12), (uint8_t)(i & 1));
+            if (net_build_snapshot_for(&w, &in, &s) != 0) bad++;
+            n = aoi_brute_force(&w, &in, ids);
+            if (n != s.entity_count || s.entities[0].entity_id != in.viewer_id ||
+                s.entities[0].entity_type != 0) {
+                bad++;
+                continue;
+            }
+            for (k = 0; k < n; k++) {
+                if (!aoi_has(&s, ids[k])) bad++;
+            }
+            if (in.entered_count != n || in.left_count != 0) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+    }
+    TEST_END();
+}
+
+static void test_aoi_los_blocks(void) {
+    TEST_BEGIN("aoi: walls hide entities; the doorway shows them");
+    {
+        static NetWorld w;
+        static Snapshot s;
+        NetInterest in;
+
+        aoi_world(&w);
+        net_world_add_entity(&w, 1, 13, 5, 10, 10, '@');
+        net_world_add_entity(&w, 2, 17, 5, 10, 10, 'S');   /* behind the wall  */
+        net_world_add_entity(&w, 3, 11, 5, 10, 10, 'S');   /* same side        */
+
+        net_interest_init(&in, 1, 6, 1);
+        ASSERT_EQ_I32(net_build_snapshot_for(&w, &in, &s), 0);
+        ASSERT(aoi_has(&s, 3));
+        ASSERT(!aoi_has(&s, 2));
+
+        net_interest_init(&in, 1, 6, 0);                    /* LOS off */
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT(aoi_has(&s, 2));
+
+        ASSERT(net_map_line_of_sight(&w.map, 13, 10, 17, 10));  /* through the hole */
+        ASSERT(!net_map_line_of_sight(&w.map, 13, 9, 17, 9));
+        ASSERT(net_map_line_of_sight(&w.map, 4, 4, 4, 4));
+    }
+    TEST_END();
+}
+
+static void test_snapshot_reports_truncation(void) {
+    TEST_BEGIN("snapshot: entities past the snapshot cap are reported, not hidden");
+    {
+        static NetWorld w;
+        static Snapshot s;
+        NetInterest in;
+        uint32_t i;
+
+        aoi_world(&w);
+        for (i = 1; i <= NET_MAX_SNAPSHOT_ENTS + 44; i++) {
+            ASSERT_EQ_I32(net_world_add_entity(&w, i, (uint16_t)(3 + i % 5), (uint16_t)(3 + i / 5 % 5),
+                                               10, 10, 'S'), 0);
+        }
+        ASSERT_EQ_U32(net_build_snapshot(&w, &s), 44);
+        ASSERT_EQ_U32(s.entity_count, NET_MAX_SNAPSHOT_ENTS);
+
+        net_interest_init(&in, 1, 6, 0);
+        ASSERT_EQ_I32(net_build_snapshot_for(&w, &in, &s), 0);
+        ASSERT_EQ_U32(s.entity_count, NET_MAX_SNAPSHOT_ENTS);
+        ASSERT_EQ_U32(in.truncated, 44);
+
+        net_world_remove_entity(&w, 2);                     /* still over: one fewer */
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT_EQ_U32(in.truncated, 43);
+        ASSERT_EQ_U32(net_build_snapshot(&w, &s), 43);
+
+        aoi_world(&w);
+        net_world_add_entity(&w, 1, 3, 3, 10, 10, '@');
+        ASSERT_EQ_U32(net_build_snapshot(&w, &s), 0);
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT_EQ_U32(in.truncated, 0);
+    }
+    TEST_END();
+}
+
+static void test_aoi_enter_leave(void) {
+    TEST_BEGIN("aoi: enter/leave events follow moves, despawns and the viewer");
+    {
+        static NetWorld w;
+        static Snapshot s;
+        NetInterest in;
+        InteractionCommand cmd;
+        uint32_t i;
+
+        aoi_world(&w);
+        net_world_add_entity(&w, 1, 5, 5, 10, 10, '@');
+        net_world_add_entity(&w, 2, 8, 5, 10, 10, 'S');
+        net_world_add_entity(&w, 3, 5, 9, 10, 10, 'S');
+        net_interest_init(&in, 1, 3, 0);
+
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT_EQ_U32(in.entered_count, 2);                 /* 1 and 2 */
+        ASSERT_EQ_U32(in.left_count, 0);
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT_EQ_U32(in.entered_count + in.left_count, 0);
+
+        cmd = net_cmd_move(2, OP_MOVE_EAST);                /* 2 walks out */
+        ASSERT_EQ_I32(net_process_command(&w, &cmd), VALIDATE_OK);
+        cmd = net_cmd_move(3, OP_MOVE_NORTH);               /* 3 walks in  */
+        ASSERT_EQ_I32(net_process_command(&w, &cmd), VALIDATE_OK);
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT_EQ_U32(in.left_count, 1);
+        ASSERT_EQ_U32(in.left[0], 2);
+        ASSERT_EQ_U32(in.entered_count, 1);
+        ASSERT_EQ_U32(in.entered[0], 3);
+
+        net_world_remove_entity(&w, 3);
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT_EQ_U32(in.left_count, 1);
+        ASSERT_EQ_U32(in.left[0], 3);
+
+        /* A crowd far away costs the viewer nothing */
+        for (i = 100; i < 300; i++) {
+            net_world_add_entity(&w, i, (uint16_t)(20 + i % 8), (uint16_t)(12 + i % 8), 10, 10, 'S');
+        }
+        net_build_snapshot_for(&w, &in, &s);
+        ASSERT_EQ_U32(s.entity_count, 1);
+        ASSERT_EQ_U32(in.entered_count + in.left_count, 0);
+
+        net_world_remove_entity(&w, 1);                     /* viewer gone */
+        ASSERT_EQ_I32(net_build_snapshot_for(&w, &in, &s), -1);
+        ASSERT_EQ_U32(s.entity_count, 0);
+        ASSERT_EQ_U32(in.left_count, 1);
+        ASSERT_EQ_U32(in.visible_count, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 11: BATCHED COMMAND PACKETS
+ * ========================================================================= */
+
+static int commands_equal(const InteractionCommand* a, const InteractionCommand* b) {
+    return a->entity_id == b->entity_id && a->opcode == b->opcode && a->param1 == b->param1 &&
+           a->target_x == b->target_x && a->target_y == b->target_y &&
+           a->target_id == b->target_id && a->sequence == b->sequence;
+}
+
+/* Random command whose fields fit its opcode's batch layout */
+static InteractionCommand random_batch_command(uint32_t eid, uint16_t seq) {
+    InteractionCommand c;
+    uint8_t m;
+    memset(&c, 0, sizeof(c));
+    c.entity_id = eid;
+    c.sequence  = seq;
+    c.opcode    = (uint8_t)delta_rand(256);
+    m = net_batch_layout(c.opcode);
+    if (m & NET_BATCH_PARAM1)    c.param1    = (uint8_t)delta_rand(256);
+    if (m & NET_BATCH_TARGET_X)  c.target_x  = (uint16_t)delta_rand(65536);
+    if (m & NET_BATCH_TARGET_Y)  c.target_y  = (uint16_t)delta_rand(65536);
+    if (m & NET_BATCH_TARGET_ID) c.target_id = delta_rand(0x7FFFFFFF) * 2u + delta_rand(2);
+    return c;
+}
+
+static void test_batch_known_bytes(void) {
+    TEST_BEGIN("batch: 4 commands in 12 bytes, same bytes as network.lua");
+    {
+        static const uint8_t expect[12] = { 4, 0xAC, 0x02, 0xE8, 0x07, 0x00, 0xF0, 0x10, 0x07,
+                                            0x34, 0x02, 0x00 };
+        InteractionCommand c[4], d[4];
+        CommandQueue q;
+        uint8_t buf[NET_BATCH_MAX_SIZE];
+        uint32_t i, n;
+
+        c[0] = net_cmd_move(300, OP_MOVE_NORTH);
+        c[1] = net_cmd_heartbeat(300);
+        c[2] = net_cmd_melee(300, 7);
+        c[3] = net_cmd_use_item(300, 2);
+        for (i = 0; i < 4; i++) c[i].sequence = (uint16_t)(1000 + i);
+
+        n = net_batch_write(c, 4, buf, sizeof(buf));
+        ASSERT_EQ_U32(n, 12);
+        ASSERT(memcmp(buf, expect, sizeof(expect)) == 0);
+        ASSERT_EQ_I32(net_batch_read(buf, n, d, 4), 4);
+        for (i = 0; i < 4; i++) ASSERT(commands_equal(&c[i], &d[i]));
+
+        net_queue_init(&q);
+        ASSERT_EQ_I32(net_queue_push_batch(&q, buf, n), 4);
+        ASSERT_EQ_U32(q.count, 4);
+        ASSERT_EQ_U32(q.commands[2].target_id, 7);
+    }
+    TEST_END();
+}
+
+static void test_batch_fuzz_roundtrip(void) {
+    TEST_BEGIN("batch: 5000 random batches round-trip");
+    {
+        InteractionCommand c[NET_BATCH_MAX_CMDS], d[NET_BATCH_MAX_CMDS];
+        uint8_t buf[NET_BATCH_MAX_SIZE];
+        uint32_t iter, i, n, len, bad = 0;
+
+        for (iter = 0; iter < 5000; iter++) {
+            uint32_t eid = (iter & 1) ? delta_rand(0x7FFFFFFF) : delta_rand(100);
+            uint16_t seq = (uint16_t)delta_rand(65536);
+            n = 1 + delta_rand(NET_BATCH_MAX_CMDS);
+            for (i = 0; i < n; i++) c[i] = random_batch_command(eid, (uint16_t)(seq + i));
+            len = net_batch_write(c, n, buf, sizeof(buf));
+            if (len == 0 || net_batch_read(buf, len, d, NET_BATCH_MAX_CMDS) != (int)n) {
+                bad++;
+                continue;
+            }
+            for (i = 0; i < n; i++) {
+                if (!commands_equal(&c[i], &d[i])) bad++;
+            }
+        }
+        ASSERT_EQ_U32(bad, 0);
+    }
+    TEST_END();
+}
+
+static void test_batch_typical_cost(void) {
+    TEST_BEGIN("batch: moves, heartbeats and attacks cost 1-4 bytes each");
+    {
+        InteractionCommand c[64];
+        uint8_t buf[NET_BATCH_MAX_SIZE];
+        uint32_t i, n;
+
+        for (i = 0; i < 64; i++) {
+            switch (i % 4) {
+            case 0:  c[i] = net_cmd_move(1234, (OpCode)(i % 8)); break;
+            case 1:  c[i] = net_cmd_heartbeat(1234); break;
+            case 2:  c[i] = net_cmd_melee(1234, 1000 + i); break;
+            default: c[i] = net_cmd_use_item(1234, (uint8_t)i); break;
+            }
+            c[i].sequence = (uint16_t)(65500 + i);                 /* wraps */
+        }
+        n = net_batch_write(c, 64, buf, sizeof(buf));
+        ASSERT(n > 0);
+        ASSERT(n <= 6 + 64 * 3);
+        ASSERT(n * 5 < 64 * NET_CMD_SIZE);
+    }
+    TEST_END();
+}
+
+static void test_batch_rejects_wide_varint(void) {
+    TEST_BEGIN("batch: 5-byte varint wider than 32 bits refused, not truncated");
+    {
+        InteractionCommand c, d[NET_BATCH_MAX_CMDS];
+        uint8_t buf[NET_BATCH_MAX_SIZE], pkt[NET_BATCH_MAX_SIZE + 4];
+        uint32_t n;
+
+        c = net_cmd_melee(9, 70000);
+        c.sequence = 5;
+        n = net_batch_write(&c, 1, buf, sizeof(buf));
+        ASSERT(n > 2);
+        ASSERT_EQ_U32(buf[1], 9);                                 /* 1-byte entity id */
+
+        /* Same packet with the entity id spelled as 5 bytes */
+        pkt[0] = buf[0];
+        pkt[1] = 0x89; pkt[2] = 0x80; pkt[3] = 0x80; pkt[4] = 0x80; pkt[5] = 0x00;
+        memcpy(pkt + 6, buf + 2, n - 2);
+        ASSERT_EQ_I32(net_batch_read(pkt, n + 4, d, NET_BATCH_MAX_CMDS), 1);
+        ASSERT_EQ_U32(d[0].entity_id, 9);
+
+        pkt[5] = 0x10;                                            /* 9 + 2^32 */
+        ASSERT_EQ_I32(net_batch_read(pkt, n + 4, d, NET_BATCH_MAX_CMDS), -1);
+        pkt[5] = 0xF0;
+        ASSERT_EQ_I32(net_batch_read(pkt, n + 4, d, NET_BATCH_MAX_CMDS), -1);
+    }
+    TEST_END();
+}
+
+static void test_batch_rejects(void) {
+    TEST_BEGIN("batch: mixed, gapped, off-layout, truncated and garbage refused");
+    {
+        InteractionCommand c[3], d[NET_BATCH_MAX_CMDS];
+        CommandQueue q;
+        uint8_t buf[NET_BATCH_MAX_SIZE], junk[64];
+        uint32_t i, n, len, bad = 0;
+
+        for (i = 0; i < 3; i++) {
+            c[i] = net_cmd_melee(9, 70000);
+            c[i].sequence = (uint16_t)(5 + i);
+        }
+        n = net_batch_write(c, 3, buf, sizeof(buf));
+        ASSERT(n > 0);
+        ASSERT_EQ_U32(net_batch_write(c, 3, buf, n - 1), 0);      /* cap */
+        ASSERT_EQ_U32(net_batch_write(c, 0, buf, sizeof(buf)), 0);
+
+        c[1].entity_id = 10;
+        ASSERT_EQ_U32(net_batch_write(c, 3, buf, sizeof(buf)), 0);
+        c[1].entity_id = 9; c[2].sequence = 8;
+        ASSERT_EQ_U32(net_batch_write(c, 3, buf, sizeof(buf)), 0);
+        c[2].sequence = 7; c[0].param1 = 1;                        /* melee has no param1 */
+        ASSERT_EQ_U32(net_batch_write(c, 3, buf, sizeof(buf)), 0);
+        c[0].param1 = 0;
+
+        n = net_batch_write(c, 3, buf, sizeof(buf));
+        for (len = 0; len < n; len++) {
+            if (net_batch_read(buf, len, d, NET_BATCH_MAX_CMDS) >= 0) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+        buf[n] = 0;
+        ASSERT_EQ_I32(net_batch_read(buf, n + 1, d, NET_BATCH_MAX_CMDS), -1);
+        ASSERT_EQ_I32(net_batch_read(buf, n, d, 2), -1);           /* out too small */
+
+        net_queue_init(&q);
+        ASSERT_EQ_I32(net_queue_push_batch(&q, buf, n - 1), -1);
+        ASSERT_EQ_U32(q.count, 0);
+
+        for (i = 0; i < 20000; i++) {
+            uint32_t k;
+            int r;
+            len = delta_rand(sizeof(junk));
+            for (k = 0; k < len; k++) junk[k] = (uint8_t)delta_rand(256);
+            r = net_batch_read(junk, len, d, NET_BATCH_MAX_CMDS);
+            if (r > NET_BATCH_MAX_CMDS || r == 0) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 12: PER-CLIENT INGRESS
+ * ========================================================================= */
+
+static NetIngress g_ingress;
+
+/* No rate limit: enough tokens for any test */
+static void ingress_unlimited(NetIngress* in, uint32_t quantum) {
+    net_ingress_init(in, quantum, 1000 * NET_RATE_ONE, 1000 * NET_RATE_ONE);
+}
+
+static void test_ingress_flooder_isolated(void) {
+    TEST_BEGIN("ingress: a flooding client fills only its own queue");
+    {
+        InteractionCommand out[NET_TICK_BUDGET], cmd;
+        uint32_t i, n;
+
+        ingress_unlimited(&g_ingress, 4);
+        for (i = 0; i < 4; i++) net_ingress_connect(&g_ingress, i);
+        for (i = 0; i < 1000; i++) {
+            cmd = net_cmd_heartbeat(0);
+            net_ingress_push(&g_ingress, 0, &cmd);
+        }
+        ASSERT_EQ_U32(g_ingress.clients[0].accepted, NET_CLIENT_QUEUE);
+        ASSERT_EQ_U32(g_ingress.clients[0].dropped_full, 1000 - NET_CLIENT_QUEUE);
+        for (i = 1; i < 4; i++) {
+            uint32_t k;
+            for (k = 0; k < 4; k++) {
+                cmd = net_cmd_move(i, OP_MOVE_EAST);
+                cmd.sequence = (uint16_t)(100 * i + k);
+                ASSERT_EQ_I32(net_ingress_push(&g_ingress, i, &cmd), 0);
+            }
+        }
+
+        /* Round one: 4 from each client in turn */
+        n = net_ingress_drain(&g_ingress, out, NET_TICK_BUDGET);
+        ASSERT_EQ_U32(n, NET_CLIENT_QUEUE + 12);
+        for (i = 0; i < 16; i++) ASSERT_EQ_U32(out[i].entity_id, i / 4);
+        for (i = 1; i < 4; i++) {
+            ASSERT_EQ_U32(g_ingress.clients[i].drained, 4);
+            ASSERT_EQ_U16(g_ingress.clients[i].last_sequence, 100 * i + 3);
+        }
+    }
+    TEST_END();
+}
+
+static void test_ingress_budget_fair(void) {
+    TEST_BEGIN("ingress: tick budget holds and shares stay within one quantum");
+    {
+        InteractionCommand out[NET_TICK_BUDGET], cmd;
+        uint32_t i, k, t, n, total = 0, bad = 0;
+
+        ingress_unlimited(&g_ingress, 3);
+        for (i = 0; i < NET_MAX_CLIENTS; i++) {
+            net_ingress_connect(&g_ingress, i);
+            for (k = 0; k < NET_CLIENT_QUEUE; k++) {
+                cmd = net_cmd_heartbeat(i);
+                net_ingress_push(&g_ingress, i, &cmd);
+            }
+        }
+        for (t = 0; t < 100; t++) {
+            uint32_t lo = 0xFFFFFFFFu, hi = 0;
+            n = net_ingress_drain(&g_ingress, out, NET_TICK_BUDGET);
+            if (n > NET_TICK_BUDGET) bad++;
+            total += n;
+            for (i = 0; i < NET_MAX_CLIENTS; i++) {
+                uint32_t d = g_ingress.clients[i].drained;
+                if (d < lo) lo = d;
+                if (d > hi) hi = d;
+            }
+            if (hi - lo > 3) bad++;
+            if (n == 0) break;
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT_EQ_U32(total, NET_MAX_CLIENTS * NET_CLIENT_QUEUE);
+    }
+    TEST_END();
+}
+
+static void test_ingress_token_bucket(void) {
+    TEST_BEGIN("ingress: token bucket allows the burst, then the sustained rate");
+    {
+        InteractionCommand out[NET_TICK_BUDGET], cmd = net_cmd_heartbeat(5);
+        uint32_t i, ok = 0;
+
+        net_ingress_init(&g_ingress, 0, 0, 0);                    /* 2/tick, burst 8 */
+        net_ingress_connect(&g_ingress, 5);
+        for (i = 0; i < 10; i++) ok += (net_ingress_push(&g_ingress, 5, &cmd) == 0);
+        ASSERT_EQ_U32(ok, 8);
+        ASSERT_EQ_U32(g_ingress.clients[5].dropped_rate, 2);
+
+        net_ingress_drain(&g_ingress, out, NET_TICK_BUDGET);       /* tick 1 */
+        ok = 0;
+        for (i = 0; i < 3; i++) ok += (net_ingress_push(&g_ingress, 5, &cmd) == 0);
+        ASSERT_EQ_U32(ok, 2);
+
+        for (i = 0; i < 10; i++) net_ingress_drain(&g_ingress, out, NET_TICK_BUDGET);
+        ok = 0;
+        for (i = 0; i < 20; i++) ok += (net_ingress_push(&g_ingress, 5, &cmd) == 0);
+        ASSERT_EQ_U32(ok, 8);                                      /* capped at burst */
+        ASSERT_EQ_U32(g_ingress.clients[5].dropped_rate, 3 + 12);
+        ASSERT_EQ_U32(g_ingress.clients[5].dropped_full, 0);
+    }
+    TEST_END();
+}
+
+static void test_ingress_tick(void) {
+    TEST_BEGIN("ingress: net_tick_ingress applies, batches and disconnects");
+    {
+        InteractionCommand c[2], cmd;
+        uint8_t buf[NET_BATCH_MAX_SIZE];
+        uint32_t n;
+
+        setup_test_world();
+        ingress_unlimited(&g_ingress, 0);
+        net_ingress_connect(&g_ingress, 0);
+        net_ingress_connect(&g_ingress, 1);
+
+        c[0] = net_cmd_move(0, OP_MOVE_WEST);
+        c[1] = net_cmd_melee(0, 1);
+        c[1].sequence = 1;
+        n = net_batch_write(c, 2, buf, sizeof(buf));
+        ASSERT_EQ_I32(net_ingress_push_batch(&g_ingress, 0, buf, n), 2);
+        ASSERT_EQ_I32(net_ingress_push_batch(&g_ingress, 0, buf, n - 1), -1);
+        cmd = net_cmd_move(1, OP_MOVE_NORTH);
+        net_ingress_push(&g_ingress, 1, &cmd);
+        net_ingress_disconnect(&g_ingress, 1);
+        ASSERT_EQ_I32(net_ingress_push(&g_ingress, 1, &cmd), -1);
+        ASSERT_EQ_I32(net_ingress_push(&g_ingress, NET_MAX_CLIENTS, &cmd), -1);
+
+        ASSERT_EQ_U32(net_tick_ingress(&g_world, &g_ingress), 2);
+        ASSERT_EQ_U16(g_world.entities[0].x, 6);
+        ASSERT_EQ_I32(g_world.entities[1].hp, 5);
+        ASSERT_EQ_U16(g_world.entities[1].y, 7);                  /* never moved */
+        ASSERT_EQ_U32(g_world.tick, 1);
+        ASSERT(g_world.state_hash == net_world_compute_hash(&g_world));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 13: MPSC INGRESS RING
+ * ========================================================================= */
+
+static NetMpscRing g_ring;
+
+static void test_mpsc_single_thread(void) {
+    TEST_BEGIN("mpsc: push, full ring, in-order drain and unpublished slots");
+    {
+        static InteractionCommand cmds[NET_MPSC_CAP + 10], out[NET_MPSC_CAP];
+        uint32_t clients[NET_MPSC_CAP];
+        uint32_t i, n;
+
+        net_mpsc_init(&g_ring);
+        for (i = 0; i < NET_MPSC_CAP + 10; i++) {
+            cmds[i] = net_cmd_melee(1, i);
+        }
+        ASSERT_EQ_U32(net_mpsc_push(&g_ring, 3, cmds, 10), 10);
+        ASSERT_EQ_U32(net_mpsc_push(&g_ring, 4, cmds + 10, NET_MPSC_CAP), NET_MPSC_CAP - 10);
+        ASSERT_EQ_U32(g_ring.dropped, 10);
+        ASSERT_EQ_U32(net_mpsc_push(&g_ring, 4, cmds, 1), 0);
+
+        n = net_mpsc_drain(&g_ring, out, clients, 16);
+        ASSERT_EQ_U32(n, 16);
+        ASSERT_EQ_U32(clients[9], 3);
+        ASSERT_EQ_U32(clients[10], 4);
+        for (i = 0; i < n; i++) ASSERT_EQ_U32(out[i].target_id, i);
+        n = net_mpsc_drain(&g_ring, out, NULL, NET_MPSC_CAP);
+        ASSERT_EQ_U32(n, NET_MPSC_CAP - 16);
+        ASSERT_EQ_U32(out[n - 1].target_id, NET_MPSC_CAP - 1);
+
+        /* A claimed slot that isn't written yet holds back what follows */
+        g_ring.tail++;
+        ASSERT_EQ_U32(net_mpsc_push(&g_ring, 5, cmds, 2), 2);
+        ASSERT_EQ_U32(net_mpsc_drain(&g_ring, out, NULL, NET_MPSC_CAP), 0);
+        g_ring.slots[g_ring.head & (NET_MPSC_CAP - 1)].cmd = cmds[7];
+        g_ring.slots[g_ring.head & (NET_MPSC_CAP - 1)].ready = g_ring.head + 1;
+        ASSERT_EQ_U32(net_mpsc_drain(&g_ring, out, NULL, NET_MPSC_CAP), 3);
+        ASSERT_EQ_U32(out[0].target_id, 7);
+        ASSERT_EQ_U32(out[2].target_id, 1);
+    }
+    TEST_END();
+}
+
+#define MPSC_PRODUCERS    4
+#define MPSC_PER_PRODUCER 200000
+
+typedef struct {
+    NetMpscRing* ring;
+    uint32_t     client;
+} MpscProducer;
+
+/* Pushes MPSC_PER_PRODUCER commands numbered by target_id, in batches of
+ * 1-8, retrying whatever didn't fit (each refusal counts in `dropped`) */
+static MC_THREAD_PROC(mpsc_producer) {
+    MpscProducer* p = (MpscProducer*)mc_thread_arg;
+    InteractionCommand batch[8];
+    uint32_t next = 0, k;
+    while (next < MPSC_PER_PRODUCER) {
+        uint32_t n = 1 + (next * 2654435761u >> 29);
+        if (n > MPSC_PER_PRODUCER - next) n = MPSC_PER_PRODUCER - next;
+        for (k = 0; k < n; k++) batch[k] = net_cmd_melee(p->client, next + k);
+        next += net_mpsc_push(p->ring, p->client, batch, n);
+    }
+    MC_THREAD_RETURN;
+}
+
+static void test_mpsc_threads(void) {
+    TEST_BEGIN("mpsc: 4 producer threads, every command once, in order per producer");
+    {
+        static InteractionCommand out[NET_TICK_BUDGET];
+        uint32_t clients[NET_TICK_BUDGET];
+        uint32_t expect[MPSC_PRODUCERS];
+        MpscProducer prod[MPSC_PRODUCERS];
+        McThread th[MPSC_PRODUCERS];
+        uint32_t i, started = 0, total = 0, bad = 0;
+
+        net_mpsc_init(&g_ring);
+        for (i = 0; i < MPSC_PRODUCERS; i++) {
+            prod[i].ring = &g_ring;
+            prod[i].client = i;
+            expect[i] = 0;
+            if (mc_thread_start(&th[i], mpsc_producer, &prod[i]) == 0) started++;
+        }
+        if (started == MPSC_PRODUCERS) {
+            while (total < MPSC_PRODUCERS * MPSC_PER_PRODUCER) {
+                uint32_t n = net_mpsc_drain(&g_ring, out, clients, NET_TICK_BUDGET);
+                for (i = 0; i < n; i++) {
+                    uint32_t c = clients[i];
+                    if (c >= MPSC_PRODUCERS || out[i].entity_id != c ||
+                        out[i].target_id != expect[c]) bad++;
+                    else expect[c]++;
+                }
+                total += n;
+            }
+            for (i = 0; i < MPSC_PRODUCERS; i++) mc_thread_join(&th[i]);
+            ASSERT_EQ_U32(bad, 0);
+            ASSERT_EQ_U32(net_mpsc_drain(&g_ring, out, NULL, NET_TICK_BUDGET), 0);
+        } else {
+            for (i = 0; i < started; i++) mc_thread_join(&th[i]);
+            printf("  (threads unavailable, skipped)\n");
+        }
+    }
+    TEST_END();
+}
+
+static void test_mpsc_into_ingress(void) {
+    TEST_BEGIN("mpsc: tick-start receive feeds the per-client queues");
+    {
+        InteractionCommand c[3];
+        uint32_t i;
+
+        setup_test_world();
+        net_mpsc_init(&g_ring);
+        ingress_unlimited(&g_ingress, 0);
+        net_ingress_connect(&g_ingress, 0);
+        net_ingress_connect(&g_ingress, 1);
+        c[0] = net_cmd_move(0, OP_MOVE_WEST);
+        c[1] = net_cmd_move(0, OP_MOVE_WEST);
+        c[2] = net_cmd_melee(1, 0);
+        net_mpsc_push(&g_ring, 0, c, 2);
+        net_mpsc_push(&g_ring, 1, c + 2, 1);
+        for (i = 0; i < 3; i++) net_mpsc_push(&g_ring, 9, c, 1);      /* not connected */
+
+        ASSERT_EQ_U32(net_ingress_receive(&g_ingress, &g_ring), 6);
+        ASSERT_EQ_U32(g_ingress.clients[0].count, 2);
+        ASSERT_EQ_U32(g_ingress.clients[1].count, 1);
+        ASSERT_EQ_U32(net_tick_ingress(&g_world, &g_ingress), 3);
+        ASSERT_EQ_U16(g_world.entities[0].x, 5);
+        ASSERT_EQ_I32(g_world.entities[0].hp, 25);
+    }
+    TEST_END();
+}
+
 /* =========================================================================
- * SECTION 8: OPCODE NAME TABLE
+ * SECTION 14: OPCODE NAME TABLE
  * ========================================================================= */
 
 static void test_opcode_names(void) {
@@ -744,7 +1989,7 @@ static void test_opcode_names(void) {
 }
 
 /* =========================================================================
- * SECTION 9: CONVENIENCE BUILDERS
+ * SECTION 15: CONVENIENCE BUILDERS
  * ========================================================================= */
 
 static void test_cmd_builders(void) {
@@ -772,7 +2017,7 @@ static void test_cmd_builders(void) {
 }
 
 /* =========================================================================
- * SECTION 10: INTEGRATED SCENARIO
+ * SECTION 16: INTEGRATED SCENARIO
  *   Player moves around, attacks enemy, enemy dies, snapshot reflects it.
  * ========================================================================= */
 
@@ -913,7 +2158,7 @@ static void print_map(const NetWorld* w, const Snapshot* snap) {
 }
 
 static void run_demo(void) {
-    NetWorld world;
+    static NetWorld world;
     CommandQueue queue;
     Snapshot snap;
     int running = 1;
@@ -1059,6 +2304,8 @@ int main(int argc, char* argv[]) {
     test_validate_melee_no_target();
     test_validate_heartbeat();
     test_validate_unknown_opcode();
+    test_world_lookup_full();
+    test_world_remove_swaps();
 
     /* Tick Processing */
     printf("\n[Tick Processing]\n");
@@ -1070,6 +2317,46 @@ int main(int argc, char* argv[]) {
     printf("\n[Snapshot]\n");
     test_snapshot_build();
     test_snapshot_dead_entity();
+    test_snapshot_wire_roundtrip();
+    test_snapshot_lz_roundtrip();
+    test_snapshot_state_hash();
+
+    printf("\n[Delta Snapshots]\n");
+    test_delta_varint();
+    test_delta_client_roundtrip();
+    test_delta_bandwidth();
+    test_delta_rejects_bad_frames();
+
+    printf("\n[Bit-Packed Snapshots]\n");
+    test_bits_primitives();
+    test_bits_snapshot_fuzz_roundtrip();
+    test_bits_snapshot_size();
+    test_bits_snapshot_rejects();
+
+    printf("\n[Area of Interest]\n");
+    test_aoi_index_churn();
+    test_aoi_matches_brute_force();
+    test_aoi_los_blocks();
+    test_aoi_enter_leave();
+    test_snapshot_reports_truncation();
+
+    printf("\n[Batched Commands]\n");
+    test_batch_known_bytes();
+    test_batch_fuzz_roundtrip();
+    test_batch_typical_cost();
+    test_batch_rejects();
+    test_batch_rejects_wide_varint();
+
+    printf("\n[Per-Client Ingress]\n");
+    test_ingress_flooder_isolated();
+    test_ingress_budget_fair();
+    test_ingress_token_bucket();
+    test_ingress_tick();
+
+    printf("\n[MPSC Ingress Ring]\n");
+    test_mpsc_single_thread();
+    test_mpsc_threads();
+    test_mpsc_into_ingress();
 
     /* Opcode Names */
     printf("\n[Opcode Names]\n");
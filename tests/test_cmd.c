@@ -175,6 +175,9 @@ static void test_cmd_damage_layer(void) {
         /* Flush -- NOW it mutates */
         pools.layers = &g_tp_layers;
         pools.item_defs = NULL;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
         mc_cmd_flush(&buf, &pools);
 
         fetched = (CLayerStack*)mc_sparse_set_get(&g_tp_layers, 10);
@@ -204,6 +207,9 @@ static void test_cmd_damage_peels_layer(void) {
 
         pools.layers = &g_tp_layers;
         pools.item_defs = NULL;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
         mc_cmd_flush(&buf, &pools);
 
         fetched = (CLayerStack*)mc_sparse_set_get(&g_tp_layers, 10);
@@ -238,6 +244,9 @@ static void test_cmd_crit_damage(void) {
 
         pools.layers = &g_tp_layers;
         pools.item_defs = NULL;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
         mc_cmd_flush(&buf, &pools);
 
         fetched = (CLayerStack*)mc_sparse_set_get(&g_tp_layers, 1);
@@ -276,6 +285,9 @@ static void test_cmd_transform(void) {
 
         pools.layers = NULL;
         pools.item_defs = &g_tp_item_defs;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
         mc_cmd_flush(&buf, &pools);
 
         fetched = (CItemDef*)mc_sparse_set_get(&g_tp_item_defs, 50);
@@ -295,6 +307,9 @@ static void test_cmd_transform_chain(void) {
         mc_sparse_set_init(&g_tp_item_defs, sizeof(CItemDef));
         pools.layers = NULL;
         pools.item_defs = &g_tp_item_defs;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
 
         def.def_id = 900;  /* Golden Apple */
         mc_sparse_set_add(&g_tp_item_defs, 50, &def);
@@ -350,6 +365,9 @@ static void test_cmd_multi_command_batch(void) {
 
         pools.layers = &g_tp_layers;
         pools.item_defs = NULL;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
         mc_cmd_flush(&buf, &pools);
 
         fetched = (CLayerStack*)mc_sparse_set_get(&g_tp_layers, 10);
@@ -360,7 +378,169 @@ static void test_cmd_multi_command_batch(void) {
 }
 
 /* =========================================================================
- * SECTION 6: RULE SYSTEM TESTS
+ * SECTION 6: MOVES VIA COMMAND BUFFER
+ * ========================================================================= */
+
+typedef struct {
+    float x;
+    float y;
+} CPosition;
+
+static SparseSet      g_tp_positions;
+static SpatialGrid    g_tp_grid;
+static SpatialGrid    g_tp_ref_grid;
+static ContainerIndex g_tp_containers;
+
+/* 10 x 10 cells of 1 unit; positions pool, grid and containers wired */
+static void move_pools_init(PoolPtrs* pools) {
+    mc_sparse_set_init(&g_tp_positions, sizeof(CPosition));
+    mc_grid_init(&g_tp_grid, 0.0f, 0.0f, 1.0f, 10, 10);
+    mc_container_init(&g_tp_containers);
+    memset(pools, 0, sizeof(*pools));
+    pools->positions  = &g_tp_positions;
+    pools->grid       = &g_tp_grid;
+    pools->containers = &g_tp_containers;
+}
+
+static void test_cmd_move_world(void) {
+    TEST_BEGIN("move: world moves write positions, grid catches up at flush");
+    {
+        CommandBuffer buf;
+        PoolPtrs pools;
+        const CPosition* pos;
+        EntityID out[4];
+        uint64_t hash_before;
+
+        move_pools_init(&pools);
+        mc_cmd_buf_init(&buf);
+
+        /* No position row yet: the move places the entity */
+        mc_emit_move_to(&buf, 0, 0, 5, 2.5f, 3.5f);
+        mc_cmd_flush(&buf, &pools);
+        ASSERT_EQ_U32(buf.applied, 1);
+        ASSERT_EQ_U32(buf.relinked, 1);
+        pos = (const CPosition*)mc_sparse_set_get_const(&g_tp_positions, 5);
+        ASSERT_NOT_NULL(pos);
+        ASSERT(pos->x == 2.5f && pos->y == 3.5f);
+        ASSERT_EQ_U32(g_tp_grid.cell_of[5], 3u * 10u + 2u);
+        ASSERT(g_tp_positions.hash == mc_sparse_set_compute_hash(&g_tp_positions));
+
+        /* Several moves in one tick: last one wins, relinked once */
+        hash_before = g_tp_positions.hash;
+        mc_emit_move_to(&buf, 1, 0, 5, 9.0f, 9.0f);
+        mc_emit_move_to(&buf, 1, 0, 5, 7.2f, 0.5f);
+        ASSERT_EQ_U32(g_tp_grid.cell_of[5], 32);    /* unchanged until flush */
+        mc_cmd_flush(&buf, &pools);
+        ASSERT_EQ_U32(buf.applied, 2);
+        ASSERT_EQ_U32(buf.relinked, 1);
+        pos = (const CPosition*)mc_sparse_set_get_const(&g_tp_positions, 5);
+        ASSERT(pos->x == 7.2f && pos->y == 0.5f);
+        ASSERT_EQ_U32(g_tp_grid.cell_of[5], 7);
+        ASSERT_EQ_U32(g_tp_grid.count, 1);
+        ASSERT(g_tp_positions.hash != hash_before);
+        ASSERT(g_tp_positions.hash == mc_sparse_set_compute_hash(&g_tp_positions));
+        ASSERT_EQ_U32(mc_grid_query_radius(&g_tp_grid, 7.0f, 0.5f, 0.5f, out, 4), 1);
+
+        /* No positions pool: rejected, not "unknown type" */
+        pools.positions = NULL;
+        mc_emit_move_to(&buf, 2, 0, 5, 1.0f, 1.0f);
+        mc_cmd_flush(&buf, &pools);
+        ASSERT_EQ_U32(buf.rejected, 1);
+    }
+    TEST_END();
+}
+
+static void test_cmd_move_container(void) {
+    TEST_BEGIN("move: container moves leave the world and reject cycles");
+    {
+        CommandBuffer buf;
+        PoolPtrs pools;
+        EntityID kids[4];
+
+        move_pools_init(&pools);
+        mc_cmd_buf_init(&buf);
+
+        /* 1 = cart, 2 = bag, 3 = coin, all in the world */
+        mc_emit_move_to(&buf, 0, 0, 1, 1.0f, 1.0f);
+        mc_emit_move_to(&buf, 0, 0, 2, 1.5f, 1.0f);
+        mc_emit_move_to(&buf, 0, 0, 3, 2.0f, 1.0f);
+        mc_cmd_flush(&buf, &pools);
+        ASSERT_EQ_U32(g_tp_grid.count, 3);
+
+        mc_emit_move_into(&buf, 1, 0, 3, 2);    /* coin -> bag  */
+        mc_emit_move_into(&buf, 1, 0, 2, 1);    /* bag  -> cart */
+        mc_emit_move_into(&buf, 1, 0, 1, 3);    /* cart -> coin: cycle */
+        mc_emit_move_into(&buf, 1, 0, 1, 1);    /* cart -> cart: cycle */
+        mc_cmd_flush(&buf, &pools);
+        ASSERT_EQ_U32(buf.applied, 2);
+        ASSERT_EQ_U32(buf.rejected, 2);
+
+        ASSERT_EQ_U32(mc_container_parent(&g_tp_containers, 3), 2);
+        ASSERT_EQ_U32(mc_container_parent(&g_tp_containers, 2), 1);
+        ASSERT_EQ_U32(mc_container_parent(&g_tp_containers, 1), MC_CONTAINER_NONE);
+        ASSERT_EQ_U32(mc_container_children(&g_tp_containers, 1, kids, 4), 1);
+        ASSERT_EQ_U32(kids[0], 2);
+        ASSERT_EQ_I32(mc_sparse_set_has(&g_tp_positions, 2), 0);
+        ASSERT_EQ_I32(mc_grid_has(&g_tp_grid, 2), 0);
+        ASSERT_EQ_I32(mc_grid_has(&g_tp_grid, 3), 0);
+        ASSERT_EQ_U32(g_tp_grid.count, 1);
+
+        /* Dropped back into the world: off the cart's list, on the grid */
+        mc_emit_move_to(&buf, 2, 0, 2, 4.0f, 4.0f);
+        mc_cmd_flush(&buf, &pools);
+        ASSERT_EQ_U32(mc_container_children(&g_tp_containers, 1, kids, 4), 0);
+        ASSERT_EQ_U32(mc_container_children(&g_tp_containers, 2, kids, 4), 1);
+        ASSERT_EQ_U32(g_tp_grid.cell_of[2], 44);
+
+        /* No container index: container moves are rejected */
+        pools.containers = NULL;
+        mc_emit_move_into(&buf, 3, 0, 1, 2);
+        mc_cmd_flush(&buf, &pools);
+        ASSERT_EQ_U32(buf.rejected, 1);
+    }
+    TEST_END();
+}
+
+static void test_cmd_move_batch_matches_sequential(void) {
+    TEST_BEGIN("move: batched flush matches applying moves one by one");
+    {
+        CommandBuffer buf;
+        PoolPtrs pools;
+        uint32_t lcg = 99, t, i, bad = 0;
+
+        move_pools_init(&pools);
+        mc_grid_init(&g_tp_ref_grid, 0.0f, 0.0f, 1.0f, 10, 10);
+        mc_cmd_buf_init(&buf);
+
+        for (t = 0; t < 20; t++) {
+            for (i = 0; i < MAX_COMMANDS; i++) {
+                EntityID e;
+                float x, y;
+                lcg = lcg * 1664525u + 1013904223u; e = (lcg >> 8) % 64;
+                lcg = lcg * 1664525u + 1013904223u; x = (float)(lcg >> 8) / 1677721.6f;
+                lcg = lcg * 1664525u + 1013904223u; y = (float)(lcg >> 8) / 1677721.6f;
+                mc_emit_move_to(&buf, t, 0, e, x, y);
+                if (mc_grid_move(&g_tp_ref_grid, e, x, y) != 0) {
+                    mc_grid_insert(&g_tp_ref_grid, e, x, y);
+                }
+            }
+            mc_cmd_flush(&buf, &pools);
+            if (buf.applied != MAX_COMMANDS) bad++;
+        }
+
+        ASSERT_EQ_U32(g_tp_grid.count, g_tp_ref_grid.count);
+        for (i = 0; i < 64; i++) {
+            if (g_tp_grid.cell_of[i] != g_tp_ref_grid.cell_of[i]) bad++;
+            if (g_tp_grid.x[i] != g_tp_ref_grid.x[i] || g_tp_grid.y[i] != g_tp_ref_grid.y[i]) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT(g_tp_positions.hash == mc_sparse_set_compute_hash(&g_tp_positions));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 7: RULE SYSTEM TESTS
  * ========================================================================= */
 
 /* Standard pools for rule tests */
@@ -573,6 +753,9 @@ static void test_rule_read_only_invariant(void) {
         /* NOW flush -- mutations happen */
         pools.layers = &rp_layers;
         pools.item_defs = NULL;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
         mc_cmd_flush(&buf, &pools);
 
         {
@@ -677,6 +860,9 @@ static void test_rule_cascading_via_cmd_buf(void) {
         rules[0] = make_chop_rule();
         pools.layers = &rp_layers;
         pools.item_defs = NULL;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
 
         req.actor = 0; req.target = 2; req.verb = VERB_CHOP;
 
@@ -752,6 +938,12 @@ int main(void) {
     printf("\n[Multi-Command Batch]\n");
     test_cmd_multi_command_batch();
 
+    /* Moves */
+    printf("\n[Moves via Command Buffer]\n");
+    test_cmd_move_world();
+    test_cmd_move_container();
+    test_cmd_move_batch_matches_sequential();
+
     /* Rule System */
     printf("\n[Rule System]\n");
     test_rule_success_emits_commands();
@@ -0,0 +1,500 @@
+/*
+ * test_craft.c -- Crafting Recipe Matcher Tests
+ *
+ * Tests the recipe table, rarest-ingredient index selection, count
+ * vectors with tag ingredients, and that indexed matching agrees with
+ * a brute-force scan over randomized inventories. Also loads the
+ * GEN_RECIPES table marble_compile.lua emits for oak_forest.marble
+ * (include/marble_gen_recipes.h) into the same matcher.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_craft.c -o test_craft.exe
+ */
+
+#include "marble_craft.h"
+#include "marble_gen_recipes.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+#define DEF_IRON_ORE      950
+#define DEF_IRON_BAR      951
+#define DEF_RUSTY_SWORD   1
+#define DEF_HIDE          960
+#define DEF_FUR           961
+#define DEF_STICK         970
+#define DEF_COAL          971
+#define DEF_TORCH         972
+#define DEF_APPLE         980
+#define DEF_BREAD         981
+#define DEF_STEW          982
+#define DEF_JERKY         983
+
+static ItemDefTable g_items;
+static RecipeTable  g_recipes;
+static RecipeIndex  g_index;
+
+static void add_item(uint32_t def_id, uint32_t tags) {
+    ItemDef d;
+    memset(&d, 0, sizeof(d));
+    d.def_id = def_id;
+    d.tags   = tags;
+    mc_item_table_add(&g_items, &d);
+}
+
+static RecipeDef make_recipe(uint32_t id, uint32_t output) {
+    RecipeDef r;
+    memset(&r, 0, sizeof(r));
+    r.recipe_id     = id;
+    r.output_def_id = output;
+    r.output_count  = 1;
+    return r;
+}
+
+static void add_ing(RecipeDef* r, RecipeIngredientKind kind, uint32_t key, uint32_t count) {
+    r->ingredients[r->ingredient_count].kind  = kind;
+    r->ingredients[r->ingredient_count].key   = key;
+    r->ingredients[r->ingredient_count].count = count;
+    r->ingredient_count++;
+}
+
+static void build_fixtures(void) {
+    RecipeDef r;
+
+    mc_item_table_init(&g_items);
+    add_item(DEF_IRON_ORE, TAG_ORE | TAG_METAL | TAG_MATERIAL);
+    add_item(DEF_IRON_BAR, TAG_METAL | TAG_REFINED | TAG_MATERIAL);
+    add_item(DEF_HIDE,     TAG_LEATHER | TAG_ORGANIC | TAG_MATERIAL);
+    add_item(DEF_FUR,      TAG_LEATHER | TAG_ORGANIC | TAG_MATERIAL);
+    add_item(DEF_STICK,    TAG_ORGANIC | TAG_MATERIAL);
+    add_item(DEF_COAL,     TAG_FIRE | TAG_MATERIAL);
+    add_item(DEF_APPLE,    TAG_FOOD | TAG_FRUIT | TAG_ORGANIC);
+    add_item(DEF_BREAD,    TAG_FOOD | TAG_ORGANIC);
+
+    mc_recipe_table_init(&g_recipes);
+
+    /* 0: Smelt -- 3 ore -> bar */
+    r = make_recipe(1, DEF_IRON_BAR);
+    add_ing(&r, RECIPE_ING_ITEM, DEF_IRON_ORE, 3);
+    mc_recipe_table_add(&g_recipes, &r);
+
+    /* 1: Sword -- 2 bars + any leather */
+    r = make_recipe(2, DEF_RUSTY_SWORD);
+    add_ing(&r, RECIPE_ING_TAG, TAG_LEATHER, 1);
+    add_ing(&r, RECIPE_ING_ITEM, DEF_IRON_BAR, 2);
+    mc_recipe_table_add(&g_recipes, &r);
+
+    /* 2: Torch -- stick + any fire material */
+    r = make_recipe(3, DEF_TORCH);
+    add_ing(&r, RECIPE_ING_ITEM, DEF_STICK, 1);
+    add_ing(&r, RECIPE_ING_TAG, TAG_FIRE, 1);
+    mc_recipe_table_add(&g_recipes, &r);
+
+    /* 3: Stew -- 2 food + 1 leather (tags only) */
+    r = make_recipe(4, DEF_STEW);
+    add_ing(&r, RECIPE_ING_TAG, TAG_FOOD, 2);
+    add_ing(&r, RECIPE_ING_TAG, TAG_LEATHER, 1);
+    mc_recipe_table_add(&g_recipes, &r);
+
+    /* 4: Bundle -- 4 organic, one of which must be an apple */
+    r = make_recipe(5, DEF_BREAD);
+    add_ing(&r, RECIPE_ING_TAG, TAG_ORGANIC, 4);
+    add_ing(&r, RECIPE_ING_ITEM, DEF_APPLE, 1);
+    mc_recipe_table_add(&g_recipes, &r);
+
+    mc_craft_index_build(&g_index, &g_recipes, &g_items);
+}
+
+/* Reference matcher: test every recipe against the count vector. */
+static uint32_t brute_force(const CraftCounts* c, uint32_t* out) {
+    uint32_t i, n = 0;
+    for (i = 0; i < g_recipes.count; i++) {
+        if (mc_craft_can_craft(&g_recipes.recipes[i], c)) out[n++] = i;
+    }
+    return n;
+}
+
+/* =========================================================================
+ * TESTS: RECIPE TABLE
+ * ========================================================================= */
+
+static void test_recipe_table_rejects_malformed(void) {
+    TEST_BEGIN("recipe_table_rejects_malformed");
+    {
+        static RecipeTable table;
+        RecipeDef r;
+        mc_recipe_table_init(&table);
+
+        r = make_recipe(1, 1);
+        ASSERT_EQ_I32(mc_recipe_table_add(&table, &r), -1);          /* empty */
+
+        add_ing(&r, RECIPE_ING_TAG, TAG_METAL | TAG_ORE, 1);
+        ASSERT_EQ_I32(mc_recipe_table_add(&table, &r), -1);          /* multi-bit tag */
+
+        r = make_recipe(1, 1);
+        add_ing(&r, RECIPE_ING_ITEM, DEF_IRON_ORE, 0);
+        ASSERT_EQ_I32(mc_recipe_table_add(&table, &r), -1);          /* zero count */
+
+        r = make_recipe(1, 1);
+        add_ing(&r, RECIPE_ING_ITEM, DEF_IRON_ORE, 1);
+        ASSERT_EQ_I32(mc_recipe_table_add(&table, &r), 0);
+        ASSERT_EQ_U32(table.count, 1);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: INDEX
+ * ========================================================================= */
+
+static void test_index_files_each_recipe_once(void) {
+    TEST_BEGIN("index_files_each_recipe_once");
+    {
+        uint32_t total = g_index.def_offsets[g_index.def_key_count]
+                       + g_index.tag_offsets[MC_CRAFT_TAG_BITS];
+        ASSERT_EQ_U32(total, g_recipes.count);
+    }
+    TEST_END();
+}
+
+static void test_index_prefers_def_over_tag(void) {
+    TEST_BEGIN("index_prefers_def_over_tag");
+    {
+        /* Sword lists the leather tag first but must be keyed by the bar */
+        uint32_t k, found = 0;
+        for (k = 0; k < g_index.def_key_count; k++) {
+            uint32_t e;
+            if (g_index.def_keys[k] != DEF_IRON_BAR) continue;
+            for (e = g_index.def_offsets[k]; e < g_index.def_offsets[k + 1]; e++) {
+                if (g_index.def_entries[e] == 1) found = 1;
+            }
+        }
+        ASSERT_EQ_U32(found, 1);
+    }
+    TEST_END();
+}
+
+static void test_index_picks_rarest_tag(void) {
+    TEST_BEGIN("index_picks_rarest_tag");
+    {
+        /* Stew: FOOD is carried by 2 defs, LEATHER by 2 -- tie keeps the
+         * first listed. Rebuild with an extra food def so LEATHER wins. */
+        static RecipeIndex idx;
+        uint32_t leather = mc_craft_tag_index(TAG_LEATHER);
+        uint32_t food    = mc_craft_tag_index(TAG_FOOD);
+        uint32_t e, in_leather = 0, in_food = 0;
+
+        add_item(DEF_STEW, TAG_FOOD);
+        mc_craft_index_build(&idx, &g_recipes, &g_items);
+        g_items.count--;
+
+        for (e = idx.tag_offsets[leather]; e < idx.tag_offsets[leather + 1]; e++) {
+            if (idx.tag_entries[e] == 3) in_leather = 1;
+        }
+        for (e = idx.tag_offsets[food]; e < idx.tag_offsets[food + 1]; e++) {
+            if (idx.tag_entries[e] == 3) in_food = 1;
+        }
+        ASSERT_EQ_U32(in_leather, 1);
+        ASSERT_EQ_U32(in_food, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: MATCHING
+ * ========================================================================= */
+
+static void test_craft_empty_inventory(void) {
+    TEST_BEGIN("craft_empty_inventory");
+    {
+        static CraftCounts c;
+        uint32_t out[MAX_RECIPES];
+        mc_craft_counts_init(&c);
+        ASSERT_EQ_U32(mc_craft_find_craftable(&g_index, &g_recipes, &c, out, MAX_RECIPES), 0);
+    }
+    TEST_END();
+}
+
+static void test_craft_smelt_needs_full_count(void) {
+    TEST_BEGIN("craft_smelt_needs_full_count");
+    {
+        static CraftCounts c;
+        uint32_t ids[1]    = { DEF_IRON_ORE };
+        uint32_t counts[1] = { 2 };
+        uint32_t out[MAX_RECIPES];
+
+        mc_craft_counts_from_inventory(&c, &g_items, ids, counts, 1);
+        ASSERT_EQ_U32(mc_craft_find_craftable(&g_index, &g_recipes, &c, out, MAX_RECIPES), 0);
+
+        counts[0] = 3;
+        mc_craft_counts_from_inventory(&c, &g_items, ids, counts, 1);
+        ASSERT_EQ_U32(mc_craft_find_craftable(&g_index, &g_recipes, &c, out, MAX_RECIPES), 1);
+        ASSERT_EQ_U32(out[0], 0);
+    }
+    TEST_END();
+}
+
+static void test_craft_tag_ingredient_any_def(void) {
+    TEST_BEGIN("craft_tag_ingredient_any_def");
+    {
+        static CraftCounts c;
+        uint32_t ids[3] = { DEF_IRON_BAR, DEF_IRON_BAR, DEF_FUR };
+        uint32_t out[MAX_RECIPES];
+
+        /* Stacks of the same def merge; fur satisfies the leather tag */
+        mc_craft_counts_from_inventory(&c, &g_items, ids, NULL, 3);
+        ASSERT_EQ_U32(mc_craft_counts_get(&c, DEF_IRON_BAR), 2);
+        ASSERT_EQ_U32(c.def_count, 2);
+        ASSERT_EQ_U32(mc_craft_find_craftable(&g_index, &g_recipes, &c, out, MAX_RECIPES), 1);
+        ASSERT_EQ_U32(out[0], 1);
+    }
+    TEST_END();
+}
+
+static void test_craft_overlap_not_double_counted(void) {
+    TEST_BEGIN("craft_overlap_not_double_counted");
+    {
+        static CraftCounts c;
+        uint32_t out[MAX_RECIPES];
+
+        /* Bundle needs 4 organic incl. 1 apple: 1 apple + 2 sticks = 3 organic */
+        mc_craft_counts_init(&c);
+        mc_craft_counts_add(&c, DEF_APPLE, TAG_FOOD | TAG_FRUIT | TAG_ORGANIC, 1);
+        mc_craft_counts_add(&c, DEF_STICK, TAG_ORGANIC | TAG_MATERIAL, 2);
+        ASSERT_EQ_I32(mc_craft_can_craft(&g_recipes.recipes[4], &c), 0);
+
+        /* Apple claimed by the def slot; tag still needs 4 others */
+        mc_craft_counts_add(&c, DEF_STICK, TAG_ORGANIC | TAG_MATERIAL, 1);
+        ASSERT_EQ_I32(mc_craft_can_craft(&g_recipes.recipes[4], &c), 0);
+
+        mc_craft_counts_add(&c, DEF_STICK, TAG_ORGANIC | TAG_MATERIAL, 1);
+        ASSERT_EQ_I32(mc_craft_can_craft(&g_recipes.recipes[4], &c), 1);
+        ASSERT_EQ_U32(mc_craft_find_craftable(&g_index, &g_recipes, &c, out, MAX_RECIPES), 1);
+        ASSERT_EQ_U32(out[0], 4);
+    }
+    TEST_END();
+}
+
+static void test_craft_tag_overlap_between_tags(void) {
+    TEST_BEGIN("craft_tag_overlap_between_tags");
+    {
+        static CraftCounts c;
+
+        /* Stew needs 2 food + 1 leather. Jerky is both, but each piece
+         * fills one slot: two pieces are 2 items for 3 slots. */
+        mc_craft_counts_init(&c);
+        mc_craft_counts_add(&c, DEF_JERKY, TAG_FOOD | TAG_LEATHER, 2);
+        ASSERT_EQ_I32(mc_craft_can_craft(&g_recipes.recipes[3], &c), 0);
+
+        mc_craft_counts_add(&c, DEF_JERKY, TAG_FOOD | TAG_LEATHER, 1);
+        ASSERT_EQ_I32(mc_craft_can_craft(&g_recipes.recipes[3], &c), 1);
+
+        /* 2 jerky + hide: jerky as food, hide as leather */
+        mc_craft_counts_init(&c);
+        mc_craft_counts_add(&c, DEF_JERKY, TAG_FOOD | TAG_LEATHER, 2);
+        mc_craft_counts_add(&c, DEF_HIDE, TAG_LEATHER | TAG_ORGANIC | TAG_MATERIAL, 1);
+        ASSERT_EQ_I32(mc_craft_can_craft(&g_recipes.recipes[3], &c), 1);
+
+        /* 3 hides + 1 jerky: plenty of leather, not enough food */
+        mc_craft_counts_init(&c);
+        mc_craft_counts_add(&c, DEF_JERKY, TAG_FOOD | TAG_LEATHER, 1);
+        mc_craft_counts_add(&c, DEF_HIDE, TAG_LEATHER | TAG_ORGANIC | TAG_MATERIAL, 3);
+        ASSERT_EQ_I32(mc_craft_can_craft(&g_recipes.recipes[3], &c), 0);
+    }
+    TEST_END();
+}
+
+static void test_craft_counts_over_budget(void) {
+    TEST_BEGIN("craft_counts_over_budget");
+    {
+        static CraftCounts c;
+        static uint32_t ids[MC_CRAFT_MAX_INV_DEFS + 1];
+        uint32_t i;
+        for (i = 0; i <= MC_CRAFT_MAX_INV_DEFS; i++) ids[i] = 5000 + i;
+        ASSERT_EQ_I32(mc_craft_counts_from_inventory(&c, &g_items, ids, NULL, MC_CRAFT_MAX_INV_DEFS), 0);
+        ASSERT_EQ_I32(mc_craft_counts_from_inventory(&c, &g_items, ids, NULL, MC_CRAFT_MAX_INV_DEFS + 1), -1);
+        ASSERT_EQ_U32(c.def_count, MC_CRAFT_MAX_INV_DEFS);
+    }
+    TEST_END();
+}
+
+static void test_craft_output_capped(void) {
+    TEST_BEGIN("craft_output_capped");
+    {
+        static CraftCounts c;
+        uint32_t out[1];
+        mc_craft_counts_init(&c);
+        mc_craft_counts_add(&c, DEF_IRON_ORE, TAG_ORE | TAG_METAL | TAG_MATERIAL, 3);
+        mc_craft_counts_add(&c, DEF_STICK, TAG_ORGANIC | TAG_MATERIAL, 1);
+        mc_craft_counts_add(&c, DEF_COAL, TAG_FIRE | TAG_MATERIAL, 1);
+        ASSERT_EQ_U32(mc_craft_find_craftable(&g_index, &g_recipes, &c, out, 1), 2);
+        ASSERT_EQ_U32(out[0], 0);
+    }
+    TEST_END();
+}
+
+static void test_craft_matches_brute_force(void) {
+    TEST_BEGIN("craft_matches_brute_force");
+    {
+        static const uint32_t pool[] = {
+            DEF_IRON_ORE, DEF_IRON_BAR, DEF_HIDE, DEF_FUR, DEF_STICK,
+            DEF_COAL, DEF_APPLE, DEF_BREAD, 9999 /* unknown def */
+        };
+        static CraftCounts c;
+        McRng rng;
+        uint32_t trial, mismatches = 0;
+        mc_rng_seed(&rng, 1234);
+
+        for (trial = 0; trial < 500; trial++) {
+            uint32_t ids[12], counts[12];
+            uint32_t a[MAX_RECIPES], b[MAX_RECIPES];
+            uint32_t n = mc_rng_next(&rng) % 12, i, na, nb;
+            for (i = 0; i < n; i++) {
+                ids[i]    = pool[mc_rng_next(&rng) % (sizeof(pool) / sizeof(pool[0]))];
+                counts[i] = 1 + mc_rng_next(&rng) % 3;
+            }
+            mc_craft_counts_from_inventory(&c, &g_items, ids, counts, n);
+            na = mc_craft_find_craftable(&g_index, &g_recipes, &c, a, MAX_RECIPES);
+            nb = brute_force(&c, b);
+            if (na != nb || memcmp(a, b, na * sizeof(uint32_t)) != 0) mismatches++;
+        }
+        ASSERT_EQ_U32(mismatches, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: COMPILED RECIPES
+ * ========================================================================= */
+
+static void test_compiled_recipes_load(void) {
+    TEST_BEGIN("compiled_recipes_load");
+    {
+        static RecipeTable table;
+        static RecipeIndex index;
+        static CraftCounts c;
+        uint32_t out[MAX_RECIPES];
+
+        mc_recipe_table_init(&table);
+        ASSERT_EQ_U32(mc_recipe_table_load(&table, GEN_RECIPES, GEN_RECIPE_COUNT), GEN_RECIPE_COUNT);
+        ASSERT_EQ_U32(table.recipes[1].ingredients[1].kind, RECIPE_ING_TAG);
+        ASSERT_EQ_U32(table.recipes[1].ingredients[1].key, TAG_FIRE);
+        ASSERT_EQ_U32(table.recipes[2].ingredients[0].key, TAG_FOOD);
+        ASSERT_EQ_U32(table.recipes[2].ingredients[1].key, TAG_LEATHER);
+        mc_craft_index_build(&index, &table, &g_items);
+
+        /* Torch: def 970 + any fire item */
+        mc_craft_counts_init(&c);
+        mc_craft_counts_add(&c, 970, TAG_ORGANIC | TAG_MATERIAL, 1);
+        mc_craft_counts_add(&c, DEF_COAL, TAG_FIRE | TAG_MATERIAL, 1);
+        ASSERT_EQ_U32(mc_craft_find_craftable(&index, &table, &c, out, MAX_RECIPES), 1);
+        ASSERT_EQ_U32(table.recipes[out[0]].output_def_id, 972);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Crafting Matcher Tests\n");
+    printf("===================================\n\n");
+
+    build_fixtures();
+
+    printf("[Recipe Table]\n");
+    test_recipe_table_rejects_malformed();
+
+    printf("\n[Index]\n");
+    test_index_files_each_recipe_once();
+    test_index_prefers_def_over_tag();
+    test_index_picks_rarest_tag();
+
+    printf("\n[Matching]\n");
+    test_craft_empty_inventory();
+    test_craft_smelt_needs_full_count();
+    test_craft_tag_ingredient_any_def();
+    test_craft_overlap_not_double_counted();
+    test_craft_tag_overlap_between_tags();
+    test_craft_counts_over_budget();
+    test_craft_output_capped();
+    test_craft_matches_brute_force();
+
+    printf("\n[Compiled Recipes]\n");
+    test_compiled_recipes_load();
+
+    printf("\n===================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,641 @@
+/*
+ * test_delta.c -- Incremental Delta Save Tests
+ *
+ * Tests base + delta checkpoint chains: composing a base and several
+ * deltas reproduces the live world exactly (pool contents, dense order,
+ * timers), delta size tracks churn rather than world size, chains
+ * written as (optionally compressed) files reload identically, and
+ * deltas applied to the wrong base or out of order are rejected untouched.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_delta.c -o test_delta.exe -lpthread
+ */
+
+#include "marble_interact.h"
+#include "marble_delta.h"
+#include "test_fixture.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+/* Health and position pools plus timers */
+#define DELTA_PARTS (TW_HEALTH | TW_POSITION | TW_TIMERS)
+
+static TestWorld g_a;
+static TestWorld g_b;
+static uint8_t   g_base[1 << 21];
+static uint8_t   g_delta[8][1 << 18];
+static uint32_t  g_delta_len[8];
+
+static void world_populate(TestWorld* w, uint32_t n) {
+    uint32_t i;
+    for (i = 0; i < n; i++) {
+        EntityID e = mc_entity_create(&w->alloc);
+        CHealth h;
+        CPosition p;
+        h.hp = (int32_t)i;
+        h.max_hp = 100;
+        mc_sparse_set_add(&w->health, e, &h);
+        if (i % 3 == 0) {
+            p.x = (float)i;
+            p.y = 0.0f;
+            mc_sparse_set_add(&w->position, e, &p);
+        }
+    }
+}
+
+/* One "tick" worth of gameplay churn: edits, spawns, despawns, timers */
+static void world_churn(TestWorld* w, McRng* r, uint32_t edits, uint32_t spawns, uint32_t kills) {
+    uint32_t i;
+    CommandBuffer buf;
+    for (i = 0; i < edits; i++) {
+        EntityID e = mc_rng_next(r) % w->alloc.next_id;
+        CHealth* h = (CHealth*)mc_sparse_set_get(&w->health, e);
+        if (h != NULL) h->hp -= 1;
+    }
+    for (i = 0; i < spawns && w->alloc.next_id < MC_MAX_ENTITIES; i++) {
+        EntityID e = mc_entity_create(&w->alloc);
+        CHealth h;
+        CPosition p;
+        Command c;
+        h.hp = 50;
+        h.max_hp = 50;
+        p.x = (float)e;
+        p.y = (float)i;
+        mc_sparse_set_add(&w->health, e, &h);
+        mc_sparse_set_add(&w->position, e, &p);
+        memset(&c, 0, sizeof(c));
+        c.type = CMD_DAMAGE_LAYER;
+        c.target_entity = e;
+        mc_timer_schedule_in(&w->timers, &c, 1 + mc_rng_next(r) % 300);
+    }
+    for (i = 0; i < kills; i++) {
+        EntityID e = mc_rng_next(r) % w->alloc.next_id;
+        mc_sparse_set_remove(&w->health, e);
+        mc_sparse_set_remove(&w->position, e);
+    }
+    mc_cmd_buf_init(&buf);
+    mc_timer_wheel_advance(&w->timers, w->timers.current_tick, &buf);
+    w->tick.tick_number++;
+    w->tick.accumulated_us += 7;
+    mc_rng_next(&w->rng);
+}
+
+static int timers_equal(const TimerWheel* a, const TimerWheel* b) {
+    uint32_t i;
+    if (a->free_head != b->free_head || a->count != b->count
+        || a->dropped != b->dropped || a->fired != b->fired
+        || a->current_tick != b->current_tick) return 0;
+    if (memcmp(a->heads, b->heads, sizeof(a->heads)) != 0) return 0;
+    if (memcmp(a->tails, b->tails, sizeof(a->tails)) != 0) return 0;
+    for (i = 0; i < MC_MAX_TIMERS; i++) {
+        const TimerNode* x = &a->nodes[i];
+        const TimerNode* y = &b->nodes[i];
+        if (x->next != y->next || x->prev != y->prev || x->slot != y->slot
+            || x->generation != y->generation || x->active != y->active) return 0;
+        if (x->active && (x->due_tick != y->due_tick
+            || x->cmd.target_entity != y->cmd.target_entity)) return 0;
+    }
+    return 1;
+}
+
+static int worlds_equal(const TestWorld* a, const TestWorld* b) {
+    return a->alloc.next_id == b->alloc.next_id
+        && a->tick.tick_number == b->tick.tick_number
+        && a->tick.accumulated_us == b->tick.accumulated_us
+        && a->rng.state == b->rng.state
+        && pool_equal(&a->health, &b->health)
+        && pool_equal(&a->position, &b->position)
+        && timers_equal(&a->timers, &b->timers);
+}
+
+/* =========================================================================
+ * TESTS: CHAIN ROUND TRIP
+ * ========================================================================= */
+
+static void test_delta_chain_roundtrip(void) {
+    TEST_BEGIN("delta_chain_roundtrip");
+    {
+        McRng r;
+        uint32_t base_len, d, ok = 1;
+        mc_rng_seed(&r, 99);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 400);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        ASSERT(base_len > 0);
+
+        for (d = 0; d < 6; d++) {
+            world_churn(&g_a, &r, 40, 10, 8);
+            g_delta_len[d] = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[d], sizeof(g_delta[d]));
+            if (g_delta_len[d] == 0) ok = 0;
+        }
+        ASSERT(ok);
+        ASSERT_EQ_U32(g_a.chain.seq, 6);
+
+        world_init(&g_b, DELTA_PARTS);
+        ASSERT_EQ_I32(mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len), 0);
+        for (d = 0; d < 6; d++) {
+            if (mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[d], g_delta_len[d]) != 0) ok = 0;
+        }
+        ASSERT(ok);
+        ASSERT(worlds_equal(&g_a, &g_b));
+        ASSERT_EQ_U32(g_b.chain.seq, 6);
+        ASSERT_EQ_U32(g_b.chain.base_id, g_a.chain.base_id);
+    }
+    TEST_END();
+}
+
+static void test_delta_size_exact(void) {
+    TEST_BEGIN("delta_size_exact");
+    {
+        McRng r;
+        uint32_t size;
+        mc_rng_seed(&r, 3);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 200);
+        mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        world_churn(&g_a, &r, 20, 5, 5);
+        size = mc_world_save_delta_size(&g_a.refs);
+        ASSERT_EQ_U32(mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], size - 1), 0);
+        ASSERT_EQ_U32(g_a.chain.seq, 0);   /* failed write doesn't advance */
+        ASSERT_EQ_U32(mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0])), size);
+        ASSERT_EQ_U32(g_a.chain.seq, 1);
+    }
+    TEST_END();
+}
+
+static void test_delta_scales_with_churn(void) {
+    TEST_BEGIN("delta_scales_with_churn");
+    {
+        uint32_t base_len, quiet, small, e;
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 1000);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+
+        /* Nothing changed: header + ALOC/TICK/RNG + timer scalars only */
+        quiet = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+
+        /* Five edits: five records, no dense order (no adds/removes) */
+        for (e = 0; e < 5; e++) {
+            CHealth* h = (CHealth*)mc_sparse_set_get(&g_a.health, e * 100);
+            h->hp = -1;
+        }
+        small = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[1], sizeof(g_delta[1]));
+        ASSERT(small > quiet);
+        ASSERT(small - quiet <= sizeof(SaveChunkHeader) + sizeof(DeltaPoolHeader)
+                                + 5 * (sizeof(EntityID) + sizeof(CHealth)) + 8);
+        ASSERT(small * 20 < base_len);
+    }
+    TEST_END();
+}
+
+static void test_delta_preserves_dense_order(void) {
+    TEST_BEGIN("delta_preserves_dense_order");
+    {
+        uint32_t base_len, len, e;
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 64);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+
+        /* Swap-removes reshuffle dense[]; re-adding puts eids at the end */
+        for (e = 0; e < 64; e += 5) mc_sparse_set_remove(&g_a.health, e);
+        for (e = 0; e < 64; e += 10) {
+            CHealth h;
+            h.hp = 7;
+            h.max_hp = 7;
+            mc_sparse_set_add(&g_a.health, e, &h);
+        }
+        len = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), 0);
+        ASSERT(pool_equal(&g_a.health, &g_b.health));
+    }
+    TEST_END();
+}
+
+static void test_delta_transient_entity(void) {
+    TEST_BEGIN("delta_transient_entity");
+    {
+        uint32_t base_len, len;
+        EntityID e;
+        CHealth h;
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 10);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+
+        /* Spawned and despawned between checkpoints: a no-op removal */
+        e = mc_entity_create(&g_a.alloc);
+        h.hp = 1;
+        h.max_hp = 1;
+        mc_sparse_set_add(&g_a.health, e, &h);
+        mc_sparse_set_remove(&g_a.health, e);
+        len = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), 0);
+        ASSERT(worlds_equal(&g_a, &g_b));
+    }
+    TEST_END();
+}
+
+static void test_delta_continue_chain_after_load(void) {
+    TEST_BEGIN("delta_continue_chain_after_load");
+    {
+        McRng r;
+        uint32_t base_len, len;
+        mc_rng_seed(&r, 11);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 100);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        world_churn(&g_a, &r, 10, 3, 3);
+        g_delta_len[0] = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+
+        /* Resume from disk, keep playing, keep appending to the chain */
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+        mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], g_delta_len[0]);
+        world_churn(&g_b, &r, 10, 3, 3);
+        len = mc_world_save_delta(&g_b.refs, &g_b.chain, g_delta[1], sizeof(g_delta[1]));
+
+        world_init(&g_a, DELTA_PARTS);
+        mc_world_load_base(&g_a.refs, &g_a.chain, g_base, base_len);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_a.refs, &g_a.chain, g_delta[0], g_delta_len[0]), 0);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_a.refs, &g_a.chain, g_delta[1], len), 0);
+        ASSERT(worlds_equal(&g_a, &g_b));
+    }
+    TEST_END();
+}
+
+static void test_delta_files_compressed(void) {
+    TEST_BEGIN("delta_files_compressed");
+    {
+        static McLzWriter lz;
+        McRng r;
+        uint32_t d;
+        char path[64];
+        mc_rng_seed(&r, 21);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 300);
+        ASSERT_EQ_I32(mc_world_save_base_file(&g_a.refs, &g_a.chain, "test_delta_base.msav",
+                                              &lz, g_base, sizeof(g_base)), 0);
+        for (d = 0; d < 3; d++) {
+            world_churn(&g_a, &r, 30, 5, 5);
+            sprintf(path, "test_delta_%u.mdlt", d + 1);
+            ASSERT_EQ_I32(mc_world_save_delta_file(&g_a.refs, &g_a.chain, path,
+                                                   (d == 1) ? NULL : &lz,
+                                                   g_delta[0], sizeof(g_delta[0])), 0);
+        }
+        ASSERT_EQ_U32(g_a.chain.seq, 3);
+
+        world_init(&g_b, DELTA_PARTS);
+        ASSERT_EQ_I32(mc_world_load_base_file(&g_b.refs, &g_b.chain, "test_delta_base.msav",
+                                              g_base, sizeof(g_base)), 0);
+        ASSERT_EQ_U32(g_b.chain.base_id, g_a.chain.base_id);
+        for (d = 0; d < 3; d++) {
+            sprintf(path, "test_delta_%u.mdlt", d + 1);
+            ASSERT_EQ_I32(mc_world_load_delta_file(&g_b.refs, &g_b.chain, path,
+                                                   g_delta[0], sizeof(g_delta[0])), 0);
+            remove(path);
+        }
+        ASSERT(worlds_equal(&g_a, &g_b));
+        remove("test_delta_base.msav");
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: TRACKING / VALIDATION
+ * ========================================================================= */
+
+static void test_const_get_not_tracked(void) {
+    TEST_BEGIN("const_get_not_tracked");
+    {
+        uint32_t quiet, again, e;
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 100);
+        mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        quiet = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+        for (e = 0; e < 100; e++) (void)mc_sparse_set_get_const(&g_a.health, e);
+        again = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[1], sizeof(g_delta[1]));
+        ASSERT_EQ_U32(again, quiet);
+    }
+    TEST_END();
+}
+
+static void test_delta_rejects_wrong_chain(void) {
+    TEST_BEGIN("delta_rejects_wrong_chain");
+    {
+        McRng r;
+        uint32_t base_len, other_len;
+        static uint8_t other[1 << 21];
+        mc_rng_seed(&r, 5);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 50);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        world_churn(&g_a, &r, 5, 2, 2);
+        g_delta_len[0] = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+        world_churn(&g_a, &r, 5, 2, 2);
+        g_delta_len[1] = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[1], sizeof(g_delta[1]));
+
+        /* Out of order: delta 2 straight onto the base */
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[1], g_delta_len[1]), -1);
+        ASSERT_EQ_U32(g_b.chain.seq, 0);
+        ASSERT_EQ_U32(g_b.tick.tick_number, 0);
+
+        /* Replay: the same delta twice */
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], g_delta_len[0]), 0);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], g_delta_len[0]), -1);
+
+        /* Different base */
+        world_init(&g_b, DELTA_PARTS);
+        world_populate(&g_b, 51);
+        other_len = mc_world_save_base(&g_b.refs, &g_b.chain, other, sizeof(other));
+        ASSERT(other_len > 0);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], g_delta_len[0]), -1);
+        ASSERT_EQ_U32(g_b.health.count, 51);
+    }
+    TEST_END();
+}
+
+static void test_delta_rejects_corruption(void) {
+    TEST_BEGIN("delta_rejects_corruption");
+    {
+        McRng r;
+        uint32_t base_len, len, ok = 1;
+        DeltaHeader hdr;
+        mc_rng_seed(&r, 8);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 50);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        world_churn(&g_a, &r, 5, 2, 2);
+        len = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+        if (mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len - 8) != -1) ok = 0;
+        if (mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], 4) != -1) ok = 0;
+
+        memcpy(&hdr, g_delta[0], sizeof(hdr));
+        hdr.chunk_count += 1;
+        memcpy(g_delta[1], g_delta[0], len);
+        memcpy(g_delta[1], &hdr, sizeof(hdr));
+        if (mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[1], len) != -1) ok = 0;
+        ASSERT(ok);
+        ASSERT_EQ_U32(g_b.chain.seq, 0);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), 0);
+    }
+    TEST_END();
+}
+
+/* Byte offset of the first pool chunk's DeltaPoolHeader with removals,
+ * or 0 if the delta has none. */
+static uint32_t find_pool_with_removals(const uint8_t* d) {
+    DeltaHeader hdr;
+    uint32_t off, c;
+    memcpy(&hdr, d, sizeof(hdr));
+    off = hdr.header_size;
+    for (c = 0; c < hdr.chunk_count; c++) {
+        SaveChunkHeader ch;
+        memcpy(&ch, d + off, sizeof(ch));
+        off += (uint32_t)sizeof(ch);
+        if (ch.tag == MC_DELTA_TAG_POOL) {
+            DeltaPoolHeader ph;
+            memcpy(&ph, d + off, sizeof(ph));
+            if (ph.remove_count > 0) return off;
+        }
+        off += mc_save__pad8(ch.size);
+    }
+    return 0;
+}
+
+static void test_delta_diverged_world_untouched(void) {
+    TEST_BEGIN("delta_diverged_world_untouched");
+    {
+        static TestWorld before;
+        McRng r;
+        uint32_t base_len, len;
+        CPosition p;
+        mc_rng_seed(&r, 21);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 60);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        world_churn(&g_a, &r, 10, 4, 0);
+        len = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+
+        /* Same chain, but this copy gave entity 1 a position the writer
+         * never had: the delta's pool counts can't come out right. The
+         * mismatch is found before anything (health included) is applied. */
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+        p.x = 1.0f;
+        p.y = 1.0f;
+        mc_sparse_set_add(&g_b.position, 1, &p);
+        before = g_b;
+        ASSERT_EQ_I32(mc_world_delta_validate(&g_b.refs, &g_b.chain, g_delta[0], len), -1);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), -1);
+        ASSERT(worlds_equal(&g_b, &before));
+        ASSERT_EQ_U32(g_b.chain.seq, 0);
+    }
+    TEST_END();
+}
+
+static void test_delta_rejects_bad_removal(void) {
+    TEST_BEGIN("delta_rejects_bad_removal");
+    {
+        McRng r;
+        uint32_t base_len, len, at;
+        EntityID bad = MC_MAX_ENTITIES + 7;
+        mc_rng_seed(&r, 22);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 60);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        world_churn(&g_a, &r, 0, 0, 6);
+        len = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+
+        at = find_pool_with_removals(g_delta[0]);
+        ASSERT(at != 0);
+        if (at != 0) {
+            DeltaPoolHeader ph;
+            memcpy(&ph, g_delta[0] + at, sizeof(ph));
+            memcpy(g_delta[0] + at + sizeof(ph) + ph.upsert_count * (sizeof(EntityID) + ph.stride),
+                   &bad, sizeof(bad));
+        }
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+        ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), -1);
+        ASSERT_EQ_U32(g_b.health.count, 60);
+    }
+    TEST_END();
+}
+
+/* Byte offset of the first chunk header with `tag`, or 0 if none. */
+static uint32_t find_chunk(const uint8_t* d, uint32_t tag) {
+    DeltaHeader hdr;
+    uint32_t off, c;
+    memcpy(&hdr, d, sizeof(hdr));
+    off = hdr.header_size;
+    for (c = 0; c < hdr.chunk_count; c++) {
+        SaveChunkHeader ch;
+        memcpy(&ch, d + off, sizeof(ch));
+        if (ch.tag == tag) return off;
+        off += (uint32_t)sizeof(ch) + mc_save__pad8(ch.size);
+    }
+    return 0;
+}
+
+static void test_delta_rejects_bad_timer_links(void) {
+    TEST_BEGIN("delta_rejects_bad_timer_links");
+    {
+        McRng r;
+        uint32_t base_len, len, at, rng_at, v, keep;
+        uint8_t* payload;
+        uint8_t* rec0;
+        SaveChunkHeader ch;
+        DeltaTimerNode rec;
+        mc_rng_seed(&r, 23);
+        world_init(&g_a, DELTA_PARTS);
+        world_populate(&g_a, 40);
+        base_len = mc_world_save_base(&g_a.refs, &g_a.chain, g_base, sizeof(g_base));
+        world_churn(&g_a, &r, 2, 4, 0);
+        len = mc_world_save_delta(&g_a.refs, &g_a.chain, g_delta[0], sizeof(g_delta[0]));
+        world_init(&g_b, DELTA_PARTS);
+        mc_world_load_base(&g_b.refs, &g_b.chain, g_base, base_len);
+
+        at = find_chunk(g_delta[0], MC_DELTA_TAG_TIMERS);
+        rng_at = find_chunk(g_delta[0], MC_SAVE_TAG_RNG);
+        ASSERT(at != 0 && rng_at != 0);
+        if (at != 0 && rng_at != 0) {
+            payload = g_delta[0] + at + sizeof(SaveChunkHeader);
+            rec0 = payload + sizeof(DeltaTimerHeader) + 2u * MC_DELTA_TIMER_SLOTS * sizeof(uint32_t);
+
+            /* A slot head past nodes[] */
+            v = MC_MAX_TIMERS;
+            memcpy(&keep, payload + sizeof(DeltaTimerHeader), sizeof(keep));
+            memcpy(payload + sizeof(DeltaTimerHeader), &v, sizeof(v));
+            ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), -1);
+            memcpy(payload + sizeof(DeltaTimerHeader), &keep, sizeof(keep));
+
+            /* A dirty node whose next link is out of range */
+            memcpy(&rec, rec0, sizeof(rec));
+            rec.node.next = MC_MAX_TIMERS + 3;
+            memcpy(rec0, &rec, sizeof(rec));
+            ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), -1);
+            rec.node.next = g_a.timers.nodes[rec.index].next;
+            memcpy(rec0, &rec, sizeof(rec));
+
+            /* An RNG chunk from a future payload version */
+            memcpy(&ch, g_delta[0] + rng_at, sizeof(ch));
+            ch.version = 2;
+            memcpy(g_delta[0] + rng_at, &ch, sizeof(ch));
+            ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), -1);
+            ch.version = 1;
+            memcpy(g_delta[0] + rng_at, &ch, sizeof(ch));
+
+            ASSERT_EQ_U32(g_b.chain.seq, 0);
+            ASSERT_EQ_I32(mc_world_load_delta(&g_b.refs, &g_b.chain, g_delta[0], len), 0);
+            ASSERT(worlds_equal(&g_a, &g_b));
+        }
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("MarbleEngine Delta Save Tests\n");
+    printf("=============================\n\n");
+
+    printf("[Chain Round Trip]\n");
+    test_delta_chain_roundtrip();
+    test_delta_size_exact();
+    test_delta_scales_with_churn();
+    test_delta_preserves_dense_order();
+    test_delta_transient_entity();
+    test_delta_continue_chain_after_load();
+    test_delta_files_compressed();
+
+    printf("\n[Tracking / Validation]\n");
+    test_const_get_not_tracked();
+    test_delta_rejects_wrong_chain();
+    test_delta_rejects_corruption();
+    test_delta_diverged_world_untouched();
+    test_delta_rejects_bad_removal();
+    test_delta_rejects_bad_timer_links();
+
+    printf("\n=============================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
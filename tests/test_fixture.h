@@ -0,0 +1,79 @@
+/*
+ * test_fixture.h -- Shared Test World for the Persistence Tests
+ *
+ * One small world (allocator, tick, RNG, timers, health / position /
+ * layer pools, save refs, delta chain) used by test_save.c,
+ * test_delta.c, test_fork.c and test_lz.c. Each test picks which pools
+ * its WorldRefs registers (always in health, position, layers order) and
+ * whether timers are saved, then populates the world its own way.
+ * test_loader.c loads into a full World (marble_world.h) and shares only
+ * the component types and pool_equal().
+ *
+ * Include after the test's engine headers.
+ */
+
+#ifndef TEST_FIXTURE_H
+#define TEST_FIXTURE_H
+
+#include "marble_interact.h"
+#include "marble_delta.h"
+
+typedef struct {
+    int32_t hp;
+    int32_t max_hp;
+} CHealth;
+
+typedef struct {
+    float x;
+    float y;
+} CPosition;
+
+typedef struct {
+    EntityAllocator alloc;
+    TickState       tick;
+    McRng           rng;
+    TimerWheel      timers;
+    SparseSet       health;     /* CHealth */
+    SparseSet       position;   /* CPosition */
+    SparseSet       layers;     /* CLayerStack */
+    WorldRefs       refs;
+    DeltaChain      chain;
+} TestWorld;
+
+/* What world_init() registers with refs */
+#define TW_HEALTH    (1u << 0)
+#define TW_POSITION  (1u << 1)
+#define TW_LAYERS    (1u << 2)
+#define TW_TIMERS    (1u << 3)
+
+/* Empty world, RNG seeded with 1. Every pool is initialized; only the
+ * ones in `parts` are saved (refs.timers is NULL without TW_TIMERS). */
+static void world_init(TestWorld* w, uint32_t parts) {
+    mc_entity_alloc_init(&w->alloc);
+    mc_tick_state_init(&w->tick, 0);
+    mc_rng_seed(&w->rng, 1);
+    mc_timer_wheel_init(&w->timers, 0);
+    mc_sparse_set_init(&w->health, sizeof(CHealth));
+    mc_sparse_set_init(&w->position, sizeof(CPosition));
+    mc_sparse_set_init(&w->layers, sizeof(CLayerStack));
+    mc_world_refs_init(&w->refs, &w->alloc, &w->tick, &w->rng,
+                       (parts & TW_TIMERS) ? &w->timers : NULL);
+    if (parts & TW_HEALTH)   mc_world_refs_add_pool(&w->refs, &w->health);
+    if (parts & TW_POSITION) mc_world_refs_add_pool(&w->refs, &w->position);
+    if (parts & TW_LAYERS)   mc_world_refs_add_pool(&w->refs, &w->layers);
+    memset(&w->chain, 0, sizeof(w->chain));
+}
+
+/* Exact equality, including dense order and membership */
+static int pool_equal(const SparseSet* a, const SparseSet* b) {
+    uint32_t e;
+    if (a->count != b->count || a->stride != b->stride) return 0;
+    if (memcmp(a->dense, b->dense, a->count * sizeof(EntityID)) != 0) return 0;
+    if (memcmp(a->data, b->data, (size_t)a->count * a->stride) != 0) return 0;
+    for (e = 0; e < MC_MAX_ENTITIES; e++) {
+        if (mc_sparse_set_has(a, e) != mc_sparse_set_has(b, e)) return 0;
+    }
+    return 1;
+}
+
+#endif /* TEST_FIXTURE_H */
@@ -0,0 +1,582 @@
+/*
+ * test_fork.c -- Copy-on-Write World Fork Tests
+ *
+ * Tests that forks read the parent until they write, copy only the pages
+ * they touch, match a full SparseSet copy under random add/remove/write
+ * sequences (odd strides included), never modify the parent, fail
+ * atomically when the page arena is full, step real command flushes to
+ * the same state as flushing into a full copy (stopping at parent
+ * timers), and run in parallel on worker threads with results identical
+ * to sequential runs.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_fork.c -o test_fork.exe -lpthread
+ */
+
+/* Thousands of random commands are flushed; keep their log lines out of
+ * the test report (no "CRIT FAIL!" noise among real failures). */
+#define MC_QUIET
+
+#include "marble_interact.h"
+#include "marble_fork.h"
+#include "test_fixture.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+typedef struct {
+    uint8_t bytes[12];   /* odd stride: 341 rows per 4 KB page */
+} COdd;
+
+/* Fork-only pools, registered around the fixture's health/layers/position */
+static SparseSet g_odd;
+static SparseSet g_extra[4];   /* more layer pools, to exhaust the arena */
+
+enum { POOL_HEALTH, POOL_ODD, POOL_LAYERS, POOL_EXTRA, POOL_POSITIONS = POOL_EXTRA + 4 };
+
+static TestWorld g_w;
+static WorldFork g_fork;
+static SparseSet g_copy;
+static SparseSet g_mat;
+static SparseSet g_copy_pos;
+static CommandBuffer g_buf_copy;
+static CommandBuffer g_buf_fork;
+
+/* Fixture world with `n` entities; pools registered in POOL_* order */
+static void fork_world_init(TestWorld* w, uint32_t n) {
+    uint32_t i, k;
+    world_init(w, TW_HEALTH | TW_TIMERS);
+    mc_rng_seed(&w->rng, 5);
+    mc_sparse_set_init(&g_odd, sizeof(COdd));
+    mc_world_refs_add_pool(&w->refs, &g_odd);
+    mc_world_refs_add_pool(&w->refs, &w->layers);
+    for (i = 0; i < 4; i++) {
+        mc_sparse_set_init(&g_extra[i], sizeof(CLayerStack));
+        mc_world_refs_add_pool(&w->refs, &g_extra[i]);
+    }
+    mc_world_refs_add_pool(&w->refs, &w->position);
+    for (i = 0; i < n; i++) {
+        EntityID e = mc_entity_create(&w->alloc);
+        CHealth h;
+        COdd o;
+        CLayerStack ls;
+        h.hp = 100;
+        h.max_hp = 100;
+        mc_sparse_set_add(&w->health, e, &h);
+        if (i % 2 == 0) {
+            memset(&o, (int)(i & 0xFF), sizeof(o));
+            mc_sparse_set_add(&g_odd, e, &o);
+        }
+        memset(&ls, 0, sizeof(ls));
+        ls.layer_count = 1;
+        ls.layers[0].material = MAT_WOOD;
+        ls.layers[0].integrity = (int32_t)i;
+        ls.layers[0].max_integrity = 100;
+        mc_sparse_set_add(&w->layers, e, &ls);
+        for (k = 0; k < 4; k++) mc_sparse_set_add(&g_extra[k], e, &ls);
+        if (i % 3 == 0) {
+            CPosition p;
+            p.x = (float)i;
+            p.y = (float)(i / 2);
+            mc_sparse_set_add(&w->position, e, &p);
+        }
+    }
+}
+
+static uint32_t pool_hash(const SparseSet* ss) {
+    uint32_t h = 2166136261u, i;
+    for (i = 0; i < ss->count; i++) {
+        uint32_t k;
+        const uint8_t* row = &ss->data[i * ss->stride];
+        h = (h ^ ss->dense[i]) * 16777619u;
+        for (k = 0; k < ss->stride; k++) h = (h ^ row[k]) * 16777619u;
+    }
+    return h ^ ss->count;
+}
+
+static uint32_t world_hash(const TestWorld* w) {
+    return pool_hash(&w->health) ^ (pool_hash(&g_odd) * 3u) ^ (pool_hash(&w->layers) * 7u)
+         ^ (pool_hash(&w->position) * 11u)
+         ^ w->alloc.next_id ^ w->rng.state;
+}
+
+/* =========================================================================
+ * TESTS: COPY-ON-WRITE
+ * ========================================================================= */
+
+static void test_fork_reads_parent(void) {
+    TEST_BEGIN("fork_reads_parent");
+    {
+        uint32_t e, ok = 1;
+        fork_world_init(&g_w, 600);
+        mc_fork_init(&g_fork, &g_w.refs);
+        ASSERT_EQ_U32(mc_fork_pages_used(&g_fork), 0);
+        ASSERT_EQ_U32(mc_fork_count(&g_fork, POOL_ODD), g_odd.count);
+        for (e = 0; e < 700; e++) {
+            if (mc_fork_has(&g_fork, POOL_ODD, e) != mc_sparse_set_has(&g_odd, e)) ok = 0;
+            if (mc_fork_has(&g_fork, POOL_ODD, e)
+                && memcmp(mc_fork_get_const(&g_fork, POOL_ODD, e),
+                          mc_sparse_set_get_const(&g_odd, e), sizeof(COdd)) != 0) ok = 0;
+        }
+        ASSERT(ok);
+        ASSERT_EQ_U32(mc_fork_pages_used(&g_fork), 0);   /* reads never copy */
+    }
+    TEST_END();
+}
+
+static void test_fork_write_copies_one_page(void) {
+    TEST_BEGIN("fork_write_copies_one_page");
+    {
+        uint32_t before;
+        CHealth* h;
+        fork_world_init(&g_w, 600);
+        before = world_hash(&g_w);
+        mc_fork_init(&g_fork, &g_w.refs);
+
+        h = (CHealth*)mc_fork_get(&g_fork, POOL_HEALTH, 10);
+        ASSERT_NOT_NULL(h);
+        h->hp = 1;
+        ASSERT_EQ_U32(mc_fork_pages_used(&g_fork), 1);
+        h = (CHealth*)mc_fork_get(&g_fork, POOL_HEALTH, 11);   /* same page */
+        h->hp = 2;
+        ASSERT_EQ_U32(mc_fork_pages_used(&g_fork), 1);
+
+        ASSERT_EQ_I32(((const CHealth*)mc_fork_get_const(&g_fork, POOL_HEALTH, 10))->hp, 1);
+        ASSERT_EQ_I32(((const CHealth*)mc_sparse_set_get_const(&g_w.health, 10))->hp, 100);
+        ASSERT_EQ_U32(world_hash(&g_w), before);
+
+        /* Discard: back to sharing everything */
+        mc_fork_reset(&g_fork);
+        ASSERT_EQ_U32(mc_fork_pages_used(&g_fork), 0);
+        ASSERT_EQ_I32(((const CHealth*)mc_fork_get_const(&g_fork, POOL_HEALTH, 10))->hp, 100);
+    }
+    TEST_END();
+}
+
+/* Apply the same random ops to a full copy and to a fork */
+static int fork_matches_copy(uint32_t pool, const SparseSet* parent, uint32_t seed, uint32_t ops) {
+    McRng r;
+    uint32_t i;
+    uint8_t row[64];
+    mc_rng_seed(&r, seed);
+    memcpy(&g_copy, parent, sizeof(SparseSet));
+    mc_fork_init(&g_fork, &g_w.refs);
+    for (i = 0; i < ops; i++) {
+        EntityID e = mc_rng_next(&r) % MC_MAX_ENTITIES;
+        uint32_t op = mc_rng_next(&r) % 3;
+        int rc_copy, rc_fork;
+        memset(row, (int)(mc_rng_next(&r) & 0xFF), sizeof(row));
+        if (op == 0) {
+            rc_copy = mc_sparse_set_add(&g_copy, e, row);
+            rc_fork = mc_fork_add(&g_fork, pool, e, row);
+        } else if (op == 1) {
+            rc_copy = mc_sparse_set_remove(&g_copy, e);
+            rc_fork = mc_fork_remove(&g_fork, pool, e);
+        } else {
+            void* a = mc_sparse_set_get(&g_copy, e);
+            void* b = mc_fork_get(&g_fork, pool, e);
+            rc_copy = (a != NULL) ? 0 : -1;
+            rc_fork = (b != NULL) ? 0 : -1;
+            if (a != NULL && b != NULL) {
+                memcpy(a, row, g_copy.stride);
+                memcpy(b, row, g_copy.stride);
+            }
+        }
+        if (rc_copy != rc_fork) return 0;
+    }
+    if (mc_fork_overflows(&g_fork) != 0) return 0;
+    mc_fork_materialize_pool(&g_fork, pool, &g_mat);
+    return pool_equal(&g_copy, &g_mat);
+}
+
+static void test_fork_matches_full_copy(void) {
+    TEST_BEGIN("fork_matches_full_copy");
+    {
+        uint32_t before;
+        fork_world_init(&g_w, 500);
+        before = world_hash(&g_w);
+        ASSERT(fork_matches_copy(POOL_HEALTH, &g_w.health, 1, 3000));
+        ASSERT(fork_matches_copy(POOL_ODD, &g_odd, 2, 3000));
+        ASSERT(fork_matches_copy(POOL_LAYERS, &g_w.layers, 3, 600));
+        ASSERT_EQ_U32(world_hash(&g_w), before);
+    }
+    TEST_END();
+}
+
+static void test_fork_iteration_order(void) {
+    TEST_BEGIN("fork_iteration_order");
+    {
+        uint32_t i, ok = 1;
+        fork_world_init(&g_w, 100);
+        mc_fork_init(&g_fork, &g_w.refs);
+        mc_fork_remove(&g_fork, POOL_HEALTH, 3);    /* 99 moves into slot 3 */
+        ASSERT_EQ_U32(mc_fork_count(&g_fork, POOL_HEALTH), 99);
+        ASSERT_EQ_U32(mc_fork_entity_at(&g_fork, POOL_HEALTH, 3), 99);
+        for (i = 0; i < mc_fork_count(&g_fork, POOL_HEALTH); i++) {
+            EntityID e = mc_fork_entity_at(&g_fork, POOL_HEALTH, i);
+            if (mc_fork_data_at(&g_fork, POOL_HEALTH, i) != mc_fork_get_const(&g_fork, POOL_HEALTH, e)) ok = 0;
+        }
+        ASSERT(ok);
+        ASSERT(!mc_fork_has(&g_fork, POOL_HEALTH, 3));
+        ASSERT(mc_sparse_set_has(&g_w.health, 3));
+    }
+    TEST_END();
+}
+
+static void test_fork_arena_full_is_atomic(void) {
+    TEST_BEGIN("fork_arena_full_is_atomic");
+    {
+        uint32_t e, p, before;
+        fork_world_init(&g_w, MC_MAX_ENTITIES);
+        before = world_hash(&g_w);
+        mc_fork_init(&g_fork, &g_w.refs);
+        /* Touch every layer row in every layer pool until the arena runs out */
+        for (p = POOL_LAYERS; p < POOL_EXTRA + 4; p++) {
+            for (e = 0; e < MC_MAX_ENTITIES; e++) {
+                if (mc_fork_has(&g_fork, p, e) && mc_fork_get(&g_fork, p, e) == NULL) break;
+            }
+            if (e < MC_MAX_ENTITIES) break;
+        }
+        ASSERT(p < POOL_EXTRA + 4);
+        ASSERT_EQ_U32(mc_fork_pages_used(&g_fork), MC_FORK_MAX_PAGES);
+        ASSERT(mc_fork_overflows(&g_fork) > 0);
+
+        /* Health pages are all still shared: refused, nothing half-applied */
+        ASSERT(mc_fork_get(&g_fork, POOL_HEALTH, 5) == NULL);
+        ASSERT_EQ_I32(mc_fork_remove(&g_fork, POOL_HEALTH, 5), -1);
+        ASSERT_EQ_U32(mc_fork_count(&g_fork, POOL_HEALTH), MC_MAX_ENTITIES);
+        ASSERT(mc_fork_has(&g_fork, POOL_HEALTH, 5));
+        ASSERT_EQ_I32(mc_fork_entity_at(&g_fork, POOL_HEALTH, 5), 5);
+
+        /* Already-private rows stay writable */
+        ASSERT_NOT_NULL(mc_fork_get(&g_fork, POOL_LAYERS, 0));
+        ASSERT_EQ_U32(world_hash(&g_w), before);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: COMMAND FLUSH / STEP
+ * ========================================================================= */
+
+/* Emit one tick of random commands into `buf`: layer damage, crits,
+ * moves to the world (new and existing position rows), moves into a
+ * container, transforms and log-only commands. Targets stay among the
+ * first `span` entities, plus a few that don't exist. */
+static void emit_random_tick(CommandBuffer* buf, McRng* r, uint64_t tick, uint32_t span, uint32_t n) {
+    uint32_t k;
+    for (k = 0; k < n; k++) {
+        EntityID e = mc_rng_next(r) % (span + 4);
+        uint32_t op = mc_rng_next(r) % 6;
+        if (op == 0 || op == 1) {
+            mc_emit_damage_layer(buf, tick, 0, e, (int32_t)(mc_rng_next(r) % 40));
+        } else if (op == 2) {
+            mc_emit_crit_damage(buf, tick, 0, e, 0, (int32_t)(mc_rng_next(r) % 5));
+        } else if (op == 3) {
+            mc_emit_move_to(buf, tick, 0, e, (float)(mc_rng_next(r) % 100), (float)k);
+        } else if (op == 4) {
+            mc_emit_move_into(buf, tick, 0, e, 1);
+        } else {
+            mc_emit_transform(buf, tick, 0, e, 900 + k);
+            mc_emit_feedback(buf, tick, 0, 7);
+        }
+    }
+}
+
+static void test_fork_step_matches_flushed_copy(void) {
+    TEST_BEGIN("fork_step_matches_flushed_copy");
+    {
+        McRng r;
+        PoolPtrs pp;
+        ForkPoolPtrs fpp;
+        uint32_t t, before, counts_ok = 1;
+
+        fork_world_init(&g_w, 600);
+        before = world_hash(&g_w);
+        memcpy(&g_copy, &g_w.layers, sizeof(SparseSet));
+        memcpy(&g_copy_pos, &g_w.position, sizeof(SparseSet));
+        mc_fork_init(&g_fork, &g_w.refs);
+        mc_cmd_buf_init(&g_buf_copy);
+        mc_cmd_buf_init(&g_buf_fork);
+
+        pp.layers     = &g_copy;
+        pp.item_defs  = NULL;
+        pp.positions  = &g_copy_pos;
+        pp.grid       = NULL;
+        pp.containers = NULL;
+        fpp.layers    = POOL_LAYERS;
+        fpp.item_defs = MC_FORK_NO_POOL;
+        fpp.positions = POOL_POSITIONS;
+
+        mc_rng_seed(&r, 77);
+        for (t = 0; t < 12; t++) {
+            McRng same = r;
+            emit_random_tick(&g_buf_copy, &r, t, 96, 40);
+            emit_random_tick(&g_buf_fork, &same, t, 96, 40);
+            mc_cmd_flush(&g_buf_copy, &pp);
+            ASSERT_EQ_I32(mc_fork_step(&g_fork, &g_buf_fork, &fpp), 0);
+            if (g_buf_copy.applied != g_buf_fork.applied
+                || g_buf_copy.rejected != g_buf_fork.rejected) counts_ok = 0;
+        }
+        ASSERT(counts_ok);
+        ASSERT(g_buf_copy.rejected > 0);          /* container moves, missing eids */
+        ASSERT_EQ_U32(mc_fork_overflows(&g_fork), 0);
+        ASSERT_EQ_U32((uint32_t)g_fork.tick.tick_number, 12);
+
+        mc_fork_materialize_pool(&g_fork, POOL_LAYERS, &g_mat);
+        ASSERT(pool_equal(&g_copy, &g_mat));
+        mc_fork_materialize_pool(&g_fork, POOL_POSITIONS, &g_mat);
+        ASSERT(pool_equal(&g_copy_pos, &g_mat));
+
+        ASSERT_EQ_U32(world_hash(&g_w), before);
+        ASSERT(mc_fork_pages_used(&g_fork) <= 8);  /* two layer pages + position pages */
+    }
+    TEST_END();
+}
+
+static void test_fork_step_stops_at_timer(void) {
+    TEST_BEGIN("fork_step_stops_at_timer");
+    {
+        Command cmd;
+        ForkPoolPtrs fpp;
+        const CLayerStack* ls;
+        uint32_t t;
+
+        fork_world_init(&g_w, 100);
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.type          = CMD_DAMAGE_LAYER;
+        cmd.target_entity = 50;
+        cmd.damage_amount = 1;
+        mc_timer_schedule(&g_w.timers, &cmd, 3);
+
+        fpp.layers    = POOL_LAYERS;
+        fpp.item_defs = MC_FORK_NO_POOL;
+        fpp.positions = POOL_POSITIONS;
+        mc_fork_init(&g_fork, &g_w.refs);
+        mc_cmd_buf_init(&g_buf_fork);
+        for (t = 0; t < 3; t++) {
+            mc_emit_damage_layer(&g_buf_fork, t, 0, 40, 1);
+            ASSERT_EQ_I32(mc_fork_step(&g_fork, &g_buf_fork, &fpp), 0);
+        }
+        mc_emit_damage_layer(&g_buf_fork, 3, 0, 40, 1);
+        ASSERT_EQ_I32(mc_fork_step(&g_fork, &g_buf_fork, &fpp), -1);
+        ASSERT_EQ_U32((uint32_t)g_fork.tick.tick_number, 3);
+        ASSERT_EQ_U32(g_buf_fork.count, 1);                  /* left queued */
+
+        ls = (const CLayerStack*)mc_fork_get_const(&g_fork, POOL_LAYERS, 40);
+        ASSERT_EQ_I32(ls->layers[0].integrity, 37);
+        ASSERT_EQ_I32(((const CLayerStack*)mc_sparse_set_get_const(&g_w.layers, 40))->layers[0].integrity, 40);
+    }
+    TEST_END();
+}
+
+static void test_fork_move_rejects_wide_positions(void) {
+    TEST_BEGIN("fork_move_rejects_wide_positions");
+    {
+        static SparseSet wide;
+        WorldRefs refs;
+        ForkPoolPtrs fpp;
+        uint8_t row[80];
+
+        /* A "positions" pool wider than the applicator's 64-byte row */
+        fork_world_init(&g_w, 10);
+        mc_sparse_set_init(&wide, sizeof(row));
+        memset(row, 0, sizeof(row));
+        mc_sparse_set_add(&wide, 1, row);
+        mc_world_refs_init(&refs, &g_w.alloc, &g_w.tick, &g_w.rng, NULL);
+        mc_world_refs_add_pool(&refs, &wide);
+
+        fpp.layers    = MC_FORK_NO_POOL;
+        fpp.item_defs = MC_FORK_NO_POOL;
+        fpp.positions = 0;
+        mc_fork_init(&g_fork, &refs);
+        mc_cmd_buf_init(&g_buf_fork);
+        mc_emit_move_to(&g_buf_fork, 0, 0, 2, 1.0f, 2.0f);    /* would add a row */
+        mc_emit_move_to(&g_buf_fork, 0, 0, 1, 1.0f, 2.0f);    /* would rewrite one */
+        ASSERT_EQ_I32(mc_fork_step(&g_fork, &g_buf_fork, &fpp), 0);
+        ASSERT_EQ_U32(g_buf_fork.rejected, 2);
+        ASSERT_EQ_U32(mc_fork_count(&g_fork, 0), 1);
+        ASSERT_EQ_U32(mc_fork_pages_used(&g_fork), 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: PARALLEL LOOKAHEAD
+ * ========================================================================= */
+
+#define LOOKAHEAD_FORKS 4
+
+typedef struct {
+    const WorldRefs* parent;
+    WorldFork*       fork;
+    CommandBuffer    buf;
+    uint32_t         seed;
+    uint32_t         score;
+} Lookahead;
+
+static WorldFork g_forks[LOOKAHEAD_FORKS];
+
+/* Step a fork 8 ticks through random combat in one neighbourhood and
+ * score the outcome: layers destroyed, then surviving integrity folded
+ * in dense order. */
+static void lookahead_run(Lookahead* job) {
+    McRng r;
+    ForkPoolPtrs fpp;
+    uint32_t t, k, score = 0;
+    fpp.layers    = POOL_LAYERS;
+    fpp.item_defs = MC_FORK_NO_POOL;
+    fpp.positions = POOL_POSITIONS;
+    mc_fork_init(job->fork, job->parent);
+    mc_cmd_buf_init(&job->buf);
+    mc_rng_seed(&r, job->seed);
+    for (t = 0; t < 8; t++) {
+        for (k = 0; k < 16; k++) {
+            EntityID e = mc_rng_next(&r) % 48;
+            mc_emit_damage_layer(&job->buf, job->fork->tick.tick_number, 0, e,
+                                 (int32_t)(mc_rng_next(&r) % 40));
+        }
+        mc_fork_step(job->fork, &job->buf, &fpp);
+    }
+    for (k = 0; k < mc_fork_count(job->fork, POOL_LAYERS); k++) {
+        const CLayerStack* ls = (const CLayerStack*)mc_fork_data_at(job->fork, POOL_LAYERS, k);
+        if (ls->layer_count == 0) score++;
+        else score = score * 31u + (uint32_t)ls->layers[0].integrity;
+    }
+    job->score = score;
+}
+
+static MC_THREAD_PROC(lookahead_worker) {
+    lookahead_run((Lookahead*)mc_thread_arg);
+    MC_THREAD_RETURN;
+}
+
+static void test_parallel_forks(void) {
+    TEST_BEGIN("parallel_forks");
+    {
+        Lookahead jobs[LOOKAHEAD_FORKS];
+        McThread threads[LOOKAHEAD_FORKS];
+        uint32_t expected[LOOKAHEAD_FORKS];
+        int started[LOOKAHEAD_FORKS];
+        uint32_t i, before, ok = 1;
+
+        fork_world_init(&g_w, 800);
+        before = world_hash(&g_w);
+
+        for (i = 0; i < LOOKAHEAD_FORKS; i++) {
+            jobs[i].parent = &g_w.refs;
+            jobs[i].fork   = &g_forks[i];
+            jobs[i].seed   = 100 + i;
+            lookahead_run(&jobs[i]);
+            expected[i] = jobs[i].score;
+        }
+        for (i = 0; i < LOOKAHEAD_FORKS; i++) {
+            jobs[i].score = 0;
+            started[i] = (mc_thread_start(&threads[i], lookahead_worker, &jobs[i]) == 0);
+            if (!started[i]) lookahead_run(&jobs[i]);
+        }
+        for (i = 0; i < LOOKAHEAD_FORKS; i++) {
+            if (started[i]) mc_thread_join(&threads[i]);
+            if (jobs[i].score != expected[i]) ok = 0;
+        }
+        ASSERT(ok);
+        ASSERT(expected[0] != expected[1]);          /* seeds explore differently */
+        ASSERT_EQ_U32(world_hash(&g_w), before);
+        ASSERT(mc_fork_pages_used(&g_forks[0]) <= 2);   /* a page or two, not a 72 KB pool */
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("MarbleEngine World Fork Tests\n");
+    printf("=============================\n\n");
+
+    printf("[Copy-on-Write]\n");
+    test_fork_reads_parent();
+    test_fork_write_copies_one_page();
+    test_fork_matches_full_copy();
+    test_fork_iteration_order();
+    test_fork_arena_full_is_atomic();
+
+    printf("\n[Command Flush / Step]\n");
+    test_fork_step_matches_flushed_copy();
+    test_fork_step_stops_at_timer();
+    test_fork_move_rejects_wide_positions();
+
+    printf("\n[Parallel Lookahead]\n");
+    test_parallel_forks();
+
+    printf("\n=============================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,371 @@
+/*
+ * test_hash.c -- World State Hash Tests
+ *
+ * Tests that mc_hash64() is bit-exact XXH64, that every pool's running
+ * hash equals a full rehash after adds, removes and applicator writes,
+ * that the hash ignores dense[] order, that save/load reproduces it, and
+ * that peers comparing per-tick world hashes find the first tick they
+ * diverged on.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_hash.c -o test_hash.exe -lpthread
+ */
+
+#include "marble_world.h"
+#include "marble_delta.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+typedef struct {
+    int32_t hp;
+    int32_t max_hp;
+} CHealth;
+
+typedef struct {
+    float x;
+    float y;
+} CPosition;
+
+static const uint32_t k_strides[LOADER_POOL_COUNT] = {
+    sizeof(CHealth), sizeof(CPosition), sizeof(CLayerStack), 0,
+    0, 0, 0, 0, 0, 0
+};
+
+static World   g_a;
+static World   g_b;
+static uint8_t g_save_buf[1024u * 1024u];
+
+static CLayerStack make_stack(int32_t bark, int32_t wood) {
+    CLayerStack ls;
+    memset(&ls, 0, sizeof(ls));
+    ls.layer_count = 2;
+    ls.layers[0].material = MAT_BARK; ls.layers[0].integrity = bark; ls.layers[0].max_integrity = bark;
+    ls.layers[1].material = MAT_WOOD; ls.layers[1].integrity = wood; ls.layers[1].max_integrity = wood;
+    return ls;
+}
+
+/* Trees 0..n-1, each with health, position and a layer stack */
+static void setup_forest(World* w, uint32_t seed, uint32_t n) {
+    uint32_t i;
+    mc_world_init(w, 0, seed, k_strides);
+    for (i = 0; i < n; i++) {
+        EntityID e = mc_entity_create(&w->alloc);
+        CHealth h;
+        CPosition p;
+        CLayerStack ls = make_stack(10 + (int32_t)i, 40);
+        h.hp = 100; h.max_hp = 100;
+        p.x = (float)i; p.y = (float)(i * 3u);
+        mc_sparse_set_add(w->ctx.pool_health,   e, &h);
+        mc_sparse_set_add(w->ctx.pool_position, e, &p);
+        mc_sparse_set_add(w->ctx.pool_layers,   e, &ls);
+    }
+}
+
+static void push_damage(World* w, EntityID target, int32_t amount) {
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type          = CMD_DAMAGE_LAYER;
+    cmd.target_entity = target;
+    cmd.damage_amount = amount;
+    mc_cmd_push(&w->commands, &cmd);
+}
+
+/* =========================================================================
+ * XXH64
+ * ========================================================================= */
+
+static void test_xxh64_known_answers(void) {
+    TEST_BEGIN("xxh64_known_answers");
+    {
+        /* Reference xxHash: XXH64("", 0), XXH64("a", 0), XXH64("abc", 0) */
+        static const char long_in[] = "Nobody inspects the spammish repetition";
+        uint8_t bytes[100];
+        uint32_t i;
+
+        ASSERT(mc_hash64("", 0, 0) == 0xEF46DB3751D8E999ull);
+        ASSERT(mc_hash64("a", 1, 0) == 0xD24EC4F1A98C6E5Bull);
+        ASSERT(mc_hash64("abc", 3, 0) == 0x44BC2CF5AD770999ull);
+        ASSERT(mc_hash64(long_in, (uint32_t)strlen(long_in), 0) == 0xFBCEA83C8A378BF1ull);
+
+        /* Every tail length across the 32-byte stripe boundary: the seed
+         * and each input byte reach the output */
+        for (i = 0; i < sizeof(bytes); i++) bytes[i] = (uint8_t)(i * 37u + 1u);
+        for (i = 0; i < sizeof(bytes); i++) {
+            uint64_t h = mc_hash64(bytes, i + 1, 0);
+            ASSERT(h != mc_hash64(bytes, i + 1, 1));
+            bytes[i] ^= 0x80;
+            ASSERT(h != mc_hash64(bytes, i + 1, 0));
+            bytes[i] ^= 0x80;
+        }
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * POOL HASH
+ * ========================================================================= */
+
+static void test_pool_incremental_matches_full(void) {
+    TEST_BEGIN("pool_incremental_matches_full");
+    {
+        static SparseSet ss;
+        McRng r;
+        uint32_t i, bad = 0;
+
+        mc_sparse_set_init(&ss, sizeof(CHealth));
+        ASSERT(ss.hash == 0);
+        mc_rng_seed(&r, 7u);
+        for (i = 0; i < 5000; i++) {
+            EntityID e = mc_rng_range(&r, 200);
+            if (mc_sparse_set_has(&ss, e) && (mc_rng_next(&r) & 1u)) {
+                mc_sparse_set_remove(&ss, e);
+            } else if (mc_sparse_set_has(&ss, e)) {
+                CHealth* h = (CHealth*)mc_sparse_set_get(&ss, e);
+                mc_sparse_set_hash_out(&ss, e);
+                h->hp -= 1;
+                mc_sparse_set_hash_in(&ss, e);
+            } else {
+                CHealth h;
+                h.hp = (int32_t)mc_rng_range(&r, 100);
+                h.max_hp = 100;
+                mc_sparse_set_add(&ss, e, &h);
+            }
+            if (ss.hash != mc_sparse_set_compute_hash(&ss)) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+
+        /* Emptying the pool brings the hash back to zero */
+        while (ss.count > 0) mc_sparse_set_remove(&ss, ss.dense[0]);
+        ASSERT(ss.hash == 0);
+    }
+    TEST_END();
+}
+
+static void test_pool_hash_order_independent(void) {
+    TEST_BEGIN("pool_hash_order_independent");
+    {
+        static SparseSet a, b;
+        CHealth h;
+        uint32_t i;
+
+        mc_sparse_set_init(&a, sizeof(CHealth));
+        mc_sparse_set_init(&b, sizeof(CHealth));
+        for (i = 0; i < 32; i++) {
+            h.hp = (int32_t)i; h.max_hp = 50;
+            mc_sparse_set_add(&a, i, &h);
+            h.hp = (int32_t)(31 - i);
+            mc_sparse_set_add(&b, 31 - i, &h);
+        }
+        ASSERT(a.dense[0] != b.dense[0]);
+        ASSERT(a.hash == b.hash);
+
+        /* Same component on two entities: rows don't cancel */
+        mc_sparse_set_init(&a, sizeof(CHealth));
+        h.hp = 9; h.max_hp = 9;
+        mc_sparse_set_add(&a, 1, &h);
+        mc_sparse_set_add(&a, 2, &h);
+        ASSERT(a.hash != 0);
+        ASSERT(mc_sparse_set_row_hash(&a, 1) != mc_sparse_set_row_hash(&a, 2));
+        ASSERT(mc_sparse_set_row_hash(&a, 3) == 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * WORLD HASH
+ * ========================================================================= */
+
+static void test_applicators_keep_hash(void) {
+    TEST_BEGIN("applicators_keep_hash");
+    {
+        uint32_t t;
+        setup_forest(&g_a, 42u, 6);
+        ASSERT(mc_world_hash_verify(&g_a));
+
+        for (t = 0; t < 20; t++) {
+            push_damage(&g_a, t % 6u, 3);
+            mc_world_push_request(&g_a, 0, 1 + t % 5u, VERB_CHOP);
+            mc_world_step(&g_a);
+            ASSERT(mc_world_hash_verify(&g_a));
+        }
+        ASSERT(mc_world_hash_verify(&g_a));
+    }
+    TEST_END();
+}
+
+static void test_world_hash_history(void) {
+    TEST_BEGIN("world_hash_history");
+    {
+        uint64_t h0, h1 = 0, h = 0;
+        uint32_t t;
+
+        setup_forest(&g_a, 42u, 4);
+        h0 = mc_world_state_hash(&g_a);
+        ASSERT_EQ_I32(mc_world_tick_hash(&g_a, 0, &h), -1);   /* not run yet */
+
+        mc_world_step(&g_a);                                  /* idle tick */
+        ASSERT_EQ_I32(mc_world_tick_hash(&g_a, 0, &h), 0);
+        ASSERT(h == h0);
+
+        push_damage(&g_a, 2, 4);
+        mc_world_step(&g_a);
+        ASSERT_EQ_I32(mc_world_tick_hash(&g_a, 1, &h1), 0);
+        ASSERT(h1 != h0);
+        ASSERT(h1 == mc_world_state_hash(&g_a));
+
+        for (t = 0; t < MC_WORLD_HASH_HISTORY; t++) mc_world_step(&g_a);
+        ASSERT_EQ_I32(mc_world_tick_hash(&g_a, 1, &h), -1);   /* aged out */
+        ASSERT_EQ_I32(mc_world_tick_hash(&g_a, 2, &h), 0);
+    }
+    TEST_END();
+}
+
+static void test_hash_check_finds_first_desync(void) {
+    TEST_BEGIN("hash_check_finds_first_desync");
+    {
+        uint64_t peer = 0;
+        uint32_t t;
+
+        setup_forest(&g_a, 9u, 5);
+        setup_forest(&g_b, 9u, 5);
+        for (t = 0; t < 30; t++) {
+            push_damage(&g_a, t % 5u, 2);
+            push_damage(&g_b, t % 5u, (t == 17) ? 3 : 2);     /* one bad tick */
+            mc_world_step(&g_a);
+            mc_world_step(&g_b);
+        }
+        ASSERT(g_a.desync_tick == MC_WORLD_NO_DESYNC);
+
+        /* Peer hashes arrive late and out of order */
+        for (t = 29; t + 1 > 0; t--) {
+            ASSERT_EQ_I32(mc_world_tick_hash(&g_b, t, &peer), 0);
+            ASSERT_EQ_I32(mc_world_hash_check(&g_a, t, peer), (t >= 17) ? 1 : 0);
+        }
+        ASSERT(g_a.desync_tick == 17);
+        ASSERT_EQ_I32(mc_world_hash_check(&g_a, 30, 0), -1);
+    }
+    TEST_END();
+}
+
+static void test_save_load_preserves_hash(void) {
+    TEST_BEGIN("save_load_preserves_hash");
+    {
+        WorldRefs ra, rb;
+        uint32_t len, t;
+
+        setup_forest(&g_a, 42u, 8);
+        for (t = 0; t < 4; t++) {
+            push_damage(&g_a, t, 5);
+            mc_world_step(&g_a);
+        }
+        mc_sparse_set_remove(g_a.ctx.pool_position, 3);
+
+        mc_world_refs(&g_a, &ra);
+        len = mc_world_save(&ra, g_save_buf, sizeof(g_save_buf));
+        ASSERT(len > 0);
+
+        mc_world_init(&g_b, 1, 42u, k_strides);
+        mc_world_refs(&g_b, &rb);
+        ASSERT_EQ_I32(mc_world_load(&rb, g_save_buf, len), 0);
+        ASSERT(mc_world_hash_verify(&g_b));
+        ASSERT(mc_world_state_hash(&g_a) == mc_world_state_hash(&g_b));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine World State Hash Tests\n");
+    printf("===================================\n\n");
+
+    printf("[XXH64]\n");
+    test_xxh64_known_answers();
+
+    printf("\n[Pool Hash]\n");
+    test_pool_incremental_matches_full();
+    test_pool_hash_order_independent();
+
+    printf("\n[World Hash]\n");
+    test_applicators_keep_hash();
+    test_world_hash_history();
+    test_hash_check_finds_first_desync();
+    test_save_load_preserves_hash();
+
+    printf("\n===================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
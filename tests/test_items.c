@@ -712,6 +712,9 @@ static void test_item_transform_via_cmd_buf(void) {
         /* Flush */
         pools.layers = NULL;
         pools.item_defs = &pool_item_defs;
+        pools.positions = NULL;
+        pools.grid = NULL;
+        pools.containers = NULL;
         mc_cmd_flush(&buf, &pools);
 
         /* Entity 50 now has def_id 901 */
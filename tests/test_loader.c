@@ -0,0 +1,339 @@
+/*
+ * test_loader.c -- World Loader Tests
+ *
+ * Tests the manifest loader paths: sequential Loader_LoadWorld, the
+ * grouped/parallel loader (must produce byte-identical pools, including
+ * dense order), and the binary .mbin loader.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_loader.c -o test_loader.exe -lpthread
+ */
+
+#include "marble_world.h"
+#include "test_fixture.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t state;
+    uint32_t timer;
+} CBehaviorStub;
+
+static World         g_seq;
+static World         g_grp;
+static LoaderScratch g_scratch;
+
+static const uint32_t k_strides[LOADER_POOL_COUNT] = {
+    sizeof(CHealth), sizeof(CPosition), sizeof(CLayerStack), sizeof(CSkills),
+    sizeof(CAnatomy), sizeof(CCapabilities), sizeof(CAffordances), sizeof(CTool),
+    sizeof(CBodyParts), sizeof(CBehaviorStub)
+};
+
+/* Exact equality, including dense order */
+static int worlds_equal(const World* a, const World* b) {
+    uint32_t t;
+    if (a->alloc.next_id != b->alloc.next_id) return 0;
+    for (t = 0; t < LOADER_POOL_COUNT; t++) {
+        if (!pool_equal(&a->pools[t], &b->pools[t])) return 0;
+    }
+    return 1;
+}
+
+/* Large shuffled manifest: every entity gets a random subset of
+ * components; entries are interleaved across types. */
+static uint8_t       g_payload[LOADER_MAX_ENTRIES][64];
+static ManifestEntry g_manifest[LOADER_MAX_ENTRIES];
+
+static uint32_t build_big_manifest(uint32_t entity_count) {
+    McRng rng;
+    uint32_t n = 0, e, t, i;
+    mc_rng_seed(&rng, 99);
+    for (e = 0; e < entity_count; e++) {
+        for (t = 0; t < LOADER_POOL_COUNT; t++) {
+            if (t != COMP_TYPE_HEALTH && mc_rng_range(&rng, 3) == 0) continue;
+            for (i = 0; i < 64; i++) g_payload[n][i] = (uint8_t)mc_rng_next(&rng);
+            g_manifest[n].entity_idx = e;
+            g_manifest[n].type       = (ComponentType)t;
+            g_manifest[n].data_ptr   = g_payload[n];
+            n++;
+        }
+    }
+    /* Fisher-Yates so pool writes are fully interleaved */
+    for (i = n - 1; i > 0; i--) {
+        uint32_t j = mc_rng_range(&rng, i + 1);
+        ManifestEntry tmp = g_manifest[i];
+        g_manifest[i] = g_manifest[j];
+        g_manifest[j] = tmp;
+    }
+    return n;
+}
+
+/* =========================================================================
+ * TESTS: SEQUENTIAL LOADER
+ * ========================================================================= */
+
+static void test_load_world_small(void) {
+    TEST_BEGIN("load_world_small");
+    {
+        CHealth   h  = { 80, 100 };
+        CPosition p  = { 2.0f, 3.0f };
+        CTool     tl = { MAT_IRON };
+        ManifestEntry m[3];
+        const CHealth* got;
+        m[0].entity_idx = 0; m[0].type = COMP_TYPE_HEALTH;   m[0].data_ptr = &h;
+        m[1].entity_idx = 2; m[1].type = COMP_TYPE_POSITION; m[1].data_ptr = &p;
+        m[2].entity_idx = 0; m[2].type = COMP_TYPE_TOOL;     m[2].data_ptr = &tl;
+
+        mc_world_init(&g_seq, 0, 1, k_strides);
+        Loader_LoadWorld(&g_seq.ctx, m, 3);
+        ASSERT_EQ_U32(g_seq.alloc.next_id, 3);
+        got = (const CHealth*)mc_sparse_set_get_const(g_seq.ctx.pool_health, 0);
+        ASSERT_NOT_NULL(got);
+        if (got) ASSERT_EQ_I32(got->hp, 80);
+        ASSERT(mc_sparse_set_has(g_seq.ctx.pool_position, 2));
+        ASSERT(mc_sparse_set_has(g_seq.ctx.pool_tool, 0));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: GROUPED LOADER
+ * ========================================================================= */
+
+static void test_grouped_matches_sequential_small(void) {
+    TEST_BEGIN("grouped_matches_sequential_small");
+    {
+        uint32_t n = build_big_manifest(40);
+        mc_world_init(&g_seq, 0, 1, k_strides);
+        mc_world_init(&g_grp, 0, 1, k_strides);
+        Loader_LoadWorld(&g_seq.ctx, g_manifest, n);
+        g_scratch.max_workers = 4;
+        ASSERT_EQ_I32(Loader_LoadWorldGrouped(&g_grp.ctx, g_manifest, n, &g_scratch), 0);
+        g_scratch.max_workers = 0;
+        ASSERT_EQ_U32(g_scratch.workers_used, 0);   /* buckets too small */
+        ASSERT(worlds_equal(&g_seq, &g_grp));
+    }
+    TEST_END();
+}
+
+static void test_grouped_matches_sequential_threaded(void) {
+    TEST_BEGIN("grouped_matches_sequential_threaded");
+    {
+        /* Every bucket well above LOADER_PARALLEL_MIN_ENTRIES */
+        uint32_t n = build_big_manifest(MC_MAX_ENTITIES);
+        uint32_t t;
+        mc_world_init(&g_seq, 0, 1, k_strides);
+        mc_world_init(&g_grp, 0, 1, k_strides);
+        Loader_LoadWorld(&g_seq.ctx, g_manifest, n);
+        g_scratch.max_workers = 4;
+        ASSERT_EQ_I32(Loader_LoadWorldGrouped(&g_grp.ctx, g_manifest, n, &g_scratch), 0);
+        g_scratch.max_workers = 0;
+        ASSERT_EQ_U32(g_scratch.workers_used, 3);
+        for (t = 0; t < LOADER_POOL_COUNT; t++) {
+            ASSERT(g_scratch.jobs[t].count >= LOADER_PARALLEL_MIN_ENTRIES);
+        }
+        ASSERT_EQ_U32(g_grp.pools[COMP_TYPE_HEALTH].count, MC_MAX_ENTITIES);
+        ASSERT(worlds_equal(&g_seq, &g_grp));
+    }
+    TEST_END();
+}
+
+/* Position of an entry in the original manifest (data_ptr is unique) */
+static uint32_t manifest_pos(const ManifestEntry* e, uint32_t n) {
+    uint32_t i;
+    for (i = 0; i < n; i++) {
+        if (g_manifest[i].data_ptr == e->data_ptr) return i;
+    }
+    return MC_INVALID_INDEX;
+}
+
+static void test_grouped_buckets_are_stable(void) {
+    TEST_BEGIN("grouped_buckets_are_stable");
+    {
+        uint32_t n = build_big_manifest(200);
+        uint32_t t, i, ok = 1;
+        mc_world_init(&g_grp, 0, 1, k_strides);
+        Loader_LoadWorldGrouped(&g_grp.ctx, g_manifest, n, &g_scratch);
+        for (t = 0; t < LOADER_POOL_COUNT; t++) {
+            const LoaderPoolJob* job = &g_scratch.jobs[t];
+            uint32_t prev = 0;
+            for (i = 0; i < job->count; i++) {
+                uint32_t pos = manifest_pos(&job->bucket[i], n);
+                if (job->bucket[i].type != (ComponentType)t) ok = 0;
+                if (pos == MC_INVALID_INDEX || (i > 0 && pos <= prev)) ok = 0;
+                prev = pos;
+            }
+        }
+        ASSERT(ok);
+    }
+    TEST_END();
+}
+
+static void test_grouped_reports_rejects(void) {
+    TEST_BEGIN("grouped_reports_rejects");
+    {
+        CHealth h = { 1, 1 };
+        ManifestEntry m[4];
+        m[0].entity_idx = 0; m[0].type = COMP_TYPE_HEALTH; m[0].data_ptr = &h;
+        m[1].entity_idx = 0; m[1].type = COMP_TYPE_HEALTH; m[1].data_ptr = &h;   /* duplicate */
+        m[2].entity_idx = 1; m[2].type = (ComponentType)77; m[2].data_ptr = &h;  /* bad type */
+        m[3].entity_idx = 1; m[3].type = COMP_TYPE_HEALTH; m[3].data_ptr = &h;
+
+        mc_world_init(&g_grp, 0, 1, k_strides);
+        ASSERT_EQ_I32(Loader_LoadWorldGrouped(&g_grp.ctx, m, 4, &g_scratch), -1);
+        ASSERT_EQ_U32(g_grp.ctx.pool_health->count, 2);
+        ASSERT_EQ_U32(g_grp.alloc.next_id, 2);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: BINARY LOADER
+ * ========================================================================= */
+
+static uint32_t g_image_words[(LOADER_POOL_COUNT * (MC_MAX_ENTITIES * 68 + 256)) / 4];
+
+static uint32_t bake(const World* w) {
+    const SparseSet* pools[LOADER_POOL_COUNT];
+    uint32_t types[LOADER_POOL_COUNT];
+    uint32_t t;
+    for (t = 0; t < LOADER_POOL_COUNT; t++) {
+        pools[t] = &w->pools[t];
+        types[t] = t;
+    }
+    return mc_mbin_write((uint8_t*)g_image_words, sizeof(g_image_words),
+                         &w->alloc, pools, types, LOADER_POOL_COUNT);
+}
+
+static void test_binary_matches_manifest(void) {
+    TEST_BEGIN("binary_matches_manifest");
+    {
+        uint32_t n = build_big_manifest(500);
+        uint32_t size;
+        mc_world_init(&g_seq, 0, 1, k_strides);
+        Loader_LoadWorld(&g_seq.ctx, g_manifest, n);
+        size = bake(&g_seq);
+        ASSERT(size > 0);
+
+        mc_world_init(&g_grp, 0, 1, k_strides);
+        ASSERT_EQ_I32(Loader_LoadWorldBinary(&g_grp.ctx, (const uint8_t*)g_image_words, size), 0);
+        ASSERT(worlds_equal(&g_seq, &g_grp));
+    }
+    TEST_END();
+}
+
+static void test_binary_rejects_stale_layout(void) {
+    TEST_BEGIN("binary_rejects_stale_layout");
+    {
+        uint32_t n = build_big_manifest(50);
+        uint32_t size;
+        mc_world_init(&g_seq, 0, 1, k_strides);
+        Loader_LoadWorld(&g_seq.ctx, g_manifest, n);
+        size = bake(&g_seq);
+
+        /* Runtime tool struct "grew" since the image was baked */
+        mc_world_init(&g_grp, 0, 1, k_strides);
+        mc_sparse_set_init(g_grp.ctx.pool_tool, sizeof(CTool) + 4);
+        ASSERT_EQ_I32(Loader_LoadWorldBinary(&g_grp.ctx, (const uint8_t*)g_image_words, size), -1);
+        ASSERT_EQ_U32(g_grp.ctx.pool_health->count, 0);   /* nothing half-loaded */
+        ASSERT_EQ_U32(g_grp.alloc.next_id, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Loader Tests\n");
+    printf("=========================\n\n");
+
+    printf("[Sequential Loader]\n");
+    test_load_world_small();
+
+    printf("\n[Grouped Loader]\n");
+    test_grouped_matches_sequential_small();
+    test_grouped_matches_sequential_threaded();
+    test_grouped_buckets_are_stable();
+    test_grouped_reports_rejects();
+
+    printf("\n[Binary Loader]\n");
+    test_binary_matches_manifest();
+    test_binary_rejects_stale_layout();
+
+    printf("\n=========================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,458 @@
+/*
+ * test_lz.c -- Block Compression Tests
+ *
+ * Tests the LZ block codec and frame layer: exact round trips across
+ * edge sizes and data shapes (empty, tiny, incompressible, template-heavy
+ * component rows, multi-block), streaming writes and block-at-a-time
+ * reads, checksum/corruption rejection, bounds safety on garbage input,
+ * and compressed save/autosave files. Prints decode throughput.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_lz.c -o test_lz.exe -lpthread
+ */
+
+#include <time.h>
+
+#include "marble_interact.h"
+#include "marble_save.h"
+#include "test_fixture.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+#define BIG_SIZE (300u * 1024u)
+
+static McLzWriter g_lz;
+static uint8_t    g_src[BIG_SIZE];
+static uint8_t    g_frame[BIG_SIZE + 4096];
+static uint8_t    g_out[BIG_SIZE];
+
+/* Component rows like a freshly generated world: a few templates
+ * repeated with small per-entity differences */
+static void fill_layer_rows(uint8_t* dst, uint32_t bytes) {
+    uint32_t n = bytes / sizeof(CLayerStack), i;
+    memset(dst, 0, bytes);
+    for (i = 0; i < n; i++) {
+        CLayerStack ls;
+        memset(&ls, 0, sizeof(ls));
+        ls.layer_count = 2;
+        ls.layers[0].material = (i % 3 == 0) ? MAT_WOOD : MAT_STONE;
+        ls.layers[0].integrity = 100;
+        ls.layers[0].max_integrity = 100;
+        ls.layers[1].material = MAT_FLESH;
+        ls.layers[1].integrity = (int32_t)(i & 7);
+        ls.layers[1].max_integrity = 50;
+        memcpy(dst + i * sizeof(ls), &ls, sizeof(ls));
+    }
+}
+
+static void fill_random(uint8_t* dst, uint32_t bytes, uint32_t seed) {
+    McRng r;
+    uint32_t i;
+    mc_rng_seed(&r, seed);
+    for (i = 0; i < bytes; i++) dst[i] = (uint8_t)(mc_rng_next(&r) >> 24);
+}
+
+static int frame_roundtrip(const uint8_t* src, uint32_t len, uint32_t* frame_len) {
+    uint32_t got = 0;
+    *frame_len = mc_lz_frame_compress(&g_lz, src, len, g_frame, sizeof(g_frame));
+    if (*frame_len == 0) return 0;
+    if (*frame_len > mc_lz_frame_bound(len)) return 0;
+    if (mc_lz_frame_decompress(g_frame, *frame_len, g_out, sizeof(g_out), &got) != 0) return 0;
+    return got == len && memcmp(src, g_out, len) == 0;
+}
+
+/* =========================================================================
+ * TESTS: CODEC
+ * ========================================================================= */
+
+static void test_checksum_vectors(void) {
+    TEST_BEGIN("checksum_vectors");
+    {
+        const char* s = "Nobody inspects the spammish repetition";
+        ASSERT_EQ_U32(mc_lz_checksum((const uint8_t*)"", 0), 0x02CC5D05u);
+        ASSERT_EQ_U32(mc_lz_checksum((const uint8_t*)"abc", 3), 0x32D153FFu);
+        ASSERT_EQ_U32(mc_lz_checksum((const uint8_t*)s, (uint32_t)strlen(s)), 0xE2293B2Fu);
+    }
+    TEST_END();
+}
+
+static void test_roundtrip_edge_sizes(void) {
+    TEST_BEGIN("roundtrip_edge_sizes");
+    {
+        static const uint32_t sizes[] = { 0, 1, 5, 12, 13, 16, 17, 64, 255, 256, 4099 };
+        uint32_t i, flen, ok = 1;
+        fill_layer_rows(g_src, 8192);
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            if (!frame_roundtrip(g_src, sizes[i], &flen)) {
+                printf("    size %u failed\n", sizes[i]);
+                ok = 0;
+            }
+        }
+        ASSERT(ok);
+    }
+    TEST_END();
+}
+
+static void test_roundtrip_redundant_rows(void) {
+    TEST_BEGIN("roundtrip_redundant_rows");
+    {
+        uint32_t flen;
+        fill_layer_rows(g_src, BIG_SIZE);
+        ASSERT(frame_roundtrip(g_src, BIG_SIZE, &flen));
+        ASSERT(flen * 4 < BIG_SIZE);         /* template data shrinks >4x */
+        printf("    %u -> %u bytes (%.1fx)\n", BIG_SIZE, flen, (double)BIG_SIZE / flen);
+    }
+    TEST_END();
+}
+
+static void test_roundtrip_incompressible(void) {
+    TEST_BEGIN("roundtrip_incompressible");
+    {
+        uint32_t flen;
+        fill_random(g_src, BIG_SIZE, 77);
+        ASSERT(frame_roundtrip(g_src, BIG_SIZE, &flen));
+        ASSERT_EQ_U32(flen, mc_lz_frame_bound(BIG_SIZE));   /* all blocks stored */
+    }
+    TEST_END();
+}
+
+static void test_roundtrip_long_runs(void) {
+    TEST_BEGIN("roundtrip_long_runs");
+    {
+        uint32_t flen, i, ok = 1;
+        /* Overlapping matches (offset 1..7) and long length extensions */
+        for (i = 1; i <= 9; i++) {
+            uint32_t j;
+            for (j = 0; j < 70000; j++) g_src[j] = (uint8_t)(j % i);
+            if (!frame_roundtrip(g_src, 70000, &flen)) ok = 0;
+        }
+        /* Random literals separated by runs */
+        fill_random(g_src, 70000, 3);
+        for (i = 0; i < 70000; i += 1000) memset(g_src + i, 0xAA, 300);
+        if (!frame_roundtrip(g_src, 70000, &flen)) ok = 0;
+        ASSERT(ok);
+    }
+    TEST_END();
+}
+
+static void test_block_rejects_malformed(void) {
+    TEST_BEGIN("block_rejects_malformed");
+    {
+        uint8_t blk[64];
+        uint32_t got;
+        uint8_t bad_off[]   = { 0x10, 'a', 0x05, 0x00, 0x00 };  /* offset past start */
+        uint8_t zero_off[]  = { 0x10, 'a', 0x00, 0x00, 0x00 };
+        uint8_t lit_over[]  = { 0xF0, 0x20, 'a' };              /* literals past end */
+        uint8_t good[]      = { 0x14, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f' };
+
+        ASSERT_EQ_I32(mc_lz_decompress_block(good, sizeof(good), blk, sizeof(blk), &got), 0);
+        ASSERT_EQ_U32(got, 1 + 8 + 5);
+        ASSERT(memcmp(blk, "aaaaaaaaabcdef", 14) == 0);
+        ASSERT_EQ_I32(mc_lz_decompress_block(good, sizeof(good), blk, 13, &got), -1);
+        ASSERT_EQ_I32(mc_lz_decompress_block(good, 4, blk, sizeof(blk), &got), -1);
+        ASSERT_EQ_I32(mc_lz_decompress_block(bad_off, sizeof(bad_off), blk, sizeof(blk), &got), -1);
+        ASSERT_EQ_I32(mc_lz_decompress_block(zero_off, sizeof(zero_off), blk, sizeof(blk), &got), -1);
+        ASSERT_EQ_I32(mc_lz_decompress_block(lit_over, sizeof(lit_over), blk, sizeof(blk), &got), -1);
+        ASSERT_EQ_I32(mc_lz_decompress_block(good, 0, blk, sizeof(blk), &got), -1);
+    }
+    TEST_END();
+}
+
+static void test_block_garbage_is_safe(void) {
+    TEST_BEGIN("block_garbage_is_safe");
+    {
+        McRng r;
+        uint32_t i, got;
+        mc_rng_seed(&r, 12345);
+        /* Random inputs must fail cleanly or decode within bounds */
+        for (i = 0; i < 2000; i++) {
+            uint32_t n = 1 + mc_rng_next(&r) % 256;
+            fill_random(g_src, n, mc_rng_next(&r));
+            (void)mc_lz_decompress_block(g_src, n, g_out, 1024, &got);
+        }
+        ASSERT(1);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: FRAMES / STREAMING
+ * ========================================================================= */
+
+static void test_stream_chunks_match_oneshot(void) {
+    TEST_BEGIN("stream_chunks_match_oneshot");
+    {
+        static uint8_t frame2[BIG_SIZE + 4096];
+        uint32_t one, streamed, off = 0, step = 1;
+        fill_layer_rows(g_src, 200000);
+        one = mc_lz_frame_compress(&g_lz, g_src, 200000, g_frame, sizeof(g_frame));
+
+        mc_lz_writer_begin(&g_lz, frame2, sizeof(frame2));
+        while (off < 200000) {
+            uint32_t n = (step > 200000 - off) ? 200000 - off : step;
+            mc_lz_writer_write(&g_lz, g_src + off, n);
+            off += n;
+            step = step * 3 + 1;
+        }
+        streamed = mc_lz_writer_end(&g_lz);
+        ASSERT(one > 0);
+        ASSERT_EQ_U32(streamed, one);
+        ASSERT(memcmp(g_frame, frame2, one) == 0);
+    }
+    TEST_END();
+}
+
+static void test_reader_block_at_a_time(void) {
+    TEST_BEGIN("reader_block_at_a_time");
+    {
+        static uint8_t block[MC_LZ_BLOCK_SIZE];
+        McLzReader r;
+        uint32_t flen, got, total = 0, blocks = 0, ok = 1;
+        int rc;
+        fill_layer_rows(g_src, BIG_SIZE);
+        flen = mc_lz_frame_compress(&g_lz, g_src, BIG_SIZE, g_frame, sizeof(g_frame));
+        ASSERT_EQ_I32(mc_lz_reader_begin(&r, g_frame, flen), 0);
+        while ((rc = mc_lz_reader_next(&r, block, sizeof(block), &got)) == 1) {
+            if (memcmp(block, g_src + total, got) != 0) ok = 0;
+            total += got;
+            blocks++;
+        }
+        ASSERT_EQ_I32(rc, 0);
+        ASSERT(ok);
+        ASSERT_EQ_U32(total, BIG_SIZE);
+        ASSERT_EQ_U32(blocks, (BIG_SIZE + MC_LZ_BLOCK_SIZE - 1) / MC_LZ_BLOCK_SIZE);
+    }
+    TEST_END();
+}
+
+static void test_frame_rejects_corruption(void) {
+    TEST_BEGIN("frame_rejects_corruption");
+    {
+        uint32_t flen, got, i, ok = 1;
+        McRng r;
+        fill_layer_rows(g_src, 100000);
+        flen = mc_lz_frame_compress(&g_lz, g_src, 100000, g_frame, sizeof(g_frame));
+
+        ASSERT_EQ_I32(mc_lz_frame_decompress(g_frame, flen - 1, g_out, sizeof(g_out), &got), -1);
+        ASSERT_EQ_I32(mc_lz_frame_decompress(g_frame, flen, g_out, 99999, &got), -1);
+        ASSERT_EQ_U32(mc_lz_frame_compress(&g_lz, g_src, 100000, g_frame, 100), 0);
+        flen = mc_lz_frame_compress(&g_lz, g_src, 100000, g_frame, sizeof(g_frame));
+
+        /* Any single flipped payload bit is caught */
+        mc_rng_seed(&r, 4);
+        for (i = 0; i < 200; i++) {
+            uint32_t at = (uint32_t)sizeof(LzFrameHeader) + mc_rng_next(&r) % (flen - sizeof(LzFrameHeader));
+            uint8_t bit = (uint8_t)(1u << (mc_rng_next(&r) & 7));
+            g_frame[at] ^= bit;
+            if (mc_lz_frame_decompress(g_frame, flen, g_out, sizeof(g_out), &got) == 0
+                && memcmp(g_out, g_src, 100000) != 0) ok = 0;
+            g_frame[at] ^= bit;
+        }
+        ASSERT(ok);
+        ASSERT_EQ_I32(mc_lz_frame_decompress(g_frame, flen, g_out, sizeof(g_out), &got), 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: SAVE FILES
+ * ========================================================================= */
+
+/* Save-file worlds: world_init(w, TW_LAYERS), one layer pool, no timers */
+static TestWorld g_wa;
+static TestWorld g_wb;
+static uint8_t   g_scratch[1 << 20];
+
+static void lz_world_populate(TestWorld* w) {
+    static uint8_t rows[MC_MAX_ENTITIES * sizeof(CLayerStack)];
+    uint32_t i;
+    fill_layer_rows(rows, sizeof(rows));
+    for (i = 0; i < MC_MAX_ENTITIES; i++) {
+        EntityID e = mc_entity_create(&w->alloc);
+        mc_sparse_set_add(&w->layers, e, rows + i * sizeof(CLayerStack));
+    }
+}
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    long n;
+    if (f == NULL) return -1;
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fclose(f);
+    return n;
+}
+
+static void test_save_file_compressed(void) {
+    TEST_BEGIN("save_file_compressed");
+    {
+        const char* path = "test_lz_world.msav";
+        uint32_t raw;
+        world_init(&g_wa, TW_LAYERS);
+        lz_world_populate(&g_wa);
+        raw = mc_world_save_size(&g_wa.refs);
+        ASSERT_EQ_I32(mc_world_save_file_lz(&g_wa.refs, path, &g_lz, g_scratch, sizeof(g_scratch)), 0);
+        ASSERT(file_size(path) > 0 && file_size(path) * 4 < (long)raw);
+
+        world_init(&g_wb, TW_LAYERS);
+        ASSERT_EQ_I32(mc_world_load_file(&g_wb.refs, path, g_scratch, sizeof(g_scratch)), 0);
+        ASSERT_EQ_U32(g_wb.layers.count, MC_MAX_ENTITIES);
+        ASSERT(pool_equal(&g_wa.layers, &g_wb.layers));
+
+        /* Scratch too small to hold frame + raw bytes side by side */
+        world_init(&g_wb, TW_LAYERS);
+        ASSERT_EQ_I32(mc_world_load_file(&g_wb.refs, path, g_scratch, raw), -1);
+        remove(path);
+    }
+    TEST_END();
+}
+
+static void test_autosave_compressed(void) {
+    TEST_BEGIN("autosave_compressed");
+    {
+        const char* path = "test_lz_auto.msav";
+        McAutosave as;
+        world_init(&g_wa, TW_LAYERS);
+        lz_world_populate(&g_wa);
+        mc_autosave_init(&as, g_scratch, sizeof(g_scratch));
+        mc_autosave_set_compression(&as, &g_lz);
+        ASSERT_EQ_I32(mc_autosave_begin(&as, &g_wa.refs, path), 0);
+        ASSERT_EQ_I32(mc_autosave_finish(&as), 0);
+        ASSERT(file_size(path) * 4 < (long)as.length);
+
+        world_init(&g_wb, TW_LAYERS);
+        ASSERT_EQ_I32(mc_world_load_file(&g_wb.refs, path, g_scratch, sizeof(g_scratch)), 0);
+        ASSERT_EQ_U32(g_wb.layers.count, MC_MAX_ENTITIES);
+        remove(path);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * THROUGHPUT (informational)
+ * ========================================================================= */
+
+static void test_decode_throughput(void) {
+    TEST_BEGIN("decode_throughput");
+    {
+        uint32_t flen, got = 0, iters = 200, i;
+        clock_t t0, t1;
+        double secs;
+        fill_layer_rows(g_src, BIG_SIZE);
+        flen = mc_lz_frame_compress(&g_lz, g_src, BIG_SIZE, g_frame, sizeof(g_frame));
+
+        t0 = clock();
+        for (i = 0; i < iters; i++) {
+            mc_lz_frame_decompress(g_frame, flen, g_out, sizeof(g_out), &got);
+        }
+        t1 = clock();
+        secs = (double)(t1 - t0) / CLOCKS_PER_SEC;
+        if (secs > 0.0) {
+            printf("    decode: %.0f MB/s (incl. checksum)\n",
+                   (double)BIG_SIZE * iters / (1024.0 * 1024.0) / secs);
+        }
+        ASSERT_EQ_U32(got, BIG_SIZE);
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("MarbleEngine LZ Compression Tests\n");
+    printf("=================================\n\n");
+
+    printf("[Codec]\n");
+    test_checksum_vectors();
+    test_roundtrip_edge_sizes();
+    test_roundtrip_redundant_rows();
+    test_roundtrip_incompressible();
+    test_roundtrip_long_runs();
+    test_block_rejects_malformed();
+    test_block_garbage_is_safe();
+
+    printf("\n[Frames / Streaming]\n");
+    test_stream_chunks_match_oneshot();
+    test_reader_block_at_a_time();
+    test_frame_rejects_corruption();
+
+    printf("\n[Save Files]\n");
+    test_save_file_compressed();
+    test_autosave_compressed();
+
+    printf("\n[Throughput]\n");
+    test_decode_throughput();
+
+    printf("\n=================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,401 @@
+/*
+ * test_mbin.c -- Binary World Manifest Tests
+ *
+ * Tests the .mbin writer, validation against truncated and corrupted
+ * images, one-shot pool loads matching the source pools, zero-copy
+ * views into the image, and loading through a file mapping.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_mbin.c -o test_mbin.exe
+ */
+
+#include "marble_mbin.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NULL(ptr) \
+    do { \
+        if ((ptr) != NULL) { \
+            printf("  FAIL: %s (line %d): %s should be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+typedef struct {
+    int32_t hp;
+    int32_t max_hp;
+} CHealth;
+
+typedef struct {
+    float x;
+    float y;
+} CPosition;
+
+#define COMP_HEALTH    0
+#define COMP_POSITION  1
+
+static EntityAllocator g_alloc;
+static SparseSet       g_health;
+static SparseSet       g_position;
+static SparseSet       g_load_health;
+static SparseSet       g_load_position;
+
+/* uint32_t-backed so the image is aligned like a real mapping */
+static uint32_t g_image_words[(MC_MAX_ENTITIES * 80 * 2) / 4];
+#define g_image ((uint8_t*)g_image_words)
+
+/* 100 entities; every entity has health, every third has a position.
+ * A few are removed so dense order differs from EntityID order. */
+static void build_world(void) {
+    uint32_t i;
+    mc_entity_alloc_init(&g_alloc);
+    mc_sparse_set_init(&g_health, sizeof(CHealth));
+    mc_sparse_set_init(&g_position, sizeof(CPosition));
+    for (i = 0; i < 100; i++) {
+        EntityID eid = mc_entity_create(&g_alloc);
+        CHealth h;
+        h.hp = (int32_t)i;
+        h.max_hp = 100;
+        mc_sparse_set_add(&g_health, eid, &h);
+        if (i % 3 == 0) {
+            CPosition p;
+            p.x = (float)i;
+            p.y = (float)i * 0.5f;
+            mc_sparse_set_add(&g_position, eid, &p);
+        }
+    }
+    mc_sparse_set_remove(&g_health, 7);
+    mc_sparse_set_remove(&g_health, 42);
+}
+
+static uint32_t write_world(void) {
+    const SparseSet* pools[2];
+    uint32_t types[2];
+    pools[0] = &g_health;   types[0] = COMP_HEALTH;
+    pools[1] = &g_position; types[1] = COMP_POSITION;
+    return mc_mbin_write(g_image, sizeof(g_image_words), &g_alloc, pools, types, 2);
+}
+
+/* Re-seal the checksum after deliberately corrupting the body */
+static void reseal(void) {
+    MbinHeader* hdr = (MbinHeader*)g_image;
+    hdr->checksum = mc_mbin_checksum(g_image + sizeof(MbinHeader),
+                                     hdr->file_size - (uint32_t)sizeof(MbinHeader));
+}
+
+static int pools_equal(const SparseSet* a, const SparseSet* b) {
+    uint32_t e;
+    if (a->count != b->count || a->stride != b->stride) return 0;
+    for (e = 0; e < MC_MAX_ENTITIES; e++) {
+        const void* da = mc_sparse_set_get_const(a, e);
+        const void* db = mc_sparse_set_get_const(b, e);
+        if ((da == NULL) != (db == NULL)) return 0;
+        if (da != NULL && memcmp(da, db, a->stride) != 0) return 0;
+    }
+    return 1;
+}
+
+/* =========================================================================
+ * TESTS: WRITE / VALIDATE
+ * ========================================================================= */
+
+static void test_mbin_write_validates(void) {
+    TEST_BEGIN("mbin_write_validates");
+    {
+        uint32_t size = write_world();
+        const MbinHeader* hdr = mc_mbin_header(g_image);
+        const SparseSet* pools[2];
+        pools[0] = &g_health;
+        pools[1] = &g_position;
+        ASSERT(size > 0);
+        ASSERT_EQ_U32(size, mc_mbin_write_size(pools, 2));
+        ASSERT_EQ_U32(size % MC_MBIN_ALIGN, 0);
+        ASSERT_EQ_U32(hdr->entity_count, 100);
+        ASSERT_EQ_U32(hdr->pool_count, 2);
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), 0);
+    }
+    TEST_END();
+}
+
+static void test_mbin_write_too_small(void) {
+    TEST_BEGIN("mbin_write_too_small");
+    {
+        const SparseSet* pools[1];
+        uint32_t types[1] = { COMP_HEALTH };
+        pools[0] = &g_health;
+        ASSERT_EQ_U32(mc_mbin_write(g_image, 64, &g_alloc, pools, types, 1), 0);
+    }
+    TEST_END();
+}
+
+static void test_mbin_blocks_aligned(void) {
+    TEST_BEGIN("mbin_blocks_aligned");
+    {
+        uint32_t p;
+        write_world();
+        for (p = 0; p < 2; p++) {
+            const MbinPoolDesc* pd = mc_mbin_pool_desc(g_image, p);
+            ASSERT_EQ_U32(pd->dense_offset % MC_MBIN_ALIGN, 0);
+            ASSERT_EQ_U32(pd->data_offset % MC_MBIN_ALIGN, 0);
+        }
+    }
+    TEST_END();
+}
+
+static void test_mbin_rejects_corruption(void) {
+    TEST_BEGIN("mbin_rejects_corruption");
+    {
+        uint32_t size = write_world();
+        MbinHeader* hdr = (MbinHeader*)g_image;
+        MbinPoolDesc* pd = (MbinPoolDesc*)(g_image + sizeof(MbinHeader));
+        EntityID* dense;
+
+        /* Truncated */
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size - 1), -1);
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, 8), -1);
+
+        /* Bad magic / version */
+        hdr->magic ^= 1;
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), -1);
+        hdr->magic ^= 1;
+        hdr->version = 99;
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), -1);
+        hdr->version = MC_MBIN_VERSION;
+
+        /* Payload bit flip: structurally fine, caught by the opt-in checksum */
+        ASSERT_EQ_I32(mc_mbin_verify_checksum(g_image), 0);
+        g_image[pd[0].data_offset] ^= 0x40;
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), 0);
+        ASSERT_EQ_I32(mc_mbin_verify_checksum(g_image), -1);
+        g_image[pd[0].data_offset] ^= 0x40;
+        ASSERT_EQ_I32(mc_mbin_verify_checksum(g_image), 0);
+
+        /* Block out of bounds */
+        pd[1].data_offset = size;
+        reseal();
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), -1);
+        write_world();
+
+        /* EntityID beyond entity_count */
+        dense = (EntityID*)(g_image + pd[0].dense_offset);
+        dense[0] = 100;
+        reseal();
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), -1);
+
+        /* Duplicate EntityID within a pool */
+        dense[0] = dense[1];
+        reseal();
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), -1);
+        write_world();
+
+        /* Two pools claiming one component type */
+        pd[1].comp_type = pd[0].comp_type;
+        reseal();
+        ASSERT_EQ_I32(mc_mbin_validate(g_image, size), -1);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: LOAD
+ * ========================================================================= */
+
+static void test_mbin_load_matches_source(void) {
+    TEST_BEGIN("mbin_load_matches_source");
+    {
+        const MbinPoolDesc* pd;
+        write_world();
+        mc_sparse_set_init(&g_load_health, sizeof(CHealth));
+        mc_sparse_set_init(&g_load_position, sizeof(CPosition));
+
+        pd = mc_mbin_find_pool(g_image, COMP_HEALTH);
+        ASSERT_NOT_NULL(pd);
+        ASSERT_EQ_I32(mc_mbin_load_pool(&g_load_health, g_image, pd), 0);
+        pd = mc_mbin_find_pool(g_image, COMP_POSITION);
+        ASSERT_NOT_NULL(pd);
+        ASSERT_EQ_I32(mc_mbin_load_pool(&g_load_position, g_image, pd), 0);
+
+        ASSERT(pools_equal(&g_health, &g_load_health));
+        ASSERT(pools_equal(&g_position, &g_load_position));
+        ASSERT(!mc_sparse_set_has(&g_load_health, 42));
+    }
+    TEST_END();
+}
+
+static void test_mbin_load_replaces_contents(void) {
+    TEST_BEGIN("mbin_load_replaces_contents");
+    {
+        CHealth h;
+        h.hp = 1;
+        h.max_hp = 1;
+        write_world();
+        mc_sparse_set_init(&g_load_health, sizeof(CHealth));
+        mc_sparse_set_add(&g_load_health, 42, &h);   /* not in the image */
+        mc_sparse_set_add(&g_load_health, 500, &h);  /* beyond the image */
+
+        mc_mbin_load_pool(&g_load_health, g_image, mc_mbin_find_pool(g_image, COMP_HEALTH));
+        ASSERT(!mc_sparse_set_has(&g_load_health, 42));
+        ASSERT(!mc_sparse_set_has(&g_load_health, 500));
+        ASSERT(pools_equal(&g_health, &g_load_health));
+    }
+    TEST_END();
+}
+
+static void test_mbin_load_rejects_stride_mismatch(void) {
+    TEST_BEGIN("mbin_load_rejects_stride_mismatch");
+    {
+        write_world();
+        mc_sparse_set_init(&g_load_health, sizeof(CHealth) + 4);
+        ASSERT_EQ_I32(mc_mbin_load_pool(&g_load_health, g_image,
+                                        mc_mbin_find_pool(g_image, COMP_HEALTH)), -1);
+        ASSERT_EQ_U32(g_load_health.count, 0);
+    }
+    TEST_END();
+}
+
+static void test_mbin_zero_copy_view(void) {
+    TEST_BEGIN("mbin_zero_copy_view");
+    {
+        const MbinPoolDesc* pd;
+        const CPosition* pos;
+        const EntityID* dense;
+        write_world();
+        pd = mc_mbin_find_pool(g_image, COMP_POSITION);
+        pos = (const CPosition*)mc_mbin_pool_data(g_image, pd);
+        dense = mc_mbin_pool_dense(g_image, pd);
+        ASSERT((const uint8_t*)pos >= g_image);
+        ASSERT((const uint8_t*)pos < g_image + mc_mbin_header(g_image)->file_size);
+        ASSERT_EQ_U32(dense[1], 3);
+        ASSERT(pos[1].x == 3.0f);
+        ASSERT_NULL(mc_mbin_find_pool(g_image, 9));
+    }
+    TEST_END();
+}
+
+static void test_mbin_map_file(void) {
+    TEST_BEGIN("mbin_map_file");
+    {
+        const char* path = "test_mbin.tmp";
+        uint32_t size = write_world();
+        MbinMapping m;
+        FILE* f = fopen(path, "wb");
+        ASSERT_NOT_NULL(f);
+        if (f != NULL) {
+            fwrite(g_image, 1, size, f);
+            fclose(f);
+            ASSERT_EQ_I32(mc_mbin_map(&m, path), 0);
+            if (m.base != NULL) {
+                ASSERT_EQ_U32((uint32_t)m.size, size);
+                ASSERT_EQ_I32(mc_mbin_validate(m.base, m.size), 0);
+                mc_sparse_set_init(&g_load_health, sizeof(CHealth));
+                mc_mbin_load_pool(&g_load_health, m.base,
+                                  mc_mbin_find_pool(m.base, COMP_HEALTH));
+                ASSERT(pools_equal(&g_health, &g_load_health));
+                mc_mbin_unmap(&m);
+            }
+            remove(path);
+        }
+        ASSERT_EQ_I32(mc_mbin_map(&m, "does_not_exist.mbin"), -1);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Binary Manifest Tests\n");
+    printf("==================================\n\n");
+
+    build_world();
+
+    printf("[Write / Validate]\n");
+    test_mbin_write_validates();
+    test_mbin_write_too_small();
+    test_mbin_blocks_aligned();
+    test_mbin_rejects_corruption();
+
+    printf("\n[Load]\n");
+    test_mbin_load_matches_source();
+    test_mbin_load_replaces_contents();
+    test_mbin_load_rejects_stride_mismatch();
+    test_mbin_zero_copy_view();
+    test_mbin_map_file();
+
+    printf("\n==================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
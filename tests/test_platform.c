@@ -0,0 +1,225 @@
+/*
+ * test_platform.c -- Platform Timing + Tick Jitter Tests
+ *
+ * Tests the TickJitter statistics (exact microsecond percentiles,
+ * overflow bucket, mean) and the platform layer's deadline sleep: it
+ * never returns before the deadline, wakes close after it, and does
+ * not drift over a run of back-to-back deadlines.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_platform.c -o test_platform.exe
+ *   (MinGW: add -lwinmm)
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "marble_core.h"
+
+#ifdef _WIN32
+#include "marble_platform_win32.h"
+#else
+#include "marble_platform_posix.h"
+#endif
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+
+/* =========================================================================
+ * JITTER STATS
+ * ========================================================================= */
+
+static void test_jitter_quantiles(void) {
+    TEST_BEGIN("jitter_quantiles");
+    {
+        static TickJitter j;
+        uint32_t i;
+
+        mc_tick_jitter_init(&j);
+        ASSERT(mc_tick_jitter_quantile(&j, 0.99) == 0);
+        ASSERT(mc_tick_jitter_mean(&j) == 0);
+
+        /* 0..999 us, once each */
+        for (i = 0; i < 1000; i++) mc_tick_jitter_record(&j, (i * 7u) % 1000u);
+        ASSERT(j.count == 1000);
+        ASSERT(j.max_us == 999);
+        ASSERT(mc_tick_jitter_mean(&j) == 499);
+        ASSERT(mc_tick_jitter_quantile(&j, 0.0) == 0);
+        ASSERT(mc_tick_jitter_quantile(&j, 0.50) == 500);
+        ASSERT(mc_tick_jitter_quantile(&j, 0.99) == 990);
+        ASSERT(mc_tick_jitter_quantile(&j, 1.0) == 999);
+    }
+    TEST_END();
+}
+
+static void test_jitter_overflow_bucket(void) {
+    TEST_BEGIN("jitter_overflow_bucket");
+    {
+        static TickJitter j;
+        uint32_t i;
+
+        mc_tick_jitter_init(&j);
+        for (i = 0; i < 98; i++) mc_tick_jitter_record(&j, 3);
+        mc_tick_jitter_record(&j, 5000);
+        mc_tick_jitter_record(&j, 250000);      /* a 250 ms hitch */
+        ASSERT_EQ_U32(j.hist[MC_JITTER_BUCKETS - 1], 2);
+        ASSERT(mc_tick_jitter_quantile(&j, 0.50) == 3);
+        /* Past the last exact bucket the quantile reports the true max */
+        ASSERT(mc_tick_jitter_quantile(&j, 0.99) == 250000);
+        ASSERT(j.max_us == 250000);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * DEADLINE SLEEP
+ * ========================================================================= */
+
+#define SLEEP_ROUNDS 40
+#define SLEEP_STEP_US 2500
+
+static void test_sleep_until_never_early(void) {
+    TEST_BEGIN("sleep_until_never_early");
+    {
+        static TickJitter j;
+        uint64_t start, deadline = 0;
+        uint32_t i, early = 0;
+
+        mc_tick_jitter_init(&j);
+        start = mc_platform_time_us();
+        for (i = 1; i <= SLEEP_ROUNDS; i++) {
+            uint64_t now;
+            deadline = start + (uint64_t)i * SLEEP_STEP_US;
+            mc_platform_sleep_until_us(deadline);
+            now = mc_platform_time_us();
+            if (now < deadline) early++;
+            else mc_tick_jitter_record(&j, now - deadline);
+        }
+        ASSERT_EQ_U32(early, 0);
+        /* Typical wakeups land within the spin; the bound is loose so a
+         * loaded test machine doesn't flake. */
+        ASSERT(mc_tick_jitter_quantile(&j, 0.50) < 500);
+        printf("    (deadline lateness: p50 %llu us, p99 %llu us, max %llu us)\n",
+               (unsigned long long)mc_tick_jitter_quantile(&j, 0.50),
+               (unsigned long long)mc_tick_jitter_quantile(&j, 0.99),
+               (unsigned long long)j.max_us);
+
+        /* A past deadline returns at once */
+        start = mc_platform_time_us();
+        mc_platform_sleep_until_us(start - 1000);
+        ASSERT(mc_platform_time_us() - start < 1000);
+    }
+    TEST_END();
+}
+
+static void test_sleep_until_no_drift(void) {
+    TEST_BEGIN("sleep_until_no_drift");
+    {
+        uint64_t start, end;
+        uint32_t i;
+
+        /* Work between sleeps is absorbed by the absolute deadline */
+        start = mc_platform_time_us();
+        for (i = 1; i <= SLEEP_ROUNDS; i++) {
+            uint64_t t = mc_platform_time_us();
+            while (mc_platform_time_us() - t < 300) { }    /* "tick work" */
+            mc_platform_sleep_until_us(start + (uint64_t)i * SLEEP_STEP_US);
+        }
+        end = mc_platform_time_us();
+        ASSERT(end >= start + SLEEP_ROUNDS * SLEEP_STEP_US);
+        ASSERT(end <  start + SLEEP_ROUNDS * SLEEP_STEP_US + 5000);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Platform Timing Tests\n");
+    printf("==================================\n\n");
+
+    mc_platform_init();
+    printf("(spin margin: %llu us)\n\n", (unsigned long long)g_spin_us);
+
+    printf("[Tick Jitter]\n");
+    test_jitter_quantiles();
+    test_jitter_overflow_bucket();
+
+    printf("\n[Deadline Sleep]\n");
+    test_sleep_until_never_early();
+    test_sleep_until_no_drift();
+
+    printf("\n==================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
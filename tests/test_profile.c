@@ -0,0 +1,391 @@
+/*
+ * test_profile.c -- Tick Profiler Tests
+ *
+ * Tests the log-linear histogram buckets and percentiles, zone nesting
+ * and the depth limit, ring wraparound, the Chrome trace output, the
+ * slow-tick trigger (worst zone + automatic dump), and that worker
+ * threads recording into their own slots merge into one report.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_profile.c -o test_profile.exe -lpthread
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "marble_profile.h"
+#include "marble_thread.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+
+static McProfiler g_prof;
+static char       g_text[1u << 20];
+
+static void spin_ns(uint64_t ns) {
+    uint64_t t0 = mc_prof_now_ns();
+    while (mc_prof_now_ns() - t0 < ns) { }
+}
+
+/* Read a whole file into g_text. Returns its length, or 0. */
+static uint32_t slurp(FILE* f) {
+    size_t n;
+    rewind(f);
+    n = fread(g_text, 1, sizeof(g_text) - 1, f);
+    g_text[n] = '\0';
+    return (uint32_t)n;
+}
+
+static uint32_t count_substr(const char* hay, const char* needle) {
+    uint32_t n = 0;
+    const char* p = hay;
+    while ((p = strstr(p, needle)) != NULL) { n++; p++; }
+    return n;
+}
+
+/* =========================================================================
+ * HISTOGRAM
+ * ========================================================================= */
+
+static void test_bucket_bounds(void) {
+    TEST_BEGIN("bucket_bounds");
+    {
+        uint64_t v;
+        uint32_t prev = 0, bad_order = 0, bad_range = 0;
+
+        for (v = 0; v < 5000000ull; v = v + 1 + v / 7) {
+            uint32_t b = mc_prof__bucket(v);
+            if (b < prev) bad_order++;
+            if (v < mc_prof__bucket_low(b) || v >= mc_prof__bucket_low(b + 1)) bad_range++;
+            /* bucket width is at most a quarter of its low edge */
+            if (v >= 4 && (mc_prof__bucket_low(b + 1) - mc_prof__bucket_low(b)) * 4 > mc_prof__bucket_low(b)) bad_range++;
+            prev = b;
+        }
+        ASSERT_EQ_U32(bad_order, 0);
+        ASSERT_EQ_U32(bad_range, 0);
+        ASSERT_EQ_U32(mc_prof__bucket(3), 3);
+        ASSERT_EQ_U32(mc_prof__bucket(4), 4);
+        ASSERT_EQ_U32(mc_prof__bucket(8), 8);
+        ASSERT_EQ_U32(mc_prof__bucket(0xFFFFFFFFFFFFull), MC_PROF_HIST_BUCKETS - 1);
+    }
+    TEST_END();
+}
+
+static void test_percentiles(void) {
+    TEST_BEGIN("percentiles");
+    {
+        McProfStats st;
+        uint64_t now;
+        uint32_t i;
+
+        mc_prof_init(&g_prof);
+        now = g_prof.epoch_ns;
+        /* 1..1000 us, shuffled by a stride coprime to 1000 */
+        for (i = 0; i < 1000; i++) {
+            uint64_t us = (uint64_t)((i * 383u) % 1000u) + 1u;
+            mc_prof_record(&g_prof, 0, MC_PROF_ZONE_FIRST_SYSTEM, now, us * 1000u);
+        }
+        mc_prof_zone_stats(&g_prof, MC_PROF_ZONE_FIRST_SYSTEM, &st);
+        ASSERT(st.count == 1000);
+        ASSERT(st.max_ns == 1000000u);
+        ASSERT(st.total_ns == 500500000ull);
+        ASSERT(st.p50_ns >= 500000u && st.p50_ns < 500000u * 5 / 4);
+        ASSERT(st.p99_ns >= 990000u && st.p99_ns <= 1000000u);
+
+        mc_prof_zone_stats(&g_prof, MC_PROF_ZONE_SNAPSHOT, &st);
+        ASSERT(st.count == 0 && st.p99_ns == 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * ZONES
+ * ========================================================================= */
+
+static void test_nesting_and_depth_limit(void) {
+    TEST_BEGIN("nesting_and_depth_limit");
+    {
+        const McProfThread* t = &g_prof.threads[2];
+        const McProfEvent* inner;
+        const McProfEvent* outer;
+        uint32_t i;
+
+        mc_prof_init(&g_prof);
+        mc_prof_begin(&g_prof, 2, MC_PROF_ZONE_CMD_FLUSH);
+        mc_prof_begin(&g_prof, 2, MC_PROF_ZONE_SNAPSHOT);
+        spin_ns(20000);
+        mc_prof_end(&g_prof, 2);
+        mc_prof_end(&g_prof, 2);
+
+        ASSERT(t->written == 2);
+        inner = &t->ring[0];
+        outer = &t->ring[1];
+        ASSERT_EQ_U32(inner->zone, MC_PROF_ZONE_SNAPSHOT);
+        ASSERT_EQ_U32(inner->depth, 1);
+        ASSERT_EQ_U32(outer->zone, MC_PROF_ZONE_CMD_FLUSH);
+        ASSERT_EQ_U32(outer->depth, 0);
+        ASSERT(inner->dur_ns >= 20000);
+        ASSERT(outer->start_ns <= inner->start_ns);
+        ASSERT(outer->dur_ns >= inner->dur_ns);
+
+        /* Zones past the depth limit are counted but not timed, and the
+         * stack unwinds cleanly */
+        for (i = 0; i < MC_PROF_MAX_DEPTH + 3; i++) mc_prof_begin(&g_prof, 2, MC_PROF_ZONE_SNAPSHOT);
+        for (i = 0; i < MC_PROF_MAX_DEPTH + 3; i++) mc_prof_end(&g_prof, 2);
+        ASSERT_EQ_U32(t->too_deep, 3);
+        ASSERT_EQ_U32(t->depth, 0);
+        ASSERT(t->written == 2 + MC_PROF_MAX_DEPTH);
+        ASSERT(mc_prof_end(&g_prof, 2) == 0);          /* unbalanced end is a no-op */
+        ASSERT(mc_prof_end(&g_prof, MC_PROF_MAX_THREADS) == 0);     /* bad slot */
+    }
+    TEST_END();
+}
+
+static void test_trace_export(void) {
+    TEST_BEGIN("trace_export");
+    {
+        FILE* f = tmpfile();
+        uint32_t i, events, len;
+
+        mc_prof_init(&g_prof);
+        mc_prof_thread_name(&g_prof, 0, "main");
+        mc_prof_zone_name(&g_prof, MC_PROF_ZONE_FIRST_SYSTEM, "SYS_TEST");
+        /* Wrap the ring: only the newest MC_PROF_RING_EVENTS survive */
+        for (i = 0; i < MC_PROF_RING_EVENTS + 100; i++) {
+            mc_prof_tick_begin(&g_prof, 0, i);
+            MC_PROF_BEGIN(&g_prof, 0, MC_PROF_ZONE_FIRST_SYSTEM);
+            MC_PROF_END(&g_prof, 0);
+            mc_prof_tick_end(&g_prof, 0);
+        }
+        mc_prof_begin(&g_prof, 3, MC_PROF_ZONE_SNAPSHOT);
+        mc_prof_end(&g_prof, 3);
+
+        ASSERT_NOT_NULL(f);
+        if (f != NULL) {
+            events = mc_prof_write_trace(&g_prof, f);
+            len = slurp(f);
+            fclose(f);
+            ASSERT_EQ_U32(events, MC_PROF_RING_EVENTS + 1);
+            ASSERT(len > 0);
+            ASSERT(strncmp(g_text, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 39) == 0);
+            ASSERT(strcmp(g_text + len - 4, "\n]}\n") == 0);
+            ASSERT_EQ_U32(count_substr(g_text, "\"ph\":\"X\""), events);
+            ASSERT_EQ_U32(count_substr(g_text, "\"ph\":\"M\""), 2);
+            ASSERT_EQ_U32(count_substr(g_text, "\"args\":{\"name\":\"main\"}"), 1);
+            ASSERT_EQ_U32(count_substr(g_text, "\"args\":{\"name\":\"worker\"}"), 1);
+            ASSERT_EQ_U32(count_substr(g_text, "\"name\":\"SYS_TEST\""), MC_PROF_RING_EVENTS / 2);
+            /* 2 events per tick: ticks 1124..2147 fill the ring */
+            ASSERT_EQ_U32(count_substr(g_text, "\"args\":{\"tick\":1123}"), 0);
+            ASSERT_EQ_U32(count_substr(g_text, "\"args\":{\"tick\":1124}"), 2);
+            ASSERT_EQ_U32(count_substr(g_text, "\"args\":{\"tick\":2147}"), 2);
+            ASSERT_EQ_U32(count_substr(g_text, "{\""), count_substr(g_text, "}"));
+        }
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SLOW TICKS
+ * ========================================================================= */
+
+static void test_slow_tick_trigger(void) {
+    TEST_BEGIN("slow_tick_trigger");
+    {
+        static const char* path = "test_profile_slow.json";
+        FILE* f;
+        int slow;
+
+        remove(path);
+        mc_prof_init(&g_prof);
+        mc_prof_set_slow_trigger(&g_prof, 500, path, 1);   /* 0.5 ms budget */
+
+        mc_prof_tick_begin(&g_prof, 0, 10);
+        MC_PROF_BEGIN(&g_prof, 0, MC_PROF_ZONE_CMD_FLUSH);
+        MC_PROF_END(&g_prof, 0);
+        ASSERT_EQ_I32(mc_prof_tick_end(&g_prof, 0), 0);
+        ASSERT_EQ_U32(g_prof.slow_ticks, 0);
+
+        mc_prof_tick_begin(&g_prof, 0, 11);
+        MC_PROF_BEGIN(&g_prof, 0, MC_PROF_ZONE_CMD_FLUSH);
+        spin_ns(50000);
+        MC_PROF_END(&g_prof, 0);
+        MC_PROF_BEGIN(&g_prof, 0, MC_PROF_ZONE_FIRST_SYSTEM + 1);
+        spin_ns(1000000);                                  /* the culprit */
+        MC_PROF_END(&g_prof, 0);
+        slow = mc_prof_tick_end(&g_prof, 0);
+
+        ASSERT_EQ_I32(slow, 1);
+        ASSERT_EQ_U32(g_prof.slow_ticks, 1);
+        ASSERT(g_prof.last_slow.tick == 11);
+        ASSERT_EQ_U32(g_prof.last_slow.worst_zone, MC_PROF_ZONE_FIRST_SYSTEM + 1);
+        ASSERT(g_prof.last_slow.worst_ns >= 1000000u);
+        ASSERT(g_prof.last_slow.dur_ns >= g_prof.last_slow.worst_ns);
+        ASSERT_EQ_U32(g_prof.dumps_left, 0);
+
+        f = fopen(path, "rb");
+        ASSERT_NOT_NULL(f);
+        if (f != NULL) {
+            slurp(f);
+            fclose(f);
+            ASSERT_EQ_U32(count_substr(g_text, "\"args\":{\"tick\":11}"), 3);
+        }
+        remove(path);
+
+        /* Later slow ticks are still counted, but the dump budget is spent */
+        mc_prof_tick_begin(&g_prof, 0, 12);
+        spin_ns(600000);
+        ASSERT_EQ_I32(mc_prof_tick_end(&g_prof, 0), 1);
+        ASSERT_EQ_U32(g_prof.slow_ticks, 2);
+        f = fopen(path, "rb");
+        ASSERT(f == NULL);
+        if (f != NULL) fclose(f);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * THREADS
+ * ========================================================================= */
+
+#define PROF_WORKERS 4
+#define PROF_ZONES_PER_WORKER 5000
+
+static MC_THREAD_PROC(prof_worker) {
+    uint32_t slot = *(const uint32_t*)mc_thread_arg;
+    uint32_t i;
+    for (i = 0; i < PROF_ZONES_PER_WORKER; i++) {
+        mc_prof_tick_begin(&g_prof, slot, i);
+        MC_PROF_BEGIN(&g_prof, slot, MC_PROF_ZONE_FIRST_SYSTEM);
+        MC_PROF_END(&g_prof, slot);
+        mc_prof_tick_end(&g_prof, slot);
+    }
+    MC_THREAD_RETURN;
+}
+
+static void test_threads_merge(void) {
+    TEST_BEGIN("threads_merge");
+    {
+        McThread threads[PROF_WORKERS];
+        uint32_t slots[PROF_WORKERS];
+        int started[PROF_WORKERS];
+        McProfStats st;
+        uint32_t w;
+
+        mc_prof_init(&g_prof);
+        for (w = 0; w < PROF_WORKERS; w++) {
+            slots[w] = w + 1;
+            started[w] = (mc_thread_start(&threads[w], prof_worker, &slots[w]) == 0);
+            if (!started[w]) prof_worker(&slots[w]);
+        }
+        for (w = 0; w < PROF_WORKERS; w++) {
+            if (started[w]) mc_thread_join(&threads[w]);
+        }
+
+        mc_prof_zone_stats(&g_prof, MC_PROF_ZONE_FIRST_SYSTEM, &st);
+        ASSERT(st.count == (uint64_t)PROF_WORKERS * PROF_ZONES_PER_WORKER);
+        mc_prof_zone_stats(&g_prof, MC_PROF_ZONE_TICK, &st);
+        ASSERT(st.count == (uint64_t)PROF_WORKERS * PROF_ZONES_PER_WORKER);
+        ASSERT(st.p50_ns <= st.p99_ns && st.p99_ns <= st.max_ns);
+        ASSERT(g_prof.threads[0].written == 0);
+        for (w = 1; w <= PROF_WORKERS; w++) {
+            ASSERT(g_prof.threads[w].written == 2u * PROF_ZONES_PER_WORKER);
+            ASSERT_EQ_U32(g_prof.threads[w].depth, 0);
+        }
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Tick Profiler Tests\n");
+    printf("================================\n\n");
+
+    printf("[Histogram]\n");
+    test_bucket_bounds();
+    test_percentiles();
+
+    printf("\n[Zones]\n");
+    test_nesting_and_depth_limit();
+    test_trace_export();
+
+    printf("\n[Slow Ticks]\n");
+    test_slow_tick_trigger();
+
+    printf("\n[Threads]\n");
+    test_threads_merge();
+
+    printf("\n================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
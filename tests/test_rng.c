@@ -0,0 +1,322 @@
+/*
+ * test_rng.c -- Counter-Based RNG Tests
+ *
+ * Tests Philox4x32-10 against the published known-answer vectors, that
+ * the batch API matches the scalar API lane for lane (any length, any
+ * draw index, with and without a draw array), that results do not depend
+ * on batch order, that multiply-shift reduction stays in range and is
+ * evenly spread, and that distinct streams / ticks / entities decorrelate.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_rng.c -o test_rng.exe
+ *   (add -mavx2 to exercise the AVX2 path, -DMC_RNG_NO_SIMD for scalar)
+ */
+
+#include "marble_rng.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * PHILOX
+ * ========================================================================= */
+
+static void test_philox_known_answers(void) {
+    TEST_BEGIN("philox_known_answers");
+    {
+        /* Random123 kat_vectors: philox4x32_10 */
+        static const uint32_t ctr0[4] = { 0, 0, 0, 0 };
+        static const uint32_t exp0[4] = { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u };
+        static const uint32_t ctr1[4] = { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu };
+        static const uint32_t exp1[4] = { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu };
+        static const uint32_t ctr2[4] = { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u };
+        static const uint32_t exp2[4] = { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u };
+        uint32_t out[4];
+        uint32_t i;
+
+        mc_philox4x32(ctr0, 0, 0, out);
+        for (i = 0; i < 4; i++) ASSERT_EQ_U32(out[i], exp0[i]);
+        mc_philox4x32(ctr1, 0xffffffffu, 0xffffffffu, out);
+        for (i = 0; i < 4; i++) ASSERT_EQ_U32(out[i], exp1[i]);
+        mc_philox4x32(ctr2, 0xa4093822u, 0x299f31d0u, out);
+        for (i = 0; i < 4; i++) ASSERT_EQ_U32(out[i], exp2[i]);
+    }
+    TEST_END();
+}
+
+static void test_draws_share_blocks(void) {
+    TEST_BEGIN("draws_share_blocks");
+    {
+        McCrng g;
+        uint32_t block[4];
+        uint32_t d;
+
+        mc_crng_init(&g, 42u, MC_CRNG_STREAM_INTERACT);
+        mc_crng_block(&g, 0x100000007ull, 17, 2, block);
+        for (d = 0; d < 4; d++) {
+            ASSERT_EQ_U32(mc_crng_u32(&g, 0x100000007ull, 17, 8 + d), block[d]);
+        }
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * BATCH
+ * ========================================================================= */
+
+#define BATCH_MAX 203   /* deliberately not a multiple of any lane width */
+
+static void test_batch_matches_scalar(void) {
+    TEST_BEGIN("batch_matches_scalar");
+    {
+        static uint32_t entity[BATCH_MAX], draw[BATCH_MAX], out[BATCH_MAX];
+        static int32_t rolls[BATCH_MAX];
+        McCrng g;
+        McRng r;
+        uint32_t n, i;
+        uint32_t bad_u32 = 0, bad_d100 = 0, bad_nodraw = 0;
+        uint64_t tick = 0xDEADBEEF12345ull;
+
+        mc_crng_init(&g, 0xC0FFEEu, 7);
+        mc_rng_seed(&r, 99u);
+        for (i = 0; i < BATCH_MAX; i++) {
+            entity[i] = mc_rng_next(&r) % MC_MAX_ENTITIES;
+            draw[i]   = mc_rng_next(&r);
+        }
+
+        for (n = 0; n <= BATCH_MAX; n += 1 + n / 4) {
+            mc_crng_u32_batch(&g, tick, entity, draw, out, n);
+            for (i = 0; i < n; i++) {
+                if (out[i] != mc_crng_u32(&g, tick, entity[i], draw[i])) bad_u32++;
+            }
+            mc_crng_d100_batch(&g, tick, entity, draw, rolls, n);
+            for (i = 0; i < n; i++) {
+                if (rolls[i] != mc_crng_d100(&g, tick, entity[i], draw[i])) bad_d100++;
+            }
+            mc_crng_u32_batch(&g, tick, entity, NULL, out, n);
+            for (i = 0; i < n; i++) {
+                if (out[i] != mc_crng_u32(&g, tick, entity[i], 0)) bad_nodraw++;
+            }
+        }
+        ASSERT_EQ_U32(bad_u32, 0);
+        ASSERT_EQ_U32(bad_d100, 0);
+        ASSERT_EQ_U32(bad_nodraw, 0);
+    }
+    TEST_END();
+}
+
+static void test_batch_order_independent(void) {
+    TEST_BEGIN("batch_order_independent");
+    {
+        static uint32_t entity[64], draw[64], fwd[64], rev_e[64], rev_d[64], rev[64];
+        McCrng g;
+        uint32_t i, mismatches = 0;
+
+        mc_crng_init(&g, 5u, MC_CRNG_STREAM_USER);
+        for (i = 0; i < 64; i++) {
+            entity[i] = i * 7u;
+            draw[i]   = i % 5u;
+            rev_e[63 - i] = entity[i];
+            rev_d[63 - i] = draw[i];
+        }
+        mc_crng_u32_batch(&g, 300, entity, draw, fwd, 64);
+        mc_crng_u32_batch(&g, 300, rev_e, rev_d, rev, 64);
+        for (i = 0; i < 64; i++) {
+            if (fwd[i] != rev[63 - i]) mismatches++;
+        }
+        ASSERT_EQ_U32(mismatches, 0);
+
+        /* Rolling one lane alone gives the same number as in the batch */
+        mc_crng_u32_batch(&g, 300, entity + 13, draw + 13, rev, 1);
+        ASSERT_EQ_U32(rev[0], fwd[13]);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * RANGE + DISTRIBUTION
+ * ========================================================================= */
+
+static void test_reduce_range(void) {
+    TEST_BEGIN("reduce_range");
+    {
+        McRng r;
+        uint32_t i, out_of_range = 0;
+
+        ASSERT_EQ_U32(mc_rng_reduce(0, 100), 0);
+        ASSERT_EQ_U32(mc_rng_reduce(0xFFFFFFFFu, 100), 99);
+        ASSERT_EQ_U32(mc_rng_reduce(0x80000000u, 100), 50);
+        ASSERT_EQ_U32(mc_rng_reduce(0xFFFFFFFFu, 0), 0);
+
+        mc_rng_seed(&r, 1u);
+        ASSERT_EQ_U32(mc_rng_range(&r, 0), 0);
+        for (i = 0; i < 10000; i++) {
+            int32_t d = mc_rng_d100(&r);
+            if (d < 0 || d > 99) out_of_range++;
+        }
+        ASSERT_EQ_U32(out_of_range, 0);
+    }
+    TEST_END();
+}
+
+static void test_d100_distribution(void) {
+    TEST_BEGIN("d100_distribution");
+    {
+        static uint32_t entity[1000];
+        static int32_t rolls[1000];
+        uint32_t hist[100];
+        McCrng g;
+        uint32_t t, i, lo = 0xFFFFFFFFu, hi = 0;
+        double chi2 = 0.0;
+
+        memset(hist, 0, sizeof(hist));
+        mc_crng_init(&g, 42u, MC_CRNG_STREAM_INTERACT);
+        for (i = 0; i < 1000; i++) entity[i] = i;
+
+        /* 200k rolls; each bucket expects 2000 */
+        for (t = 0; t < 200; t++) {
+            mc_crng_d100_batch(&g, t, entity, NULL, rolls, 1000);
+            for (i = 0; i < 1000; i++) hist[rolls[i]]++;
+        }
+        for (i = 0; i < 100; i++) {
+            double d = (double)hist[i] - 2000.0;
+            chi2 += d * d / 2000.0;
+            if (hist[i] < lo) lo = hist[i];
+            if (hist[i] > hi) hi = hist[i];
+        }
+        /* 99 dof: p = 0.001 critical value is ~148 */
+        ASSERT(chi2 < 148.0);
+        ASSERT(lo > 1800 && hi < 2200);
+    }
+    TEST_END();
+}
+
+static void test_keys_decorrelate(void) {
+    TEST_BEGIN("keys_decorrelate");
+    {
+        McCrng a, b, c;
+        uint32_t i, v;
+        uint32_t same_stream = 0, same_tick = 0, same_entity = 0;
+        uint32_t bits = 0;
+
+        mc_crng_init(&a, 42u, 1);
+        mc_crng_init(&b, 42u, 2);
+        mc_crng_init(&c, 43u, 1);
+        for (i = 0; i < 1000; i++) {
+            uint32_t x = mc_crng_u32(&a, i, 3, 0);
+            uint32_t y = x ^ mc_crng_u32(&c, i, 3, 0);
+            if (x == mc_crng_u32(&b, i, 3, 0)) same_stream++;
+            if (x == mc_crng_u32(&a, i + 1, 3, 0)) same_tick++;
+            if (x == mc_crng_u32(&a, i, 4, 0)) same_entity++;
+            /* avalanche: flipping the seed's low bit flips ~half the output */
+            for (v = 0; v < 32; v++) bits += (y >> v) & 1u;
+        }
+        ASSERT_EQ_U32(same_stream, 0);
+        ASSERT_EQ_U32(same_tick, 0);
+        ASSERT_EQ_U32(same_entity, 0);
+        /* 32000 bits, expect ~16000 */
+        ASSERT(bits > 15000 && bits < 17000);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Counter-Based RNG Tests\n");
+    printf("====================================\n\n");
+#if MC_RNG_AVX2
+    printf("(batch path: AVX2, %d lanes)\n\n", MC_CRNG_LANES);
+#elif MC_RNG_SSE2
+    printf("(batch path: SSE2, %d lanes)\n\n", MC_CRNG_LANES);
+#elif MC_RNG_NEON
+    printf("(batch path: NEON, %d lanes)\n\n", MC_CRNG_LANES);
+#else
+    printf("(batch path: scalar)\n\n");
+#endif
+
+    printf("[Philox]\n");
+    test_philox_known_answers();
+    test_draws_share_blocks();
+
+    printf("\n[Batch]\n");
+    test_batch_matches_scalar();
+    test_batch_order_independent();
+
+    printf("\n[Range]\n");
+    test_reduce_range();
+    test_d100_distribution();
+    test_keys_decorrelate();
+
+    printf("\n====================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
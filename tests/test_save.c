@@ -0,0 +1,506 @@
+/*
+ * test_save.c -- World Save/Load Tests
+ *
+ * Tests versioned world serialization: exact round trips (allocator,
+ * pools, tick, RNG, timers), identical continuation after load, schema
+ * and corruption rejection without touching the world, forward-compatible
+ * chunk skipping, atomic file writes and background autosave.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_save.c -o test_save.exe -lpthread
+ */
+
+#include "marble_interact.h"
+#include "marble_save.h"
+#include "test_fixture.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+/* Every part saved: three pools plus timers */
+#define SAVE_PARTS (TW_HEALTH | TW_POSITION | TW_LAYERS | TW_TIMERS)
+
+static TestWorld g_a;
+static TestWorld g_b;
+static uint8_t   g_buf[1 << 21];
+static uint8_t   g_buf2[1 << 21];
+
+/* Populate with `n` entities, churn some, advance RNG/tick, queue timers */
+static void world_populate(TestWorld* w, uint32_t n, uint32_t seed) {
+    McRng r;
+    uint32_t i;
+    mc_rng_seed(&r, seed);
+    for (i = 0; i < n; i++) {
+        EntityID e = mc_entity_create(&w->alloc);
+        CHealth h;
+        h.hp = (int32_t)(mc_rng_next(&r) % 100);
+        h.max_hp = 100;
+        mc_sparse_set_add(&w->health, e, &h);
+        if (mc_rng_next(&r) & 1) {
+            CPosition p;
+            p.x = (float)(mc_rng_next(&r) % 1000);
+            p.y = (float)i;
+            mc_sparse_set_add(&w->position, e, &p);
+        }
+        if (i % 4 == 0) {
+            CLayerStack ls;
+            memset(&ls, 0, sizeof(ls));
+            ls.layer_count = 1;
+            ls.layers[0].material = MAT_WOOD;
+            ls.layers[0].integrity = (int32_t)i;
+            ls.layers[0].max_integrity = (int32_t)i;
+            mc_sparse_set_add(&w->layers, e, &ls);
+        }
+    }
+    for (i = 0; i < n; i += 7) {
+        mc_sparse_set_remove(&w->health, i);
+    }
+    for (i = 0; i < 20; i++) {
+        Command c;
+        memset(&c, 0, sizeof(c));
+        c.type = CMD_DAMAGE_LAYER;
+        c.target_entity = i;
+        c.damage_amount = (int32_t)i + 1;
+        mc_timer_schedule(&w->timers, &c, 5 + i * 37);
+    }
+    w->tick.tick_number = 1234;
+    w->tick.accumulated_us = 4321;
+    for (i = 0; i < 17; i++) mc_rng_next(&w->rng);
+}
+
+static int worlds_equal(const TestWorld* a, const TestWorld* b) {
+    return a->alloc.next_id == b->alloc.next_id
+        && a->tick.tick_number == b->tick.tick_number
+        && a->tick.accumulated_us == b->tick.accumulated_us
+        && a->rng.state == b->rng.state
+        && a->timers.count == b->timers.count
+        && pool_equal(&a->health, &b->health)
+        && pool_equal(&a->position, &b->position)
+        && pool_equal(&a->layers, &b->layers);
+}
+
+/* =========================================================================
+ * TESTS: ROUND TRIP
+ * ========================================================================= */
+
+static void test_save_size_exact(void) {
+    TEST_BEGIN("save_size_exact");
+    {
+        uint32_t len;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 300, 7);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+        ASSERT(len > 0);
+        ASSERT_EQ_U32(len, mc_world_save_size(&g_a.refs));
+        ASSERT_EQ_U32(mc_world_save(&g_a.refs, g_buf, len - 1), 0);
+    }
+    TEST_END();
+}
+
+static void test_save_roundtrip(void) {
+    TEST_BEGIN("save_roundtrip");
+    {
+        uint32_t len;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 500, 11);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+
+        /* Different world in the target: load must fully replace it */
+        world_init(&g_b, SAVE_PARTS);
+        world_populate(&g_b, 900, 99);
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), 0);
+        ASSERT(worlds_equal(&g_a, &g_b));
+    }
+    TEST_END();
+}
+
+static void test_save_sparse_not_written(void) {
+    TEST_BEGIN("save_sparse_not_written");
+    {
+        uint32_t len;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 10, 3);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+        /* 3 pools of MC_MAX_ENTITIES sparse entries would be 12 KB alone;
+         * everything but the timer wheel must fit in a fraction of that */
+        ASSERT(len - mc_timer_wheel_snapshot_size() < MC_MAX_ENTITIES * sizeof(uint32_t));
+    }
+    TEST_END();
+}
+
+static void test_save_continuation_identical(void) {
+    TEST_BEGIN("save_continuation_identical");
+    {
+        uint32_t len, t, ok = 1;
+        CommandBuffer ca, cb;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 200, 5);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+        world_init(&g_b, SAVE_PARTS);
+        mc_world_load(&g_b.refs, g_buf, len);
+
+        /* Timers fire the same commands on the same ticks; RNG agrees */
+        for (t = 0; t < 1000; t++) {
+            uint32_t i;
+            mc_cmd_buf_init(&ca);
+            mc_cmd_buf_init(&cb);
+            mc_timer_wheel_advance(&g_a.timers, t, &ca);
+            mc_timer_wheel_advance(&g_b.timers, t, &cb);
+            if (ca.count != cb.count) ok = 0;
+            for (i = 0; i < ca.count && i < cb.count; i++) {
+                if (ca.commands[i].target_entity != cb.commands[i].target_entity) ok = 0;
+            }
+            if (mc_rng_next(&g_a.rng) != mc_rng_next(&g_b.rng)) ok = 0;
+        }
+        ASSERT(ok);
+        ASSERT_EQ_U32(g_b.timers.count, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: VALIDATION
+ * ========================================================================= */
+
+static void test_load_rejects_bad_files(void) {
+    TEST_BEGIN("load_rejects_bad_files");
+    {
+        uint32_t len;
+        SaveHeader* hdr = (SaveHeader*)g_buf;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 100, 1);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+        world_init(&g_b, SAVE_PARTS);
+
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len - 8), -1);
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, 4), -1);
+        hdr->magic ^= 0xFF;
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+        hdr->magic ^= 0xFF;
+        hdr->version = 2;
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+        hdr->version = MC_SAVE_VERSION;
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), 0);
+    }
+    TEST_END();
+}
+
+static void test_load_rejects_schema_mismatch(void) {
+    TEST_BEGIN("load_rejects_schema_mismatch");
+    {
+        uint32_t len;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 100, 1);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+
+        /* Target registers a pool with a different component size */
+        world_init(&g_b, SAVE_PARTS);
+        world_populate(&g_b, 50, 2);
+        mc_sparse_set_init(&g_b.position, sizeof(CPosition) + 4);
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+        ASSERT_EQ_U32(g_b.alloc.next_id, 50);   /* untouched */
+
+        /* Target has an extra pool the file doesn't cover */
+        world_init(&g_b, SAVE_PARTS);
+        mc_world_refs_add_pool(&g_b.refs, &g_b.layers);
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+
+        /* Target expects timers, file has none */
+        world_init(&g_a, SAVE_PARTS);
+        g_a.refs.timers = NULL;
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+        world_init(&g_b, SAVE_PARTS);
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+    }
+    TEST_END();
+}
+
+static void test_load_rejects_bad_entity_ids(void) {
+    TEST_BEGIN("load_rejects_bad_entity_ids");
+    {
+        uint32_t len, off;
+        SaveChunkHeader ch;
+        EntityID* dense = NULL;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 20, 4);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+
+        /* Find the first POOL chunk's dense[] */
+        off = sizeof(SaveHeader);
+        while (off < len) {
+            memcpy(&ch, g_buf + off, sizeof(ch));
+            if (ch.tag == MC_SAVE_TAG_POOL) {
+                dense = (EntityID*)(g_buf + off + sizeof(ch) + sizeof(SavePoolHeader));
+                break;
+            }
+            off += sizeof(ch) + ((ch.size + 7u) & ~7u);
+        }
+        ASSERT_NOT_NULL(dense);
+        if (dense != NULL) {
+            EntityID keep0 = dense[0];
+            world_init(&g_b, SAVE_PARTS);
+            dense[0] = 20;              /* == next_id */
+            ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+            dense[0] = dense[1];        /* duplicate */
+            ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+            dense[0] = keep0;
+            ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), 0);
+        }
+    }
+    TEST_END();
+}
+
+static void test_load_rejects_bad_timers(void) {
+    TEST_BEGIN("load_rejects_bad_timers");
+    {
+        uint32_t len, off;
+        SaveChunkHeader ch;
+        uint8_t* snap = NULL;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 20, 4);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+
+        off = sizeof(SaveHeader);
+        while (off < len) {
+            memcpy(&ch, g_buf + off, sizeof(ch));
+            if (ch.tag == MC_SAVE_TAG_TIMERS) {
+                snap = g_buf + off + sizeof(ch);
+                break;
+            }
+            off += sizeof(ch) + ((ch.size + 7u) & ~7u);
+        }
+        ASSERT_NOT_NULL(snap);
+        if (snap != NULL) {
+            uint8_t* head0 = snap + MC_TIMER_SNAPSHOT_HEADER + offsetof(TimerWheel, heads);
+            uint32_t keep, bad = MC_MAX_TIMERS;
+            world_init(&g_b, SAVE_PARTS);
+            snap[0] ^= 0xFF;            /* inner magic */
+            ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+            ASSERT_EQ_U32(g_b.alloc.next_id, 0);     /* untouched */
+            snap[0] ^= 0xFF;
+            memcpy(&keep, head0, sizeof(keep));
+            memcpy(head0, &bad, sizeof(bad));        /* slot head past nodes[] */
+            ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), -1);
+            ASSERT_EQ_U32(g_b.alloc.next_id, 0);
+            memcpy(head0, &keep, sizeof(keep));
+            ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, len), 0);
+            ASSERT_EQ_U32(g_b.timers.count, g_a.timers.count);
+        }
+    }
+    TEST_END();
+}
+
+static void test_load_skips_unknown_chunks(void) {
+    TEST_BEGIN("load_skips_unknown_chunks");
+    {
+        uint32_t len;
+        SaveHeader hdr;
+        SaveChunkHeader ch;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 64, 8);
+        len = mc_world_save(&g_a.refs, g_buf, sizeof(g_buf));
+
+        /* Append a chunk a future build might write */
+        ch.tag = 0x4F4F4F46u;  /* "FOOO" */
+        ch.version = 7;
+        ch.reserved = 0;
+        ch.id = 0;
+        ch.size = 5;
+        memcpy(g_buf + len, &ch, sizeof(ch));
+        memset(g_buf + len + sizeof(ch), 0xAB, 8);
+        memcpy(&hdr, g_buf, sizeof(hdr));
+        hdr.chunk_count++;
+        hdr.total_size = len + (uint32_t)sizeof(ch) + 8;
+        memcpy(g_buf, &hdr, sizeof(hdr));
+
+        world_init(&g_b, SAVE_PARTS);
+        ASSERT_EQ_I32(mc_world_load(&g_b.refs, g_buf, hdr.total_size), 0);
+        ASSERT(worlds_equal(&g_a, &g_b));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: FILES / AUTOSAVE
+ * ========================================================================= */
+
+static void test_save_file_roundtrip(void) {
+    TEST_BEGIN("save_file_roundtrip");
+    {
+        const char* path = "test_save.tmp.msav";
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 400, 21);
+        ASSERT_EQ_I32(mc_world_save_file(&g_a.refs, path, g_buf, sizeof(g_buf)), 0);
+        world_init(&g_b, SAVE_PARTS);
+        ASSERT_EQ_I32(mc_world_load_file(&g_b.refs, path, g_buf2, sizeof(g_buf2)), 0);
+        ASSERT(worlds_equal(&g_a, &g_b));
+
+        /* Scratch smaller than the file is refused, not truncated */
+        world_init(&g_b, SAVE_PARTS);
+        ASSERT_EQ_I32(mc_world_load_file(&g_b.refs, path, g_buf2, 256), -1);
+        remove(path);
+        ASSERT_EQ_I32(mc_world_load_file(&g_b.refs, path, g_buf2, sizeof(g_buf2)), -1);
+    }
+    TEST_END();
+}
+
+static void test_autosave_background(void) {
+    TEST_BEGIN("autosave_background");
+    {
+        const char* path = "test_autosave.tmp.msav";
+        McAutosave as;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 300, 33);
+        mc_autosave_init(&as, g_buf, sizeof(g_buf));
+
+        ASSERT_EQ_I32(mc_autosave_begin(&as, &g_a.refs, path), 0);
+        ASSERT_EQ_I32(mc_autosave_begin(&as, &g_a.refs, path), -1);  /* in flight */
+
+        /* The world may keep ticking: the save is already serialized */
+        mc_sparse_set_remove(&g_a.health, 1);
+        ASSERT_EQ_I32(mc_autosave_finish(&as), 0);
+        ASSERT_EQ_U32(as.completed, 1);
+
+        world_init(&g_b, SAVE_PARTS);
+        ASSERT_EQ_I32(mc_world_load_file(&g_b.refs, path, g_buf2, sizeof(g_buf2)), 0);
+        ASSERT(mc_sparse_set_has(&g_b.health, 1));
+        ASSERT_EQ_U32(g_b.alloc.next_id, 300);
+        remove(path);
+    }
+    TEST_END();
+}
+
+static void test_autosave_poll(void) {
+    TEST_BEGIN("autosave_poll");
+    {
+        const char* path = "test_autosave_poll.tmp.msav";
+        McAutosave as;
+        uint32_t i;
+        world_init(&g_a, SAVE_PARTS);
+        world_populate(&g_a, 300, 34);
+        mc_autosave_init(&as, g_buf, sizeof(g_buf));
+        ASSERT_EQ_I32(mc_autosave_poll(&as), 1);             /* idle */
+
+        /* Two autosaves back to back, reaped only by polling -- never
+         * by a blocking finish -- as a tick loop would. */
+        for (i = 0; i < 2; i++) {
+            ASSERT_EQ_I32(mc_autosave_begin(&as, &g_a.refs, path), 0);
+            while (mc_autosave_poll(&as) == 0) {
+                /* the tick would keep running here */
+            }
+            ASSERT(!as.in_flight);
+            ASSERT_EQ_I32(as.result, 0);
+        }
+        ASSERT_EQ_U32(as.completed, 2);
+        ASSERT_EQ_I32(mc_autosave_poll(&as), 1);
+        ASSERT_EQ_I32(mc_autosave_finish(&as), 0);           /* nothing left to join */
+        ASSERT_EQ_U32(as.completed, 2);
+
+        world_init(&g_b, SAVE_PARTS);
+        ASSERT_EQ_I32(mc_world_load_file(&g_b.refs, path, g_buf2, sizeof(g_buf2)), 0);
+        ASSERT_EQ_U32(g_b.alloc.next_id, 300);
+        remove(path);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Save/Load Tests\n");
+    printf("============================\n\n");
+
+    printf("[Round Trip]\n");
+    test_save_size_exact();
+    test_save_roundtrip();
+    test_save_sparse_not_written();
+    test_save_continuation_identical();
+
+    printf("\n[Validation]\n");
+    test_load_rejects_bad_files();
+    test_load_rejects_schema_mismatch();
+    test_load_rejects_bad_entity_ids();
+    test_load_rejects_bad_timers();
+    test_load_skips_unknown_chunks();
+
+    printf("\n[Files / Autosave]\n");
+    test_save_file_roundtrip();
+    test_autosave_background();
+    test_autosave_poll();
+
+    printf("\n============================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
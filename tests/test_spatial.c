@@ -0,0 +1,328 @@
+/*
+ * test_spatial.c -- Uniform Grid Spatial Index Tests
+ *
+ * Tests incremental insert/remove/move, clamping of out-of-bounds
+ * positions, building from a position pool, and radius, rectangle and
+ * k-nearest queries against a brute-force scan on 100k random entities.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 -I../include test_spatial.c -o test_spatial.exe
+ */
+
+/* Server-sized index: 100k entities in a 256 x 256 grid */
+#define MC_GRID_MAX_ENTITIES 131072
+#define MC_GRID_MAX_CELLS    65536
+
+#include "marble_spatial.h"
+#include <stdio.h>
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+typedef struct { float x, y; } CPosition;
+
+#define BIG_N 100000
+
+static SpatialGrid g_grid;
+static float       g_px[BIG_N], g_py[BIG_N];
+static EntityID    g_out[BIG_N], g_ref[BIG_N];
+static uint8_t     g_seen[BIG_N];
+
+static uint32_t g_lcg = 12345;
+static float frand(float lo, float hi) {
+    g_lcg = g_lcg * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float)(g_lcg >> 8) / 16777216.0f;
+}
+
+/* Same set of ids, any order */
+static int same_set(const EntityID* a, uint32_t na, const EntityID* b, uint32_t nb) {
+    uint32_t i;
+    int ok = 1;
+    if (na != nb) return 0;
+    for (i = 0; i < na; i++) g_seen[a[i]]++;
+    for (i = 0; i < nb; i++) if (g_seen[b[i]]-- != 1) ok = 0;
+    for (i = 0; i < na; i++) g_seen[a[i]] = 0;
+    for (i = 0; i < nb; i++) g_seen[b[i]] = 0;
+    return ok;
+}
+
+/* 100k entities over [0, 1024)^2 with 4-unit cells, a few outside */
+static void fill_big(void) {
+    uint32_t i;
+    mc_grid_init(&g_grid, 0.0f, 0.0f, 4.0f, 256, 256);
+    for (i = 0; i < BIG_N; i++) {
+        g_px[i] = (i % 1000 == 0) ? frand(-50.0f, 1100.0f) : frand(0.0f, 1024.0f);
+        g_py[i] = frand(0.0f, 1024.0f);
+        mc_grid_insert(&g_grid, i, g_px[i], g_py[i]);
+    }
+}
+
+/* =========================================================================
+ * TESTS: MAINTENANCE
+ * ========================================================================= */
+
+static void test_init_limits(void) {
+    TEST_BEGIN("init rejects bad dimensions");
+    {
+        ASSERT_EQ_I32(mc_grid_init(&g_grid, 0, 0, 0.0f, 4, 4), -1);
+        ASSERT_EQ_I32(mc_grid_init(&g_grid, 0, 0, 1.0f, 0, 4), -1);
+        ASSERT_EQ_I32(mc_grid_init(&g_grid, 0, 0, 1.0f, 257, 256), -1);
+        ASSERT_EQ_I32(mc_grid_init(&g_grid, 0, 0, 1.0f, 256, 256), 0);
+        ASSERT_EQ_U32(g_grid.count, 0);
+    }
+    TEST_END();
+}
+
+static void test_insert_remove_move(void) {
+    TEST_BEGIN("insert, remove and move keep cells consistent");
+    {
+        EntityID out[8];
+        mc_grid_init(&g_grid, 0.0f, 0.0f, 10.0f, 10, 10);
+        ASSERT_EQ_I32(mc_grid_insert(&g_grid, 1, 5.0f, 5.0f), 0);
+        ASSERT_EQ_I32(mc_grid_insert(&g_grid, 2, 6.0f, 5.0f), 0);
+        ASSERT_EQ_I32(mc_grid_insert(&g_grid, 3, 55.0f, 55.0f), 0);
+        ASSERT_EQ_I32(mc_grid_insert(&g_grid, 2, 1.0f, 1.0f), -1);   /* duplicate */
+        ASSERT_EQ_I32(mc_grid_insert(&g_grid, MC_GRID_MAX_ENTITIES, 1.0f, 1.0f), -1);
+        ASSERT_EQ_U32(g_grid.count, 3);
+        ASSERT_EQ_U32(mc_grid_query_radius(&g_grid, 5.0f, 5.0f, 2.0f, out, 8), 2);
+
+        /* Middle of a cell list, then across cells */
+        ASSERT_EQ_I32(mc_grid_remove(&g_grid, 1), 0);
+        ASSERT_EQ_I32(mc_grid_remove(&g_grid, 1), -1);
+        ASSERT_EQ_U32(mc_grid_query_radius(&g_grid, 5.0f, 5.0f, 2.0f, out, 8), 1);
+        ASSERT_EQ_U32(out[0], 2);
+
+        ASSERT_EQ_I32(mc_grid_move(&g_grid, 2, 54.0f, 56.0f), 0);
+        ASSERT_EQ_U32(g_grid.cell_of[2], g_grid.cell_of[3]);
+        ASSERT_EQ_U32(mc_grid_query_radius(&g_grid, 5.0f, 5.0f, 2.0f, out, 8), 0);
+        ASSERT_EQ_U32(mc_grid_query_radius(&g_grid, 55.0f, 55.0f, 2.0f, out, 8), 2);
+        ASSERT_EQ_I32(mc_grid_move(&g_grid, 1, 0.0f, 0.0f), -1);     /* not indexed */
+
+        /* Out of bounds clamps to the edge cell but keeps its true position */
+        ASSERT_EQ_I32(mc_grid_move(&g_grid, 3, -500.0f, 9999.0f), 0);
+        ASSERT_EQ_U32(g_grid.cell_of[3], 9u * 10u + 0u);
+        ASSERT_EQ_U32(mc_grid_query_rect(&g_grid, -1000.0f, 9000.0f, 0.0f, 10000.0f, out, 8), 1);
+        ASSERT_EQ_U32(out[0], 3);
+        ASSERT_EQ_U32(mc_grid_query_rect(&g_grid, 0.0f, 90.0f, 10.0f, 100.0f, out, 8), 0);
+        ASSERT_EQ_U32(g_grid.count, 2);
+    }
+    TEST_END();
+}
+
+static void test_build_from_pool(void) {
+    TEST_BEGIN("build indexes every row of a position pool");
+    {
+        static SparseSet pool;
+        EntityID out[8];
+        CPosition p;
+        mc_sparse_set_init(&pool, sizeof(CPosition));
+        p.x = 12.0f; p.y = 3.0f;  mc_sparse_set_add(&pool, 7, &p);
+        p.x = 80.0f; p.y = 80.0f; mc_sparse_set_add(&pool, 9, &p);
+        p.x = 13.0f; p.y = 4.0f;  mc_sparse_set_add(&pool, 40, &p);
+
+        mc_grid_init(&g_grid, 0.0f, 0.0f, 10.0f, 10, 10);
+        mc_grid_insert(&g_grid, 500, 1.0f, 1.0f);           /* cleared by build */
+        ASSERT_EQ_U32(mc_grid_build(&g_grid, &pool), 3);
+        ASSERT_EQ_U32(g_grid.count, 3);
+        ASSERT_EQ_I32(mc_grid_has(&g_grid, 500), 0);
+        ASSERT_EQ_U32(mc_grid_query_radius(&g_grid, 12.5f, 3.5f, 1.0f, out, 8), 2);
+        ASSERT(same_set(out, 2, (const EntityID[]){7, 40}, 2));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * TESTS: QUERIES
+ * ========================================================================= */
+
+static void test_radius_matches_brute_force(void) {
+    TEST_BEGIN("radius query matches brute force (100k)");
+    {
+        uint32_t q, i, bad = 0, total = 0;
+        fill_big();
+        for (q = 0; q < 200; q++) {
+            float x = frand(-20.0f, 1044.0f), y = frand(-20.0f, 1044.0f);
+            float r = frand(0.0f, 40.0f);
+            uint32_t nr = 0, n;
+            for (i = 0; i < BIG_N; i++) {
+                float dx = g_px[i] - x, dy = g_py[i] - y;
+                if (dx * dx + dy * dy <= r * r) g_ref[nr++] = i;
+            }
+            n = mc_grid_query_radius(&g_grid, x, y, r, g_out, BIG_N);
+            if (!same_set(g_out, n, g_ref, nr)) bad++;
+            total += n;
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT(total > 0);
+    }
+    TEST_END();
+}
+
+static void test_rect_matches_brute_force(void) {
+    TEST_BEGIN("rect query matches brute force and honors cap");
+    {
+        uint32_t q, i, bad = 0;
+        EntityID small[4];
+        fill_big();
+        for (q = 0; q < 200; q++) {
+            float x0 = frand(-60.0f, 1024.0f), y0 = frand(-10.0f, 1024.0f);
+            float x1 = x0 + frand(0.0f, 60.0f), y1 = y0 + frand(0.0f, 60.0f);
+            uint32_t nr = 0, n;
+            for (i = 0; i < BIG_N; i++) {
+                if (g_px[i] >= x0 && g_px[i] <= x1 && g_py[i] >= y0 && g_py[i] <= y1) g_ref[nr++] = i;
+            }
+            n = mc_grid_query_rect(&g_grid, x0, y0, x1, y1, g_out, BIG_N);
+            if (!same_set(g_out, n, g_ref, nr)) bad++;
+        }
+        ASSERT_EQ_U32(bad, 0);
+
+        /* Count is the full match count even when the buffer is short */
+        ASSERT(mc_grid_query_rect(&g_grid, 0.0f, 0.0f, 100.0f, 100.0f, small, 4) > 4);
+        ASSERT_EQ_U32(mc_grid_query_rect(&g_grid, 5.0f, 5.0f, 4.0f, 4.0f, small, 4), 0);
+    }
+    TEST_END();
+}
+
+static void test_knn_matches_brute_force(void) {
+    TEST_BEGIN("k-nearest matches brute force (100k)");
+    {
+        EntityID out[16];
+        float    d2[16], ref_d2[16];
+        uint32_t q, i, j, bad = 0;
+        fill_big();
+        for (q = 0; q < 100; q++) {
+            float x = frand(-100.0f, 1124.0f), y = frand(-100.0f, 1124.0f);
+            uint32_t k = 1 + q % 16, nr = 0, n;
+            for (i = 0; i < BIG_N; i++) {
+                float dx = g_px[i] - x, dy = g_py[i] - y, dd = dx * dx + dy * dy;
+                if (nr < k) nr++;
+                else if (dd >= ref_d2[k - 1]) continue;
+                for (j = nr - 1; j > 0 && ref_d2[j - 1] > dd; j--) ref_d2[j] = ref_d2[j - 1];
+                ref_d2[j] = dd;
+            }
+            n = mc_grid_query_knn(&g_grid, x, y, k, out, d2);
+            if (n != k) { bad++; continue; }
+            for (j = 0; j < k; j++) {
+                float dx = g_px[out[j]] - x, dy = g_py[out[j]] - y;
+                if (d2[j] != ref_d2[j] || d2[j] != dx * dx + dy * dy) bad++;
+            }
+        }
+        ASSERT_EQ_U32(bad, 0);
+    }
+    TEST_END();
+}
+
+static void test_knn_sparse(void) {
+    TEST_BEGIN("k-nearest searches the whole grid when sparse");
+    {
+        EntityID out[8];
+        float    d2[8];
+        mc_grid_init(&g_grid, 0.0f, 0.0f, 1.0f, 100, 100);
+        ASSERT_EQ_U32(mc_grid_query_knn(&g_grid, 50.0f, 50.0f, 4, out, d2), 0);
+        mc_grid_insert(&g_grid, 1, 99.5f, 99.5f);
+        mc_grid_insert(&g_grid, 2, 0.5f, 0.5f);
+        mc_grid_insert(&g_grid, 3, 150.0f, -20.0f);         /* clamped corner */
+        ASSERT_EQ_U32(mc_grid_query_knn(&g_grid, 10.0f, 10.0f, 8, out, d2), 3);
+        ASSERT_EQ_U32(out[0], 2);
+        ASSERT_EQ_U32(out[1], 1);
+        ASSERT_EQ_U32(out[2], 3);
+        ASSERT_EQ_U32(mc_grid_query_knn(&g_grid, 140.0f, -10.0f, 1, out, d2), 1);
+        ASSERT_EQ_U32(out[0], 3);
+        ASSERT_EQ_U32(mc_grid_query_knn(&g_grid, 0.0f, 0.0f, 0, out, d2), 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Spatial Grid Tests\n");
+    printf("===============================\n\n");
+
+    printf("[Maintenance]\n");
+    test_init_limits();
+    test_insert_remove_move();
+    test_build_from_pool();
+
+    printf("\n[Queries]\n");
+    test_radius_matches_brute_force();
+    test_rect_matches_brute_force();
+    test_knn_matches_brute_force();
+    test_knn_sparse();
+
+    printf("\n===============================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
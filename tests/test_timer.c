@@ -0,0 +1,513 @@
+/*
+ * test_timer.c -- Hierarchical Timing Wheel Tests
+ *
+ * Tests scheduled commands: O(1) insert/cancel, per-tick drain,
+ * cascading across wheel levels, beyond-horizon timers, integration
+ * with the command buffer flush, and snapshot round-trips.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_timer.c -o test_timer.exe
+ */
+
+#include "marble_timer.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+/* =========================================================================
+ * HELPERS
+ * ========================================================================= */
+
+static TimerWheel    g_wheel;
+static TimerWheel    g_wheel_b;
+static CommandBuffer g_buf;
+static uint8_t       g_snap[sizeof(TimerWheel) + 64];
+
+static Command make_feedback(uint32_t message_id) {
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type       = CMD_PLAY_FEEDBACK;
+    cmd.message_id = message_id;
+    return cmd;
+}
+
+/* Advance one tick at a time until a buffer first receives a command.
+ * Returns the tick it fired on, or UINT64_MAX if nothing fired. */
+static uint64_t run_until_fire(TimerWheel* w, uint64_t limit) {
+    uint64_t t;
+    for (t = w->current_tick; t <= limit; t++) {
+        mc_cmd_buf_init(&g_buf);
+        if (mc_timer_wheel_advance(w, t, &g_buf) > 0) return t;
+    }
+    return UINT64_MAX;
+}
+
+/* =========================================================================
+ * SECTION 1: SCHEDULE / DRAIN
+ * ========================================================================= */
+
+static void test_timer_init_empty(void) {
+    TEST_BEGIN("timer: init produces empty wheel at start tick");
+    {
+        mc_timer_wheel_init(&g_wheel, 100);
+        ASSERT_EQ_U32(g_wheel.count, 0);
+        ASSERT_EQ_U32((uint32_t)g_wheel.current_tick, 100);
+        mc_cmd_buf_init(&g_buf);
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, 500, &g_buf), 0);
+        ASSERT_EQ_U32((uint32_t)g_wheel.current_tick, 501);
+    }
+    TEST_END();
+}
+
+static void test_timer_fires_on_due_tick(void) {
+    TEST_BEGIN("timer: command scheduled 30 ticks out fires exactly on tick 30");
+    {
+        Command cmd = make_feedback(7);
+        TimerHandle h;
+        mc_timer_wheel_init(&g_wheel, 0);
+        h = mc_timer_schedule_in(&g_wheel, &cmd, 30);
+        ASSERT(h != MC_TIMER_INVALID);
+        ASSERT_EQ_U32(g_wheel.count, 1);
+
+        mc_cmd_buf_init(&g_buf);
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, 29, &g_buf), 0);
+        ASSERT(mc_timer_pending(&g_wheel, h));
+
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, 30, &g_buf), 1);
+        ASSERT_EQ_U32(g_buf.count, 1);
+        ASSERT_EQ_U32(g_buf.commands[0].message_id, 7);
+        ASSERT_EQ_U32((uint32_t)g_buf.commands[0].tick, 30);
+        ASSERT(!mc_timer_pending(&g_wheel, h));
+        ASSERT_EQ_U32(g_wheel.count, 0);
+    }
+    TEST_END();
+}
+
+static void test_timer_past_due_fires_next_drain(void) {
+    TEST_BEGIN("timer: due tick in the past fires on the next drain");
+    {
+        Command cmd = make_feedback(1);
+        mc_timer_wheel_init(&g_wheel, 50);
+        mc_timer_schedule(&g_wheel, &cmd, 10);
+        mc_cmd_buf_init(&g_buf);
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, 50, &g_buf), 1);
+    }
+    TEST_END();
+}
+
+static void test_timer_same_tick_fifo(void) {
+    TEST_BEGIN("timer: same-tick timers drain in schedule order");
+    {
+        uint32_t i;
+        mc_timer_wheel_init(&g_wheel, 0);
+        for (i = 0; i < 5; i++) {
+            Command cmd = make_feedback(i);
+            mc_timer_schedule(&g_wheel, &cmd, 12);
+        }
+        mc_cmd_buf_init(&g_buf);
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, 12, &g_buf), 5);
+        for (i = 0; i < 5; i++) {
+            ASSERT_EQ_U32(g_buf.commands[i].message_id, i);
+        }
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 2: CASCADING ACROSS LEVELS
+ * ========================================================================= */
+
+static void test_timer_cascade_levels(void) {
+    TEST_BEGIN("timer: timers on every wheel level fire on their exact tick");
+    {
+        /* level 0, level 1 boundary, level 2, level 3 */
+        static const uint64_t delays[] = { 1, 63, 64, 65, 200, 4095, 4096, 5000,
+                                           300000, 262144 + 7 };
+        uint32_t i;
+        for (i = 0; i < sizeof(delays) / sizeof(delays[0]); i++) {
+            Command cmd = make_feedback(i);
+            uint64_t start = 13;  /* deliberately unaligned start */
+            mc_timer_wheel_init(&g_wheel, start);
+            mc_timer_schedule(&g_wheel, &cmd, start + delays[i]);
+            ASSERT_EQ_U32((uint32_t)run_until_fire(&g_wheel, start + delays[i] + 10),
+                          (uint32_t)(start + delays[i]));
+        }
+    }
+    TEST_END();
+}
+
+static void test_timer_beyond_horizon(void) {
+    TEST_BEGIN("timer: timer beyond the wheel span still fires on time");
+    {
+        Command cmd = make_feedback(99);
+        uint64_t due = MC_TIMER_WHEEL_SPAN + 12345;
+        mc_timer_wheel_init(&g_wheel, 0);
+        mc_timer_schedule(&g_wheel, &cmd, due);
+
+        mc_cmd_buf_init(&g_buf);
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, due - 1, &g_buf), 0);
+        ASSERT_EQ_U32(g_wheel.count, 1);
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, due, &g_buf), 1);
+        ASSERT_EQ_U32((uint32_t)g_buf.commands[0].tick, (uint32_t)due);
+    }
+    TEST_END();
+}
+
+static void test_timer_bulk_advance_matches_stepwise(void) {
+    TEST_BEGIN("timer: one bulk advance drains the same stream as single steps");
+    {
+        uint32_t i, total_a = 0, total_b = 0;
+        uint64_t t;
+        McRng rng;
+
+        mc_timer_wheel_init(&g_wheel, 0);
+        mc_timer_wheel_init(&g_wheel_b, 0);
+        mc_rng_seed(&rng, 1234);
+        for (i = 0; i < 200; i++) {
+            Command cmd = make_feedback(i);
+            uint64_t due = mc_rng_range(&rng, 9000);
+            mc_timer_schedule(&g_wheel, &cmd, due);
+            mc_timer_schedule(&g_wheel_b, &cmd, due);
+        }
+
+        for (t = 0; t < 9000; t++) {
+            mc_cmd_buf_init(&g_buf);
+            total_a += mc_timer_wheel_advance(&g_wheel, t, &g_buf);
+        }
+        ASSERT_EQ_U32(total_a, 200);
+        ASSERT_EQ_U32(g_wheel.count, 0);
+
+        /* Bulk drain in chunks smaller than MAX_COMMANDS */
+        for (t = 999; t < 9000; t += 1000) {
+            mc_cmd_buf_init(&g_buf);
+            total_b += mc_timer_wheel_advance(&g_wheel_b, t, &g_buf);
+        }
+        ASSERT_EQ_U32(total_b, 200);
+        ASSERT_EQ_U32(g_wheel_b.count, 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 3: CANCEL
+ * ========================================================================= */
+
+static void test_timer_cancel(void) {
+    TEST_BEGIN("timer: cancelled timer never fires");
+    {
+        Command cmd = make_feedback(5);
+        TimerHandle h;
+        mc_timer_wheel_init(&g_wheel, 0);
+        h = mc_timer_schedule(&g_wheel, &cmd, 500);
+        ASSERT_EQ_I32(mc_timer_cancel(&g_wheel, h), 0);
+        ASSERT_EQ_U32(g_wheel.count, 0);
+        ASSERT_EQ_U32((uint32_t)run_until_fire(&g_wheel, 600), (uint32_t)UINT64_MAX);
+    }
+    TEST_END();
+}
+
+static void test_timer_cancel_stale_handle(void) {
+    TEST_BEGIN("timer: stale handle cannot cancel a recycled node");
+    {
+        Command cmd = make_feedback(5);
+        TimerHandle h1, h2;
+        mc_timer_wheel_init(&g_wheel, 0);
+        h1 = mc_timer_schedule(&g_wheel, &cmd, 3);
+        ASSERT_EQ_I32(mc_timer_cancel(&g_wheel, h1), 0);
+
+        /* Node is reused with a new generation */
+        h2 = mc_timer_schedule(&g_wheel, &cmd, 3);
+        ASSERT_EQ_U32(h2 & 0xFFFFu, h1 & 0xFFFFu);
+        ASSERT(h1 != h2);
+        ASSERT_EQ_I32(mc_timer_cancel(&g_wheel, h1), -1);
+        ASSERT(mc_timer_pending(&g_wheel, h2));
+        ASSERT_EQ_I32(mc_timer_cancel(&g_wheel, MC_TIMER_INVALID), -1);
+    }
+    TEST_END();
+}
+
+static void test_timer_cancel_middle_of_slot(void) {
+    TEST_BEGIN("timer: cancelling the middle of a slot list keeps neighbours");
+    {
+        Command a = make_feedback(1), b = make_feedback(2), c = make_feedback(3);
+        TimerHandle hb;
+        mc_timer_wheel_init(&g_wheel, 0);
+        mc_timer_schedule(&g_wheel, &a, 8);
+        hb = mc_timer_schedule(&g_wheel, &b, 8);
+        mc_timer_schedule(&g_wheel, &c, 8);
+        ASSERT_EQ_I32(mc_timer_cancel(&g_wheel, hb), 0);
+
+        mc_cmd_buf_init(&g_buf);
+        ASSERT_EQ_U32(mc_timer_wheel_advance(&g_wheel, 8, &g_buf), 2);
+        ASSERT_EQ_U32(g_buf.commands[0].message_id, 1);
+        ASSERT_EQ_U32(g_buf.commands[1].message_id, 3);
+    }
+    TEST_END();
+}
+
+static void test_timer_pool_exhaustion(void) {
+    TEST_BEGIN("timer: pool exhaustion returns INVALID and counts dropped");
+    {
+        Command cmd = make_feedback(0);
+        uint32_t i;
+        mc_timer_wheel_init(&g_wheel, 0);
+        for (i = 0; i < MC_MAX_TIMERS; i++) {
+            ASSERT(mc_timer_schedule(&g_wheel, &cmd, 1000 + i) != MC_TIMER_INVALID);
+        }
+        ASSERT_EQ_U32(mc_timer_schedule(&g_wheel, &cmd, 5), MC_TIMER_INVALID);
+        ASSERT_EQ_U32(g_wheel.dropped, 1);
+        ASSERT_EQ_U32(g_wheel.count, MC_MAX_TIMERS);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 4: COMMAND BUFFER INTEGRATION
+ * ========================================================================= */
+
+static SparseSet g_tt_layers;
+
+static void test_timer_delayed_damage_via_flush(void) {
+    TEST_BEGIN("timer: delayed DAMAGE_LAYER is applied by the flush on its tick");
+    {
+        PoolPtrs pools;
+        CLayerStack ls;
+        Command cmd;
+        uint64_t tick;
+        const CLayerStack* fetched;
+
+        mc_sparse_set_init(&g_tt_layers, sizeof(CLayerStack));
+        memset(&ls, 0, sizeof(ls));
+        ls.layer_count = 1;
+        ls.layers[0].material = MAT_WOOD; ls.layers[0].integrity = 5; ls.layers[0].max_integrity = 5;
+        mc_sparse_set_add(&g_tt_layers, 3, &ls);
+
+        memset(&pools, 0, sizeof(pools));
+        pools.layers = &g_tt_layers;
+
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.type          = CMD_DAMAGE_LAYER;
+        cmd.target_entity = 3;
+        cmd.damage_amount = 2;
+
+        mc_timer_wheel_init(&g_wheel, 0);
+        mc_cmd_buf_init(&g_buf);
+        mc_timer_schedule(&g_wheel, &cmd, 4);
+
+        for (tick = 0; tick < 4; tick++) {
+            mc_cmd_flush_timed(&g_buf, &pools, &g_wheel, tick);
+        }
+        fetched = (const CLayerStack*)mc_sparse_set_get_const(&g_tt_layers, 3);
+        ASSERT_EQ_I32(fetched->layers[0].integrity, 5);  /* not yet */
+
+        mc_cmd_flush_timed(&g_buf, &pools, &g_wheel, 4);
+        fetched = (const CLayerStack*)mc_sparse_set_get_const(&g_tt_layers, 3);
+        ASSERT_EQ_I32(fetched->layers[0].integrity, 3);
+        ASSERT_EQ_U32(g_buf.applied, 1);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 5: SNAPSHOT / DETERMINISM
+ * ========================================================================= */
+
+static void test_timer_snapshot_roundtrip(void) {
+    TEST_BEGIN("timer: snapshot + restore drains an identical command stream");
+    {
+        uint32_t i, written;
+        uint64_t t;
+        int same = 1;
+        CommandBuffer buf_b;
+        McRng rng;
+
+        mc_timer_wheel_init(&g_wheel, 0);
+        mc_rng_seed(&rng, 77);
+        for (i = 0; i < 100; i++) {
+            Command cmd = make_feedback(i);
+            mc_timer_schedule(&g_wheel, &cmd, mc_rng_range(&rng, 5000));
+        }
+        /* Run part-way so the snapshot captures mid-cascade state */
+        for (t = 0; t < 1500; t++) {
+            mc_cmd_buf_init(&g_buf);
+            mc_timer_wheel_advance(&g_wheel, t, &g_buf);
+        }
+
+        written = mc_timer_wheel_snapshot(&g_wheel, g_snap, sizeof(g_snap));
+        ASSERT_EQ_U32(written, mc_timer_wheel_snapshot_size());
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, written), 0);
+
+        for (t = 1500; t < 5000; t++) {
+            uint32_t k;
+            mc_cmd_buf_init(&g_buf);
+            mc_cmd_buf_init(&buf_b);
+            mc_timer_wheel_advance(&g_wheel, t, &g_buf);
+            mc_timer_wheel_advance(&g_wheel_b, t, &buf_b);
+            if (g_buf.count != buf_b.count) same = 0;
+            for (k = 0; k < g_buf.count && k < buf_b.count; k++) {
+                if (g_buf.commands[k].message_id != buf_b.commands[k].message_id) same = 0;
+            }
+        }
+        ASSERT(same);
+        ASSERT_EQ_U32(g_wheel_b.count, 0);
+    }
+    TEST_END();
+}
+
+static void test_timer_restore_rejects_bad_snapshot(void) {
+    TEST_BEGIN("timer: restore rejects truncated or foreign data");
+    {
+        mc_timer_wheel_init(&g_wheel, 0);
+        ASSERT_EQ_U32(mc_timer_wheel_snapshot(&g_wheel, g_snap, 8), 0);
+        mc_timer_wheel_snapshot(&g_wheel, g_snap, sizeof(g_snap));
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, 8), -1);
+        g_snap[0] ^= 0xFF;
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, sizeof(g_snap)), -1);
+    }
+    TEST_END();
+}
+
+static void test_timer_restore_rejects_bad_links(void) {
+    TEST_BEGIN("timer: restore rejects out-of-range links");
+    {
+        uint8_t* body = g_snap + MC_TIMER_SNAPSHOT_HEADER;
+        Command cmd;
+        TimerNode node;
+        uint32_t v;
+        memset(&cmd, 0, sizeof(cmd));
+        mc_timer_wheel_init(&g_wheel, 0);
+        mc_timer_schedule(&g_wheel, &cmd, 3);
+        mc_timer_schedule(&g_wheel, &cmd, 3);
+        mc_timer_wheel_snapshot(&g_wheel, g_snap, sizeof(g_snap));
+        mc_timer_wheel_init(&g_wheel_b, 77);
+
+        v = MC_MAX_TIMERS;
+        memcpy(body + offsetof(TimerWheel, free_head), &v, sizeof(v));
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, sizeof(g_snap)), -1);
+        memcpy(body + offsetof(TimerWheel, free_head), &g_wheel.free_head, sizeof(v));
+
+        v = 0x7FFFFFFFu;
+        memcpy(body + offsetof(TimerWheel, tails) + 3 * sizeof(uint32_t), &v, sizeof(v));
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, sizeof(g_snap)), -1);
+        memcpy(body + offsetof(TimerWheel, tails) + 3 * sizeof(uint32_t), &g_wheel.tails[3], sizeof(v));
+
+        node = g_wheel.nodes[0];
+        node.next = MC_MAX_TIMERS + 1;
+        memcpy(body + offsetof(TimerWheel, nodes), &node, sizeof(node));
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, sizeof(g_snap)), -1);
+        node = g_wheel.nodes[0];
+        node.slot = MC_TIMER_WHEEL_LEVELS * MC_TIMER_WHEEL_SLOTS;
+        memcpy(body + offsetof(TimerWheel, nodes), &node, sizeof(node));
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, sizeof(g_snap)), -1);
+        ASSERT(g_wheel_b.current_tick == 77);      /* untouched */
+
+        node = g_wheel.nodes[0];
+        memcpy(body + offsetof(TimerWheel, nodes), &node, sizeof(node));
+        ASSERT_EQ_I32(mc_timer_wheel_restore(&g_wheel_b, g_snap, sizeof(g_snap)), 0);
+        ASSERT_EQ_U32(g_wheel_b.count, 2);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * RUN ALL TESTS
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Timing Wheel Tests\n");
+    printf("===============================\n\n");
+
+    printf("[Schedule / Drain]\n");
+    test_timer_init_empty();
+    test_timer_fires_on_due_tick();
+    test_timer_past_due_fires_next_drain();
+    test_timer_same_tick_fifo();
+
+    printf("\n[Cascading]\n");
+    test_timer_cascade_levels();
+    test_timer_beyond_horizon();
+    test_timer_bulk_advance_matches_stepwise();
+
+    printf("\n[Cancel]\n");
+    test_timer_cancel();
+    test_timer_cancel_stale_handle();
+    test_timer_cancel_middle_of_slot();
+    test_timer_pool_exhaustion();
+
+    printf("\n[Command Buffer Integration]\n");
+    test_timer_delayed_damage_via_flush();
+
+    printf("\n[Snapshot]\n");
+    test_timer_snapshot_roundtrip();
+    test_timer_restore_rejects_bad_snapshot();
+    test_timer_restore_rejects_bad_links();
+
+    printf("\n===============================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,435 @@
+/*
+ * test_world.c -- Multi-World Runtime Tests
+ *
+ * Tests that a World owns all of its state (loaders fill it through its
+ * embedded WorldContext, stepping one world never touches another),
+ * that stepping is deterministic, that timers fire through the world's
+ * step, that mc_world_refs() round-trips through save/load, and that
+ * the runtime's threaded passes match stepping each world sequentially.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 test_world.c -o test_world.exe -lpthread
+ */
+
+#include "marble_world.h"
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * TEST FIXTURES
+ * ========================================================================= */
+
+typedef struct {
+    int32_t hp;
+    int32_t max_hp;
+} CHealth;
+
+typedef struct {
+    float x;
+    float y;
+} CPosition;
+
+typedef struct {
+    uint32_t state;
+    uint32_t timer;
+} CBehaviorStub;
+
+static const uint32_t k_strides[LOADER_POOL_COUNT] = {
+    sizeof(CHealth), sizeof(CPosition), sizeof(CLayerStack), sizeof(CSkills),
+    sizeof(CAnatomy), sizeof(CCapabilities), sizeof(CAffordances), sizeof(CTool),
+    sizeof(CBodyParts), sizeof(CBehaviorStub)
+};
+
+#define N_WORLDS 8
+
+static World        g_a;
+static World        g_b;
+static World        g_par[N_WORLDS];
+static World        g_seq[N_WORLDS];
+static WorldRuntime g_rt;
+static uint8_t      g_save_buf[2u * 1024u * 1024u];
+
+/* Lumberjack (eid 0) with a right hand (eid 1) and a tree (eid 2) whose
+ * bark thickness varies with 'bark' so worlds can differ. */
+static void setup_lumber_world(World* w, uint32_t id, uint32_t seed, int32_t bark) {
+    EntityID jack, hand, tree;
+    CLayerStack ls;
+    CHealth h;
+    CAnatomy anat;
+    CSkills skills;
+    CCapabilities caps;
+    CTool tool;
+    CBodyParts bp;
+    CAffordances affs;
+    uint32_t i;
+
+    mc_world_init(w, id, seed, k_strides);
+
+    jack = mc_entity_create(&w->alloc);
+    hand = mc_entity_create(&w->alloc);
+    tree = mc_entity_create(&w->alloc);
+
+    memset(&ls, 0, sizeof(ls));
+    ls.layer_count = 2;
+    ls.layers[0].material = MAT_FLESH; ls.layers[0].integrity = 5;  ls.layers[0].max_integrity = 5;
+    ls.layers[1].material = MAT_BONE;  ls.layers[1].integrity = 5;  ls.layers[1].max_integrity = 5;
+    mc_sparse_set_add(w->ctx.pool_layers, hand, &ls);
+
+    h.hp = 100; h.max_hp = 100;
+    anat.flags = ANAT_ARMS | ANAT_HANDS | ANAT_LEGS;
+    memset(&skills, 0, sizeof(skills));
+    skills.level[SKILL_WOODCUTTING] = 60;
+    caps.flags = (1u << CAP_CHOP);
+    tool.material = MAT_IRON;
+    for (i = 0; i < MAX_BODY_PARTS; i++) bp.part_entity[i] = MC_INVALID_INDEX;
+    bp.part_entity[BODYPART_RIGHT_HAND] = hand;
+
+    mc_sparse_set_add(w->ctx.pool_health,       jack, &h);
+    mc_sparse_set_add(w->ctx.pool_anatomy,      jack, &anat);
+    mc_sparse_set_add(w->ctx.pool_skills,       jack, &skills);
+    mc_sparse_set_add(w->ctx.pool_capabilities, jack, &caps);
+    mc_sparse_set_add(w->ctx.pool_tool,         jack, &tool);
+    mc_sparse_set_add(w->ctx.pool_body_parts,   jack, &bp);
+
+    memset(&ls, 0, sizeof(ls));
+    ls.layer_count = 2;
+    ls.layers[0].material = MAT_BARK; ls.layers[0].integrity = bark; ls.layers[0].max_integrity = bark;
+    ls.layers[1].material = MAT_WOOD; ls.layers[1].integrity = 50;   ls.layers[1].max_integrity = 50;
+    affs.flags = (1u << AFF_CHOPPABLE);
+    mc_sparse_set_add(w->ctx.pool_layers,      tree, &ls);
+    mc_sparse_set_add(w->ctx.pool_affordances, tree, &affs);
+}
+
+static const CLayerStack* tree_layers(World* w) {
+    return (const CLayerStack*)mc_sparse_set_get_const(mc_world_pool(w, COMP_TYPE_LAYERS), 2);
+}
+
+static int pools_equal(const SparseSet* a, const SparseSet* b) {
+    if (a->count != b->count || a->stride != b->stride) return 0;
+    if (memcmp(a->dense, b->dense, a->count * sizeof(EntityID)) != 0) return 0;
+    return memcmp(a->data, b->data, (size_t)a->count * a->stride) == 0;
+}
+
+static int worlds_equal(const World* a, const World* b) {
+    uint32_t t;
+    if (a->alloc.next_id != b->alloc.next_id) return 0;
+    if (a->tick.tick_number != b->tick.tick_number) return 0;
+    for (t = 0; t < LOADER_POOL_COUNT; t++) {
+        if (!pools_equal(&a->pools[t], &b->pools[t])) return 0;
+    }
+    return 1;
+}
+
+/* =========================================================================
+ * WORLD TESTS
+ * ========================================================================= */
+
+static void test_world_init_wires_context(void) {
+    TEST_BEGIN("world_init_wires_context");
+    {
+        static const CHealth hp = { 40, 50 };
+        static const ManifestEntry entries[] = {
+            { 0, COMP_TYPE_HEALTH, &hp },
+            { 3, COMP_TYPE_HEALTH, &hp }
+        };
+        const CHealth* got;
+
+        mc_world_init(&g_a, 7, 1234u, k_strides);
+        ASSERT_EQ_U32(g_a.id, 7);
+        ASSERT(g_a.ctx.alloc == &g_a.alloc);
+        ASSERT(g_a.ctx.pool_layers == mc_world_pool(&g_a, COMP_TYPE_LAYERS));
+        ASSERT(g_a.ctx.pool_behavior == &g_a.pools[COMP_TYPE_BEHAVIOR]);
+        ASSERT_EQ_U32(g_a.pools[COMP_TYPE_HEALTH].stride, sizeof(CHealth));
+
+        /* The loaders populate a World through its embedded context */
+        Loader_LoadWorld(&g_a.ctx, entries, 2);
+        ASSERT_EQ_U32(g_a.alloc.next_id, 4);
+        got = (const CHealth*)mc_sparse_set_get_const(g_a.ctx.pool_health, 3);
+        ASSERT_NOT_NULL(got);
+        if (got) ASSERT_EQ_I32(got->hp, 40);
+    }
+    TEST_END();
+}
+
+static void test_worlds_are_isolated(void) {
+    TEST_BEGIN("worlds_are_isolated");
+    {
+        Command cmd;
+        uint32_t t;
+
+        setup_lumber_world(&g_a, 0, 42u, 30);
+        setup_lumber_world(&g_b, 1, 42u, 30);
+
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.type          = CMD_DAMAGE_LAYER;
+        cmd.target_entity = 2;
+        cmd.damage_amount = 4;
+        mc_cmd_push(&g_a.commands, &cmd);
+
+        for (t = 0; t < 3; t++) {
+            mc_world_push_request(&g_a, 0, 2, VERB_CHOP);
+            mc_world_step(&g_a);
+        }
+
+        ASSERT_EQ_U32((uint32_t)g_a.tick.tick_number, 3);
+        ASSERT_EQ_U32((uint32_t)g_b.tick.tick_number, 0);
+        ASSERT(tree_layers(&g_a)->layers[0].integrity < 30);
+        ASSERT_EQ_I32(tree_layers(&g_b)->layers[0].integrity, 30);
+        ASSERT_EQ_U32(g_b.interaction_count, 0);
+        ASSERT_EQ_U32(g_a.interaction_count, 1);
+    }
+    TEST_END();
+}
+
+static void test_world_step_deterministic(void) {
+    TEST_BEGIN("world_step_deterministic");
+    {
+        uint32_t t;
+        setup_lumber_world(&g_a, 0, 99u, 30);
+        setup_lumber_world(&g_b, 5, 99u, 30);   /* id does not feed the sim */
+
+        for (t = 0; t < 12; t++) {
+            mc_world_push_request(&g_a, 0, 2, VERB_CHOP);
+            mc_world_push_request(&g_b, 0, 2, VERB_CHOP);
+            mc_world_step(&g_a);
+            mc_world_step(&g_b);
+            ASSERT_EQ_U32(g_a.interactions[0].rng_state, g_b.interactions[0].rng_state);
+            ASSERT_EQ_I32(g_a.interactions[0].result, g_b.interactions[0].result);
+        }
+        ASSERT(worlds_equal(&g_a, &g_b));
+    }
+    TEST_END();
+}
+
+static void test_world_request_queue_full(void) {
+    TEST_BEGIN("world_request_queue_full");
+    {
+        uint32_t i;
+        mc_world_init(&g_a, 0, 1u, k_strides);
+        for (i = 0; i < MAX_INTERACTION_REQUESTS; i++) {
+            ASSERT_EQ_I32(mc_world_push_request(&g_a, 0, 1, VERB_CHOP), 0);
+        }
+        ASSERT_EQ_I32(mc_world_push_request(&g_a, 0, 1, VERB_CHOP), -1);
+        ASSERT_EQ_U32(g_a.request_count, MAX_INTERACTION_REQUESTS);
+        ASSERT_EQ_U32(g_a.requests_dropped, 1);
+    }
+    TEST_END();
+}
+
+static void test_world_step_fires_timers(void) {
+    TEST_BEGIN("world_step_fires_timers");
+    {
+        Command cmd;
+        uint32_t t;
+
+        setup_lumber_world(&g_a, 0, 42u, 30);
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.type          = CMD_DAMAGE_LAYER;
+        cmd.target_entity = 2;
+        cmd.damage_amount = 5;
+        ASSERT(mc_timer_schedule(&g_a.timers, &cmd, 4) != MC_TIMER_INVALID);
+
+        for (t = 0; t < 4; t++) mc_world_step(&g_a);
+        ASSERT_EQ_I32(tree_layers(&g_a)->layers[0].integrity, 30);
+
+        mc_world_step(&g_a);   /* tick 4 */
+        ASSERT_EQ_I32(tree_layers(&g_a)->layers[0].integrity, 25);
+        ASSERT_EQ_U32(g_a.timers.count, 0);
+    }
+    TEST_END();
+}
+
+static void test_world_save_roundtrip(void) {
+    TEST_BEGIN("world_save_roundtrip");
+    {
+        WorldRefs ra, rb;
+        uint32_t len, t;
+
+        setup_lumber_world(&g_a, 0, 42u, 30);
+        for (t = 0; t < 5; t++) {
+            mc_world_push_request(&g_a, 0, 2, VERB_CHOP);
+            mc_world_step(&g_a);
+        }
+
+        mc_world_refs(&g_a, &ra);
+        ASSERT_EQ_U32(ra.pool_count, LOADER_POOL_COUNT);
+        len = mc_world_save(&ra, g_save_buf, sizeof(g_save_buf));
+        ASSERT(len > 0);
+
+        mc_world_init(&g_b, 1, 42u, k_strides);
+        mc_world_refs(&g_b, &rb);
+        ASSERT_EQ_I32(mc_world_load(&rb, g_save_buf, len), 0);
+        ASSERT(worlds_equal(&g_a, &g_b));
+
+        /* The loaded world continues exactly as the saved one */
+        for (t = 0; t < 5; t++) {
+            mc_world_push_request(&g_a, 0, 2, VERB_CHOP);
+            mc_world_push_request(&g_b, 0, 2, VERB_CHOP);
+            mc_world_step(&g_a);
+            mc_world_step(&g_b);
+        }
+        ASSERT(worlds_equal(&g_a, &g_b));
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * RUNTIME TESTS
+ * ========================================================================= */
+
+static void test_runtime_assignment(void) {
+    TEST_BEGIN("runtime_assignment");
+    {
+        uint32_t i;
+
+        mc_runtime_init(&g_rt, g_par, N_WORLDS, 3);
+        ASSERT_EQ_U32(g_rt.worker_count, 3);
+        for (i = 0; i < N_WORLDS; i++) {
+            ASSERT_EQ_U32(mc_runtime_worker_of(&g_rt, i), i % 3);
+        }
+
+        /* Clamped to the world count and to MC_THREAD_MAX_WORKERS */
+        mc_runtime_init(&g_rt, g_par, 2, 8);
+        ASSERT_EQ_U32(g_rt.worker_count, 2);
+        mc_runtime_init(&g_rt, g_par, N_WORLDS, 1000);
+        ASSERT(g_rt.worker_count <= MC_THREAD_MAX_WORKERS);
+        mc_runtime_init(&g_rt, g_par, N_WORLDS, 0);
+        ASSERT(g_rt.worker_count >= 1);
+    }
+    TEST_END();
+}
+
+static void test_runtime_matches_sequential(void) {
+    TEST_BEGIN("runtime_matches_sequential");
+    {
+        uint32_t i, t, k;
+        uint64_t steps = 0;
+        int all_equal = 1;
+        int any_differ = 0;
+
+        for (i = 0; i < N_WORLDS; i++) {
+            setup_lumber_world(&g_par[i], i, 1000u + i, 6 + (int32_t)i);
+            setup_lumber_world(&g_seq[i], i, 1000u + i, 6 + (int32_t)i);
+        }
+
+        mc_runtime_init(&g_rt, g_par, N_WORLDS, 4);
+        for (t = 0; t < 6; t++) {
+            for (i = 0; i < N_WORLDS; i++) {
+                mc_world_push_request(&g_par[i], 0, 2, VERB_CHOP);
+                mc_world_push_request(&g_seq[i], 0, 2, VERB_CHOP);
+            }
+            mc_runtime_run(&g_rt, 1);
+            for (i = 0; i < N_WORLDS; i++) mc_world_step(&g_seq[i]);
+        }
+        /* A multi-tick pass with empty queues */
+        mc_runtime_run(&g_rt, 4);
+        for (t = 0; t < 4; t++) {
+            for (i = 0; i < N_WORLDS; i++) mc_world_step(&g_seq[i]);
+        }
+
+        for (i = 0; i < N_WORLDS; i++) {
+            if (!worlds_equal(&g_par[i], &g_seq[i])) all_equal = 0;
+            if (i > 0 && tree_layers(&g_par[i])->layers[0].integrity
+                      != tree_layers(&g_par[0])->layers[0].integrity) any_differ = 1;
+        }
+        for (k = 0; k < g_rt.worker_count; k++) steps += g_rt.workers[k].steps;
+
+        ASSERT(all_equal);
+        ASSERT(any_differ);
+        ASSERT_EQ_U32((uint32_t)g_par[0].tick.tick_number, 10);
+        ASSERT_EQ_U32((uint32_t)steps, N_WORLDS * 10);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * MAIN
+ * ========================================================================= */
+
+int main(void) {
+    printf("MarbleEngine Multi-World Runtime Tests\n");
+    printf("======================================\n\n");
+
+    printf("[World]\n");
+    test_world_init_wires_context();
+    test_worlds_are_isolated();
+    test_world_step_deterministic();
+    test_world_request_queue_full();
+    test_world_step_fires_timers();
+    test_world_save_roundtrip();
+
+    printf("\n[Runtime]\n");
+    test_runtime_assignment();
+    test_runtime_matches_sequential();
+
+    printf("\n======================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * test_ws.c -- Minimal WebSocket Layer Tests
+ *
+ * Tests SHA-1 and base64 against published vectors, the RFC 6455
+ * handshake example in both directions, and frame round-trips at every
+ * length encoding, masked and unmasked, plus the protocol errors the
+ * parser must refuse.
+ *
+ * BUILD:
+ *   gcc -std=c99 -Wall -Wextra -O2 -I../include test_ws.c -o test_ws.exe
+ */
+
+#include "marble_ws.h"
+#include <stdio.h>
+
+/* =========================================================================
+ * TEST FRAMEWORK (same as test.c)
+ * ========================================================================= */
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_BEGIN(name) \
+    do { \
+        const char* _test_name = (name); \
+        int _test_ok = 1; \
+        g_tests_run++;
+
+#define ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            printf("  FAIL: %s (line %d): %s\n", _test_name, __LINE__, #expr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_I32(a, b) \
+    do { \
+        int32_t _a = (a); int32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %d, expected %d\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ_U32(a, b) \
+    do { \
+        uint32_t _a = (a); uint32_t _b = (b); \
+        if (_a != _b) { \
+            printf("  FAIL: %s (line %d): %s == %u, expected %u\n", \
+                   _test_name, __LINE__, #a, _a, _b); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) { \
+            printf("  FAIL: %s (line %d): %s should not be NULL\n", \
+                   _test_name, __LINE__, #ptr); \
+            _test_ok = 0; \
+        } \
+    } while(0)
+
+#define TEST_END() \
+        if (_test_ok) { \
+            printf("  PASS: %s\n", _test_name); \
+            g_tests_passed++; \
+        } else { \
+            g_tests_failed++; \
+        } \
+    } while(0)
+
+
+/* =========================================================================
+ * SECTION 1: DIGESTS
+ * ========================================================================= */
+
+static void hex(const uint8_t* d, uint32_t n, char* out) {
+    static const char h[] = "0123456789abcdef";
+    uint32_t i;
+    for (i = 0; i < n; i++) {
+        out[i * 2] = h[d[i] >> 4];
+        out[i * 2 + 1] = h[d[i] & 15];
+    }
+    out[n * 2] = '\0';
+}
+
+static void test_sha1_vectors(void) {
+    TEST_BEGIN("sha1: FIPS 180 vectors, including a two-block tail");
+    {
+        static uint8_t million[1000000];
+        uint8_t d[20];
+        char s[41];
+        const char* two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+        mc_ws_sha1((const uint8_t*)"abc", 3, d);
+        hex(d, 20, s);
+        ASSERT(strcmp(s, "a9993e364706816aba3e25717850c26c9cd0d89d") == 0);
+        mc_ws_sha1((const uint8_t*)"", 0, d);
+        hex(d, 20, s);
+        ASSERT(strcmp(s, "da39a3ee5e6b4b0d3255bfef95601890afd80709") == 0);
+        mc_ws_sha1((const uint8_t*)two, (uint32_t)strlen(two), d);
+        hex(d, 20, s);
+        ASSERT(strcmp(s, "84983e441c3bd26ebaae4aa1f95129e5e54670f1") == 0);
+        memset(million, 'a', sizeof(million));
+        mc_ws_sha1(million, sizeof(million), d);
+        hex(d, 20, s);
+        ASSERT(strcmp(s, "34aa973cd4c4daa4f61eeb2bdbad27316534016f") == 0);
+    }
+    TEST_END();
+}
+
+static void test_base64(void) {
+    TEST_BEGIN("base64: RFC 4648 vectors with padding");
+    {
+        char s[16];
+        ASSERT_EQ_U32(mc_ws_base64((const uint8_t*)"", 0, s), 0);
+        mc_ws_base64((const uint8_t*)"f", 1, s);      ASSERT(strcmp(s, "Zg==") == 0);
+        mc_ws_base64((const uint8_t*)"fo", 2, s);     ASSERT(strcmp(s, "Zm8=") == 0);
+        mc_ws_base64((const uint8_t*)"foo", 3, s);    ASSERT(strcmp(s, "Zm9v") == 0);
+        mc_ws_base64((const uint8_t*)"foobar", 6, s); ASSERT(strcmp(s, "Zm9vYmFy") == 0);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 2: HANDSHAKE
+ * ========================================================================= */
+
+static const char* RFC_KEY = "dGhlIHNhbXBsZSBub25jZQ==";
+
+static void test_handshake_rfc_example(void) {
+    TEST_BEGIN("handshake: RFC 6455 example key, request and reply");
+    {
+        static const char req[] =
+            "GET /chat HTTP/1.1\r\n"
+            "Host: server.example.com\r\n"
+            "upgrade: WebSocket\r\n"
+            "Connection: keep-alive, Upgrade\r\n"
+            "Sec-WebSocket-Key:   dGhlIHNhbXBsZSBub25jZQ==  \r\n"
+            "Sec-WebSocket-Version: 13\r\n\r\n";
+        char accept[MC_WS_ACCEPT_LEN + 1], key[MC_WS_KEY_LEN + 1];
+        uint8_t out[512];
+        uint32_t n, len = (uint32_t)sizeof(req) - 1;
+
+        mc_ws_accept_key(RFC_KEY, accept);
+        ASSERT(strcmp(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0);
+
+        ASSERT_EQ_I32(mc_ws_parse_request((const uint8_t*)req, len - 1, key), 0);   /* partial */
+        ASSERT_EQ_I32(mc_ws_parse_request((const uint8_t*)req, len, key), (int32_t)len);
+        ASSERT(strcmp(key, RFC_KEY) == 0);
+
+        n = mc_ws_write_response(key, out, sizeof(out));
+        ASSERT(n > 0);
+        ASSERT_EQ_I32(mc_ws_check_response(out, n, RFC_KEY), (int32_t)n);
+        ASSERT_EQ_I32(mc_ws_check_response(out, n - 1, RFC_KEY), 0);
+        ASSERT_EQ_I32(mc_ws_check_response(out, n, "AAAAAAAAAAAAAAAAAAAAAA=="), -1);
+        ASSERT_EQ_U32(mc_ws_write_response(key, out, n - 1), 0);
+    }
+    TEST_END();
+}
+
+static void test_handshake_client_request(void) {
+    TEST_BEGIN("handshake: client request parses on the server side");
+    {
+        char key[MC_WS_KEY_LEN + 1];
+        uint8_t out[512];
+        uint32_t n = mc_ws_write_request("localhost:8080", "/", RFC_KEY, out, sizeof(out));
+        ASSERT(n > 0);
+        ASSERT_EQ_I32(mc_ws_parse_request(out, n, key), (int32_t)n);
+        ASSERT(strcmp(key, RFC_KEY) == 0);
+        ASSERT_EQ_U32(mc_ws_write_request("localhost:8080", "/", RFC_KEY, out, 20), 0);
+    }
+    TEST_END();
+}
+
+static void test_handshake_rejects(void) {
+    TEST_BEGIN("handshake: non-upgrade, bad key, POST and oversize refused");
+    {
+        static uint8_t big[MC_WS_MAX_HANDSHAKE];
+        char key[MC_WS_KEY_LEN + 1];
+        const char* plain = "GET / HTTP/1.1\r\nHost: x\r\n\r\n";
+        const char* post = "POST / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n";
+        const char* short_key = "GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                "Sec-WebSocket-Key: abc\r\n\r\n";
+        const char* websockets = "GET / HTTP/1.1\r\nUpgrade: websockets\r\nConnection: Upgrade\r\n"
+                                 "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n";
+
+        ASSERT_EQ_I32(mc_ws_parse_request((const uint8_t*)plain, (uint32_t)strlen(plain), key), -1);
+        ASSERT_EQ_I32(mc_ws_parse_request((const uint8_t*)post, (uint32_t)strlen(post), key), -1);
+        ASSERT_EQ_I32(mc_ws_parse_request((const uint8_t*)short_key, (uint32_t)strlen(short_key), key), -1);
+        ASSERT_EQ_I32(mc_ws_parse_request((const uint8_t*)websockets, (uint32_t)strlen(websockets), key), -1);
+        memset(big, 'A', sizeof(big));
+        ASSERT_EQ_I32(mc_ws_parse_request(big, sizeof(big), key), -1);
+    }
+    TEST_END();
+}
+
+/* =========================================================================
+ * SECTION 3: FRAMES
+ * ========================================================================= */
+
+static void test_frame_roundtrip(void) {
+    TEST_BEGIN("frames: 7/16/64-bit lengths, masked and unmasked, split delivery");
+    {
+        static uint8_t payload[70000], buf[70100];
+        static const uint32_t lens[] = { 0, 1, 125, 126, 127, 65535, 65536, 70000 };
+        uint32_t i, k, bad = 0;
+
+        for (i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)(i * 31 + 7);
+        for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            int masked;
+            for (masked = 0; masked <= 1; masked++) {
+                McWsFrame f;
+                uint32_t n = mc_ws_write_frame(buf, sizeof(buf), MC_WS_OP_BINARY, payload, lens[i],
+                                               masked, 0x9E3779B9u);
+                if (n == 0) { bad++; continue; }
+                for (k = 0; k < n; k += (n / 7) + 1) {
+                    if (mc_ws_parse_frame(buf, k, masked, sizeof(payload), &f) != 0) bad++;
+                }
+                if (mc_ws_parse_frame(buf, n, !masked, sizeof(payload), &f) != -1) bad++;
+                if (mc_ws_parse_frame(buf, n, masked, sizeof(payload), &f) != (int32_t)n) { bad++; continue; }
+                if (f.opcode != MC_WS_OP_BINARY || f.payload_len != lens[i]) bad++;
+                if (lens[i] > 0 && memcmp(buf + f.payload_off, payload, lens[i]) != 0) bad++;
+            }
+        }
+        ASSERT_EQ_U32(bad, 0);
+        ASSERT_EQ_U32(mc_ws_write_frame(buf, 10, MC_WS_OP_BINARY, payload, 9, 0, 0), 0);
+    }
+    TEST_END();
+}
+
+static void test_frame_rejects(void) {
+    TEST_BEGIN("frames: fragments, RSV bits, big control frames, oversize refused");
+    {
+        uint8_t buf[300], p[200];
+        McWsFrame f;
+        uint32_t n;
+
+        memset(p, 0, sizeof(p));
+        n = mc_ws_write_frame(buf, sizeof(buf), MC_WS_OP_TEXT, p, 10, 0, 0);
+        buf[0] &= 0x7F;                                            /* FIN = 0 */
+        ASSERT_EQ_I32(mc_ws_parse_frame(buf, n, 0, 1024, &f), -1);
+        buf[0] = 0x80 | MC_WS_OP_CONT;
+        ASSERT_EQ_I32(mc_ws_parse_frame(buf, n, 0, 1024, &f), -1);
+        buf[0] = 0xC0 | MC_WS_OP_TEXT;                             /* RSV1 */
+        ASSERT_EQ_I32(mc_ws_parse_frame(buf, n, 0, 1024, &f), -1);
+        buf[0] = 0x80 | 0x3;                                       /* reserved opcode */
+        ASSERT_EQ_I32(mc_ws_parse_frame(buf, n, 0, 1024, &f), -1);
+
+        n = mc_ws_write_frame(buf, sizeof(buf), MC_WS_OP_PING, p, 126, 0, 0);
+        ASSERT_EQ_I32(mc_ws_parse_frame(buf, n, 0, 1024, &f), -1);
+        n = mc_ws_write_frame(buf, sizeof(buf), MC_WS_OP_BINARY, p, 200, 0, 0);
+        ASSERT_EQ_I32(mc_ws_parse_frame(buf, n, 0, 199, &f), -1);
+
+        n = mc_ws_write_close(buf, sizeof(buf), MC_WS_CLOSE_PROTOCOL, 1, 1234);
+        ASSERT_EQ_I32(mc_ws_parse_frame(buf, n, 1, 1024, &f), (int32_t)n);
+        ASSERT_EQ_U32(f.opcode, MC_WS_OP_CLOSE);
+        ASSERT_EQ_U32(((uint32_t)buf[f.payload_off] << 8) | buf[f.payload_off + 1], MC_WS_CLOSE_PROTOCOL);
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("MarbleEngine WebSocket Layer Tests\n");
+    printf("==================================\n\n");
+
+    printf("[Digests]\n");
+    test_sha1_vectors();
+    test_base64();
+
+    printf("\n[Handshake]\n");
+    test_handshake_rfc_example();
+    test_handshake_client_request();
+    test_handshake_rejects();
+
+    printf("\n[Frames]\n");
+    test_frame_roundtrip();
+    test_frame_rejects();
+
+    printf("\n==================================\n");
+    printf("TOTAL: %d  PASSED: %d  FAILED: %d\n",
+           g_tests_run, g_tests_passed, g_tests_failed);
+
+    if (g_tests_failed == 0) {
+        printf("ALL TESTS PASSED\n");
+    } else {
+        printf("*** FAILURES DETECTED ***\n");
+    }
+
+    return (g_tests_failed > 0) ? 1 : 0;
+}